@@ -0,0 +1,198 @@
+#ifndef AUTO_EXPOSURE_H
+#define AUTO_EXPOSURE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+// Histogram based automatic exposure that never leaves the GPU, the tone mapping shader samples
+// ExposureTexture() (g channel) instead of reading a value back on the CPU.
+//  1. histogram: one point per sampled pixel of the HDR target is scattered into a BINS x 1 float texture
+//     with additive blending, the vertex shader fetches the pixel and picks its log2 luminance bin
+//     (bin 0 collects black pixels and is ignored)
+//  2. adaptation: a single fragment averages the log luminance between the LowPercent and HighPercent
+//     percentiles, moves last frame's value towards it exponentially and stores r = luminance, g = exposure
+//
+// The shaders are passed in by the demo (see 6.luminance_histogram.vs/.fs and 6.exposure_adapt.vs/.fs in 6.hdr):
+//     histogram: uniforms hdrBuffer, sampleStep, width, bins, minLog2, log2Range
+//     adapt:     uniforms histogram, previous, bins, minLog2, log2Range, lowPercent, highPercent,
+//                speedUp, speedDown, deltaTime, keyValue, reset
+class AutoExposure
+{
+public:
+
+	static const int BINS = 128;
+
+	float MinLog2;      // luminance range covered by the histogram
+	float MaxLog2;
+	float LowPercent;   // darkest fraction of the pixels that is ignored
+	float HighPercent;  // everything brighter than this fraction is ignored
+	float SpeedUp;      // adaptation speed towards brighter and darker scenes, in 1 / seconds
+	float SpeedDown;
+	float KeyValue;     // exposure = KeyValue / average luminance
+	int SampleStep;     // histogram every SampleStep-th pixel in x and y
+
+	AutoExposure(Shader& histogramShader, Shader& adaptShader)
+		: MinLog2(-8.0f), MaxLog2(8.0f), LowPercent(0.5f), HighPercent(0.95f), SpeedUp(3.0f), SpeedDown(1.0f),
+		  KeyValue(0.18f), SampleStep(2), histogramShader(histogramShader), adaptShader(adaptShader), current(0), reset(true)
+	{
+		glGenVertexArrays(1, &emptyVAO);
+
+		glGenFramebuffers(1, &histogramFBO);
+		glGenTextures(1, &histogram);
+		glBindTexture(GL_TEXTURE_2D, histogram);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, BINS, 1, 0, GL_RED, GL_FLOAT, NULL);
+		setNearest();
+		glBindFramebuffer(GL_FRAMEBUFFER, histogramFBO);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, histogram, 0);
+
+		// ping-pong between two 1x1 targets so the previous result can be read while writing the new one
+		glGenFramebuffers(2, exposureFBO);
+		glGenTextures(2, exposure);
+		float initial[2] = { 1.0f, 1.0f };
+		for (int i = 0; i < 2; ++i)
+		{
+			glBindTexture(GL_TEXTURE_2D, exposure[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, 1, 1, 0, GL_RG, GL_FLOAT, initial);
+			setNearest();
+			glBindFramebuffer(GL_FRAMEBUFFER, exposureFBO[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, exposure[i], 0);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	~AutoExposure()
+	{
+		glDeleteVertexArrays(1, &emptyVAO);
+		glDeleteFramebuffers(1, &histogramFBO);
+		glDeleteTextures(1, &histogram);
+		glDeleteFramebuffers(2, exposureFBO);
+		glDeleteTextures(2, exposure);
+	}
+
+	// jump straight to the measured exposure on the next Update instead of adapting to it
+	void Reset()
+	{
+		reset = true;
+	}
+
+	// builds the histogram of hdrTexture and adapts the exposure; changes the textures bound to units 0 and 1,
+	// leaves framebuffer 0 bound and restores the caller's viewport, clear color, blend and depth test state
+	void Update(unsigned int hdrTexture, int width, int height, float deltaTime)
+	{
+		GLint viewport[4];
+		GLint blendSrc, blendDst;
+		GLfloat clearColor[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+		glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+		glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+		GLboolean blend = glIsEnabled(GL_BLEND);
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glDisable(GL_DEPTH_TEST);
+		glBindVertexArray(emptyVAO);
+
+		// 1. histogram
+		// ------------
+		int step = SampleStep > 1 ? SampleStep : 1;
+		int sampledWidth = (width + step - 1) / step;
+		int sampledHeight = (height + step - 1) / step;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, histogramFBO);
+		glViewport(0, 0, BINS, 1);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+
+		histogramShader.use();
+		histogramShader.setInt("hdrBuffer", 0);
+		histogramShader.setInt("sampleStep", step);
+		histogramShader.setInt("width", sampledWidth);
+		setRange(histogramShader);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hdrTexture);
+		glDrawArrays(GL_POINTS, 0, sampledWidth * sampledHeight);
+		glDisable(GL_BLEND);
+
+		// 2. percentile average and temporal adaptation
+		// ---------------------------------------------
+		int next = 1 - current;
+		glBindFramebuffer(GL_FRAMEBUFFER, exposureFBO[next]);
+		glViewport(0, 0, 1, 1);
+
+		adaptShader.use();
+		adaptShader.setInt("histogram", 0);
+		adaptShader.setInt("previous", 1);
+		setRange(adaptShader);
+		adaptShader.setFloat("lowPercent", LowPercent);
+		adaptShader.setFloat("highPercent", HighPercent);
+		adaptShader.setFloat("speedUp", SpeedUp);
+		adaptShader.setFloat("speedDown", SpeedDown);
+		adaptShader.setFloat("deltaTime", deltaTime);
+		adaptShader.setFloat("keyValue", KeyValue);
+		adaptShader.setBool("reset", reset);
+		glBindTexture(GL_TEXTURE_2D, histogram);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, exposure[current]);
+		glDrawArrays(GL_POINTS, 0, 1);
+		glActiveTexture(GL_TEXTURE0);
+
+		current = next;
+		reset = false;
+
+		glBindVertexArray(0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		glBlendFunc(blendSrc, blendDst);
+		if (blend)
+			glEnable(GL_BLEND);
+		if (depthTest)
+			glEnable(GL_DEPTH_TEST);
+	}
+
+	// 1x1 RG32F texture, r = adapted average luminance, g = exposure
+	unsigned int ExposureTexture() const
+	{
+		return exposure[current];
+	}
+
+	unsigned int HistogramTexture() const
+	{
+		return histogram;
+	}
+
+private:
+
+	Shader& histogramShader;
+	Shader& adaptShader;
+	unsigned int emptyVAO;
+	unsigned int histogramFBO;
+	unsigned int histogram;
+	unsigned int exposureFBO[2];
+	unsigned int exposure[2];
+	int current;
+	bool reset;
+
+	void setRange(const Shader& shader) const
+	{
+		shader.setInt("bins", BINS);
+		shader.setFloat("minLog2", MinLog2);
+		shader.setFloat("log2Range", MaxLog2 - MinLog2);
+	}
+
+	static void setNearest()
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	AutoExposure(const AutoExposure&);
+	AutoExposure& operator=(const AutoExposure&);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef BRDF_LUT_H
+#define BRDF_LUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/brdf_lut_table.h>
+
+#include <algorithm>
+#include <cmath>
+
+// The split sum BRDF LUT (scale and bias to F0 of the specular IBL term) only depends on NdotV and roughness, never
+// on the scene or the environment, so it is baked once at build time by src/tools/brdf_lut into brdf_lut_table.h
+// instead of being rendered on every startup. Two ways to use it:
+//  - LoadBRDFLUT() uploads the table as an RG16F texture, sampled exactly like the rendered LUT was
+//  - EnvBRDFApprox() is the analytic fit, no texture at all; the shader version is in the 2.2.x pbr shaders
+// Regenerate the table after changing the BRDF in IBLReference::BRDFLut(), the only implementation of it left.
+
+// uploads the baked table and returns the texture, clamp to edge and bilinear filtering like the rendered LUT
+inline unsigned int LoadBRDFLUT()
+{
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	GLint alignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, BRDF_LUT_TABLE_SIZE, BRDF_LUT_TABLE_SIZE, 0, GL_RG, GL_HALF_FLOAT, BRDF_LUT_TABLE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return texture;
+}
+
+// Analytic fit of the LUT from Karis, "Physically Based Shading on Mobile", which refines the curve fit of Lazarov,
+// "Getting More Physical in Call of Duty: Black Ops II". A handful of ALU instructions instead of a texture fetch, at
+// an rms error of about 0.05; it is least accurate at grazing angles and underestimates the scale of medium rough
+// surfaces seen head-on (0.72 instead of 0.90 at roughness 0.5)
+inline glm::vec2 EnvBRDFApprox(float NdotV, float roughness)
+{
+	const glm::vec4 c0(-1.0f, -0.0275f, -0.572f, 0.022f);
+	const glm::vec4 c1(1.0f, 0.0425f, 1.04f, -0.04f);
+	glm::vec4 r = roughness * c0 + c1;
+	float a004 = std::min(r.x * r.x, std::exp2(-9.28f * NdotV)) * r.x + r.y;
+	return glm::vec2(-1.04f, 1.04f) * a004 + glm::vec2(r.z, r.w);
+}
+
+#endif
@@ -41,8 +41,11 @@ public:
 	float MouseSensitivity;
 	float Zoom; //FOV
 
+	// sub-pixel offset of the projection in NDC units, zero unless a temporal technique sets it (see SetJitter)
+	glm::vec2 Jitter;
+
 	// constructor with vectors
-	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Jitter(0.0f)
 	{
 		Position = position;
 		WorldUp = up;
@@ -52,7 +55,7 @@ public:
 	}
 
 	// constructor with scalar values
-	Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+	Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Jitter(0.0f)
 	{
 		Position = glm::vec3(posX, posY, posZ);
 		WorldUp = glm::vec3(upX, upY, upZ);
@@ -67,6 +70,22 @@ public:
 		return glm::lookAt(Position, Position + Front, Up);
 	}
 
+	// returns the perspective projection with Zoom as vertical field of view, shifted by Jitter after the perspective
+	// divide; motion vectors need the unjittered one, so the shift can be left out
+	glm::mat4 GetProjectionMatrix(float aspect, float zNear = 0.1f, float zFar = 100.0f, bool jittered = true)
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(Zoom), aspect, zNear, zFar);
+		if (!jittered)
+			return projection;
+		return glm::translate(glm::mat4(1.0f), glm::vec3(Jitter, 0.0f)) * projection;
+	}
+
+	// sets Jitter from an offset in pixels of a width x height render target
+	void SetJitter(glm::vec2 pixels, int width, int height)
+	{
+		Jitter = glm::vec2(2.0f * pixels.x / width, 2.0f * pixels.y / height);
+	}
+
 	// processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 	{
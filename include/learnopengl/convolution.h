@@ -0,0 +1,146 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CONVOLUTION_SSE 1
+#endif
+
+// A square NxN image kernel (N odd). Row 0 is the top row, so weight (row, col) is applied to the texel
+// at offset (col - N / 2, N / 2 - row) with y pointing up like texture coordinates.
+// Kernels of rank 1 are factored into a vertical and a horizontal 1D kernel so they can run as two passes
+// of N fetches instead of one pass of N * N fetches.
+class ConvolutionKernel
+{
+public:
+
+	static const int MAX_SIZE = 15;
+
+	int Size;
+	std::vector<float> Weights;    // Size * Size, row major
+	std::vector<float> Vertical;   // Size, only valid if Separable
+	std::vector<float> Horizontal; // Size, only valid if Separable
+	bool Separable;
+
+	ConvolutionKernel() : Size(1), Weights(1, 1.0f), Separable(false)
+	{
+		Factor();
+	}
+
+	ConvolutionKernel(int size, const float* weights) : Size(size), Weights(weights, weights + size * size), Separable(false)
+	{
+		Factor();
+	}
+
+	static ConvolutionKernel Box(int size)
+	{
+		std::vector<float> w(size * size, 1.0f / (float)(size * size));
+		return ConvolutionKernel(size, &w[0]);
+	}
+
+	// binomial approximation of a Gaussian, size 3 is the 1 2 1 / 16 blur of the original demo
+	static ConvolutionKernel Binomial(int size)
+	{
+		std::vector<float> row(1, 1.0f);
+		for (int i = 1; i < size; ++i)
+		{
+			std::vector<float> next(i + 1, 1.0f);
+			for (int j = 1; j < i; ++j)
+				next[j] = row[j - 1] + row[j];
+			row = next;
+		}
+		float sum = 0.0f;
+		for (int i = 0; i < size; ++i)
+			sum += row[i];
+		std::vector<float> w(size * size);
+		for (int y = 0; y < size; ++y)
+			for (int x = 0; x < size; ++x)
+				w[y * size + x] = row[y] * row[x] / (sum * sum);
+		return ConvolutionKernel(size, &w[0]);
+	}
+
+	int Fetches() const
+	{
+		return Separable ? 2 * Size : Size * Size;
+	}
+
+private:
+
+	// rank 1 test: scale the row and column through the largest weight and check that their outer product
+	// reproduces the whole kernel
+	void Factor()
+	{
+		Separable = false;
+		Vertical.assign(Size, 0.0f);
+		Horizontal.assign(Size, 0.0f);
+
+		int pivot = 0;
+		for (int i = 1; i < Size * Size; ++i)
+			if (std::fabs(Weights[i]) > std::fabs(Weights[pivot]))
+				pivot = i;
+		float largest = Weights[pivot];
+		if (largest == 0.0f)
+			return;
+
+		int pivotRow = pivot / Size;
+		int pivotCol = pivot % Size;
+		for (int i = 0; i < Size; ++i)
+		{
+			Vertical[i] = Weights[i * Size + pivotCol];
+			Horizontal[i] = Weights[pivotRow * Size + i] / largest;
+		}
+
+		float tolerance = 1e-5f * std::fabs(largest);
+		for (int y = 0; y < Size; ++y)
+			for (int x = 0; x < Size; ++x)
+				if (std::fabs(Vertical[y] * Horizontal[x] - Weights[y * Size + x]) > tolerance)
+					return;
+		Separable = true;
+	}
+};
+
+// CPU reference of the GPU kernel passes, for verifying them without a GL context.
+// Images are RGBA float, bottom row first (as glReadPixels returns them), edges are clamped.
+// The four channels of a pixel are processed together in one SSE register when available.
+inline void ConvolveReference(const float* src, float* dst, int width, int height, const ConvolutionKernel& kernel)
+{
+	int half = kernel.Size / 2;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+#ifdef CONVOLUTION_SSE
+			__m128 sum = _mm_setzero_ps();
+#else
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+#endif
+			for (int row = 0; row < kernel.Size; ++row)
+			{
+				int sy = std::min(std::max(y + half - row, 0), height - 1);
+				const float* line = src + (size_t)sy * width * 4;
+				for (int col = 0; col < kernel.Size; ++col)
+				{
+					int sx = std::min(std::max(x + col - half, 0), width - 1);
+					float w = kernel.Weights[row * kernel.Size + col];
+#ifdef CONVOLUTION_SSE
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(line + sx * 4), _mm_set1_ps(w)));
+#else
+					for (int c = 0; c < 4; ++c)
+						sum[c] += line[sx * 4 + c] * w;
+#endif
+				}
+			}
+#ifdef CONVOLUTION_SSE
+			_mm_storeu_ps(dst + ((size_t)y * width + x) * 4, sum);
+#else
+			std::copy(sum, sum + 4, dst + ((size_t)y * width + x) * 4);
+#endif
+		}
+	}
+}
+
+#endif
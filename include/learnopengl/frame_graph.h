@@ -0,0 +1,507 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/post_chain.h>
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+
+// Passes over named targets that declare what they read and write; the graph works out the rest:
+//  - dependencies: a pass depends on the last earlier pass that wrote a target it reads or writes, and comes after
+//    every earlier reader of a target it overwrites
+//  - culling: only passes that lead to the backbuffer or to an exported target are kept
+//  - order: the kept passes are sorted by their dependencies, among the passes that are ready the one continuing
+//    from the most recently run pass goes first, which keeps the lifetimes of the targets in between short
+//  - aliasing: targets created by the graph are transient and only live from the first to the last pass that
+//    uses them, targets with the same description and disjoint lifetimes share one texture of the pool (GL 3.3
+//    cannot alias memory between different formats, so only identical descriptions share)
+//  - timing: every pass is timed with its own GpuTimer, see PassMilliseconds() and PrintTimings()
+//
+//     int color = graph.Create("color", GL_RGBA16F);
+//     int depth = graph.Create("depth", GL_DEPTH_COMPONENT24);
+//     graph.AddPass("scene", {}, { color, depth }, [&]() { glClear(...); drawScene(); });
+//     graph.AddPass("tonemap", { color }, { FrameGraph::BACKBUFFER }, [&]() { tonemapShader.use(); renderQuad(); });
+//     graph.Compile();
+//     ... every frame: graph.Execute();
+//
+// Execute() binds a framebuffer with the written targets attached (color targets in declaration order, depth
+// targets to the depth attachment) and the viewport of the first one, the read targets go to texture units 0,
+// 1, ... in declaration order. The pass sets its shader state, clears what it needs cleared and draws; it may
+// bind framebuffers of its own for steps the graph does not describe (mip levels, array layers) as long as they
+// only write the targets the pass declares. Passes run with their own timer, so they must not start GpuTimers.
+//
+// No barriers are inserted: GL orders rendering into a texture before any later sampling from it by itself, an
+// explicit glMemoryBarrier is only needed after image load/store or shader storage writes, which GL 3.3 does not
+// have. The graph still knows every write-then-read transition, which is where a barrier would go.
+class FrameGraph
+{
+public:
+
+	static const int BACKBUFFER = -1;
+	typedef std::function<void()> PassFunction;
+
+	// time every pass, off for graphs whose passes run inside an outer GpuTimer
+	bool Timing;
+
+	FrameGraph() : Timing(true), width(0), height(0), compiled(false)
+	{
+	}
+
+	~FrameGraph()
+	{
+		releaseFramebuffers();
+		for (size_t i = 0; i < timers.size(); ++i)
+			delete timers[i];
+	}
+
+	// output size of the graph, transient targets are sized relative to it; reallocates them on the next Compile()
+	void Resize(int outputWidth, int outputHeight)
+	{
+		if (outputWidth == width && outputHeight == height)
+			return;
+		width = outputWidth;
+		height = outputHeight;
+		pool.Clear();
+		compiled = false;
+		for (size_t i = 0; i < targets.size(); ++i)
+			if (!targets[i].Imported)
+				targets[i].Desc = describe(targets[i].Desc.InternalFormat, targets[i].Shift);
+	}
+
+	// removes all passes and targets, the pooled textures are kept for the next Compile()
+	void Clear()
+	{
+		releaseFramebuffers();
+		passes.clear();
+		targets.clear();
+		schedule.clear();
+		compiled = false;
+	}
+
+	// a texture owned by the caller, e.g. the scene color; can only be read
+	int Import(const std::string& name, unsigned int texture)
+	{
+		Target target;
+		target.Name = name;
+		target.Imported = true;
+		target.Exported = false;
+		target.Texture = texture;
+		target.Desc = describe(GL_RGBA16F, 0);
+		target.Shift = 0;
+		target.Filter = 0;
+		target.Slot = -1;
+		targets.push_back(target);
+		return (int)targets.size() - 1;
+	}
+
+	// a transient target of (output size >> shift), color or depth depending on the format; filter is the
+	// GL_TEXTURE_MIN/MAG_FILTER used when passes read it, set on every read as aliased targets share the texture
+	int Create(const std::string& name, GLenum internalFormat, int shift = 0, GLenum filter = GL_LINEAR)
+	{
+		Target target;
+		target.Name = name;
+		target.Imported = false;
+		target.Exported = false;
+		target.Texture = 0;
+		target.Desc = describe(internalFormat, shift);
+		target.Shift = shift;
+		target.Filter = filter;
+		target.Slot = -1;
+		targets.push_back(target);
+		compiled = false;
+		return (int)targets.size() - 1;
+	}
+
+	// keeps a target alive after the last pass, for reading it back after Execute(); its writers are never culled
+	void Export(int target)
+	{
+		targets[target].Exported = true;
+		compiled = false;
+	}
+
+	// returns the index of the pass, for PassMilliseconds() / IsCulled()
+	int AddPass(const std::string& name, const std::vector<int>& reads, const std::vector<int>& writes, PassFunction execute)
+	{
+		Pass pass;
+		pass.Name = name;
+		pass.Reads = reads;
+		pass.Writes = writes;
+		pass.Execute = execute;
+		pass.Culled = false;
+		pass.Framebuffer = 0;
+		pass.Attached = false;
+		passes.push_back(pass);
+		compiled = false;
+		return (int)passes.size() - 1;
+	}
+
+	// dependencies, culling, order and pool textures for the transient targets; no GL calls besides deleting
+	// pool textures that are no longer needed
+	void Compile()
+	{
+		int passCount = (int)passes.size();
+
+		// 1. dependencies in declaration order
+		std::vector<std::vector<int> > needs(passCount), after(passCount);
+		std::vector<int> lastWriter(targets.size(), -1);
+		int backbufferWriter = -1;
+		std::vector<std::vector<int> > readers(targets.size());
+		for (int p = 0; p < passCount; ++p)
+		{
+			const Pass& pass = passes[p];
+			for (size_t i = 0; i < pass.Reads.size(); ++i)
+			{
+				int t = pass.Reads[i];
+				if (lastWriter[t] >= 0)
+					needs[p].push_back(lastWriter[t]);
+				readers[t].push_back(p);
+			}
+			for (size_t i = 0; i < pass.Writes.size(); ++i)
+			{
+				int t = pass.Writes[i];
+				// passes drawing over each other on the backbuffer keep their declaration order, like any other target
+				if (t == BACKBUFFER)
+				{
+					if (backbufferWriter >= 0)
+						needs[p].push_back(backbufferWriter);
+					backbufferWriter = p;
+					continue;
+				}
+				// a write that does not clear keeps the earlier content, so the earlier writer is needed as well
+				if (lastWriter[t] >= 0)
+					needs[p].push_back(lastWriter[t]);
+				for (size_t r = 0; r < readers[t].size(); ++r)
+					if (readers[t][r] != p)
+						after[p].push_back(readers[t][r]);
+				lastWriter[t] = p;
+				readers[t].clear();
+			}
+		}
+
+		// 2. culling, backwards from the passes whose results leave the graph
+		std::vector<bool> live(passCount, false);
+		for (int p = passCount - 1; p >= 0; --p)
+		{
+			const Pass& pass = passes[p];
+			for (size_t i = 0; i < pass.Writes.size(); ++i)
+			{
+				int t = pass.Writes[i];
+				if (t == BACKBUFFER || targets[t].Exported)
+					live[p] = true;
+			}
+			if (!live[p])
+				continue;
+			for (size_t i = 0; i < needs[p].size(); ++i)
+				live[needs[p][i]] = true;
+		}
+
+		// 3. order: topological sort of the live passes, preferring the pass that continues from the latest one
+		std::vector<int> blocking(passCount, 0);
+		std::vector<std::vector<int> > unblocks(passCount);
+		for (int p = 0; p < passCount; ++p)
+		{
+			if (!live[p])
+				continue;
+			std::vector<int> edges = needs[p];
+			edges.insert(edges.end(), after[p].begin(), after[p].end());
+			std::sort(edges.begin(), edges.end());
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+			for (size_t i = 0; i < edges.size(); ++i)
+			{
+				if (!live[edges[i]])
+					continue;
+				++blocking[p];
+				unblocks[edges[i]].push_back(p);
+			}
+		}
+		std::vector<int> readyAt(passCount, -1);
+		std::vector<int> ready;
+		for (int p = 0; p < passCount; ++p)
+			if (live[p] && blocking[p] == 0)
+				ready.push_back(p);
+		schedule.clear();
+		while (!ready.empty())
+		{
+			size_t best = 0;
+			for (size_t i = 1; i < ready.size(); ++i)
+				if (readyAt[ready[i]] > readyAt[ready[best]] || (readyAt[ready[i]] == readyAt[ready[best]] && ready[i] < ready[best]))
+					best = i;
+			int p = ready[best];
+			ready.erase(ready.begin() + best);
+			schedule.push_back(p);
+			for (size_t i = 0; i < unblocks[p].size(); ++i)
+			{
+				int next = unblocks[p][i];
+				readyAt[next] = (int)schedule.size();
+				if (--blocking[next] == 0)
+					ready.push_back(next);
+			}
+		}
+		for (int p = 0; p < passCount; ++p)
+			passes[p].Culled = !live[p];
+
+		// 4. lifetimes along the schedule and pool textures
+		std::vector<int> first(targets.size(), -1), last(targets.size(), -1);
+		for (int s = 0; s < (int)schedule.size(); ++s)
+		{
+			const Pass& pass = passes[schedule[s]];
+			std::vector<int> used = pass.Reads;
+			used.insert(used.end(), pass.Writes.begin(), pass.Writes.end());
+			for (size_t i = 0; i < used.size(); ++i)
+			{
+				int t = used[i];
+				if (t == BACKBUFFER)
+					continue;
+				if (first[t] < 0)
+					first[t] = s;
+				last[t] = targets[t].Exported ? (int)schedule.size() : s;
+			}
+		}
+
+		pool.ReleaseAll();
+		for (size_t t = 0; t < targets.size(); ++t)
+			targets[t].Slot = -1;
+		for (int s = 0; s < (int)schedule.size(); ++s)
+		{
+			for (size_t t = 0; t < targets.size(); ++t)
+				if (!targets[t].Imported && first[t] == s)
+					targets[t].Slot = pool.Acquire(targets[t].Desc);
+			for (size_t t = 0; t < targets.size(); ++t)
+				if (!targets[t].Imported && last[t] == s)
+					pool.Release(targets[t].Slot);
+		}
+		pool.Trim();
+		for (size_t p = 0; p < passes.size(); ++p)
+			passes[p].Attached = false;
+		compiled = true;
+	}
+
+	void Execute()
+	{
+		if (!compiled)
+			Compile();
+		while (timers.size() < passes.size())
+			timers.push_back(new GpuTimer());
+		for (size_t s = 0; s < schedule.size(); ++s)
+		{
+			int p = schedule[s];
+			Pass& pass = passes[p];
+			if (Timing)
+				timers[p]->Begin();
+			bind(pass);
+			for (size_t i = 0; i < pass.Reads.size(); ++i)
+			{
+				const Target& target = targets[pass.Reads[i]];
+				glActiveTexture(GL_TEXTURE0 + (GLenum)i);
+				glBindTexture(GL_TEXTURE_2D, Texture(pass.Reads[i]));
+				if (!target.Imported)
+				{
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, target.Filter);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, target.Filter);
+				}
+			}
+			glActiveTexture(GL_TEXTURE0);
+			pass.Execute();
+			if (Timing)
+				timers[p]->End();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, width, height);
+	}
+
+	// texture of a target; with aliasing a transient target only holds its content until its last pass has run
+	unsigned int Texture(int target)
+	{
+		if (targets[target].Imported)
+			return targets[target].Texture;
+		return targets[target].Slot >= 0 ? pool.Texture(targets[target].Slot) : 0;
+	}
+
+	// framebuffer with only this transient target attached, e.g. to blit an exported depth target
+	unsigned int Framebuffer(int target)
+	{
+		return targets[target].Slot >= 0 ? pool.Framebuffer(targets[target].Slot) : 0;
+	}
+
+	const RenderTargetDesc& Desc(int target) const
+	{
+		return targets[target].Desc;
+	}
+
+	// memory the transient targets of the kept passes would need with one texture each
+	size_t DeclaredBytes() const
+	{
+		size_t bytes = 0;
+		for (size_t t = 0; t < targets.size(); ++t)
+			if (!targets[t].Imported && targets[t].Slot >= 0)
+				bytes += targets[t].Desc.Bytes();
+		return bytes;
+	}
+
+	// memory of the pool textures they were assigned after Compile()
+	size_t PooledBytes() const
+	{
+		return pool.Bytes();
+	}
+
+	int PooledCount() const
+	{
+		return pool.Count();
+	}
+
+	int PassCount() const
+	{
+		return (int)passes.size();
+	}
+
+	// passes that run, in execution order
+	const std::vector<int>& Schedule() const
+	{
+		return schedule;
+	}
+
+	const std::string& PassName(int pass) const
+	{
+		return passes[pass].Name;
+	}
+
+	bool IsCulled(int pass) const
+	{
+		return passes[pass].Culled;
+	}
+
+	// smoothed GPU time of a pass, 0 for culled passes and before the first results
+	float PassMilliseconds(int pass) const
+	{
+		return pass < (int)timers.size() && !passes[pass].Culled ? timers[pass]->Milliseconds : 0.0f;
+	}
+
+	// average since the last ResetTimings(), for benchmarks
+	float PassAverage(int pass) const
+	{
+		return pass < (int)timers.size() && !passes[pass].Culled ? timers[pass]->Average() : 0.0f;
+	}
+
+	void ResetTimings()
+	{
+		for (size_t i = 0; i < timers.size(); ++i)
+			timers[i]->Reset();
+	}
+
+	// per pass breakdown in execution order, culled passes last
+	void PrintTimings() const
+	{
+		float total = 0.0f;
+		for (size_t s = 0; s < schedule.size(); ++s)
+		{
+			printf("%-20s %.3f ms\n", passes[schedule[s]].Name.c_str(), PassMilliseconds(schedule[s]));
+			total += PassMilliseconds(schedule[s]);
+		}
+		for (size_t p = 0; p < passes.size(); ++p)
+			if (passes[p].Culled)
+				printf("%-20s culled\n", passes[p].Name.c_str());
+		printf("%-20s %.3f ms, targets %.1f MB pooled / %.1f MB declared\n", "total", total, PooledBytes() / (1024.0f * 1024.0f), DeclaredBytes() / (1024.0f * 1024.0f));
+	}
+
+	int OutputWidth() const { return width; }
+	int OutputHeight() const { return height; }
+
+private:
+
+	struct Target
+	{
+		std::string Name;
+		bool Imported;
+		bool Exported;
+		unsigned int Texture;
+		RenderTargetDesc Desc;
+		int Shift;
+		GLenum Filter;
+		int Slot;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		std::vector<int> Reads;
+		std::vector<int> Writes;
+		PassFunction Execute;
+		bool Culled;
+		unsigned int Framebuffer;
+		bool Attached;  // attachments match the current pool assignment
+	};
+
+	int width;
+	int height;
+	bool compiled;
+	std::vector<Target> targets;
+	std::vector<Pass> passes;
+	std::vector<int> schedule;
+	std::vector<GpuTimer*> timers;
+	RenderTargetPool pool;
+
+	RenderTargetDesc describe(GLenum internalFormat, int shift) const
+	{
+		RenderTargetDesc desc = { internalFormat, std::max(width >> shift, 1), std::max(height >> shift, 1) };
+		return desc;
+	}
+
+	// framebuffer and viewport of a pass, the framebuffer is (re)attached after every Compile()
+	void bind(Pass& pass)
+	{
+		if (pass.Writes.empty() || pass.Writes[0] == BACKBUFFER)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, width, height);
+			return;
+		}
+		if (!pass.Framebuffer)
+			glGenFramebuffers(1, &pass.Framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, pass.Framebuffer);
+		if (!pass.Attached)
+		{
+			std::vector<GLenum> drawBuffers;
+			for (size_t i = 0; i < pass.Writes.size(); ++i)
+			{
+				int t = pass.Writes[i];
+				if (targets[t].Desc.IsDepth())
+				{
+					GLenum attachment = targets[t].Desc.InternalFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+					glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, Texture(t), 0);
+				}
+				else
+				{
+					GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)drawBuffers.size();
+					glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, Texture(t), 0);
+					drawBuffers.push_back(attachment);
+				}
+			}
+			if (drawBuffers.empty())
+				glDrawBuffer(GL_NONE);
+			else
+				glDrawBuffers((GLsizei)drawBuffers.size(), &drawBuffers[0]);
+			pass.Attached = true;
+		}
+		const RenderTargetDesc& desc = targets[pass.Writes[0]].Desc;
+		glViewport(0, 0, desc.Width, desc.Height);
+	}
+
+	void releaseFramebuffers()
+	{
+		for (size_t p = 0; p < passes.size(); ++p)
+			if (passes[p].Framebuffer)
+				glDeleteFramebuffers(1, &passes[p].Framebuffer);
+	}
+
+	FrameGraph(const FrameGraph&);
+	FrameGraph& operator=(const FrameGraph&);
+};
+
+#endif
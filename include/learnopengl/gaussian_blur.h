@@ -0,0 +1,100 @@
+#ifndef GAUSSIAN_BLUR_H
+#define GAUSSIAN_BLUR_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// Offsets and weights of one direction of a separable Gaussian blur, index 0 is the center tap.
+// With linear sampling every two neighbouring texels are merged into a single bilinear fetch placed
+// between them at the ratio of their weights, so a radius r blur costs 1 + 2 * ceil(r / 2) fetches instead of 2r + 1.
+//
+// The matching fragment shader loop (see 7.blur.fs or 3.1.3.shadow_blur.fs):
+//     result = texture(image, uv) * weights[0];
+//     for(int i = 1; i < taps; ++i)
+//         result += (texture(image, uv + direction * offsets[i]) + texture(image, uv - direction * offsets[i])) * weights[i];
+class GaussianKernel
+{
+public:
+
+	// size of offsets[] and weights[] in the shaders: a radius 64 blur without linear sampling, 128 with it
+	static const int MAX_TAPS = 65;
+
+	int Radius;
+	float Sigma;
+	bool LinearSampling;
+	std::vector<float> Offsets; // in texels
+	std::vector<float> Weights; // normalized over both sides of the kernel
+
+	// sigma <= 0 picks radius / 2, so the kernel is cut off at two standard deviations; the radius is clamped to what
+	// fits into MAX_TAPS
+	GaussianKernel(int radius, float sigma = 0.0f, bool linearSampling = true) : Radius(0), Sigma(0.0f), LinearSampling(linearSampling)
+	{
+		Build(radius, sigma, linearSampling);
+	}
+
+	void Build(int radius, float sigma = 0.0f, bool linearSampling = true)
+	{
+		Radius = std::min(std::max(radius, 0), linearSampling ? 2 * (MAX_TAPS - 1) : MAX_TAPS - 1);
+		Sigma = sigma > 0.0f ? sigma : std::max(Radius * 0.5f, 0.5f);
+		LinearSampling = linearSampling;
+
+		// discrete weights of one side, normalized so center + 2 * sides == 1
+		std::vector<float> discrete(Radius + 1);
+		float sum = 0.0f;
+		for (int i = 0; i <= Radius; ++i)
+		{
+			discrete[i] = std::exp(-(float)(i * i) / (2.0f * Sigma * Sigma));
+			sum += i == 0 ? discrete[i] : 2.0f * discrete[i];
+		}
+		for (int i = 0; i <= Radius; ++i)
+			discrete[i] /= sum;
+
+		Offsets.assign(1, 0.0f);
+		Weights.assign(1, discrete[0]);
+		if (!LinearSampling)
+		{
+			for (int i = 1; i <= Radius; ++i)
+			{
+				Offsets.push_back((float)i);
+				Weights.push_back(discrete[i]);
+			}
+			return;
+		}
+
+		// merge texels (1, 2), (3, 4), ... the bilinear filter reproduces both weights exactly
+		for (int i = 1; i <= Radius; i += 2)
+		{
+			float w1 = discrete[i];
+			float w2 = i + 1 <= Radius ? discrete[i + 1] : 0.0f;
+			float weight = w1 + w2;
+			Offsets.push_back(weight > 0.0f ? (i * w1 + (i + 1) * w2) / weight : (float)i);
+			Weights.push_back(weight);
+		}
+	}
+
+	int Taps() const
+	{
+		return (int)Offsets.size();
+	}
+
+	// texture fetches per pixel and direction
+	int Fetches() const
+	{
+		return 2 * Taps() - 1;
+	}
+
+	// uploads taps, offsets[] and weights[] to the currently used shader
+	void SetUniforms(const Shader& shader) const
+	{
+		shader.setInt("taps", Taps());
+		glUniform1fv(glGetUniformLocation(shader.ID, "offsets"), Taps(), &Offsets[0]);
+		glUniform1fv(glGetUniformLocation(shader.ID, "weights"), Taps(), &Weights[0]);
+	}
+};
+
+#endif
@@ -0,0 +1,536 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/instance_buffer.h>
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+// Procedural meshes for the demos, built on the CPU without a GL context. Vertices are interleaved position, normal
+// and texture coordinates (8 floats, attribute locations 0-2 like the meshes of renderSphere() and renderCube()),
+// triangles are indexed lists that OptimizeVertexCache() / OptimizeVertexFetch() reorder for the GPU.
+struct MeshData
+{
+	std::vector<float> Vertices;
+	std::vector<unsigned int> Indices;
+
+	int VertexCount() const { return (int)Vertices.size() / 8; }
+	int TriangleCount() const { return (int)Indices.size() / 3; }
+	glm::vec3 Position(unsigned int index) const { return glm::vec3(Vertices[index * 8], Vertices[index * 8 + 1], Vertices[index * 8 + 2]); }
+};
+
+class Geometry
+{
+public:
+
+	// UV sphere of the 6.pbr demos (segments x segments quads between the poles), as triangles; the quads at the
+	// poles degenerate into slivers, so it spends most of its vertices where the sphere is smallest on screen
+	static MeshData UVSphere(int segments)
+	{
+		MeshData mesh;
+		const float PI = 3.14159265359f;
+		for (int x = 0; x <= segments; ++x)
+		{
+			for (int y = 0; y <= segments; ++y)
+			{
+				float xSegment = (float)x / (float)segments;
+				float ySegment = (float)y / (float)segments;
+				glm::vec3 position(std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI), std::cos(ySegment * PI), std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI));
+				addVertex(mesh, position, glm::vec2(xSegment, ySegment));
+			}
+		}
+		for (int x = 0; x < segments; ++x)
+		{
+			for (int y = 0; y < segments; ++y)
+			{
+				unsigned int i0 = x * (segments + 1) + y;
+				unsigned int i1 = (x + 1) * (segments + 1) + y;
+				addTriangle(mesh, i0, i1, i0 + 1);
+				addTriangle(mesh, i1, i1 + 1, i0 + 1);
+			}
+		}
+		return mesh;
+	}
+
+	// subdivided icosahedron: 20 * 4^subdivisions nearly equilateral triangles of nearly equal area, the fewest
+	// triangles for a given deviation from the sphere
+	static MeshData Icosphere(int subdivisions)
+	{
+		const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+		std::vector<glm::vec3> positions;
+		const float corners[12][3] = {
+			{ -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+			{ 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+			{ t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+		};
+		for (int i = 0; i < 12; ++i)
+			positions.push_back(glm::normalize(glm::vec3(corners[i][0], corners[i][1], corners[i][2])));
+		const unsigned int faces[20][3] = {
+			{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+			{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+			{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+			{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+		};
+		std::vector<unsigned int> triangles(&faces[0][0], &faces[0][0] + 60);
+
+		// split every triangle into four, the midpoint of an edge is shared by the two triangles on it
+		for (int level = 0; level < subdivisions; ++level)
+		{
+			std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+			std::vector<unsigned int> split;
+			split.reserve(triangles.size() * 4);
+			for (size_t i = 0; i < triangles.size(); i += 3)
+			{
+				unsigned int a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+				unsigned int ab = midpoint(positions, midpoints, a, b);
+				unsigned int bc = midpoint(positions, midpoints, b, c);
+				unsigned int ca = midpoint(positions, midpoints, c, a);
+				unsigned int children[12] = { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca };
+				split.insert(split.end(), children, children + 12);
+			}
+			triangles.swap(split);
+		}
+
+		MeshData mesh;
+		for (size_t i = 0; i < positions.size(); ++i)
+			addVertex(mesh, positions[i], sphericalUV(positions[i]));
+		for (size_t i = 0; i < triangles.size(); i += 3)
+			addTriangle(mesh, triangles[i], triangles[i + 1], triangles[i + 2]);
+		return mesh;
+	}
+
+	// cube with segments x segments quads per face projected onto the sphere; the face coordinates are warped by
+	// tan() so the quads cover equal angles instead of bunching up at the face centers
+	static MeshData CubeSphere(int segments)
+	{
+		MeshData mesh;
+		const float PI = 3.14159265359f;
+		const glm::vec3 normals[6] = {
+			glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+		};
+		const glm::vec3 us[6] = {
+			glm::vec3(0, 0, -1), glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0)
+		};
+		// the edges of neighbouring faces are computed from different axes, vertices are matched by position
+		std::map<std::pair<int, std::pair<int, int> >, unsigned int> welded;
+		std::vector<unsigned int> grid((segments + 1) * (segments + 1));
+		for (int face = 0; face < 6; ++face)
+		{
+			glm::vec3 v = glm::cross(normals[face], us[face]);
+			for (int y = 0; y <= segments; ++y)
+			{
+				for (int x = 0; x <= segments; ++x)
+				{
+					float a = std::tan(((float)x / segments * 2.0f - 1.0f) * PI / 4.0f);
+					float b = std::tan(((float)y / segments * 2.0f - 1.0f) * PI / 4.0f);
+					glm::vec3 position = glm::normalize(normals[face] + a * us[face] + b * v);
+					std::pair<int, std::pair<int, int> > key((int)std::floor(position.x * 65536.0f + 0.5f),
+						std::make_pair((int)std::floor(position.y * 65536.0f + 0.5f), (int)std::floor(position.z * 65536.0f + 0.5f)));
+					std::map<std::pair<int, std::pair<int, int> >, unsigned int>::iterator found = welded.find(key);
+					if (found == welded.end())
+					{
+						found = welded.insert(std::make_pair(key, (unsigned int)mesh.VertexCount())).first;
+						addVertex(mesh, position, sphericalUV(position));
+					}
+					grid[y * (segments + 1) + x] = found->second;
+				}
+			}
+			for (int y = 0; y < segments; ++y)
+			{
+				for (int x = 0; x < segments; ++x)
+				{
+					unsigned int i00 = grid[y * (segments + 1) + x], i10 = grid[y * (segments + 1) + x + 1];
+					unsigned int i01 = grid[(y + 1) * (segments + 1) + x], i11 = grid[(y + 1) * (segments + 1) + x + 1];
+					// split along the shorter diagonal
+					if (glm::length(mesh.Position(i00) - mesh.Position(i11)) < glm::length(mesh.Position(i10) - mesh.Position(i01)))
+					{
+						addTriangle(mesh, i00, i10, i11);
+						addTriangle(mesh, i00, i11, i01);
+					}
+					else
+					{
+						addTriangle(mesh, i00, i10, i01);
+						addTriangle(mesh, i10, i11, i01);
+					}
+				}
+			}
+		}
+		return mesh;
+	}
+
+	// Reorders the triangles for the post-transform vertex cache with Forsyth's "Linear-Speed Vertex Cache
+	// Optimisation": greedily emits the triangle whose vertices score best, where a vertex scores for being recently
+	// used and for having few triangles left (so the optimizer finishes off vertices instead of leaving islands)
+	static void OptimizeVertexCache(MeshData& mesh)
+	{
+		const int CACHE_SIZE = 32;
+		int vertexCount = mesh.VertexCount();
+		int triangleCount = mesh.TriangleCount();
+		const std::vector<unsigned int>& indices = mesh.Indices;
+
+		// triangles of every vertex, the live ones first
+		std::vector<int> offsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < indices.size(); ++i)
+			++offsets[indices[i] + 1];
+		for (int v = 0; v < vertexCount; ++v)
+			offsets[v + 1] += offsets[v];
+		std::vector<int> remaining(vertexCount, 0);
+		std::vector<int> adjacency(indices.size());
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			unsigned int v = indices[i];
+			adjacency[offsets[v] + remaining[v]++] = (int)(i / 3);
+		}
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (int v = 0; v < vertexCount; ++v)
+			vertexScores[v] = vertexScore(cachePosition[v], remaining[v], CACHE_SIZE);
+		std::vector<float> triangleScores(triangleCount);
+		for (int t = 0; t < triangleCount; ++t)
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+		std::vector<int> cache, nextCache;
+		int best = -1;
+		int scan = 0;
+		for (int count = 0; count < triangleCount; ++count)
+		{
+			// no candidate next to the cache, take the best of the rest
+			if (best < 0)
+			{
+				float bestScore = -1.0f;
+				while (scan < triangleCount && emitted[scan])
+					++scan;
+				for (int t = scan; t < triangleCount; ++t)
+				{
+					if (!emitted[t] && triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						best = t;
+					}
+				}
+			}
+
+			emitted[best] = true;
+			nextCache.clear();
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				unsigned int v = indices[best * 3 + corner];
+				output.push_back(v);
+				nextCache.push_back((int)v);
+				// remove the triangle from the live triangles of the vertex
+				int* live = &adjacency[offsets[v]];
+				for (int i = 0; i < remaining[v]; ++i)
+				{
+					if (live[i] == best)
+					{
+						std::swap(live[i], live[remaining[v] - 1]);
+						--remaining[v];
+						break;
+					}
+				}
+			}
+			for (size_t i = 0; i < cache.size(); ++i)
+			{
+				if (std::find(nextCache.begin(), nextCache.end(), cache[i]) == nextCache.end())
+					nextCache.push_back(cache[i]);
+			}
+
+			// rescore the cached vertices (and the ones that fell out) and pick the best triangle among theirs
+			for (size_t i = 0; i < nextCache.size(); ++i)
+				cachePosition[nextCache[i]] = i < (size_t)CACHE_SIZE ? (int)i : -1;
+			best = -1;
+			float bestScore = -1.0f;
+			for (size_t i = 0; i < nextCache.size(); ++i)
+			{
+				int v = nextCache[i];
+				float score = vertexScore(cachePosition[v], remaining[v], CACHE_SIZE);
+				float delta = score - vertexScores[v];
+				vertexScores[v] = score;
+				for (int j = 0; j < remaining[v]; ++j)
+				{
+					int t = adjacency[offsets[v] + j];
+					triangleScores[t] += delta;
+					if (triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						best = t;
+					}
+				}
+			}
+			if (nextCache.size() > (size_t)CACHE_SIZE)
+				nextCache.resize(CACHE_SIZE);
+			cache.swap(nextCache);
+		}
+		mesh.Indices.swap(output);
+	}
+
+	// renumbers the vertices in the order the triangles first use them, so vertex fetches walk through memory
+	static void OptimizeVertexFetch(MeshData& mesh)
+	{
+		std::vector<int> remap(mesh.VertexCount(), -1);
+		std::vector<float> vertices;
+		vertices.reserve(mesh.Vertices.size());
+		for (size_t i = 0; i < mesh.Indices.size(); ++i)
+		{
+			unsigned int v = mesh.Indices[i];
+			if (remap[v] < 0)
+			{
+				remap[v] = (int)vertices.size() / 8;
+				vertices.insert(vertices.end(), mesh.Vertices.begin() + v * 8, mesh.Vertices.begin() + v * 8 + 8);
+			}
+			mesh.Indices[i] = (unsigned int)remap[v];
+		}
+		mesh.Vertices.swap(vertices);
+	}
+
+	// average cache miss ratio: vertex shader invocations per triangle with a FIFO post-transform cache of
+	// cacheSize vertices (0.5 is the limit for large regular meshes, 3 means no reuse at all)
+	static float ACMR(const MeshData& mesh, int cacheSize)
+	{
+		std::vector<int> insertedAt(mesh.VertexCount(), -1);
+		int misses = 0;
+		for (size_t i = 0; i < mesh.Indices.size(); ++i)
+		{
+			unsigned int v = mesh.Indices[i];
+			if (insertedAt[v] < 0 || misses - insertedAt[v] >= cacheSize)
+			{
+				insertedAt[v] = misses;
+				++misses;
+			}
+		}
+		return mesh.TriangleCount() > 0 ? (float)misses / mesh.TriangleCount() : 0.0f;
+	}
+
+	// largest distance of the mesh surface below the unit sphere, in units of the radius: the plane of a triangle
+	// cuts the sphere deepest at the middle of the triangle
+	static float SphereError(const MeshData& mesh)
+	{
+		float error = 0.0f;
+		for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+		{
+			glm::vec3 a = mesh.Position(mesh.Indices[i]);
+			glm::vec3 b = mesh.Position(mesh.Indices[i + 1]);
+			glm::vec3 c = mesh.Position(mesh.Indices[i + 2]);
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			if (glm::length(normal) < 1e-12f)
+				continue;
+			error = std::max(error, 1.0f - std::fabs(glm::dot(glm::normalize(normal), a)));
+		}
+		return error;
+	}
+
+private:
+
+	static void addVertex(MeshData& mesh, glm::vec3 position, glm::vec2 uv)
+	{
+		// on the unit sphere the normal is the position
+		float vertex[8] = { position.x, position.y, position.z, position.x, position.y, position.z, uv.x, uv.y };
+		mesh.Vertices.insert(mesh.Vertices.end(), vertex, vertex + 8);
+	}
+
+	// adds the triangle counter-clockwise seen from outside the sphere
+	static void addTriangle(MeshData& mesh, unsigned int a, unsigned int b, unsigned int c)
+	{
+		glm::vec3 pa = mesh.Position(a), pb = mesh.Position(b), pc = mesh.Position(c);
+		if (glm::dot(glm::cross(pb - pa, pc - pa), pa + pb + pc) < 0.0f)
+			std::swap(b, c);
+		mesh.Indices.push_back(a);
+		mesh.Indices.push_back(b);
+		mesh.Indices.push_back(c);
+	}
+
+	// the mapping of the UV sphere; the seam is not split, so it only suits untextured spheres
+	static glm::vec2 sphericalUV(glm::vec3 p)
+	{
+		const float PI = 3.14159265359f;
+		float u = std::atan2(p.z, p.x) / (2.0f * PI);
+		return glm::vec2(u < 0.0f ? u + 1.0f : u, std::acos(glm::clamp(p.y, -1.0f, 1.0f)) / PI);
+	}
+
+	static unsigned int midpoint(std::vector<glm::vec3>& positions, std::map<std::pair<unsigned int, unsigned int>, unsigned int>& midpoints, unsigned int a, unsigned int b)
+	{
+		std::pair<unsigned int, unsigned int> edge(std::min(a, b), std::max(a, b));
+		std::map<std::pair<unsigned int, unsigned int>, unsigned int>::iterator found = midpoints.find(edge);
+		if (found != midpoints.end())
+			return found->second;
+		positions.push_back(glm::normalize(positions[a] + positions[b]));
+		midpoints[edge] = (unsigned int)positions.size() - 1;
+		return (unsigned int)positions.size() - 1;
+	}
+
+	static float vertexScore(int cachePosition, int remainingTriangles, int cacheSize)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// the vertices of the last triangle get a fixed score, so it is not simply repeated in another order
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - (float)(cachePosition - 3) / (cacheSize - 3), 1.5f);
+		}
+		return score + 2.0f * std::pow((float)remainingTriangles, -0.5f);
+	}
+};
+
+// The LODs of the three sphere meshes, cache and fetch optimized, in one vertex and one index buffer shared by a
+// single vertex array; every LOD is a range of 16-bit indices drawn with a base vertex. Select() picks the coarsest
+// LOD whose deviation from the sphere stays below MaxPixelError at the size the sphere covers on screen.
+class SphereLODs
+{
+public:
+	enum Kind
+	{
+		UV_SPHERE,    // 4 to 128 segments, the 64 segment sphere of renderSphere() is LOD 4
+		ICOSPHERE,    // 0 to 5 subdivisions
+		CUBE_SPHERE,  // 1 to 32 segments per cube face
+		KIND_COUNT
+	};
+	static const int LOD_COUNT = 6;
+
+	struct LOD
+	{
+		int Triangles;
+		int Vertices;
+		float Error;   // largest deviation from the sphere in units of the radius
+		float ACMR;    // vertex shader invocations per triangle (32 entry FIFO cache)
+		size_t IndexOffset;
+		int BaseVertex;
+	};
+
+	float MaxPixelError;
+
+	SphereLODs(float maxPixelError = 0.5f) : MaxPixelError(maxPixelError)
+	{
+		std::vector<float> vertices;
+		std::vector<unsigned short> indices;
+		for (int kind = 0; kind < KIND_COUNT; ++kind)
+		{
+			for (int lod = 0; lod < LOD_COUNT; ++lod)
+			{
+				MeshData mesh = Build((Kind)kind, lod);
+				LOD& level = lods[kind][lod];
+				level.Triangles = mesh.TriangleCount();
+				level.Vertices = mesh.VertexCount();
+				level.Error = Geometry::SphereError(mesh);
+				level.ACMR = Geometry::ACMR(mesh, 32);
+				level.IndexOffset = indices.size() * sizeof(unsigned short);
+				level.BaseVertex = (int)vertices.size() / 8;
+				vertices.insert(vertices.end(), mesh.Vertices.begin(), mesh.Vertices.end());
+				indices.insert(indices.end(), mesh.Indices.begin(), mesh.Indices.end());
+			}
+		}
+
+		glGenVertexArrays(1, &vao);
+		glGenBuffers(1, &vbo);
+		glGenBuffers(1, &ebo);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0], GL_STATIC_DRAW);
+		unsigned int stride = 8 * sizeof(float);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+		glBindVertexArray(0);
+	}
+
+	~SphereLODs()
+	{
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		glDeleteBuffers(1, &ebo);
+	}
+
+	// the optimized mesh of a LOD, without a GL context
+	static MeshData Build(Kind kind, int lod)
+	{
+		MeshData mesh = kind == UV_SPHERE ? Geometry::UVSphere(4 << lod) : kind == ICOSPHERE ? Geometry::Icosphere(lod) : Geometry::CubeSphere(1 << lod);
+		// the greedy order can lose to the generated one on the smallest meshes, keep whichever is better
+		MeshData optimized = mesh;
+		Geometry::OptimizeVertexCache(optimized);
+		if (Geometry::ACMR(optimized, 32) < Geometry::ACMR(mesh, 32))
+			mesh.Indices.swap(optimized.Indices);
+		Geometry::OptimizeVertexFetch(mesh);
+		return mesh;
+	}
+
+	const LOD& Level(Kind kind, int lod) const
+	{
+		return lods[kind][lod];
+	}
+
+	// radius of a sphere on screen in pixels, for a perspective projection with the vertical field of view fovY
+	static float ProjectedRadius(glm::vec3 center, float radius, glm::vec3 cameraPosition, float fovY, float viewportHeight)
+	{
+		float distance = std::max(glm::length(center - cameraPosition), radius);
+		return radius / (distance * std::tan(fovY * 0.5f)) * viewportHeight * 0.5f;
+	}
+
+	// the same from a perspective projection matrix, e.g. the 90 degree one of a cubemap face
+	static float ProjectedRadius(glm::vec3 center, float radius, glm::vec3 cameraPosition, const glm::mat4& projection, float viewportHeight)
+	{
+		float distance = std::max(glm::length(center - cameraPosition), radius);
+		return radius * projection[1][1] / distance * viewportHeight * 0.5f;
+	}
+
+	int Select(Kind kind, float projectedRadius) const
+	{
+		for (int lod = 0; lod < LOD_COUNT - 1; ++lod)
+		{
+			if (lods[kind][lod].Error * projectedRadius <= MaxPixelError)
+				return lod;
+		}
+		return LOD_COUNT - 1;
+	}
+
+	// one LOD for a whole instanced draw of unit spheres: the one the instance closest to the camera needs
+	int SelectInstanced(Kind kind, const std::vector<PBRInstance>& instances, glm::vec3 cameraPosition, float fovY, float viewportHeight) const
+	{
+		float largest = 0.0f;
+		for (size_t i = 0; i < instances.size(); ++i)
+			largest = std::max(largest, ProjectedRadius(glm::vec3(instances[i].Model[3]), 1.0f, cameraPosition, fovY, viewportHeight));
+		return Select(kind, largest);
+	}
+
+	// draws one sphere, or instances [first, first + count) of the buffer (all of them from first if count < 0)
+	void Draw(Kind kind, int lod, const InstanceBuffer* instances = NULL, int first = 0, int count = -1) const
+	{
+		const LOD& level = lods[kind][lod];
+		glBindVertexArray(vao);
+		if (instances)
+		{
+			instances->Attach(vao, first);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, level.Triangles * 3, GL_UNSIGNED_SHORT, (void*)level.IndexOffset,
+				count < 0 ? instances->Count - first : count, level.BaseVertex);
+		}
+		else
+			glDrawElementsBaseVertex(GL_TRIANGLES, level.Triangles * 3, GL_UNSIGNED_SHORT, (void*)level.IndexOffset, level.BaseVertex);
+		glBindVertexArray(0);
+	}
+
+private:
+
+	LOD lods[KIND_COUNT][LOD_COUNT];
+	unsigned int vao, vbo, ebo;
+
+	SphereLODs(const SphereLODs&);
+	SphereLODs& operator=(const SphereLODs&);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+// Measures the GPU time spent between Begin() and End() with GL_TIME_ELAPSED queries.
+// Results are read back a few frames later from a small ring of queries, so timing never stalls the pipeline.
+// Only one timer can be running at a time (GL does not allow nested GL_TIME_ELAPSED queries).
+class GpuTimer
+{
+	static const int QUERY_COUNT = 4;
+public:
+
+	// smoothed time of the most recent results, in milliseconds
+	float Milliseconds;
+
+	GpuTimer() : Milliseconds(0.0f), current(0), totalMs(0.0), samples(0)
+	{
+		glGenQueries(QUERY_COUNT, queries);
+		for (int i = 0; i < QUERY_COUNT; ++i)
+			pending[i] = false;
+	}
+
+	~GpuTimer()
+	{
+		glDeleteQueries(QUERY_COUNT, queries);
+	}
+
+	void Begin()
+	{
+		// ring is full, wait for the oldest result instead of overwriting it
+		if (pending[current])
+			collect(current, true);
+		glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+	}
+
+	void End()
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		pending[current] = true;
+		current = (current + 1) % QUERY_COUNT;
+
+		for (int i = 0; i < QUERY_COUNT; ++i)
+		{
+			int index = (current + i) % QUERY_COUNT;
+			if (pending[index])
+				collect(index, false);
+		}
+	}
+
+	// average over all results since the last Reset(), used for benchmarks
+	float Average() const
+	{
+		return samples > 0 ? (float)(totalMs / samples) : 0.0f;
+	}
+
+	int Samples() const
+	{
+		return samples;
+	}
+
+	void Reset()
+	{
+		totalMs = 0.0;
+		samples = 0;
+	}
+
+private:
+
+	unsigned int queries[QUERY_COUNT];
+	bool pending[QUERY_COUNT];
+	int current;
+	double totalMs;
+	int samples;
+
+	void collect(int index, bool wait)
+	{
+		GLint available = 0;
+		if (!wait)
+		{
+			glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return;
+		}
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &elapsed);
+		pending[index] = false;
+
+		float ms = (float)(elapsed / 1000000.0);
+		Milliseconds = samples == 0 && Milliseconds == 0.0f ? ms : Milliseconds * 0.9f + ms * 0.1f;
+		totalMs += ms;
+		++samples;
+	}
+
+	// owns GL queries
+	GpuTimer(const GpuTimer&);
+	GpuTimer& operator=(const GpuTimer&);
+};
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef HDR_IMAGE_H
+#define HDR_IMAGE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HDR_IMAGE_SSE2 1
+#endif
+
+// Radiance .hdr (RGBE) reader that decodes straight to the half floats the demos upload as GL_RGB16F, instead of
+// going through stbi_loadf's 32 bit float RGB:
+//  1. Open() maps the file and walks the run-length encoded scanlines once to find where each one starts; skipping
+//     runs is much cheaper than decoding them, and it is the only part that has to be serial
+//  2. DecodeHalf() decodes chunks of scanlines in parallel, each one into a small RGBE buffer that RGBEToHalf()
+//     converts with SSE2, four components per register, into RGBA half floats
+//  3. LoadTexture() runs DecodeHalf() on a mapped pixel unpack buffer, so the rows go from the file mapping to
+//     the buffer the texture is uploaded from without another copy
+// Rows come out bottom row first, like stbi_loadf after stbi_set_flip_vertically_on_load(true). Only the standard
+// "-Y height +X width" orientation is supported, as in stb_image.
+class HDRImage
+{
+public:
+
+	int Width;
+	int Height;
+	size_t FileBytes;
+
+	HDRImage() : Width(0), Height(0), FileBytes(0), data(NULL), pixelsOffset(0)
+	{
+#ifdef _WIN32
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+#endif
+	}
+
+	~HDRImage()
+	{
+		Close();
+	}
+
+	// maps the file, parses the header and finds the scanlines; false when it is not a valid RGBE file
+	bool Open(const std::string& path)
+	{
+		Close();
+		if (!mapFile(path) || !parseHeader() || !findScanlines())
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+		if (data)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+#else
+			munmap((void*)data, FileBytes);
+#endif
+		}
+#ifdef _WIN32
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+#endif
+		data = NULL;
+		FileBytes = 0;
+		Width = Height = 0;
+		scanlines.clear();
+	}
+
+	// decodes the opened image into Width * Height RGBA half floats (alpha 1), bottom row first. Open() already
+	// validated every run, so this can't fail
+	void DecodeHalf(ThreadPool& pool, unsigned short* rgba) const
+	{
+		const int rowsPerChunk = 16;
+		pool.ParallelFor((Height + rowsPerChunk - 1) / rowsPerChunk, [&](int chunk)
+		{
+			std::vector<unsigned char> rgbe((size_t)Width * 4);
+			int last = std::min((chunk + 1) * rowsPerChunk, Height);
+			for (int y = chunk * rowsPerChunk; y < last; ++y)
+			{
+				decodeScanline(y, &rgbe[0]);
+				RGBEToHalf(&rgbe[0], Width, rgba + (size_t)(Height - 1 - y) * Width * 4);
+			}
+		});
+	}
+
+	// converts count RGBE pixels to RGBA half floats: m * 2^(e - 136) per channel, zero when e is 0, clamped to the
+	// largest half; rounds to nearest even like glm::packHalf1x16
+	static void RGBEToHalf(const unsigned char* rgbe, int count, unsigned short* rgba)
+	{
+		int i = 0;
+#ifdef HDR_IMAGE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set_epi32(-1, 0, 0, 0);
+		const __m128 halfMax = _mm_set1_ps(65504.0f);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(rgbe + i * 4));
+			__m128i low = _mm_unpacklo_epi8(bytes, zero);
+			__m128i high = _mm_unpackhi_epi8(bytes, zero);
+			__m128i h0 = pixelToHalf(_mm_unpacklo_epi16(low, zero), alphaMask, halfMax);
+			__m128i h1 = pixelToHalf(_mm_unpackhi_epi16(low, zero), alphaMask, halfMax);
+			__m128i h2 = pixelToHalf(_mm_unpacklo_epi16(high, zero), alphaMask, halfMax);
+			__m128i h3 = pixelToHalf(_mm_unpackhi_epi16(high, zero), alphaMask, halfMax);
+			// halves are at most 0x7bff, so the signed saturating pack keeps them intact
+			_mm_storeu_si128((__m128i*)(rgba + i * 4), _mm_packs_epi32(h0, h1));
+			_mm_storeu_si128((__m128i*)(rgba + i * 4 + 8), _mm_packs_epi32(h2, h3));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			const unsigned char* pixel = rgbe + i * 4;
+			float scale = pixel[3] ? std::ldexp(1.0f, pixel[3] - 136) : 0.0f;
+			for (int c = 0; c < 3; ++c)
+				rgba[i * 4 + c] = glm::packHalf1x16(std::min(pixel[c] * scale, 65504.0f));
+			rgba[i * 4 + 3] = 0x3c00;
+		}
+	}
+
+	// decodes the file into a GL_RGB16F texture through a pixel unpack buffer, 0 when the file can't be read
+	static unsigned int LoadTexture(const std::string& path, ThreadPool* pool = NULL)
+	{
+		if (!pool)
+		{
+			ThreadPool localPool;
+			return LoadTexture(path, &localPool);
+		}
+		HDRImage image;
+		if (!image.Open(path))
+			return 0;
+
+		size_t bytes = (size_t)image.Width * image.Height * 4 * sizeof(unsigned short);
+		unsigned int buffer;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+		void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (target)
+			image.DecodeHalf(*pool, (unsigned short*)target);
+		// the buffer contents are undefined when unmapping fails
+		bool decoded = target && glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+
+		unsigned int texture = 0;
+		if (decoded)
+		{
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, image.Width, image.Height, 0, GL_RGBA, GL_HALF_FLOAT, (void*)0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+		return texture;
+	}
+
+private:
+
+	const unsigned char* data;
+	std::vector<size_t> scanlines;   // offset of every scanline in the file, top row first
+	size_t pixelsOffset;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+
+	// no copies, the mapping is owned
+	HDRImage(const HDRImage&);
+	HDRImage& operator=(const HDRImage&);
+
+	bool mapFile(const std::string& path)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+			return false;
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping)
+			return false;
+		data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		FileBytes = data ? (size_t)size.QuadPart : 0;
+		return data != NULL;
+#else
+		int descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			return false;
+		struct stat status;
+		void* view = MAP_FAILED;
+		if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+			view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+		if (view == MAP_FAILED)
+			return false;
+		madvise(view, (size_t)status.st_size, MADV_SEQUENTIAL);
+		data = (const unsigned char*)view;
+		FileBytes = (size_t)status.st_size;
+		return true;
+#endif
+	}
+
+	// "#?RADIANCE" (or "#?RGBE"), header lines up to an empty line, then "-Y height +X width"
+	bool parseHeader()
+	{
+		size_t pos = 0;
+		std::string line;
+		if (!readLine(pos, line) || (line != "#?RADIANCE" && line != "#?RGBE"))
+			return false;
+		bool rgbe = false;
+		while (readLine(pos, line) && !line.empty())
+		{
+			if (line == "FORMAT=32-bit_rle_rgbe")
+				rgbe = true;
+		}
+		if (!rgbe || !readLine(pos, line))
+			return false;
+		if (sscanf(line.c_str(), "-Y %d +X %d", &Height, &Width) != 2 || Width <= 0 || Height <= 0)
+			return false;
+		pixelsOffset = pos;
+		return true;
+	}
+
+	bool readLine(size_t& pos, std::string& line) const
+	{
+		size_t end = pos;
+		while (end < FileBytes && data[end] != '\n')
+			++end;
+		if (end >= FileBytes)
+			return false;
+		line.assign((const char*)data + pos, end - pos);
+		pos = end + 1;
+		return true;
+	}
+
+	// new style run-length encoded scanlines start with 2, 2 and the width; anything else is a flat scanline
+	bool isEncoded(size_t pos) const
+	{
+		return Width >= 8 && Width < 32768 && pos + 4 <= FileBytes && data[pos] == 2 && data[pos + 1] == 2 &&
+			(data[pos + 2] & 0x80) == 0 && ((data[pos + 2] << 8) | data[pos + 3]) == Width;
+	}
+
+	// walks the runs of every scanline without decoding them, the four channels of a scanline are encoded one
+	// after the other: a count byte > 128 repeats the next byte count - 128 times, otherwise count bytes follow
+	bool findScanlines()
+	{
+		scanlines.resize(Height);
+		size_t pos = pixelsOffset;
+		for (int y = 0; y < Height; ++y)
+		{
+			scanlines[y] = pos;
+			if (!isEncoded(pos))
+			{
+				pos += (size_t)Width * 4;
+				if (pos > FileBytes)
+					return false;
+				continue;
+			}
+			pos += 4;
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				int x = 0;
+				while (x < Width)
+				{
+					if (pos >= FileBytes)
+						return false;
+					int count = data[pos++];
+					if (count > 128)
+					{
+						count -= 128;
+						pos += 1;
+					}
+					else
+						pos += count;
+					if (count == 0 || x + count > Width)
+						return false;
+					x += count;
+				}
+			}
+			if (pos > FileBytes)
+				return false;
+		}
+		return true;
+	}
+
+	// decodes scanline y (top row first) into Width RGBE pixels
+	void decodeScanline(int y, unsigned char* rgbe) const
+	{
+		size_t pos = scanlines[y];
+		if (!isEncoded(pos))
+		{
+			memcpy(rgbe, data + pos, (size_t)Width * 4);
+			return;
+		}
+		pos += 4;
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			unsigned char* out = rgbe + channel;
+			int x = 0;
+			while (x < Width)
+			{
+				int count = data[pos++];
+				if (count > 128)
+				{
+					count -= 128;
+					unsigned char value = data[pos++];
+					for (int i = 0; i < count; ++i)
+						out[(x + i) * 4] = value;
+				}
+				else
+				{
+					for (int i = 0; i < count; ++i)
+						out[(x + i) * 4] = data[pos + i];
+					pos += count;
+				}
+				x += count;
+			}
+		}
+	}
+
+#ifdef HDR_IMAGE_SSE2
+	// one RGBE pixel in four 32 bit lanes to RGBA halves in the low 16 bits of each lane: the scale 2^(e - 136) is
+	// built directly as float bits, then the float to half conversion of Giesen's float_to_half_fast3 for positive,
+	// finite values (subnormal halves through a magic number add, normal ones by rebiasing and rounding the exponent)
+	static __m128i pixelToHalf(__m128i pixel, __m128i alphaMask, __m128 halfMax)
+	{
+		__m128i exponent = _mm_sub_epi32(_mm_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3)), _mm_set1_epi32(9));
+		// e < 10 would be a float denormal, far below the smallest half, so it becomes 0 like e = 0
+		__m128 scale = _mm_and_ps(_mm_castsi128_ps(_mm_slli_epi32(exponent, 23)), _mm_castsi128_ps(_mm_cmpgt_epi32(exponent, _mm_setzero_si128())));
+		__m128 value = _mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(pixel), scale), halfMax);
+
+		const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+		const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+		const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+		__m128i bits = _mm_castps_si128(value);
+		__m128i isSubnormal = _mm_cmpgt_epi32(minNormal, bits);
+		__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(value, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+		__m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+		__m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, normalBias), mantissaOdd), 13);
+		__m128i half = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+		// alpha = 1.0
+		return _mm_or_si128(_mm_andnot_si128(alphaMask, half), _mm_and_si128(alphaMask, _mm_set1_epi32(0x3c00)));
+	}
+#endif
+};
+
+#endif
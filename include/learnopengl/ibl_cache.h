@@ -0,0 +1,386 @@
+#ifndef IBL_CACHE_H
+#define IBL_CACHE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <learnopengl/filesystem.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// bump when the bake shaders or the file layout change, older cache files are then rebaked
+const unsigned int IBL_CACHE_VERSION = 2;
+
+// On-disk cache of the image based lighting maps baked from one HDR environment: environment cubemap, irradiance
+// map and pre-filtered specular mips. The file sits next to the HDR file (<hdr>.ibl) and holds every face
+// and mip level as tightly packed half floats, so a cache hit skips decoding the HDR file and all convolution passes.
+//  1. Add() every map the demo uses, with the format, size and mip count it bakes them at
+//  2. Load() returns true when the cache holds all of them for the current contents of the HDR file, Texture() then
+//     gives the uploaded maps; the whole data block is read into one pixel unpack buffer and uploaded from there
+//  3. otherwise bake as usual, hand the textures over with SetTexture() and Save() them for the next startup
+//
+// The key is a hash of the HDR file contents, so a changed environment is rebaked without deleting anything. Maps
+// are stored by name and Save() keeps the maps other demos stored for the same file, so the irradiance demo and the
+// specular demos share one cache.
+class IBLCache
+{
+public:
+
+	std::string CachePath;
+	size_t FileBytes;   // size of the cache file after the last successful Load() or Save()
+
+	IBLCache(const std::string& hdrPath)
+		: CachePath(FileSystem::getPath(hdrPath) + ".ibl"), FileBytes(0), sourcePath(FileSystem::getPath(hdrPath)),
+		  sourceHash(0), sourceHashed(false)
+	{
+	}
+
+	// declares a map, target is GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D and format the client format of the stored
+	// texels (GL_RGB, GL_RG, ...); returns the index for Texture() / SetTexture()
+	int Add(const char* name, GLenum target, GLenum internalFormat, GLenum format, int size, int levels)
+	{
+		MapHeader map;
+		memset(&map, 0, sizeof(map));
+		strncpy(map.Name, name, sizeof(map.Name) - 1);
+		map.Target = target;
+		map.InternalFormat = internalFormat;
+		map.Format = format;
+		map.Size = size;
+		map.Levels = levels;
+		map.Bytes = mapBytes(map);
+		maps.push_back(map);
+		textures.push_back(0);
+		return (int)maps.size() - 1;
+	}
+
+	unsigned int Texture(int map) const
+	{
+		return textures[map];
+	}
+
+	void SetTexture(int map, unsigned int texture)
+	{
+		textures[map] = texture;
+	}
+
+	// creates the textures of all declared maps from the cache file, false on a miss (no file, another HDR file
+	// contents, a different version or a map that is missing or was stored with another format, size or mip count)
+	bool Load()
+	{
+		if (!hashSource())
+			return false;
+		FILE* file = fopen(CachePath.c_str(), "rb");
+		if (!file)
+			return false;
+
+		std::vector<MapHeader> stored;
+		bool hit = readHeader(file, stored);
+		std::vector<uint64_t> offsets(maps.size(), 0);
+		uint64_t begin = ~(uint64_t)0;
+		uint64_t end = 0;
+		for (size_t i = 0; hit && i < maps.size(); ++i)
+		{
+			const MapHeader* found = find(stored, maps[i].Name);
+			hit = found && found->Target == maps[i].Target && found->InternalFormat == maps[i].InternalFormat &&
+				found->Format == maps[i].Format && found->Size == maps[i].Size && found->Levels == maps[i].Levels &&
+				found->Bytes == maps[i].Bytes;
+			if (!hit)
+				break;
+			offsets[i] = found->Offset;
+			begin = found->Offset < begin ? found->Offset : begin;
+			end = found->Offset + found->Bytes > end ? found->Offset + found->Bytes : end;
+		}
+
+		// one read straight into a mapped unpack buffer, then every face and level is uploaded from an offset into it;
+		// maps of other demos between the ones we need are read along, which is cheaper than seeking around them
+		unsigned int pbo = 0;
+		if (hit && end > begin)
+		{
+			glGenBuffers(1, &pbo);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)(end - begin), NULL, GL_STREAM_DRAW);
+			void* data = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+			hit = data && fseek(file, (long)begin, SEEK_SET) == 0 && fread(data, 1, (size_t)(end - begin), file) == end - begin;
+			if (data && glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+				hit = false;
+		}
+		if (hit)
+		{
+			fseek(file, 0, SEEK_END);
+			FileBytes = (size_t)ftell(file);
+		}
+		fclose(file);
+
+		if (hit)
+		{
+			GLint alignment;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			for (size_t i = 0; i < maps.size(); ++i)
+				textures[i] = createTexture(maps[i], offsets[i] - begin);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+		}
+		if (pbo)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &pbo);
+		}
+		return hit;
+	}
+
+	// reads the textures of all declared maps back and writes the cache file, keeping the maps of other demos that
+	// were stored for the same HDR file contents
+	bool Save()
+	{
+		if (!hashSource())
+			return false;
+
+		// maps of other demos stored under the same key
+		std::vector<MapHeader> kept;
+		std::vector<std::vector<unsigned char> > keptData;
+		FILE* file = fopen(CachePath.c_str(), "rb");
+		if (file)
+		{
+			std::vector<MapHeader> stored;
+			if (readHeader(file, stored))
+			{
+				for (size_t i = 0; i < stored.size(); ++i)
+				{
+					if (find(maps, stored[i].Name))
+						continue;
+					std::vector<unsigned char> data((size_t)stored[i].Bytes);
+					if (fseek(file, (long)stored[i].Offset, SEEK_SET) != 0 || fread(data.data(), 1, data.size(), file) != data.size())
+						continue;
+					kept.push_back(stored[i]);
+					keptData.push_back(data);
+				}
+			}
+			fclose(file);
+		}
+
+		// read the baked maps back as half floats, level by level and face by face
+		std::vector<MapHeader> written(maps);
+		std::vector<std::vector<unsigned char> > writtenData(maps.size());
+		GLint alignment;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		for (size_t i = 0; i < maps.size(); ++i)
+		{
+			const MapHeader& map = maps[i];
+			writtenData[i].resize((size_t)map.Bytes);
+			unsigned char* data = writtenData[i].data();
+			glBindTexture(map.Target, textures[i]);
+			for (unsigned int level = 0; level < map.Levels; ++level)
+			{
+				for (unsigned int face = 0; face < faceCount(map); ++face)
+				{
+					glGetTexImage(faceTarget(map, face), level, map.Format, GL_HALF_FLOAT, data);
+					data += levelBytes(map, level);
+				}
+			}
+			glBindTexture(map.Target, 0);
+		}
+		glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+		written.insert(written.end(), kept.begin(), kept.end());
+		writtenData.insert(writtenData.end(), keptData.begin(), keptData.end());
+
+		FileHeader header;
+		memcpy(header.Magic, "LOGLIBL", 8);
+		header.Version = IBL_CACHE_VERSION;
+		header.MapCount = (uint32_t)written.size();
+		header.SourceHash = sourceHash;
+		uint64_t offset = sizeof(FileHeader) + written.size() * sizeof(MapHeader);
+		for (size_t i = 0; i < written.size(); ++i)
+		{
+			written[i].Offset = offset;
+			offset += written[i].Bytes;
+		}
+
+		file = fopen(CachePath.c_str(), "wb");
+		if (!file)
+			return false;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(written.data(), sizeof(MapHeader), written.size(), file) == written.size();
+		for (size_t i = 0; ok && i < writtenData.size(); ++i)
+			ok = fwrite(writtenData[i].data(), 1, writtenData[i].size(), file) == writtenData[i].size();
+		ok = fclose(file) == 0 && ok;
+		if (!ok)
+			remove(CachePath.c_str());
+		FileBytes = ok ? (size_t)offset : 0;
+		return ok;
+	}
+
+	// GL free read of one stored map as float texels in the file layout (levels outer, faces inner), for tools that
+	// compare against the GPU bake; false when the cache holds no map of that name for the current HDR file contents
+	bool ReadMap(const char* name, std::vector<float>& texels, int& size, int& levels, int& channels)
+	{
+		if (!hashSource())
+			return false;
+		FILE* file = fopen(CachePath.c_str(), "rb");
+		if (!file)
+			return false;
+		std::vector<MapHeader> stored;
+		const MapHeader* map = readHeader(file, stored) ? find(stored, name) : NULL;
+		std::vector<uint16_t> halves;
+		bool ok = map && fseek(file, (long)map->Offset, SEEK_SET) == 0;
+		if (ok)
+		{
+			halves.resize((size_t)map->Bytes / 2);
+			ok = fread(halves.data(), 2, halves.size(), file) == halves.size();
+		}
+		fclose(file);
+		if (!ok)
+			return false;
+
+		size = map->Size;
+		levels = map->Levels;
+		channels = (int)(levelBytes(*map, 0) / ((uint64_t)size * size * 2));
+		texels.resize(halves.size());
+		for (size_t i = 0; i < halves.size(); ++i)
+			texels[i] = glm::unpackHalf1x16(halves[i]);
+		return true;
+	}
+
+	// number of levels of a full mip chain down to 1x1
+	static int MipCount(int size)
+	{
+		int levels = 1;
+		while (size > 1)
+		{
+			size /= 2;
+			++levels;
+		}
+		return levels;
+	}
+
+private:
+
+	// file layout: FileHeader, MapCount MapHeaders, then the data of every map (levels outer, faces inner, rows
+	// tightly packed); both structs are free of implicit padding so they are read and written as is
+	struct FileHeader
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t MapCount;
+		uint64_t SourceHash;
+	};
+
+	struct MapHeader
+	{
+		char Name[32];
+		uint32_t Target;
+		uint32_t InternalFormat;
+		uint32_t Format;
+		uint32_t Size;
+		uint32_t Levels;
+		uint32_t Reserved;
+		uint64_t Offset;    // from the start of the file
+		uint64_t Bytes;
+	};
+
+	std::vector<MapHeader> maps;
+	std::vector<unsigned int> textures;
+	std::string sourcePath;
+	uint64_t sourceHash;
+	bool sourceHashed;
+
+	// 64-bit FNV-1a of the HDR file, a few milliseconds for a typical environment and far below the cost of a bake
+	bool hashSource()
+	{
+		if (sourceHashed)
+			return true;
+		FILE* file = fopen(sourcePath.c_str(), "rb");
+		if (!file)
+			return false;
+		uint64_t hash = 14695981039346656037ull;
+		unsigned char buffer[65536];
+		size_t count;
+		while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			for (size_t i = 0; i < count; ++i)
+				hash = (hash ^ buffer[i]) * 1099511628211ull;
+		}
+		fclose(file);
+		sourceHash = hash;
+		sourceHashed = true;
+		return true;
+	}
+
+	bool readHeader(FILE* file, std::vector<MapHeader>& stored) const
+	{
+		FileHeader header;
+		if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.Magic, "LOGLIBL", 8) != 0 ||
+			header.Version != IBL_CACHE_VERSION || header.SourceHash != sourceHash || header.MapCount > 64)
+			return false;
+		stored.resize(header.MapCount);
+		return header.MapCount == 0 || fread(stored.data(), sizeof(MapHeader), stored.size(), file) == stored.size();
+	}
+
+	static const MapHeader* find(const std::vector<MapHeader>& list, const char* name)
+	{
+		for (size_t i = 0; i < list.size(); ++i)
+			if (strncmp(list[i].Name, name, sizeof(list[i].Name)) == 0)
+				return &list[i];
+		return NULL;
+	}
+
+	static unsigned int faceCount(const MapHeader& map)
+	{
+		return map.Target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+	}
+
+	static GLenum faceTarget(const MapHeader& map, unsigned int face)
+	{
+		return map.Target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : map.Target;
+	}
+
+	static uint64_t levelBytes(const MapHeader& map, unsigned int level)
+	{
+		uint64_t size = map.Size >> level > 0 ? map.Size >> level : 1;
+		uint64_t channels = map.Format == GL_RGBA ? 4 : map.Format == GL_RGB ? 3 : map.Format == GL_RG ? 2 : 1;
+		return size * size * channels * 2;
+	}
+
+	static uint64_t mapBytes(const MapHeader& map)
+	{
+		uint64_t bytes = 0;
+		for (unsigned int level = 0; level < map.Levels; ++level)
+			bytes += levelBytes(map, level) * faceCount(map);
+		return bytes;
+	}
+
+	// expects the unpack buffer holding the data to be bound, offset is relative to its start
+	static unsigned int createTexture(const MapHeader& map, uint64_t offset)
+	{
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(map.Target, texture);
+		for (unsigned int level = 0; level < map.Levels; ++level)
+		{
+			int size = map.Size >> level > 0 ? map.Size >> level : 1;
+			for (unsigned int face = 0; face < faceCount(map); ++face)
+			{
+				glTexImage2D(faceTarget(map, face), level, map.InternalFormat, size, size, 0, map.Format, GL_HALF_FLOAT, (void*)(size_t)offset);
+				offset += levelBytes(map, level);
+			}
+		}
+		glTexParameteri(map.Target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(map.Target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		if (map.Target == GL_TEXTURE_CUBE_MAP)
+			glTexParameteri(map.Target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(map.Target, GL_TEXTURE_MIN_FILTER, map.Levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(map.Target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// the pre-filter map stores fewer levels than a full chain, limit sampling to the stored ones
+		glTexParameteri(map.Target, GL_TEXTURE_MAX_LEVEL, map.Levels - 1);
+		glBindTexture(map.Target, 0);
+		return texture;
+	}
+};
+
+#endif
@@ -0,0 +1,480 @@
+#ifndef IBL_REFERENCE_H
+#define IBL_REFERENCE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/thread_pool.h>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define IBL_REFERENCE_SSE 1
+#endif
+
+// RGBA float cubemap with a mip chain: levels outer, faces (+X, -X, +Y, -Y, +Z, -Z) inner, each face stored row by
+// row with row 0 at t = -1, the layout glGetTexImage returns (and IBLCache stores).
+struct CubeImage
+{
+	int Size;
+	int Levels;
+	std::vector<float> Texels;
+
+	CubeImage() : Size(0), Levels(0)
+	{
+	}
+
+	void Allocate(int size, int levels)
+	{
+		Size = size;
+		Levels = levels;
+		offsets.assign(levels + 1, 0);
+		for (int level = 0; level < levels; ++level)
+			offsets[level + 1] = offsets[level] + (size_t)6 * LevelSize(level) * LevelSize(level) * 4;
+		Texels.assign(offsets[levels], 0.0f);
+	}
+
+	int LevelSize(int level) const
+	{
+		return std::max(Size >> level, 1);
+	}
+
+	float* Face(int level, int face)
+	{
+		return &Texels[offsets[level] + (size_t)face * LevelSize(level) * LevelSize(level) * 4];
+	}
+
+	const float* Face(int level, int face) const
+	{
+		return &Texels[offsets[level] + (size_t)face * LevelSize(level) * LevelSize(level) * 4];
+	}
+
+	// direction through the center of texel (x, y) of a face at the given size, the inverse of the face selection below
+	static glm::vec3 TexelDirection(int face, int x, int y, int size)
+	{
+		float s = (x + 0.5f) * 2.0f / size - 1.0f;
+		float t = (y + 0.5f) * 2.0f / size - 1.0f;
+		switch (face)
+		{
+		case 0: return glm::normalize(glm::vec3(1.0f, -t, -s));
+		case 1: return glm::normalize(glm::vec3(-1.0f, -t, s));
+		case 2: return glm::normalize(glm::vec3(s, 1.0f, t));
+		case 3: return glm::normalize(glm::vec3(s, -1.0f, -t));
+		case 4: return glm::normalize(glm::vec3(s, -t, 1.0f));
+		default: return glm::normalize(glm::vec3(-s, -t, -1.0f));
+		}
+	}
+
+	// bilinear lookup of one level with the OpenGL face selection; filtering stops at the face edge where the GPU
+	// (GL_TEXTURE_CUBE_MAP_SEAMLESS) blends across, which only shows up in the outermost texel ring
+	glm::vec4 SampleLevel(const glm::vec3& v, int level) const
+	{
+		glm::vec3 a = glm::abs(v);
+		int face;
+		float sc, tc, ma;
+		if (a.x >= a.y && a.x >= a.z)
+		{
+			face = v.x > 0.0f ? 0 : 1;
+			sc = v.x > 0.0f ? -v.z : v.z;
+			tc = -v.y;
+			ma = a.x;
+		}
+		else if (a.y >= a.z)
+		{
+			face = v.y > 0.0f ? 2 : 3;
+			sc = v.x;
+			tc = v.y > 0.0f ? v.z : -v.z;
+			ma = a.y;
+		}
+		else
+		{
+			face = v.z > 0.0f ? 4 : 5;
+			sc = v.z > 0.0f ? v.x : -v.x;
+			tc = -v.y;
+			ma = a.z;
+		}
+		int size = LevelSize(level);
+		float x = (0.5f * (sc / ma + 1.0f)) * size - 0.5f;
+		float y = (0.5f * (tc / ma + 1.0f)) * size - 0.5f;
+		return Bilinear(Face(level, face), size, size, x, y);
+	}
+
+	// trilinear lookup, like textureLod on a GL_LINEAR_MIPMAP_LINEAR cubemap
+	glm::vec4 Sample(const glm::vec3& v, float lod) const
+	{
+		lod = glm::clamp(lod, 0.0f, (float)(Levels - 1));
+		int level = (int)lod;
+		float blend = lod - level;
+		glm::vec4 result = SampleLevel(v, level);
+		if (blend > 0.0f && level + 1 < Levels)
+			result = glm::mix(result, SampleLevel(v, level + 1), blend);
+		return result;
+	}
+
+	// bilinear lookup of an RGBA float image with clamp to edge, (x, y) in texel units with texel centers at integers
+	static glm::vec4 Bilinear(const float* texels, int width, int height, float x, float y)
+	{
+		x = glm::clamp(x, 0.0f, (float)(width - 1));
+		y = glm::clamp(y, 0.0f, (float)(height - 1));
+		int x0 = (int)x;
+		int y0 = (int)y;
+		int x1 = std::min(x0 + 1, width - 1);
+		int y1 = std::min(y0 + 1, height - 1);
+		float fx = x - x0;
+		float fy = y - y0;
+		const float* t00 = texels + ((size_t)y0 * width + x0) * 4;
+		const float* t10 = texels + ((size_t)y0 * width + x1) * 4;
+		const float* t01 = texels + ((size_t)y1 * width + x0) * 4;
+		const float* t11 = texels + ((size_t)y1 * width + x1) * 4;
+#ifdef IBL_REFERENCE_SSE
+		__m128 top = _mm_add_ps(_mm_loadu_ps(t00), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(t10), _mm_loadu_ps(t00)), _mm_set1_ps(fx)));
+		__m128 bottom = _mm_add_ps(_mm_loadu_ps(t01), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(t11), _mm_loadu_ps(t01)), _mm_set1_ps(fx)));
+		__m128 mixed = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(fy)));
+		glm::vec4 result;
+		_mm_storeu_ps(&result[0], mixed);
+		return result;
+#else
+		glm::vec4 top = glm::mix(glm::make_vec4(t00), glm::make_vec4(t10), fx);
+		glm::vec4 bottom = glm::mix(glm::make_vec4(t01), glm::make_vec4(t11), fx);
+		return glm::mix(top, bottom, fy);
+#endif
+	}
+
+private:
+
+	std::vector<size_t> offsets;
+};
+
+// CPU implementation of the IBL precomputation of the 6.pbr demos, for baking and regression testing without a GPU.
+// Every pass follows its shader in 2.2.3.ibl_specular_model step by step (same sample sets, same mip selection), so
+// the results match the GPU bake up to half float storage and the filtering at cubemap seams:
+//  - EquirectToCube()  2.2.3.equirectangular_to_cubemap.fs, plus the box filtered mips of glGenerateMipmap
+//  - Irradiance()      2.2.3.irradiance_convolution.fs, the sampleDelta = 0.025 Riemann sum over the hemisphere
+//  - Prefilter()       2.2.3.prefilter.fs, GGX importance sampling on the Hammersley set with PDF based source mips
+//                      (filtered importance sampling) and a sample count per roughness level
+//  - BRDFLut()         the split sum scale and bias, the source of brdf_lut_table.h
+// Work is split into rows of one face and mip level and spread over a ThreadPool. Everything that only depends on
+// the sample index (Hammersley points, tangent space directions, weights, source mips) is computed once per pass
+// instead of per texel, and the BRDF LUT evaluates four texels at a time in SSE registers.
+class IBLReference
+{
+public:
+
+	explicit IBLReference(ThreadPool& pool) : pool(pool)
+	{
+	}
+
+	// rgb holds width x height RGB float texels, bottom row first (as loaded with stbi_set_flip_vertically_on_load);
+	// sampled bilinearly with clamp to edge like the GL_LINEAR texture of loadTexture()
+	void EquirectToCube(const float* rgb, int width, int height, int size, CubeImage& env)
+	{
+		std::vector<float> rgba((size_t)width * height * 4, 1.0f);
+		for (size_t i = 0; i < (size_t)width * height; ++i)
+			std::copy(rgb + i * 3, rgb + i * 3 + 3, &rgba[i * 4]);
+
+		int levels = 1;
+		while ((size >> levels) > 0)
+			++levels;
+		env.Allocate(size, levels);
+		pool.ParallelFor(6 * size, [&](int task)
+		{
+			int face = task / size;
+			int y = task % size;
+			float* row = env.Face(0, face) + (size_t)y * size * 4;
+			for (int x = 0; x < size; ++x)
+			{
+				glm::vec3 v = CubeImage::TexelDirection(face, x, y, size);
+				float u = std::atan2(v.z, v.x) * 0.1591f + 0.5f;
+				float w = std::asin(v.y) * 0.3183f + 0.5f;
+				glm::vec4 color = CubeImage::Bilinear(&rgba[0], width, height, u * width - 0.5f, w * height - 0.5f);
+				std::copy(&color[0], &color[0] + 4, row + x * 4);
+			}
+		});
+		GenerateMips(env);
+	}
+
+	// 2x2 box filter from each level to the next
+	void GenerateMips(CubeImage& image)
+	{
+		for (int level = 1; level < image.Levels; ++level)
+		{
+			int size = image.LevelSize(level);
+			int parent = image.LevelSize(level - 1);
+			pool.ParallelFor(6 * size, [&](int task)
+			{
+				int face = task / size;
+				int y = task % size;
+				const float* src = image.Face(level - 1, face);
+				float* dst = image.Face(level, face) + (size_t)y * size * 4;
+				for (int x = 0; x < size; ++x)
+				{
+					for (int c = 0; c < 4; ++c)
+					{
+						int x0 = x * 2, x1 = std::min(x * 2 + 1, parent - 1);
+						int y0 = y * 2, y1 = std::min(y * 2 + 1, parent - 1);
+						dst[x * 4 + c] = 0.25f * (src[((size_t)y0 * parent + x0) * 4 + c] + src[((size_t)y0 * parent + x1) * 4 + c] +
+							src[((size_t)y1 * parent + x0) * 4 + c] + src[((size_t)y1 * parent + x1) * 4 + c]);
+					}
+				}
+			});
+		}
+	}
+
+	// size x size irradiance map of env. The shader fetches with implicit derivatives, which at this resolution select
+	// the mip whose texels match the output texels, so that is the level sampled here.
+	void Irradiance(const CubeImage& env, int size, CubeImage& irradiance)
+	{
+		const float PI = 3.14159265359f;
+		std::vector<glm::vec4> samples = IrradianceSamples();
+		int sourceLevel = std::min(std::max((int)std::log2((float)env.Size / size), 0), env.Levels - 1);
+		float scale = PI / (float)samples.size();
+
+		irradiance.Allocate(size, 1);
+		pool.ParallelFor(6 * size, [&](int task)
+		{
+			int face = task / size;
+			int y = task % size;
+			float* row = irradiance.Face(0, face) + (size_t)y * size * 4;
+			for (int x = 0; x < size; ++x)
+			{
+				glm::vec3 N = CubeImage::TexelDirection(face, x, y, size);
+				glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), N));
+				glm::vec3 up = glm::normalize(glm::cross(N, right));
+				glm::vec4 sum(0.0f);
+				for (size_t i = 0; i < samples.size(); ++i)
+				{
+					const glm::vec4& sample = samples[i];
+					glm::vec3 direction = sample.x * right + sample.y * up + sample.z * N;
+					sum += env.SampleLevel(direction, sourceLevel) * sample.w;
+				}
+				glm::vec4 color = sum * scale;
+				color.a = 1.0f;
+				std::copy(&color[0], &color[0] + 4, row + x * 4);
+			}
+		});
+	}
+
+	// size x size pre-filtered specular map of env with levels mips, roughness = level / (levels - 1), with the same
+	// sample count for every level
+	void Prefilter(const CubeImage& env, int size, int levels, unsigned int sampleCount, CubeImage& prefilter)
+	{
+		Prefilter(env, size, std::vector<unsigned int>(levels, sampleCount), 0.0f, prefilter);
+	}
+
+	// filtered importance sampling with one sample count per level (sampleCounts.size() levels): every sample reads
+	// the source mip whose texels cover its share of the lobe's solid angle, plus mipBias levels
+	void Prefilter(const CubeImage& env, int size, const std::vector<unsigned int>& sampleCounts, float mipBias, CubeImage& prefilter)
+	{
+		int levels = (int)sampleCounts.size();
+		prefilter.Allocate(size, levels);
+
+		// per level: the reflected direction L in the tangent frame of N (V = N), its NdotL weight and source mip
+		std::vector<std::vector<glm::vec4> > samples(levels);
+		for (int level = 0; level < levels; ++level)
+		{
+			float roughness = levels > 1 ? (float)level / (float)(levels - 1) : 0.0f;
+			unsigned int sampleCount = sampleCounts[level];
+			for (unsigned int i = 0; i < sampleCount; ++i)
+			{
+				glm::vec3 H = GGXHalfVector(Hammersley(i, sampleCount), roughness);
+				glm::vec3 L = 2.0f * H.z * H - glm::vec3(0.0f, 0.0f, 1.0f);
+				float NdotL = L.z;
+				if (NdotL <= 0.0f)
+					continue;
+				float pdf = DistributionGGX(H.z, roughness) * H.z / (4.0f * H.z) + 0.0001f;
+				float saTexel = 4.0f * 3.14159265359f / (6.0f * env.Size * env.Size);
+				float saSample = 1.0f / (float(sampleCount) * pdf + 0.0001f);
+				float mip = roughness == 0.0f ? 0.0f : 0.5f * std::log2(saSample / saTexel) + mipBias;
+				L = glm::normalize(L);
+				samples[level].push_back(glm::vec4(L.x, L.y, NdotL, mip));
+			}
+		}
+
+		// one task per row of every face and level, so the rows of all levels are balanced over the threads
+		std::vector<glm::ivec3> rows;
+		for (int level = 0; level < levels; ++level)
+			for (int face = 0; face < 6; ++face)
+				for (int y = 0; y < prefilter.LevelSize(level); ++y)
+					rows.push_back(glm::ivec3(level, face, y));
+
+		pool.ParallelFor((int)rows.size(), [&](int task)
+		{
+			int level = rows[task].x;
+			int face = rows[task].y;
+			int y = rows[task].z;
+			int levelSize = prefilter.LevelSize(level);
+			const std::vector<glm::vec4>& levelSamples = samples[level];
+			float* row = prefilter.Face(level, face) + (size_t)y * levelSize * 4;
+			for (int x = 0; x < levelSize; ++x)
+			{
+				glm::vec3 N = CubeImage::TexelDirection(face, x, y, levelSize);
+				glm::vec3 up = std::abs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+				glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+				glm::vec3 bitangent = glm::cross(N, tangent);
+				glm::vec4 sum(0.0f);
+				float totalWeight = 0.0f;
+				for (size_t i = 0; i < levelSamples.size(); ++i)
+				{
+					const glm::vec4& sample = levelSamples[i];
+					glm::vec3 L = tangent * sample.x + bitangent * sample.y + N * sample.z;
+					sum += env.Sample(L, sample.w) * sample.z;
+					totalWeight += sample.z;
+				}
+				glm::vec4 color = totalWeight > 0.0f ? sum / totalWeight : glm::vec4(0.0f);
+				color.a = 1.0f;
+				std::copy(&color[0], &color[0] + 4, row + x * 4);
+			}
+		});
+	}
+
+	// size x size RG float split sum LUT, x = NdotV and y = roughness at the texel centers, row 0 is roughness ~0
+	void BRDFLut(int size, unsigned int sampleCount, std::vector<float>& lut)
+	{
+		lut.assign((size_t)size * size * 2, 0.0f);
+		std::vector<glm::vec2> points(sampleCount);
+		for (unsigned int i = 0; i < sampleCount; ++i)
+			points[i] = Hammersley(i, sampleCount);
+
+		pool.ParallelFor(size, [&](int y)
+		{
+			float roughness = (y + 0.5f) / size;
+			float k = roughness * roughness / 2.0f;
+			// N = (0, 0, 1), so the half vectors of a row are the same for every NdotV; the shader's tangent frame for
+			// this N is tangent = (0, -1, 0), bitangent = (1, 0, 0)
+			std::vector<glm::vec3> H(sampleCount);
+			for (unsigned int i = 0; i < sampleCount; ++i)
+			{
+				glm::vec3 h = GGXHalfVector(points[i], roughness);
+				H[i] = glm::vec3(h.y, -h.x, h.z);
+			}
+
+			for (int x = 0; x < size; x += 4)
+			{
+				float NdotV[4];
+				for (int lane = 0; lane < 4; ++lane)
+					NdotV[lane] = (std::min(x + lane, size - 1) + 0.5f) / size;
+				float A[4], B[4];
+				integrateBRDF(NdotV, k, H, A, B);
+				for (int lane = 0; lane < 4 && x + lane < size; ++lane)
+				{
+					lut[((size_t)y * size + x + lane) * 2 + 0] = A[lane];
+					lut[((size_t)y * size + x + lane) * 2 + 1] = B[lane];
+				}
+			}
+		});
+	}
+
+	// tangent space directions and cos(theta) sin(theta) weights of the irradiance convolution, in shader order
+	static std::vector<glm::vec4> IrradianceSamples()
+	{
+		const float PI = 3.14159265359f;
+		const float sampleDelta = 0.025f;
+		std::vector<glm::vec4> samples;
+		for (float phi = 0.0f; phi < 2.0f * PI; phi += sampleDelta)
+			for (float theta = 0.0f; theta < 0.5f * PI; theta += sampleDelta)
+				samples.push_back(glm::vec4(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta), std::cos(theta) * std::sin(theta)));
+		return samples;
+	}
+
+	static glm::vec2 Hammersley(unsigned int i, unsigned int count)
+	{
+		unsigned int bits = i;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return glm::vec2((float)i / (float)count, (float)bits * 2.3283064365386963e-10f);
+	}
+
+	// GGX distributed half vector around (0, 0, 1)
+	static glm::vec3 GGXHalfVector(const glm::vec2& Xi, float roughness)
+	{
+		float a = roughness * roughness;
+		float phi = 2.0f * 3.14159265359f * Xi.x;
+		float cosTheta = std::sqrt((1.0f - Xi.y) / (1.0f + (a * a - 1.0f) * Xi.y));
+		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+	}
+
+	static float DistributionGGX(float NdotH, float roughness)
+	{
+		float a = roughness * roughness;
+		float a2 = a * a;
+		float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+		return a2 / (3.14159265359f * denom * denom);
+	}
+
+private:
+
+	ThreadPool& pool;
+
+	// split sum integral for four NdotV values at once, V = (sqrt(1 - NdotV^2), 0, NdotV) and k = roughness^2 / 2
+	static void integrateBRDF(const float* NdotV, float k, const std::vector<glm::vec3>& H, float* A, float* B)
+	{
+#ifdef IBL_REFERENCE_SSE
+		__m128 nv = _mm_loadu_ps(NdotV);
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 zero = _mm_setzero_ps();
+		__m128 vx = _mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(nv, nv)));
+		__m128 kk = _mm_set1_ps(k);
+		__m128 oneMinusK = _mm_set1_ps(1.0f - k);
+		__m128 ggxV = _mm_div_ps(nv, _mm_add_ps(_mm_mul_ps(nv, oneMinusK), kk));
+		__m128 sumA = zero;
+		__m128 sumB = zero;
+		for (size_t i = 0; i < H.size(); ++i)
+		{
+			__m128 hx = _mm_set1_ps(H[i].x);
+			__m128 hz = _mm_set1_ps(H[i].z);
+			__m128 VdotH = _mm_add_ps(_mm_mul_ps(vx, hx), _mm_mul_ps(nv, hz));
+			// L = 2 dot(V, H) H - V, only its z is needed
+			__m128 NdotL = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(VdotH, VdotH), hz), nv);
+			__m128 mask = _mm_cmpgt_ps(NdotL, zero);
+			NdotL = _mm_max_ps(NdotL, zero);
+			VdotH = _mm_max_ps(VdotH, zero);
+			__m128 ggxL = _mm_div_ps(NdotL, _mm_add_ps(_mm_mul_ps(NdotL, oneMinusK), kk));
+			__m128 G = _mm_mul_ps(ggxL, ggxV);
+			__m128 GVis = _mm_div_ps(_mm_mul_ps(G, VdotH), _mm_mul_ps(hz, nv));
+			__m128 f = _mm_sub_ps(one, VdotH);
+			__m128 f2 = _mm_mul_ps(f, f);
+			__m128 Fc = _mm_mul_ps(_mm_mul_ps(f2, f2), f);
+			GVis = _mm_and_ps(GVis, mask);
+			sumA = _mm_add_ps(sumA, _mm_mul_ps(_mm_sub_ps(one, Fc), GVis));
+			sumB = _mm_add_ps(sumB, _mm_mul_ps(Fc, GVis));
+		}
+		__m128 inverseCount = _mm_set1_ps(1.0f / (float)H.size());
+		_mm_storeu_ps(A, _mm_mul_ps(sumA, inverseCount));
+		_mm_storeu_ps(B, _mm_mul_ps(sumB, inverseCount));
+#else
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			float nv = NdotV[lane];
+			float vx = std::sqrt(1.0f - nv * nv);
+			float ggxV = nv / (nv * (1.0f - k) + k);
+			float sumA = 0.0f;
+			float sumB = 0.0f;
+			for (size_t i = 0; i < H.size(); ++i)
+			{
+				float VdotH = vx * H[i].x + nv * H[i].z;
+				float NdotL = 2.0f * VdotH * H[i].z - nv;
+				if (NdotL <= 0.0f)
+					continue;
+				VdotH = std::max(VdotH, 0.0f);
+				float G = NdotL / (NdotL * (1.0f - k) + k) * ggxV;
+				float GVis = (G * VdotH) / (H[i].z * nv);
+				float Fc = std::pow(1.0f - VdotH, 5.0f);
+				sumA += (1.0f - Fc) * GVis;
+				sumB += Fc * GVis;
+			}
+			A[lane] = sumA / (float)H.size();
+			B[lane] = sumB / (float)H.size();
+		}
+#endif
+	}
+};
+
+#endif
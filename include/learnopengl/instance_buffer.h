@@ -0,0 +1,133 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+
+// per-instance data of the pbr shaders: the model matrix and the material parameters that are uniforms for a
+// single draw
+struct PBRInstance
+{
+	glm::mat4 Model;
+	glm::vec3 Albedo;
+	float Metallic;
+	float Roughness;
+	float AO;
+};
+
+// Instances in a vertex buffer, read by the pbr vertex shaders through per-instance attributes (divisor 1) so a
+// whole scene of one mesh is a single glDrawElementsInstanced() instead of a draw call and three to four uniform
+// updates per object. Attribute locations, after position, normal and texture coordinates of the meshes:
+//   3-6  model matrix (one column per location)
+//   7    albedo, metallic
+//   8    roughness, ao
+class InstanceBuffer
+{
+public:
+	static const unsigned int FIRST_LOCATION = 3;
+
+	int Count;
+
+	InstanceBuffer() : Count(0), capacity(0)
+	{
+		glGenBuffers(1, &vbo);
+	}
+
+	~InstanceBuffer()
+	{
+		glDeleteBuffers(1, &vbo);
+	}
+
+	// replaces the instances; the buffer is reallocated only when it has to grow, so per-frame updates of a
+	// similar count reuse the storage
+	void Upload(const std::vector<PBRInstance>& instances)
+	{
+		Count = (int)instances.size();
+		if (instances.empty())
+			return;
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		if (instances.size() > capacity)
+		{
+			capacity = instances.size();
+			glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(PBRInstance), &instances[0], GL_DYNAMIC_DRAW);
+		}
+		else
+			glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(PBRInstance), &instances[0]);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// adds the instance attributes to a mesh vertex array, which must be bound, starting at instance first (GL 3.3
+	// has no base instance, so a range of the buffer is drawn by pointing the attributes at it); a no-op for arrays
+	// that already read from there, so it can be called before every draw
+	void Attach(unsigned int vao, int first = 0) const
+	{
+		for (size_t i = 0; i < attached.size(); ++i)
+		{
+			if (attached[i].first == vao)
+			{
+				if (attached[i].second == first)
+					return;
+				attached.erase(attached.begin() + i);
+				break;
+			}
+		}
+		attached.push_back(std::make_pair(vao, first));
+
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		GLsizei stride = sizeof(PBRInstance);
+		size_t base = (size_t)first * sizeof(PBRInstance);
+		for (unsigned int column = 0; column < 4; ++column)
+		{
+			glEnableVertexAttribArray(FIRST_LOCATION + column);
+			glVertexAttribPointer(FIRST_LOCATION + column, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(PBRInstance, Model) + column * sizeof(glm::vec4)));
+			glVertexAttribDivisor(FIRST_LOCATION + column, 1);
+		}
+		glEnableVertexAttribArray(FIRST_LOCATION + 4);
+		glVertexAttribPointer(FIRST_LOCATION + 4, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(PBRInstance, Albedo)));
+		glVertexAttribDivisor(FIRST_LOCATION + 4, 1);
+		glEnableVertexAttribArray(FIRST_LOCATION + 5);
+		glVertexAttribPointer(FIRST_LOCATION + 5, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(PBRInstance, Roughness)));
+		glVertexAttribDivisor(FIRST_LOCATION + 5, 1);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// the sphere grid of the 6.pbr demos: metallic increases with the row, roughness with the column (clamped to
+	// 0.05, perfectly smooth surfaces look off under point lights) and the grid is centered on the origin
+	static void AppendSphereGrid(std::vector<PBRInstance>& instances, int rows, int columns, float spacing, glm::vec3 albedo)
+	{
+		for (int row = 0; row < rows; ++row)
+		{
+			for (int col = 0; col < columns; ++col)
+			{
+				PBRInstance instance;
+				instance.Model = glm::translate(glm::mat4(1.0f), glm::vec3(
+					(col - (columns / 2)) * spacing,
+					(row - (rows / 2)) * spacing,
+					0.0f
+				));
+				instance.Albedo = albedo;
+				instance.Metallic = (float)row / (float)rows;
+				instance.Roughness = glm::clamp((float)col / (float)columns, 0.05f, 1.0f);
+				instance.AO = 1.0f;
+				instances.push_back(instance);
+			}
+		}
+	}
+
+private:
+
+	unsigned int vbo;
+	size_t capacity;
+	mutable std::vector<std::pair<unsigned int, int> > attached;  // vertex arrays and the instance they start at
+
+	InstanceBuffer(const InstanceBuffer&);
+	InstanceBuffer& operator=(const InstanceBuffer&);
+};
+
+#endif
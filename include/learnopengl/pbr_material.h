@@ -0,0 +1,422 @@
+#ifndef PBR_MATERIAL_H
+#define PBR_MATERIAL_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/filesystem.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// bump when the packing or the file layout change, older packed files are then repacked
+const unsigned int PBR_PACK_VERSION = 1;
+// largest width or height Load() accepts, larger sizes can only come from a damaged file
+const int PBR_PACK_MAX_SIZE = 16384;
+
+// The texture set of one PBR material in the packed layout, independent of GL so tools can build it:
+//   albedo  RGB8, the color as authored (sRGB, linearized in the shader)
+//   normal  RG8, x and y of the unit tangent space normal, the shader rebuilds z = sqrt(1 - x*x - y*y)
+//   orm     RGB8, R = ambient occlusion, G = roughness, B = metallic
+// which replaces the five textures (albedo, normal, metallic, roughness, ao) of a material directory by three, with
+// three fetches per fragment instead of five. The packed set is stored next to the sources (<dir>/material.pbrpack),
+// keyed by a hash of the source files so an edited texture is repacked without deleting anything.
+//
+// Source maps that are missing fall back to a constant (white albedo, flat normal, ao 1, roughness 0.5, metallic 0)
+// with a warning, and maps of different sizes are resampled to the largest of them.
+struct PBRTextureSet
+{
+	struct Image
+	{
+		int Width;
+		int Height;
+		int Components;
+		std::vector<unsigned char> Texels;   // rows as in the source image, tightly packed
+
+		Image() : Width(0), Height(0), Components(0) {}
+
+		size_t Bytes() const
+		{
+			return (size_t)Width * Height * Components;
+		}
+	};
+
+	Image Albedo;
+	Image Normal;
+	Image ORM;
+	uint64_t SourceHash;
+
+	PBRTextureSet() : SourceHash(0) {}
+
+	// the source maps of a material directory, in the order the unpacked shaders bind them
+	static const char* SourceName(int map)
+	{
+		static const char* names[5] = { "albedo.png", "normal.png", "metallic.png", "roughness.png", "ao.png" };
+		return names[map];
+	}
+
+	static std::string PackPath(const std::string& dir)
+	{
+		return dir + "/material.pbrpack";
+	}
+
+	// packs the source maps of dir (a full path), false when none of them could be read
+	bool Pack(const std::string& dir)
+	{
+		Image source[5];
+		int found = 0;
+		for (int map = 0; map < 5; ++map)
+		{
+			std::string path = dir + "/" + SourceName(map);
+			int width, height, components;
+			unsigned char* data = stbi_load(path.c_str(), &width, &height, &components, 0);
+			if (!data)
+			{
+				printf("pbr pack: %s is missing, using a constant\n", path.c_str());
+				continue;
+			}
+			source[map].Width = width;
+			source[map].Height = height;
+			source[map].Components = components;
+			source[map].Texels.assign(data, data + (size_t)width * height * components);
+			stbi_image_free(data);
+			++found;
+		}
+		if (found == 0)
+			return false;
+		SourceHash = HashSources(dir);
+
+		// albedo keeps its own size, the ORM channels share one texture so they are brought to the largest of them
+		Albedo = convert(source[0], 3, 255, 255, 255);
+
+		Image normal = convert(source[1], 3, 128, 128, 255);
+		Normal.Width = normal.Width;
+		Normal.Height = normal.Height;
+		Normal.Components = 2;
+		Normal.Texels.resize(Normal.Bytes());
+		for (size_t i = 0; i < (size_t)normal.Width * normal.Height; ++i)
+		{
+			// renormalized before z is dropped, so z can be rebuilt from a unit vector
+			float x = normal.Texels[i * 3 + 0] / 255.0f * 2.0f - 1.0f;
+			float y = normal.Texels[i * 3 + 1] / 255.0f * 2.0f - 1.0f;
+			float z = normal.Texels[i * 3 + 2] / 255.0f * 2.0f - 1.0f;
+			float length = std::sqrt(x * x + y * y + z * z);
+			if (length > 0.0f)
+			{
+				x /= length;
+				y /= length;
+			}
+			Normal.Texels[i * 2 + 0] = unorm8(x * 0.5f + 0.5f);
+			Normal.Texels[i * 2 + 1] = unorm8(y * 0.5f + 0.5f);
+		}
+
+		int width = 1, height = 1;
+		for (int map = 2; map < 5; ++map)
+		{
+			width = source[map].Width > width ? source[map].Width : width;
+			height = source[map].Height > height ? source[map].Height : height;
+		}
+		Image ao = resample(convert(source[4], 1, 255, 255, 255), width, height);
+		Image roughness = resample(convert(source[3], 1, 128, 128, 128), width, height);
+		Image metallic = resample(convert(source[2], 1, 0, 0, 0), width, height);
+		ORM.Width = width;
+		ORM.Height = height;
+		ORM.Components = 3;
+		ORM.Texels.resize(ORM.Bytes());
+		for (size_t i = 0; i < (size_t)width * height; ++i)
+		{
+			ORM.Texels[i * 3 + 0] = ao.Texels[i];
+			ORM.Texels[i * 3 + 1] = roughness.Texels[i];
+			ORM.Texels[i * 3 + 2] = metallic.Texels[i];
+		}
+		return true;
+	}
+
+	// reads the packed set of dir, false when there is none, it was packed from other source files or it does not
+	// have the layout above
+	bool Load(const std::string& dir)
+	{
+		FILE* file = fopen(PackPath(dir).c_str(), "rb");
+		if (!file)
+			return false;
+		FileHeader header;
+		bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.Magic, "LOGLPBR", 8) == 0 &&
+			header.Version == PBR_PACK_VERSION && header.SourceHash == HashSources(dir);
+		Image* images[3] = { &Albedo, &Normal, &ORM };
+		const int components[3] = { 3, 2, 3 };
+		for (int i = 0; ok && i < 3; ++i)
+		{
+			int32_t size[3];
+			ok = fread(size, sizeof(size), 1, file) == 1 && size[0] > 0 && size[0] <= PBR_PACK_MAX_SIZE &&
+				size[1] > 0 && size[1] <= PBR_PACK_MAX_SIZE && size[2] == components[i];
+			if (!ok)
+				break;
+			images[i]->Width = size[0];
+			images[i]->Height = size[1];
+			images[i]->Components = size[2];
+			images[i]->Texels.resize(images[i]->Bytes());
+			ok = fread(images[i]->Texels.data(), 1, images[i]->Texels.size(), file) == images[i]->Texels.size();
+		}
+		fclose(file);
+		if (ok)
+			SourceHash = header.SourceHash;
+		return ok;
+	}
+
+	bool Save(const std::string& dir) const
+	{
+		std::string path = PackPath(dir);
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+		FileHeader header;
+		memcpy(header.Magic, "LOGLPBR", 8);
+		header.Version = PBR_PACK_VERSION;
+		header.SourceHash = SourceHash;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		const Image* images[3] = { &Albedo, &Normal, &ORM };
+		for (int i = 0; ok && i < 3; ++i)
+		{
+			int32_t size[3] = { images[i]->Width, images[i]->Height, images[i]->Components };
+			ok = fwrite(size, sizeof(size), 1, file) == 1 &&
+				fwrite(images[i]->Texels.data(), 1, images[i]->Texels.size(), file) == images[i]->Texels.size();
+		}
+		ok = fclose(file) == 0 && ok;
+		if (!ok)
+			remove(path.c_str());
+		return ok;
+	}
+
+	// texture memory of the packed set with a full mip chain (4/3 of level 0)
+	size_t TextureBytes() const
+	{
+		return (Albedo.Bytes() + Normal.Bytes() + ORM.Bytes()) * 4 / 3;
+	}
+
+	// texture memory of the five source maps as the unpacked demos upload them (one 8 bit texture of the
+	// source's channel count each, with mips); missing maps count as nothing
+	static size_t SourceTextureBytes(const std::string& dir)
+	{
+		size_t bytes = 0;
+		for (int map = 0; map < 5; ++map)
+		{
+			int width, height, components;
+			if (stbi_info((dir + "/" + SourceName(map)).c_str(), &width, &height, &components))
+				bytes += (size_t)width * height * components;
+		}
+		return bytes * 4 / 3;
+	}
+
+	// 64-bit FNV-1a over the contents of all source maps that exist
+	static uint64_t HashSources(const std::string& dir)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (int map = 0; map < 5; ++map)
+		{
+			FILE* file = fopen((dir + "/" + SourceName(map)).c_str(), "rb");
+			hash = (hash ^ (file ? 1u : 0u)) * 1099511628211ull;
+			if (!file)
+				continue;
+			unsigned char buffer[65536];
+			size_t count;
+			while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			{
+				for (size_t i = 0; i < count; ++i)
+					hash = (hash ^ buffer[i]) * 1099511628211ull;
+			}
+			fclose(file);
+		}
+		return hash;
+	}
+
+private:
+
+	struct FileHeader
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t Reserved;
+		uint64_t SourceHash;
+	};
+
+	static unsigned char unorm8(float value)
+	{
+		value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+		return (unsigned char)(value * 255.0f + 0.5f);
+	}
+
+	// the source with the given channel count (grey is replicated, extra channels dropped), or a 1x1 image of the
+	// fallback color when the source is missing
+	static Image convert(const Image& source, int components, unsigned char r, unsigned char g, unsigned char b)
+	{
+		Image image;
+		if (source.Texels.empty())
+		{
+			unsigned char fallback[3] = { r, g, b };
+			image.Width = image.Height = 1;
+			image.Components = components;
+			image.Texels.assign(fallback, fallback + components);
+			return image;
+		}
+		image.Width = source.Width;
+		image.Height = source.Height;
+		image.Components = components;
+		image.Texels.resize(image.Bytes());
+		for (size_t i = 0; i < (size_t)source.Width * source.Height; ++i)
+		{
+			const unsigned char* in = &source.Texels[i * source.Components];
+			for (int c = 0; c < components; ++c)
+				image.Texels[i * components + c] = source.Components >= 3 ? in[c] : in[0];
+		}
+		return image;
+	}
+
+	// bilinear resize of a one channel image, texel centers aligned
+	static Image resample(const Image& source, int width, int height)
+	{
+		if (source.Width == width && source.Height == height)
+			return source;
+		Image image;
+		image.Width = width;
+		image.Height = height;
+		image.Components = 1;
+		image.Texels.resize(image.Bytes());
+		for (int y = 0; y < height; ++y)
+		{
+			float sy = (y + 0.5f) * source.Height / height - 0.5f;
+			sy = sy < 0.0f ? 0.0f : sy;
+			int y0 = (int)sy;
+			int y1 = y0 + 1 < source.Height ? y0 + 1 : y0;
+			float fy = sy - y0;
+			for (int x = 0; x < width; ++x)
+			{
+				float sx = (x + 0.5f) * source.Width / width - 0.5f;
+				sx = sx < 0.0f ? 0.0f : sx;
+				int x0 = (int)sx;
+				int x1 = x0 + 1 < source.Width ? x0 + 1 : x0;
+				float fx = sx - x0;
+				const unsigned char* row0 = &source.Texels[(size_t)y0 * source.Width];
+				const unsigned char* row1 = &source.Texels[(size_t)y1 * source.Width];
+				float top = row0[x0] + (row0[x1] - row0[x0]) * fx;
+				float bottom = row1[x0] + (row1[x1] - row1[x0]) * fx;
+				image.Texels[(size_t)y * width + x] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+			}
+		}
+		return image;
+	}
+};
+
+// The textures of one PBR material, either packed (albedo, normal RG, ORM) or the five separate source maps for
+// comparison. Load() uses the packed set stored next to the sources and packs and stores it on a miss, so the
+// first start pays for the packing once (or run the pbr_pack tool ahead of time).
+//
+// Bind(unit) binds the textures to consecutive units starting at unit: three for a packed material (albedoMap,
+// normalMap, ormMap), five for a separate one (albedoMap, normalMap, metallicMap, roughnessMap, aoMap).
+class PBRMaterial
+{
+public:
+
+	bool Packed;
+	size_t TextureBytes;   // estimated GPU memory of the textures, with mips
+	std::vector<unsigned int> Textures;
+
+	PBRMaterial() : Packed(false), TextureBytes(0) {}
+
+	~PBRMaterial()
+	{
+		release();
+	}
+
+	// dir is relative to the repository root, e.g. "res/textures/pbr/rusted_iron"
+	bool Load(const char* dir, bool packed = true)
+	{
+		std::string path = FileSystem::getPath(dir);
+		Packed = packed;
+		if (!packed)
+		{
+			release();
+			for (int map = 0; map < 5; ++map)
+			{
+				int width, height, components;
+				unsigned char* data = stbi_load((path + "/" + PBRTextureSet::SourceName(map)).c_str(), &width, &height, &components, 0);
+				if (!data)
+				{
+					// same constants as a missing map of the packed set
+					static const unsigned char fallback[5][3] = { { 255, 255, 255 }, { 128, 128, 255 }, { 0, 0, 0 }, { 128, 128, 128 }, { 255, 255, 255 } };
+					Textures.push_back(upload(fallback[map], 1, 1, 3));
+					continue;
+				}
+				Textures.push_back(upload(data, width, height, components));
+				stbi_image_free(data);
+			}
+			TextureBytes = PBRTextureSet::SourceTextureBytes(path);
+			return true;
+		}
+
+		PBRTextureSet set;
+		if (!set.Load(path))
+		{
+			if (!set.Pack(path))
+				return false;
+			if (!set.Save(path))
+				printf("pbr pack: could not write %s\n", PBRTextureSet::PackPath(path).c_str());
+		}
+		release();
+		Textures.push_back(upload(set.Albedo.Texels.data(), set.Albedo.Width, set.Albedo.Height, set.Albedo.Components));
+		Textures.push_back(upload(set.Normal.Texels.data(), set.Normal.Width, set.Normal.Height, set.Normal.Components));
+		Textures.push_back(upload(set.ORM.Texels.data(), set.ORM.Width, set.ORM.Height, set.ORM.Components));
+		TextureBytes = set.TextureBytes();
+		return true;
+	}
+
+	void Bind(unsigned int unit) const
+	{
+		for (size_t i = 0; i < Textures.size(); ++i)
+		{
+			glActiveTexture(GL_TEXTURE0 + unit + (unsigned int)i);
+			glBindTexture(GL_TEXTURE_2D, Textures[i]);
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+private:
+
+	// loading again replaces the textures, so they are deleted instead of only forgotten
+	void release()
+	{
+		if (!Textures.empty())
+			glDeleteTextures((GLsizei)Textures.size(), Textures.data());
+		Textures.clear();
+	}
+
+	static unsigned int upload(const unsigned char* data, int width, int height, int components)
+	{
+		static const GLenum formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+		static const GLenum internalFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		GLint alignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[components - 1], width, height, 0, formats[components - 1], GL_UNSIGNED_BYTE, data);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texture;
+	}
+
+	PBRMaterial(const PBRMaterial&);
+	PBRMaterial& operator=(const PBRMaterial&);
+};
+
+#endif
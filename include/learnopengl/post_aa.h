@@ -0,0 +1,165 @@
+#ifndef POST_AA_H
+#define POST_AA_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+#include <cstddef>
+
+// Post-process anti-aliasing of a single sample color texture, an alternative to multisampled render targets
+// that costs no extra memory per sample and also works on top of deferred shading.
+//  FXAA:    one pass, luma based edge direction, search along the edge and a sub-pixel blend
+//  SMAA 1x: three passes, 1. luma edges with local contrast adaptation into an RG8 texture
+//                          2. blend weights from the edge run lengths and the crossing edges at their ends
+//                          3. neighborhood blending with the weights of the pixel and its neighbours
+//
+// The shaders are passed in by the demo (see 11.2.fullscreen.vs, 11.2.fxaa.fs and 11.2.smaa_*.fs in
+// 11.2.anti_aliasing_offscreen), all of them draw a single fullscreen triangle without vertex attributes.
+// The final pass of either method renders into the framebuffer and viewport bound by the caller.
+class PostAA
+{
+public:
+
+	int Width;
+	int Height;
+	float EdgeThreshold;  // SMAA luma edge threshold
+
+	PostAA(Shader& fxaaShader, Shader& edgesShader, Shader& weightsShader, Shader& blendShader)
+		: Width(0), Height(0), EdgeThreshold(0.1f), fxaaShader(fxaaShader), edgesShader(edgesShader),
+		  weightsShader(weightsShader), blendShader(blendShader), edgesTexture(0), weightsTexture(0)
+	{
+		glGenVertexArrays(1, &emptyVAO);
+		glGenFramebuffers(1, &edgesFBO);
+		glGenFramebuffers(1, &weightsFBO);
+	}
+
+	~PostAA()
+	{
+		release();
+		glDeleteVertexArrays(1, &emptyVAO);
+		glDeleteFramebuffers(1, &edgesFBO);
+		glDeleteFramebuffers(1, &weightsFBO);
+	}
+
+	// size of the color textures to be anti-aliased, call before the first FXAA / SMAA; (re)allocates the SMAA targets
+	void Resize(int width, int height)
+	{
+		if (width == Width && height == Height)
+			return;
+		release();
+		Width = width;
+		Height = height;
+		edgesTexture = createTarget(edgesFBO, GL_RG8, GL_RG);
+		weightsTexture = createTarget(weightsFBO, GL_RGBA8, GL_RGBA);
+	}
+
+	// color texture must be filterable with GL_LINEAR, FXAA searches along edges with bilinear fetches
+	void FXAA(unsigned int colorTexture)
+	{
+		glBindVertexArray(emptyVAO);
+		fxaaShader.use();
+		fxaaShader.setInt("screenTexture", 0);
+		fxaaShader.setVec2("inverseScreenSize", 1.0f / Width, 1.0f / Height);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, colorTexture);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+	}
+
+	void SMAA(unsigned int colorTexture)
+	{
+		GLint target, viewport[4];
+		GLfloat clearColor[4];
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+		glBindVertexArray(emptyVAO);
+		glViewport(0, 0, Width, Height);
+		glActiveTexture(GL_TEXTURE0);
+
+		// 1. edges, most pixels have none and get discarded, so the target has to be cleared
+		glBindFramebuffer(GL_FRAMEBUFFER, edgesFBO);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		edgesShader.use();
+		edgesShader.setInt("screenTexture", 0);
+		edgesShader.setFloat("threshold", EdgeThreshold);
+		glBindTexture(GL_TEXTURE_2D, colorTexture);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		// 2. blend weights, only computed where pass 1 found an edge
+		glBindFramebuffer(GL_FRAMEBUFFER, weightsFBO);
+		glClear(GL_COLOR_BUFFER_BIT);
+		weightsShader.use();
+		weightsShader.setInt("edgesTexture", 0);
+		glBindTexture(GL_TEXTURE_2D, edgesTexture);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		// 3. neighborhood blending into the caller's target
+		glBindFramebuffer(GL_FRAMEBUFFER, target);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		blendShader.use();
+		blendShader.setInt("screenTexture", 0);
+		blendShader.setInt("weightsTexture", 1);
+		glBindTexture(GL_TEXTURE_2D, colorTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, weightsTexture);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glActiveTexture(GL_TEXTURE0);
+		glBindVertexArray(0);
+	}
+
+	// memory of the SMAA intermediate targets (edges RG8 + weights RGBA8)
+	size_t SMAABytes() const
+	{
+		return (size_t)Width * Height * (2 + 4);
+	}
+
+	unsigned int EdgesTexture() const { return edgesTexture; }
+	unsigned int WeightsTexture() const { return weightsTexture; }
+
+private:
+
+	Shader& fxaaShader;
+	Shader& edgesShader;
+	Shader& weightsShader;
+	Shader& blendShader;
+	unsigned int emptyVAO;
+	unsigned int edgesFBO;
+	unsigned int weightsFBO;
+	unsigned int edgesTexture;
+	unsigned int weightsTexture;
+
+	unsigned int createTarget(unsigned int fbo, GLenum internalFormat, GLenum format)
+	{
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, Width, Height, 0, format, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texture;
+	}
+
+	void release()
+	{
+		if (edgesTexture)
+			glDeleteTextures(1, &edgesTexture);
+		if (weightsTexture)
+			glDeleteTextures(1, &weightsTexture);
+		edgesTexture = weightsTexture = 0;
+	}
+
+	PostAA(const PostAA&);
+	PostAA& operator=(const PostAA&);
+};
+
+#endif
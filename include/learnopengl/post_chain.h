@@ -0,0 +1,518 @@
+#ifndef POST_CHAIN_H
+#define POST_CHAIN_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+
+// format and size of a transient color or depth target
+struct RenderTargetDesc
+{
+	GLenum InternalFormat;
+	int Width;
+	int Height;
+
+	bool operator==(const RenderTargetDesc& o) const
+	{
+		return InternalFormat == o.InternalFormat && Width == o.Width && Height == o.Height;
+	}
+
+	// three channel formats count as four, drivers store them padded
+	size_t Bytes() const
+	{
+		return (size_t)Width * Height * BytesPerPixel(InternalFormat);
+	}
+
+	bool IsDepth() const
+	{
+		return IsDepth(InternalFormat);
+	}
+
+	static int BytesPerPixel(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_R8: return 1;
+		case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+		case GL_RGB8: case GL_SRGB8: case GL_RGBA8: case GL_SRGB8_ALPHA8: case GL_RG16F: case GL_R32F: case GL_R11F_G11F_B10F: return 4;
+		case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F: case GL_DEPTH24_STENCIL8: return 4;
+		case GL_RGB16F: case GL_RGBA16F: case GL_RG32F: return 8;
+		case GL_RGB32F: case GL_RGBA32F: return 16;
+		default: return 4;
+		}
+	}
+
+	static bool IsDepth(GLenum internalFormat)
+	{
+		return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24 ||
+			internalFormat == GL_DEPTH_COMPONENT32F || internalFormat == GL_DEPTH24_STENCIL8;
+	}
+};
+
+// Render targets (texture + framebuffer) that are handed out by description and returned when no longer needed,
+// so a later user with the same description gets the same memory. Acquire / Release only do bookkeeping, the GL
+// objects are created on first use by Texture() / Framebuffer(), which lets the assignment be planned without a context.
+class RenderTargetPool
+{
+public:
+
+	RenderTargetPool()
+	{
+	}
+
+	~RenderTargetPool()
+	{
+		Clear();
+	}
+
+	// index of a free target with this description, a new one is added if there is none
+	int Acquire(const RenderTargetDesc& desc)
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			if (!slots[i].InUse && slots[i].Desc == desc)
+			{
+				slots[i].InUse = slots[i].Used = true;
+				return (int)i;
+			}
+		}
+		Slot slot = { desc, 0, 0, true, true };
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			// reuse the entry of a trimmed target
+			if (!slots[i].Used && slots[i].Texture == 0)
+			{
+				slots[i] = slot;
+				return (int)i;
+			}
+		}
+		slots.push_back(slot);
+		return (int)slots.size() - 1;
+	}
+
+	void Release(int index)
+	{
+		slots[index].InUse = false;
+	}
+
+	// starts a new assignment, every target becomes free and counts as unused until acquired again
+	void ReleaseAll()
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+			slots[i].InUse = slots[i].Used = false;
+	}
+
+	// deletes the GL objects of targets nobody acquired since ReleaseAll(); indices of the others stay valid
+	void Trim()
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			if (!slots[i].Used)
+			{
+				destroy(slots[i]);
+				slots[i].Desc.Width = slots[i].Desc.Height = 0;
+			}
+		}
+	}
+
+	void Clear()
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+			destroy(slots[i]);
+		slots.clear();
+	}
+
+	const RenderTargetDesc& Desc(int index) const
+	{
+		return slots[index].Desc;
+	}
+
+	unsigned int Texture(int index)
+	{
+		create(slots[index]);
+		return slots[index].Texture;
+	}
+
+	// framebuffer with only this target attached, e.g. as the read framebuffer of a blit
+	unsigned int Framebuffer(int index)
+	{
+		create(slots[index]);
+		return slots[index].Framebuffer;
+	}
+
+	// memory of the targets acquired since the last ReleaseAll()
+	size_t Bytes() const
+	{
+		size_t bytes = 0;
+		for (size_t i = 0; i < slots.size(); ++i)
+			if (slots[i].Used)
+				bytes += slots[i].Desc.Bytes();
+		return bytes;
+	}
+
+	int Count() const
+	{
+		int count = 0;
+		for (size_t i = 0; i < slots.size(); ++i)
+			count += slots[i].Used ? 1 : 0;
+		return count;
+	}
+
+private:
+
+	struct Slot
+	{
+		RenderTargetDesc Desc;
+		unsigned int Texture;
+		unsigned int Framebuffer;
+		bool InUse;
+		bool Used;
+	};
+	std::vector<Slot> slots;
+
+	static void create(Slot& slot)
+	{
+		if (slot.Texture)
+			return;
+		bool depth = slot.Desc.IsDepth();
+		bool stencil = slot.Desc.InternalFormat == GL_DEPTH24_STENCIL8;
+		glGenTextures(1, &slot.Texture);
+		glBindTexture(GL_TEXTURE_2D, slot.Texture);
+		// the pixel transfer format does not matter without data, it only has to be valid for the internal format
+		if (stencil)
+			glTexImage2D(GL_TEXTURE_2D, 0, slot.Desc.InternalFormat, slot.Desc.Width, slot.Desc.Height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, slot.Desc.InternalFormat, slot.Desc.Width, slot.Desc.Height, 0, depth ? GL_DEPTH_COMPONENT : GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glGenFramebuffers(1, &slot.Framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, slot.Framebuffer);
+		if (depth)
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, slot.Texture, 0);
+			// GL 3.3 needs the color buffers switched off for a framebuffer without color attachments to be complete
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+		}
+		else
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, slot.Texture, 0);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	static void destroy(Slot& slot)
+	{
+		if (!slot.Texture)
+			return;
+		glDeleteFramebuffers(1, &slot.Framebuffer);
+		glDeleteTextures(1, &slot.Texture);
+		slot.Texture = slot.Framebuffer = 0;
+	}
+
+	RenderTargetPool(const RenderTargetPool&);
+	RenderTargetPool& operator=(const RenderTargetPool&);
+};
+
+// A list of passes over named targets that run in declaration order. Every pass declares the targets it reads
+// and the one it renders to, plus optionally a depth target for passes that draw geometry; targets created by the
+// chain are transient, sized relative to the output and only live from the first to the last pass that uses them,
+// so Compile() lets targets with the same description and disjoint lifetimes share one texture of the pool.
+// GL 3.3 cannot alias memory between different formats, so only identical descriptions share. Resize() with the
+// framebuffer size once per frame is all a demo needs to follow window resizes.
+//
+//     int scene = chain.Create("scene", GL_RGBA8);
+//     int depth = chain.Create("depth", GL_DEPTH24_STENCIL8);
+//     int half = chain.Create("half", GL_RGBA16F, 1);
+//     chain.AddPass("scene", {}, scene, [&]() { glClear(...); drawScene(); }, depth);
+//     chain.AddPass("downsample", { scene }, half, [&]() { downsampleShader.use(); renderQuad(); });
+//     chain.AddPass("composite", { scene, half }, PostChain::BACKBUFFER, [&]() { compositeShader.use(); renderQuad(); });
+//     ... every frame: chain.Resize(width, height); chain.Execute();
+//
+// Execute() binds the output target and its viewport and the inputs to texture units 0, 1, ... in declaration
+// order before calling each pass; the pass only sets its shader state, clears what it needs cleared and draws.
+// Demos whose passes have to be culled or reordered use the FrameGraph (frame_graph.h) on the same pool.
+class PostChain
+{
+public:
+
+	static const int BACKBUFFER = -1;
+	typedef std::function<void()> PassFunction;
+
+	PostChain() : width(0), height(0), compiled(false)
+	{
+	}
+
+	~PostChain()
+	{
+		releaseFramebuffers();
+	}
+
+	// output size of the chain, transient targets are sized relative to it; reallocates them on the next Compile()
+	void Resize(int outputWidth, int outputHeight)
+	{
+		if (outputWidth == width && outputHeight == height)
+			return;
+		width = outputWidth;
+		height = outputHeight;
+		pool.Clear();
+		compiled = false;
+		for (size_t i = 0; i < targets.size(); ++i)
+			if (!targets[i].Imported)
+				targets[i].Desc = describe(targets[i].Desc.InternalFormat, targets[i].Shift);
+	}
+
+	// removes all passes and targets, the pooled textures are kept for the next Compile()
+	void Clear()
+	{
+		releaseFramebuffers();
+		passes.clear();
+		targets.clear();
+		compiled = false;
+	}
+
+	// a texture owned by the caller; read only
+	int Import(const std::string& name, unsigned int texture)
+	{
+		Target target;
+		target.Name = name;
+		target.Imported = true;
+		target.Exported = false;
+		target.Texture = texture;
+		target.Desc = describe(GL_RGBA16F, 0);
+		target.Shift = 0;
+		target.Slot = -1;
+		targets.push_back(target);
+		return (int)targets.size() - 1;
+	}
+
+	// a transient color or depth target of (output size >> shift)
+	int Create(const std::string& name, GLenum internalFormat, int shift = 0)
+	{
+		Target target;
+		target.Name = name;
+		target.Imported = false;
+		target.Exported = false;
+		target.Texture = 0;
+		target.Desc = describe(internalFormat, shift);
+		target.Shift = shift;
+		target.Slot = -1;
+		targets.push_back(target);
+		compiled = false;
+		return (int)targets.size() - 1;
+	}
+
+	// keeps a target alive after the last pass, for reading it after Execute()
+	void Export(int target)
+	{
+		targets[target].Exported = true;
+		compiled = false;
+	}
+
+	// depth is a depth target attached next to the output, -1 for none
+	void AddPass(const std::string& name, const std::vector<int>& inputs, int output, PassFunction execute, int depth = -1)
+	{
+		Pass pass;
+		pass.Name = name;
+		pass.Inputs = inputs;
+		pass.Output = output;
+		pass.Depth = depth;
+		pass.Execute = execute;
+		pass.Framebuffer = 0;
+		passes.push_back(pass);
+		compiled = false;
+	}
+
+	// assigns pool textures to the transient targets: a target is acquired before its first pass and released
+	// after its last one, the targets first used by a pass are acquired before the ones it last uses are released
+	void Compile()
+	{
+		std::vector<int> first(targets.size(), -1), last(targets.size(), -1);
+		for (int p = 0; p < (int)passes.size(); ++p)
+		{
+			std::vector<int> used = passes[p].Inputs;
+			used.push_back(passes[p].Output);
+			used.push_back(passes[p].Depth);
+			for (size_t i = 0; i < used.size(); ++i)
+			{
+				int t = used[i];
+				if (t < 0)
+					continue;
+				if (first[t] < 0)
+					first[t] = p;
+				last[t] = targets[t].Exported ? (int)passes.size() : p;
+			}
+		}
+
+		pool.ReleaseAll();
+		for (size_t t = 0; t < targets.size(); ++t)
+			targets[t].Slot = -1;
+		for (int p = 0; p < (int)passes.size(); ++p)
+		{
+			for (size_t t = 0; t < targets.size(); ++t)
+				if (!targets[t].Imported && first[t] == p)
+					targets[t].Slot = pool.Acquire(targets[t].Desc);
+			for (size_t t = 0; t < targets.size(); ++t)
+				if (!targets[t].Imported && last[t] == p)
+					pool.Release(targets[t].Slot);
+		}
+		pool.Trim();
+		releaseFramebuffers();
+		compiled = true;
+	}
+
+	void Execute()
+	{
+		if (!compiled)
+			Compile();
+		for (size_t p = 0; p < passes.size(); ++p)
+		{
+			Pass& pass = passes[p];
+			bind(pass);
+			for (size_t i = 0; i < pass.Inputs.size(); ++i)
+			{
+				glActiveTexture(GL_TEXTURE0 + (GLenum)i);
+				glBindTexture(GL_TEXTURE_2D, Texture(pass.Inputs[i]));
+			}
+			glActiveTexture(GL_TEXTURE0);
+			pass.Execute();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, width, height);
+	}
+
+	// texture of a target; with aliasing a transient target only holds its content until its last pass has run
+	unsigned int Texture(int target)
+	{
+		if (targets[target].Imported)
+			return targets[target].Texture;
+		return targets[target].Slot >= 0 ? pool.Texture(targets[target].Slot) : 0;
+	}
+
+	// framebuffer with only this transient target attached, e.g. as the read framebuffer of a blit
+	unsigned int Framebuffer(int target)
+	{
+		return targets[target].Slot >= 0 ? pool.Framebuffer(targets[target].Slot) : 0;
+	}
+
+	const RenderTargetDesc& Desc(int target) const
+	{
+		return targets[target].Desc;
+	}
+
+	// memory the transient targets would need with one texture each
+	size_t DeclaredBytes() const
+	{
+		size_t bytes = 0;
+		for (size_t t = 0; t < targets.size(); ++t)
+			if (!targets[t].Imported && targets[t].Slot >= 0)
+				bytes += targets[t].Desc.Bytes();
+		return bytes;
+	}
+
+	// memory of the pool textures they were assigned after Compile()
+	size_t PooledBytes() const
+	{
+		return pool.Bytes();
+	}
+
+	int PooledCount() const
+	{
+		return pool.Count();
+	}
+
+	int PassCount() const
+	{
+		return (int)passes.size();
+	}
+
+	int OutputWidth() const { return width; }
+	int OutputHeight() const { return height; }
+
+private:
+
+	struct Target
+	{
+		std::string Name;
+		bool Imported;
+		bool Exported;
+		unsigned int Texture;
+		RenderTargetDesc Desc;
+		int Shift;
+		int Slot;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		std::vector<int> Inputs;
+		int Output;
+		int Depth;
+		PassFunction Execute;
+		unsigned int Framebuffer;   // own framebuffer of a pass with a depth target, the pool ones hold one target
+	};
+
+	int width;
+	int height;
+	bool compiled;
+	std::vector<Target> targets;
+	std::vector<Pass> passes;
+	RenderTargetPool pool;
+
+	RenderTargetDesc describe(GLenum internalFormat, int shift) const
+	{
+		RenderTargetDesc desc = { internalFormat, std::max(width >> shift, 1), std::max(height >> shift, 1) };
+		return desc;
+	}
+
+	void bind(Pass& pass)
+	{
+		if (pass.Output == BACKBUFFER)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, width, height);
+			return;
+		}
+		if (pass.Depth < 0)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer(pass.Output));
+		}
+		else if (pass.Framebuffer)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, pass.Framebuffer);
+		}
+		else
+		{
+			// attached once per Compile(), the pool textures only change there
+			glGenFramebuffers(1, &pass.Framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, pass.Framebuffer);
+			GLenum attachment = Desc(pass.Depth).InternalFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture(pass.Output), 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, Texture(pass.Depth), 0);
+		}
+		const RenderTargetDesc& desc = targets[pass.Output].Desc;
+		glViewport(0, 0, desc.Width, desc.Height);
+	}
+
+	void releaseFramebuffers()
+	{
+		for (size_t p = 0; p < passes.size(); ++p)
+		{
+			if (passes[p].Framebuffer)
+				glDeleteFramebuffers(1, &passes[p].Framebuffer);
+			passes[p].Framebuffer = 0;
+		}
+	}
+
+	PostChain(const PostChain&);
+	PostChain& operator=(const PostChain&);
+};
+
+#endif
@@ -0,0 +1,388 @@
+#ifndef REFLECTION_PROBE_H
+#define REFLECTION_PROBE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/gpu_timer.h>
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+// A reflection probe placed in the scene: the scene is captured into a cubemap from Position and filtered into the
+// irradiance map and the pre-filtered specular map the 6.pbr shaders sample, with the same convolution shaders as
+// the static environment. Capturing and filtering a whole probe at once costs far more than a frame can spare, so an
+// update is split into steps of one face or one face of one mip level (see Step), which ProbeUpdater spreads over
+// frames. The filtered maps are double buffered: shading always reads the maps of the last completed update while
+// the next one is built in the other pair, and the two swap when the last step of an update is done.
+class ReflectionProbe
+{
+public:
+
+	enum StepKind
+	{
+		CAPTURE_FACE,     // render the scene into one face of the capture cubemap
+		GENERATE_MIPS,    // mip chain of the capture cubemap, read by the filtered importance sampling of the pre-filter
+		IRRADIANCE_FACE,  // convolve one face of the irradiance map
+		PREFILTER_FACE    // pre-filter one face of one roughness level
+	};
+
+	struct Step
+	{
+		StepKind Kind;
+		int Face;
+		int Mip;
+	};
+
+	glm::vec3 Position;
+	int CaptureSize;
+	int IrradianceSize;
+	int PrefilterSize;
+	int PrefilterLevels;
+
+	int Updates;       // completed updates, the filtered maps are valid once this is > 0
+	int UpdateFrames;  // frames the last completed update was spread over
+
+	ReflectionProbe(glm::vec3 position, int captureSize = 128, int irradianceSize = 16, int prefilterSize = 64, int prefilterLevels = 5)
+		: Position(position), CaptureSize(captureSize), IrradianceSize(irradianceSize), PrefilterSize(prefilterSize),
+		PrefilterLevels(prefilterLevels), Updates(0), UpdateFrames(0), next(0), front(0), startFrame(0)
+	{
+		captureMap = createCubemap(CaptureSize, true);
+		for (int i = 0; i < 2; ++i)
+		{
+			irradianceMaps[i] = createCubemap(IrradianceSize, false);
+			prefilterMaps[i] = createCubemap(PrefilterSize, true);
+			// only the levels that are filtered are sampled
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, PrefilterLevels - 1);
+		}
+
+		glGenFramebuffers(1, &captureFBO);
+		glGenRenderbuffers(1, &captureRBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, CaptureSize, CaptureSize);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+		// the convolutions draw a cube around the origin and need no depth buffer
+		glGenFramebuffers(1, &filterFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	~ReflectionProbe()
+	{
+		glDeleteTextures(1, &captureMap);
+		glDeleteTextures(2, irradianceMaps);
+		glDeleteTextures(2, prefilterMaps);
+		glDeleteFramebuffers(1, &captureFBO);
+		glDeleteFramebuffers(1, &filterFBO);
+		glDeleteRenderbuffers(1, &captureRBO);
+	}
+
+	// maps of the last completed update, to bind for shading
+	unsigned int IrradianceMap() const { return irradianceMaps[front]; }
+	unsigned int PrefilterMap() const { return prefilterMaps[front]; }
+	// unfiltered capture, partially overwritten while an update is in progress
+	unsigned int CaptureMap() const { return captureMap; }
+
+	int StepCount() const
+	{
+		return 6 + 1 + 6 + 6 * PrefilterLevels;
+	}
+
+	// step the next call to RunStep() performs, the steps of an update run in this order
+	Step NextStep() const
+	{
+		Step step = { CAPTURE_FACE, 0, 0 };
+		int index = next;
+		if (index < 6)
+		{
+			step.Face = index;
+			return step;
+		}
+		index -= 6;
+		if (index == 0)
+		{
+			step.Kind = GENERATE_MIPS;
+			return step;
+		}
+		index -= 1;
+		if (index < 6)
+		{
+			step.Kind = IRRADIANCE_FACE;
+			step.Face = index;
+			return step;
+		}
+		index -= 6;
+		step.Kind = PREFILTER_FACE;
+		step.Mip = index / 6;
+		step.Face = index % 6;
+		return step;
+	}
+
+	// true when no step of the current update has run yet
+	bool UpdateStarting() const
+	{
+		return next == 0;
+	}
+
+	// view matrix of a cubemap face seen from position, in the face order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+	static glm::mat4 FaceView(int face, glm::vec3 position)
+	{
+		static const glm::vec3 directions[6] = {
+			glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+		};
+		static const glm::vec3 ups[6] = {
+			glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+			glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+		};
+		return glm::lookAt(position, position + directions[face], ups[face]);
+	}
+
+private:
+
+	friend class ProbeUpdater;
+
+	unsigned int captureMap;
+	unsigned int irradianceMaps[2];
+	unsigned int prefilterMaps[2];
+	unsigned int captureFBO, captureRBO, filterFBO;
+	int next;        // index of the next step of the current update
+	int front;       // pair of filtered maps that is shaded with
+	int startFrame;  // frame the current update started in
+
+	static unsigned int createCubemap(int size, bool mipmapped)
+	{
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+		for (unsigned int i = 0; i < 6; ++i)
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// allocate the levels up front, they are rendered to one by one
+		if (mipmapped)
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+		return texture;
+	}
+
+	ReflectionProbe(const ReflectionProbe&);
+	ReflectionProbe& operator=(const ReflectionProbe&);
+};
+
+// Runs the update steps of a set of probes within a per-frame budget of GPU milliseconds. Every kind of step (and
+// every pre-filter level, whose cost depends on its size and sample count) has a GpuTimer, and Update() keeps running
+// steps while the measured cost of the next one still fits in what is left of BudgetMs. The probes are updated one
+// after the other, so each update completes as early as possible instead of all of them lagging equally.
+//  - a step whose cost is not known yet runs alone in a frame, so the budget is only exceeded by one step while
+//    the timers warm up; at least one step runs every frame, so a budget below the cheapest step still progresses
+//  - the scene is drawn by the callback with the view and projection of the face being captured; it may shade with
+//    the filtered maps of any probe (which gives interreflections over successive updates), never with the capture
+//  - the shaders are the convolution shaders of the 2.2.x demos: environmentMap on unit 0, the pre-filter also
+//    takes roughness, sampleCount and the resolution of the captured cubemap
+//  - steps are timed, so Update() must not be called while another GpuTimer is running
+class ProbeUpdater
+{
+public:
+	typedef std::function<void(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position)> SceneFunction;
+
+	float BudgetMs;
+	// cost the last Update() budgeted for its steps, not a measurement: the latest timer result of each step, the
+	// whole budget for a step that was not measured yet
+	float EstimatedMs;
+	int FrameSteps;   // number of steps run by the last Update()
+
+	// sampleCounts: GGX samples per pre-filter level, the last entry is used for any further levels
+	ProbeUpdater(Shader& irradianceShader, Shader& prefilterShader, const std::vector<unsigned int>& sampleCounts,
+		std::function<void()> renderCube, SceneFunction renderScene, float budgetMs)
+		: BudgetMs(budgetMs), EstimatedMs(0.0f), FrameSteps(0), irradianceShader(irradianceShader), prefilterShader(prefilterShader),
+		sampleCounts(sampleCounts), renderCube(renderCube), renderScene(renderScene), current(0), frame(0)
+	{
+		irradianceShader.use();
+		irradianceShader.setInt("environmentMap", 0);
+		prefilterShader.use();
+		prefilterShader.setInt("environmentMap", 0);
+	}
+
+	~ProbeUpdater()
+	{
+		for (size_t i = 0; i < timers.size(); ++i)
+			delete timers[i];
+	}
+
+	void Add(ReflectionProbe* probe)
+	{
+		probes.push_back(probe);
+		// capture, mips, irradiance and one timer per pre-filter level
+		while (timers.size() < (size_t)(3 + probe->PrefilterLevels))
+		{
+			timers.push_back(new GpuTimer());
+			timedFrame.push_back(-1);
+		}
+	}
+
+	// spends up to BudgetMs on probe updates, call once per frame; restores the framebuffer and viewport
+	void Update()
+	{
+		EstimatedMs = 0.0f;
+		FrameSteps = 0;
+		++frame;
+		if (probes.empty())
+			return;
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		// never more than one full update of every probe, however large the budget
+		int maxSteps = 0;
+		for (size_t i = 0; i < probes.size(); ++i)
+			maxSteps += probes[i]->StepCount();
+
+		while (FrameSteps < maxSteps)
+		{
+			ReflectionProbe& probe = *probes[current];
+			ReflectionProbe::Step step = probe.NextStep();
+			int timer = timerIndex(step);
+			bool measured = timers[timer]->Samples() > 0;
+			float cost = measured ? timers[timer]->Milliseconds : BudgetMs;
+			if (FrameSteps > 0 && (!measured || EstimatedMs + cost > BudgetMs))
+				break;
+
+			// one query per timer and frame: repeating a step kind within a frame would wait on the ring of queries
+			bool timed = timedFrame[timer] != frame;
+			if (timed)
+			{
+				timedFrame[timer] = frame;
+				timers[timer]->Begin();
+			}
+			if (probe.UpdateStarting())
+				probe.startFrame = frame;
+			runStep(probe, step);
+			if (timed)
+				timers[timer]->End();
+
+			EstimatedMs += cost;
+			++FrameSteps;
+			if (probe.UpdateStarting())
+				current = (current + 1) % (int)probes.size();
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+
+	// runs a complete update of every probe regardless of the budget, to have valid maps before the first frame
+	void UpdateAll()
+	{
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		for (size_t i = 0; i < probes.size(); ++i)
+		{
+			ReflectionProbe& probe = *probes[i];
+			probe.startFrame = frame;
+			do
+				runStep(probe, probe.NextStep());
+			while (!probe.UpdateStarting());
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+
+	// smoothed GPU time of a step kind, 0 until it was measured
+	float StepMilliseconds(ReflectionProbe::StepKind kind, int mip = 0) const
+	{
+		ReflectionProbe::Step step = { kind, 0, mip };
+		size_t index = (size_t)timerIndex(step);
+		return index < timers.size() ? timers[index]->Milliseconds : 0.0f;
+	}
+
+private:
+
+	Shader& irradianceShader;
+	Shader& prefilterShader;
+	std::vector<unsigned int> sampleCounts;
+	std::function<void()> renderCube;
+	SceneFunction renderScene;
+	std::vector<ReflectionProbe*> probes;
+	std::vector<GpuTimer*> timers;
+	std::vector<int> timedFrame;  // last frame each timer was started in
+	int current;                  // probe that is being updated
+	int frame;
+
+	static int timerIndex(const ReflectionProbe::Step& step)
+	{
+		return step.Kind == ReflectionProbe::PREFILTER_FACE ? 3 + step.Mip : (int)step.Kind;
+	}
+
+	void runStep(ReflectionProbe& probe, const ReflectionProbe::Step& step)
+	{
+		// the convolutions look at the cube around the origin like the bake of the static maps
+		glm::mat4 filterProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+		glm::mat4 filterView = ReflectionProbe::FaceView(step.Face, glm::vec3(0.0f));
+		int back = 1 - probe.front;
+
+		switch (step.Kind)
+		{
+		case ReflectionProbe::CAPTURE_FACE:
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, probe.captureFBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + step.Face, probe.captureMap, 0);
+			glViewport(0, 0, probe.CaptureSize, probe.CaptureSize);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderScene(ReflectionProbe::FaceView(step.Face, probe.Position), glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f), probe.Position);
+			break;
+		}
+		case ReflectionProbe::GENERATE_MIPS:
+			glBindTexture(GL_TEXTURE_CUBE_MAP, probe.captureMap);
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+			break;
+		case ReflectionProbe::IRRADIANCE_FACE:
+			glBindFramebuffer(GL_FRAMEBUFFER, probe.filterFBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + step.Face, probe.irradianceMaps[back], 0);
+			glViewport(0, 0, probe.IrradianceSize, probe.IrradianceSize);
+			irradianceShader.use();
+			irradianceShader.setMat4("projection", filterProjection);
+			irradianceShader.setMat4("view", filterView);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, probe.captureMap);
+			renderCube();
+			break;
+		case ReflectionProbe::PREFILTER_FACE:
+		{
+			int mipSize = std::max(probe.PrefilterSize >> step.Mip, 1);
+			glBindFramebuffer(GL_FRAMEBUFFER, probe.filterFBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + step.Face, probe.prefilterMaps[back], step.Mip);
+			glViewport(0, 0, mipSize, mipSize);
+			prefilterShader.use();
+			prefilterShader.setMat4("projection", filterProjection);
+			prefilterShader.setMat4("view", filterView);
+			prefilterShader.setFloat("roughness", probe.PrefilterLevels > 1 ? (float)step.Mip / (float)(probe.PrefilterLevels - 1) : 0.0f);
+			prefilterShader.setInt("sampleCount", sampleCounts[std::min((size_t)step.Mip, sampleCounts.size() - 1)]);
+			prefilterShader.setFloat("resolution", (float)probe.CaptureSize);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, probe.captureMap);
+			renderCube();
+			break;
+		}
+		}
+
+		if (++probe.next == probe.StepCount())
+		{
+			probe.next = 0;
+			probe.front = back;
+			probe.UpdateFrames = frame - probe.startFrame + 1;
+			++probe.Updates;
+		}
+	}
+
+	// owns the step timers
+	ProbeUpdater(const ProbeUpdater&);
+	ProbeUpdater& operator=(const ProbeUpdater&);
+};
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// A rectangle inside the atlas, handed out by ShadowAtlas::Allocate. Size is always a power of two.
+struct ShadowTile
+{
+	int Node = -1;
+	unsigned int X = 0;
+	unsigned int Y = 0;
+	unsigned int Size = 0;
+
+	bool Valid() const { return Node >= 0; }
+};
+
+// One large depth texture shared by many shadow casting lights.
+// The texture is sub-allocated by a quadtree: every node is either free, split into four children or used,
+// so tiles of different power-of-two sizes can live side by side and merge back together once released.
+class ShadowAtlas
+{
+	enum ENodeState
+	{
+		ENODE_FREE,
+		ENODE_SPLIT,
+		ENODE_USED
+	};
+public:
+
+	unsigned int FBO;
+	unsigned int DepthMap;
+	unsigned int Size;
+	unsigned int MinTileSize;
+
+	// constructor, size and minTileSize must be powers of two
+	ShadowAtlas(unsigned int size = 4096, unsigned int minTileSize = 64) : Size(size), MinTileSize(minTileSize), usedTexels(0)
+	{
+		// the tree is complete down to the smallest tile size, stored implicitly (children of i are 4i+1 .. 4i+4)
+		unsigned int levels = 1;
+		for (unsigned int s = Size; s > MinTileSize; s >>= 1)
+			++levels;
+		nodes.assign(((1u << (2 * levels)) - 1) / 3, (unsigned char)ENODE_FREE);
+
+		glGenTextures(1, &DepthMap);
+		glBindTexture(GL_TEXTURE_2D, DepthMap);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, Size, Size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		// hardware depth comparison, the linear filter gives a free 2x2 PCF inside every tile
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+		glGenFramebuffers(1, &FBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, DepthMap, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	~ShadowAtlas()
+	{
+		glDeleteFramebuffers(1, &FBO);
+		glDeleteTextures(1, &DepthMap);
+	}
+
+	// returns an invalid tile if no free region of the requested size is left
+	ShadowTile Allocate(unsigned int tileSize)
+	{
+		ShadowTile tile;
+		tileSize = ClampTileSize(tileSize);
+		allocateNode(0, 0, 0, Size, tileSize, tile);
+		if (tile.Valid())
+			usedTexels += tile.Size * tile.Size;
+		return tile;
+	}
+
+	// all or nothing: count tiles of the largest size from tileSize down to minTileSize that still fits,
+	// returns false and leaves every tile invalid if not even the smallest size fits
+	bool AllocateGroup(ShadowTile* tiles, int count, unsigned int tileSize, unsigned int minTileSize = 0)
+	{
+		minTileSize = ClampTileSize(minTileSize);
+		for (unsigned int size = ClampTileSize(tileSize); size >= minTileSize; size >>= 1)
+		{
+			int allocated = 0;
+			for (; allocated < count; ++allocated)
+			{
+				tiles[allocated] = Allocate(size);
+				if (!tiles[allocated].Valid())
+					break;
+			}
+			if (allocated == count)
+				return true;
+			for (int i = 0; i < allocated; ++i)
+				Free(tiles[i]);
+		}
+		return false;
+	}
+
+	void Free(ShadowTile& tile)
+	{
+		if (!tile.Valid())
+			return;
+
+		usedTexels -= tile.Size * tile.Size;
+		nodes[tile.Node] = ENODE_FREE;
+
+		// collapse parents whose four children are all free again
+		int node = tile.Node;
+		while (node > 0)
+		{
+			int parent = (node - 1) / 4;
+			bool allFree = true;
+			for (int i = 1; i <= 4; ++i)
+				allFree = allFree && nodes[parent * 4 + i] == ENODE_FREE;
+			if (!allFree)
+				break;
+			nodes[parent] = ENODE_FREE;
+			node = parent;
+		}
+		tile = ShadowTile();
+	}
+
+	void Reset()
+	{
+		std::fill(nodes.begin(), nodes.end(), (unsigned char)ENODE_FREE);
+		usedTexels = 0;
+	}
+
+	// fraction of the atlas currently handed out
+	float Occupancy() const
+	{
+		return (float)usedTexels / ((float)Size * (float)Size);
+	}
+
+	// xy: uv offset, zw: uv scale of a tile inside the atlas (all zero for an invalid tile)
+	glm::vec4 TileRect(const ShadowTile& tile) const
+	{
+		if (!tile.Valid())
+			return glm::vec4(0.0f);
+		float inv = 1.0f / (float)Size;
+		return glm::vec4(tile.X * inv, tile.Y * inv, tile.Size * inv, tile.Size * inv);
+	}
+
+	unsigned int ClampTileSize(unsigned int tileSize) const
+	{
+		unsigned int s = MinTileSize;
+		while (s < tileSize && s < Size)
+			s <<= 1;
+		return s;
+	}
+
+	// picks a tile size from the number of screen pixels a light's sphere of influence covers,
+	// so distant or small lights get small tiles and nearby lights get the most resolution
+	unsigned int TileSizeForCoverage(const glm::vec3& lightPos, float radius, const glm::vec3& viewPos, float fovy, unsigned int screenHeight, unsigned int maxTileSize, float scale = 1.0f) const
+	{
+		float distance = glm::length(lightPos - viewPos);
+		float pixels = (float)maxTileSize;
+		if (distance > radius)
+			pixels = scale * radius / (distance * std::tan(fovy * 0.5f)) * (float)screenHeight;
+		pixels = glm::clamp(pixels, (float)MinTileSize, (float)maxTileSize);
+		return ClampTileSize((unsigned int)pixels);
+	}
+
+	// binds the atlas and restricts rendering (and the depth clear) to one tile
+	void BeginTile(const ShadowTile& tile)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glEnable(GL_SCISSOR_TEST);
+		glViewport(tile.X, tile.Y, tile.Size, tile.Size);
+		glScissor(tile.X, tile.Y, tile.Size, tile.Size);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	void End()
+	{
+		glDisable(GL_SCISSOR_TEST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+private:
+
+	std::vector<unsigned char> nodes;
+	unsigned int usedTexels;
+
+	// owns the texture and framebuffer, a copy would delete them twice
+	ShadowAtlas(const ShadowAtlas&);
+	ShadowAtlas& operator=(const ShadowAtlas&);
+
+	bool allocateNode(int node, unsigned int x, unsigned int y, unsigned int nodeSize, unsigned int tileSize, ShadowTile& tile)
+	{
+		if (nodeSize < tileSize || nodes[node] == ENODE_USED)
+			return false;
+
+		if (nodes[node] == ENODE_FREE)
+		{
+			if (nodeSize == tileSize)
+			{
+				nodes[node] = ENODE_USED;
+				tile.Node = node;
+				tile.X = x;
+				tile.Y = y;
+				tile.Size = nodeSize;
+				return true;
+			}
+			// only split a free node when no already split sibling had room (checked by the caller first)
+			nodes[node] = ENODE_SPLIT;
+			for (int i = 1; i <= 4; ++i)
+				nodes[node * 4 + i] = ENODE_FREE;
+		}
+
+		unsigned int half = nodeSize / 2;
+		unsigned int cx[4] = { x, x + half, x, x + half };
+		unsigned int cy[4] = { y, y, y + half, y + half };
+
+		// best fit: prefer descending into children that are already split to keep large free blocks intact
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				int child = node * 4 + 1 + i;
+				bool split = nodes[child] == ENODE_SPLIT;
+				if ((pass == 0) != split)
+					continue;
+				if (allocateNode(child, cx[i], cy[i], half, tileSize, tile))
+					return true;
+			}
+		}
+
+		// nothing fit, undo the split we just made
+		bool allFree = true;
+		for (int i = 1; i <= 4; ++i)
+			allFree = allFree && nodes[node * 4 + i] == ENODE_FREE;
+		if (allFree)
+			nodes[node] = ENODE_FREE;
+		return false;
+	}
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef SPHERICAL_HARMONICS_H
+#define SPHERICAL_HARMONICS_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SPHERICAL_HARMONICS_SSE 1
+#endif
+
+// Diffuse irradiance as 9 spherical harmonics coefficients (bands 0 to 2), after Ramamoorthi and Hanrahan, "An
+// Efficient Representation for Irradiance Environment Maps". The cosine lobe is almost entirely contained in the
+// first three bands, so the projected environment reproduces the irradiance map to within a few percent and the
+// shader evaluates it with a handful of multiply-adds instead of a cubemap fetch:
+//   irradiance / PI = C0 + C1 y + C2 z + C3 x + C4 xy + C5 yz + C6 (3z^2 - 1) + C7 xz + C8 (x^2 - y^2)
+// The coefficients already include the basis normalization and the cosine lobe convolution, and they are divided by
+// PI to match what the irradiance map stores (the PBR shaders multiply it by albedo directly).
+struct SH9
+{
+	glm::vec3 Coefficients[9];
+
+	SH9()
+	{
+		for (int i = 0; i < 9; ++i)
+			Coefficients[i] = glm::vec3(0.0f);
+	}
+
+	// irradiance / PI around normal n (normalized), the CPU version of the shader function
+	glm::vec3 Evaluate(const glm::vec3& n) const
+	{
+		glm::vec3 result = Coefficients[0]
+			+ Coefficients[1] * n.y + Coefficients[2] * n.z + Coefficients[3] * n.x
+			+ Coefficients[4] * (n.x * n.y) + Coefficients[5] * (n.y * n.z) + Coefficients[6] * (3.0f * n.z * n.z - 1.0f)
+			+ Coefficients[7] * (n.x * n.z) + Coefficients[8] * (n.x * n.x - n.y * n.y);
+		return glm::max(result, glm::vec3(0.0f));
+	}
+
+	// sets the vec3 array uniform "name[9]"
+	void SetUniforms(Shader& shader, const std::string& name = "shCoefficients") const
+	{
+		for (int i = 0; i < 9; ++i)
+			shader.setVec3(name + "[" + std::to_string(i) + "]", Coefficients[i]);
+	}
+
+	// world space direction through texel coordinates s, t (both in [-1, 1]) of cubemap face +X, -X, +Y, -Y, +Z, -Z,
+	// following the OpenGL face orientation; t grows with the row index as glGetTexImage returns the rows
+	static glm::vec3 CubemapDirection(int face, float s, float t)
+	{
+		switch (face)
+		{
+		case 0: return glm::normalize(glm::vec3(1.0f, -t, -s));
+		case 1: return glm::normalize(glm::vec3(-1.0f, -t, s));
+		case 2: return glm::normalize(glm::vec3(s, 1.0f, t));
+		case 3: return glm::normalize(glm::vec3(s, -1.0f, -t));
+		case 4: return glm::normalize(glm::vec3(s, -t, 1.0f));
+		default: return glm::normalize(glm::vec3(-s, -t, -1.0f));
+		}
+	}
+
+	// projects the radiance of a cubemap onto the basis: texels holds the 6 faces (+X to -Z) of size x size RGBA float
+	// texels each. Rows are split over the available cores, each thread reduces into its own sums which are added up
+	// at the end; the RGB(A) of a texel is accumulated in one SSE register when available. Every texel is weighted by
+	// its solid angle, so low resolution mips (32^2 to 64^2) already give the full precision of 9 coefficients.
+	static SH9 ProjectCubemap(const float* texels, int size, float* milliseconds = NULL)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+		int rows = 6 * size;
+		int threadCount = (int)std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+		threadCount = std::min(threadCount, rows);
+		std::vector<float> partial((size_t)threadCount * PARTIAL_FLOATS, 0.0f);
+		std::vector<std::thread> threads;
+		for (int t = 1; t < threadCount; ++t)
+			threads.push_back(std::thread(projectRows, texels, size, t * rows / threadCount, (t + 1) * rows / threadCount, &partial[(size_t)t * PARTIAL_FLOATS]));
+		projectRows(texels, size, 0, rows / threadCount, &partial[0]);
+		for (size_t t = 0; t < threads.size(); ++t)
+			threads[t].join();
+
+		double sums[PARTIAL_FLOATS] = { 0.0 };
+		for (int t = 0; t < threadCount; ++t)
+			for (int i = 0; i < PARTIAL_FLOATS; ++i)
+				sums[i] += partial[(size_t)t * PARTIAL_FLOATS + i];
+
+		// Y_k^2 normalization times the cosine lobe (A_l / PI: 1, 2/3, 1/4) times 4 PI / total weight, the weights only
+		// approximate the solid angles so they are renormalized to cover the sphere exactly
+		const float PI = 3.14159265359f;
+		static const float basis[9] = { 0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f };
+		static const float lobe[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+		double sphere = 4.0 * PI / sums[36];
+		SH9 sh;
+		for (int k = 0; k < 9; ++k)
+		{
+			float scale = (float)(basis[k] * basis[k] * lobe[k] * sphere);
+			sh.Coefficients[k] = glm::vec3((float)sums[k * 4], (float)sums[k * 4 + 1], (float)sums[k * 4 + 2]) * scale;
+		}
+
+		if (milliseconds)
+			*milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return sh;
+	}
+
+private:
+
+	// 9 RGBA sums and the total weight
+	static const int PARTIAL_FLOATS = 9 * 4 + 1;
+
+	// rows [firstRow, lastRow) counted over all faces, face = row / size
+	static void projectRows(const float* texels, int size, int firstRow, int lastRow, float* out)
+	{
+#ifdef SPHERICAL_HARMONICS_SSE
+		__m128 sum[9];
+		for (int k = 0; k < 9; ++k)
+			sum[k] = _mm_setzero_ps();
+#else
+		float sum[9][4] = { { 0.0f } };
+#endif
+		double totalWeight = 0.0;
+		float texel = 2.0f / size;
+		for (int row = firstRow; row < lastRow; ++row)
+		{
+			int face = row / size;
+			float t = (row % size + 0.5f) * texel - 1.0f;
+			const float* line = texels + (size_t)row * size * 4;
+			for (int x = 0; x < size; ++x)
+			{
+				float s = (x + 0.5f) * texel - 1.0f;
+				// solid angle of the texel up to a constant factor
+				float d = 1.0f + s * s + t * t;
+				float weight = 1.0f / (d * std::sqrt(d));
+				totalWeight += weight;
+
+				glm::vec3 n = CubemapDirection(face, s, t);
+				float polynomial[9] = {
+					weight, n.y * weight, n.z * weight, n.x * weight, n.x * n.y * weight, n.y * n.z * weight,
+					(3.0f * n.z * n.z - 1.0f) * weight, n.x * n.z * weight, (n.x * n.x - n.y * n.y) * weight
+				};
+#ifdef SPHERICAL_HARMONICS_SSE
+				__m128 color = _mm_loadu_ps(line + x * 4);
+				for (int k = 0; k < 9; ++k)
+					sum[k] = _mm_add_ps(sum[k], _mm_mul_ps(color, _mm_set1_ps(polynomial[k])));
+#else
+				for (int k = 0; k < 9; ++k)
+					for (int c = 0; c < 4; ++c)
+						sum[k][c] += line[x * 4 + c] * polynomial[k];
+#endif
+			}
+		}
+		for (int k = 0; k < 9; ++k)
+		{
+#ifdef SPHERICAL_HARMONICS_SSE
+			_mm_storeu_ps(out + k * 4, sum[k]);
+#else
+			std::copy(sum[k], sum[k] + 4, out + k * 4);
+#endif
+		}
+		out[36] = (float)totalWeight;
+	}
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef TEMPORAL_AA_H
+#define TEMPORAL_AA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+
+#include <cstddef>
+
+// Temporal accumulation of a jittered render target into a history that persists across frames: anti-aliasing
+// when the render and output sizes match, temporal upsampling when the scene is rendered at a lower resolution.
+// Every frame:
+//  1. NextJitter() gives the sub-pixel offset of this frame (Halton 2, 3), pass it to Camera::SetJitter and render
+//     the scene with Camera::GetProjectionMatrix
+//  2. the geometry passes write motion vectors into an RG16F target: current minus previous texture coordinate,
+//     computed with the unjittered projection so the jitter itself does not show up as motion
+//  3. Resolve() reprojects the history with the motion vectors, clips it to the colour range of the current
+//     frame's 3x3 neighbourhood and blends the current frame in, the result is the new history
+//
+// The resolve shader is passed in by the demo (see 8.1.taa_resolve.vs/.fs in 8.1.deferred_shading), it draws a
+// single fullscreen triangle without vertex attributes.
+class TemporalAA
+{
+public:
+
+	int RenderWidth;    // size of the jittered color and velocity targets
+	int RenderHeight;
+	int OutputWidth;    // size of the history, larger than the render size for temporal upsampling
+	int OutputHeight;
+	int SampleCount;    // length of the jitter sequence
+	float FeedbackMin;  // history weight where the history had to be clipped, low to avoid ghosting
+	float FeedbackMax;  // history weight of converged pixels, high for stable edges
+
+	TemporalAA(Shader& resolveShader)
+		: RenderWidth(0), RenderHeight(0), OutputWidth(0), OutputHeight(0), SampleCount(8), FeedbackMin(0.88f),
+		  FeedbackMax(0.97f), resolveShader(resolveShader), frame(0), current(0), historyValid(false), jitter(0.0f)
+	{
+		glGenVertexArrays(1, &emptyVAO);
+		glGenFramebuffers(2, historyFBO);
+		history[0] = history[1] = 0;
+	}
+
+	~TemporalAA()
+	{
+		release();
+		glDeleteVertexArrays(1, &emptyVAO);
+		glDeleteFramebuffers(2, historyFBO);
+	}
+
+	// (re)allocates the history when the output size changes; any size change drops the history
+	void Resize(int renderWidth, int renderHeight, int outputWidth, int outputHeight)
+	{
+		RenderWidth = renderWidth;
+		RenderHeight = renderHeight;
+		historyValid = false;
+		if (outputWidth == OutputWidth && outputHeight == OutputHeight)
+			return;
+		release();
+		OutputWidth = outputWidth;
+		OutputHeight = outputHeight;
+		glGenTextures(2, history);
+		for (int i = 0; i < 2; ++i)
+		{
+			glBindTexture(GL_TEXTURE_2D, history[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, OutputWidth, OutputHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, history[i], 0);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	// drops the history, e.g. after a camera cut, the next Resolve() starts from the current frame
+	void Reset()
+	{
+		historyValid = false;
+	}
+
+	// advances to the next frame and returns its jitter in render target pixels, within [-0.5, 0.5]
+	glm::vec2 NextJitter()
+	{
+		frame = (frame + 1) % (SampleCount > 0 ? SampleCount : 1);
+		jitter = Halton(frame + 1) - glm::vec2(0.5f);
+		return jitter;
+	}
+
+	// accumulates colorTexture (render size, rendered with the last NextJitter()) into the history using the motion
+	// vectors of velocityTexture (render size); the new history is left in HistoryTexture() / HistoryFramebuffer().
+	// Changes the texture bindings of units 0 to 2, leaves framebuffer 0 bound and restores the caller's viewport.
+	void Resolve(unsigned int colorTexture, unsigned int velocityTexture)
+	{
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glDisable(GL_DEPTH_TEST);
+
+		int next = 1 - current;
+		glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[next]);
+		glViewport(0, 0, OutputWidth, OutputHeight);
+
+		resolveShader.use();
+		resolveShader.setInt("currentColor", 0);
+		resolveShader.setInt("velocityTexture", 1);
+		resolveShader.setInt("historyColor", 2);
+		resolveShader.setVec2("jitter", jitter);
+		resolveShader.setFloat("feedbackMin", FeedbackMin);
+		resolveShader.setFloat("feedbackMax", FeedbackMax);
+		resolveShader.setBool("historyValid", historyValid);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, colorTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, velocityTexture);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, history[current]);
+		glBindVertexArray(emptyVAO);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+		glActiveTexture(GL_TEXTURE0);
+
+		current = next;
+		historyValid = true;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		if (depthTest)
+			glEnable(GL_DEPTH_TEST);
+	}
+
+	// output size RGBA16F result of the last Resolve()
+	unsigned int HistoryTexture() const
+	{
+		return history[current];
+	}
+
+	unsigned int HistoryFramebuffer() const
+	{
+		return historyFBO[current];
+	}
+
+	// memory of both history textures
+	size_t HistoryBytes() const
+	{
+		return (size_t)OutputWidth * OutputHeight * 8 * 2;
+	}
+
+	// point index (> 0) of the Halton (2, 3) sequence, a low discrepancy set of sample positions in [0, 1)^2
+	static glm::vec2 Halton(int index)
+	{
+		return glm::vec2(radicalInverse(index, 2), radicalInverse(index, 3));
+	}
+
+private:
+
+	Shader& resolveShader;
+	unsigned int emptyVAO;
+	unsigned int historyFBO[2];
+	unsigned int history[2];
+	int frame;
+	int current;
+	bool historyValid;
+	glm::vec2 jitter;
+
+	static float radicalInverse(int index, int base)
+	{
+		float result = 0.0f;
+		float fraction = 1.0f / base;
+		for (int i = index; i > 0; i /= base, fraction /= base)
+			result += (i % base) * fraction;
+		return result;
+	}
+
+	void release()
+	{
+		if (history[0])
+			glDeleteTextures(2, history);
+		history[0] = history[1] = 0;
+	}
+
+	TemporalAA(const TemporalAA&);
+	TemporalAA& operator=(const TemporalAA&);
+};
+
+#endif
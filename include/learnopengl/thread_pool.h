@@ -0,0 +1,112 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+
+// A fixed set of worker threads for data parallel loops. The workers sleep between jobs, so one pool can be reused
+// for every pass of a bake without paying for thread creation each time. ParallelFor() hands out task indices one
+// by one from an atomic counter, which balances tasks of uneven cost (mip levels, rows of different roughness), and
+// the calling thread works on the job as well.
+class ThreadPool
+{
+public:
+
+	// threadCount includes the calling thread, 0 uses every hardware thread
+	explicit ThreadPool(int threadCount = 0)
+		: task(NULL), taskCount(0), nextTask(0), busyWorkers(0), generation(0), stopping(false)
+	{
+		if (threadCount <= 0)
+			threadCount = (int)std::max(std::thread::hardware_concurrency(), 1u);
+		for (int i = 1; i < threadCount; ++i)
+			workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < workers.size(); ++i)
+			workers[i].join();
+	}
+
+	int ThreadCount() const
+	{
+		return (int)workers.size() + 1;
+	}
+
+	// runs work(i) for every i in [0, count) and returns once all of them are done
+	void ParallelFor(int count, const std::function<void(int)>& work)
+	{
+		if (count <= 0)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			task = &work;
+			taskCount = count;
+			nextTask = 0;
+			busyWorkers = (int)workers.size();
+			++generation;
+		}
+		wake.notify_all();
+		runTasks(work, count);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return busyWorkers == 0; });
+		task = NULL;
+	}
+
+private:
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(int)>* task;
+	int taskCount;
+	std::atomic<int> nextTask;
+	int busyWorkers;
+	unsigned int generation;
+	bool stopping;
+
+	void runTasks(const std::function<void(int)>& work, int count)
+	{
+		for (int i = nextTask++; i < count; i = nextTask++)
+			work(i);
+	}
+
+	void workerLoop()
+	{
+		unsigned int seen = 0;
+		for (;;)
+		{
+			const std::function<void(int)>* work;
+			int count;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+				if (stopping)
+					return;
+				seen = generation;
+				work = task;
+				count = taskCount;
+			}
+			runTasks(*work, count);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--busyWorkers;
+			}
+			done.notify_one();
+		}
+	}
+};
+
+#endif
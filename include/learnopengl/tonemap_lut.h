@@ -0,0 +1,238 @@
+#ifndef TONEMAP_LUT_H
+#define TONEMAP_LUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+enum ETonemapOperator
+{
+	TONEMAP_EXPONENTIAL,        // 1 - exp(-x), what the demos used before
+	TONEMAP_REINHARD_EXTENDED,  // Reinhard on luminance with a white point
+	TONEMAP_ACES,               // Stephen Hill's fit of the ACES RRT + ODT
+	TONEMAP_UCHIMURA,           // Gran Turismo curve, linear mid section
+	TONEMAP_AGX,                // minimal AgX with the default contrast look
+	TONEMAP_COUNT
+};
+
+// everything that is baked into the LUT, a change of any of these triggers a rebake
+struct TonemapSettings
+{
+	int Operator = TONEMAP_EXPONENTIAL;
+	float WhitePoint = 4.0f;      // Reinhard extended only
+	float Contrast = 1.0f;        // around middle grey
+	float Saturation = 1.0f;
+	glm::vec3 ColorFilter = glm::vec3(1.0f);
+	float Gamma = 2.2f;
+
+	bool operator==(const TonemapSettings& o) const
+	{
+		return Operator == o.Operator && WhitePoint == o.WhitePoint && Contrast == o.Contrast &&
+			Saturation == o.Saturation && ColorFilter == o.ColorFilter && Gamma == o.Gamma;
+	}
+	bool operator!=(const TonemapSettings& o) const { return !(*this == o); }
+};
+
+// Tone mapping, grading and gamma baked into a SIZE^3 3D texture, so the per pixel work is the exposure
+// multiply, a log2 shaper and one trilinear fetch. The LUT is indexed by the log2 of the exposed HDR color
+// over [MIN_LOG2, MAX_LOG2], the first slice holds black.
+//
+// The matching fragment shader code (see 6.hdr.fs or 7.bloom_final.fs):
+//     vec3 shaped = clamp((log2(max(color, 1e-10)) - lutMinLog2) / lutLog2Range, 0.0, 1.0);
+//     vec3 mapped = texture(tonemapLUT, shaped * lutScale + lutOffset).rgb;
+class TonemapLUT
+{
+public:
+
+	static const int SIZE = 32;
+	static constexpr float MIN_LOG2 = -14.0f;
+	static constexpr float MAX_LOG2 = 8.0f;
+
+	unsigned int Texture;
+	TonemapSettings Settings;
+	float BakeMilliseconds;
+
+	TonemapLUT() : BakeMilliseconds(0.0f), data(SIZE * SIZE * SIZE * 3), baked(false)
+	{
+		glGenTextures(1, &Texture);
+		glBindTexture(GL_TEXTURE_3D, Texture);
+		glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, SIZE, SIZE, SIZE, 0, GL_RGB, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_3D, 0);
+	}
+
+	~TonemapLUT()
+	{
+		glDeleteTextures(1, &Texture);
+	}
+
+	// rebakes and uploads the LUT if the settings changed, returns true if it did
+	bool Update(const TonemapSettings& settings)
+	{
+		if (baked && settings == Settings)
+			return false;
+		Settings = settings;
+		Bake(Settings, &data[0], &BakeMilliseconds);
+		glBindTexture(GL_TEXTURE_3D, Texture);
+		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, SIZE, SIZE, SIZE, GL_RGB, GL_FLOAT, &data[0]);
+		glBindTexture(GL_TEXTURE_3D, 0);
+		baked = true;
+		return true;
+	}
+
+	void SetUniforms(const Shader& shader) const
+	{
+		shader.setFloat("lutMinLog2", MIN_LOG2);
+		shader.setFloat("lutLog2Range", MAX_LOG2 - MIN_LOG2);
+		shader.setFloat("lutScale", (SIZE - 1.0f) / SIZE);
+		shader.setFloat("lutOffset", 0.5f / SIZE);
+	}
+
+	// fills SIZE^3 RGB float texels, slices are split over the available cores (GL independent, so it
+	// can be timed and checked without a context)
+	static void Bake(const TonemapSettings& settings, float* out, float* milliseconds = NULL)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+		// shaper inverse: index -> exposed linear value, index 0 is black
+		float axis[SIZE];
+		axis[0] = 0.0f;
+		for (int i = 1; i < SIZE; ++i)
+			axis[i] = std::exp2(MIN_LOG2 + (MAX_LOG2 - MIN_LOG2) * i / (SIZE - 1.0f));
+
+		int threadCount = (int)std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+		std::vector<std::thread> threads;
+		for (int t = 1; t < threadCount; ++t)
+			threads.push_back(std::thread(bakeSlices, std::cref(settings), axis, out, t * SIZE / threadCount, (t + 1) * SIZE / threadCount));
+		bakeSlices(settings, axis, out, 0, SIZE / threadCount);
+		for (size_t t = 0; t < threads.size(); ++t)
+			threads[t].join();
+
+		if (milliseconds)
+			*milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// the full curve for one exposed linear color, returns the display (gamma encoded) color
+	static glm::vec3 Apply(const TonemapSettings& settings, glm::vec3 color)
+	{
+		const glm::vec3 luma(0.2126f, 0.7152f, 0.0722f);
+		color = glm::max(color * settings.ColorFilter, glm::vec3(0.0f));
+
+		switch (settings.Operator)
+		{
+		case TONEMAP_EXPONENTIAL:
+			color = glm::vec3(1.0f) - glm::exp(-color);
+			break;
+		case TONEMAP_REINHARD_EXTENDED:
+		{
+			float l = glm::dot(color, luma);
+			if (l > 0.0f)
+			{
+				float w2 = settings.WhitePoint * settings.WhitePoint;
+				color *= (1.0f + l / w2) / (1.0f + l);
+			}
+			break;
+		}
+		case TONEMAP_ACES:
+		{
+			// sRGB => XYZ => D65_2_D60 => AP1 => RRT_SAT, and back after the fit
+			const glm::mat3 input(0.59719f, 0.07600f, 0.02840f, 0.35458f, 0.90834f, 0.13383f, 0.04823f, 0.01566f, 0.83777f);
+			const glm::mat3 output(1.60475f, -0.10208f, -0.00327f, -0.53108f, 1.10813f, -0.07276f, -0.07367f, -0.00605f, 1.07602f);
+			glm::vec3 v = input * color;
+			v = (v * (v + 0.0245786f) - 0.000090537f) / (v * (0.983729f * v + 0.4329510f) + 0.238081f);
+			color = output * v;
+			break;
+		}
+		case TONEMAP_UCHIMURA:
+			color = glm::vec3(uchimura(color.r), uchimura(color.g), uchimura(color.b));
+			break;
+		case TONEMAP_AGX:
+		{
+			const glm::mat3 inset(0.842479062253094f, 0.0423282422610123f, 0.0423756549057051f, 0.0784335999999992f, 0.878468636469772f, 0.0784336f, 0.0792237451477643f, 0.0791661274605434f, 0.879142973793104f);
+			const glm::mat3 outset(1.19687900512017f, -0.0528968517574562f, -0.0529716355144438f, -0.0980208811401368f, 1.15190312990417f, -0.0980434501171241f, -0.0990297440797205f, -0.0989611768448433f, 1.15107367264116f);
+			const float minEv = -12.47393f;
+			const float maxEv = 4.026069f;
+			glm::vec3 v = inset * color;
+			for (int c = 0; c < 3; ++c)
+			{
+				float x = (glm::clamp(std::log2(std::max(v[c], 1e-10f)), minEv, maxEv) - minEv) / (maxEv - minEv);
+				float x2 = x * x;
+				float x4 = x2 * x2;
+				v[c] = 15.5f * x4 * x2 - 40.14f * x4 * x + 31.96f * x4 - 6.868f * x2 * x + 0.4298f * x2 + 0.1191f * x - 0.00232f;
+			}
+			// the AgX curve ends up display encoded, go back to linear for the grading below
+			color = glm::pow(glm::max(outset * v, glm::vec3(0.0f)), glm::vec3(2.2f));
+			break;
+		}
+		}
+		color = glm::clamp(color, 0.0f, 1.0f);
+
+		// grading in display linear space
+		if (settings.Contrast != 1.0f)
+			color = 0.18f * glm::pow(color / 0.18f, glm::vec3(settings.Contrast));
+		float l = glm::dot(color, luma);
+		color = glm::clamp(glm::mix(glm::vec3(l), color, settings.Saturation), 0.0f, 1.0f);
+
+		return glm::pow(color, glm::vec3(1.0f / settings.Gamma));
+	}
+
+private:
+
+	std::vector<float> data;
+	bool baked;
+
+	static void bakeSlices(const TonemapSettings& settings, const float* axis, float* out, int firstSlice, int endSlice)
+	{
+		for (int b = firstSlice; b < endSlice; ++b)
+		{
+			for (int g = 0; g < SIZE; ++g)
+			{
+				float* texel = out + ((size_t)b * SIZE + g) * SIZE * 3;
+				for (int r = 0; r < SIZE; ++r, texel += 3)
+				{
+					glm::vec3 mapped = Apply(settings, glm::vec3(axis[r], axis[g], axis[b]));
+					texel[0] = mapped.r;
+					texel[1] = mapped.g;
+					texel[2] = mapped.b;
+				}
+			}
+		}
+	}
+
+	// Uchimura 2017, "HDR theory and practice": max brightness 1, contrast 1, linear section from 0.22 to 0.62
+	static float uchimura(float x)
+	{
+		const float P = 1.0f, a = 1.0f, m = 0.22f, l = 0.4f, c = 1.33f, b = 0.0f;
+		float l0 = ((P - m) * l) / a;
+		float S0 = m + l0;
+		float S1 = m + a * l0;
+		float C2 = (a * P) / (P - S1);
+		float CP = -C2 / P;
+
+		float w0 = 1.0f - glm::smoothstep(0.0f, m, x);
+		float w2 = x < m + l0 ? 0.0f : 1.0f;
+		float w1 = 1.0f - w0 - w2;
+
+		// only evaluate the toe and shoulder where their weight is non zero, they dominate the bake time
+		float T = w0 > 0.0f ? m * std::pow(x / m, c) + b : 0.0f;
+		float S = w2 > 0.0f ? P - (P - S1) * std::exp(CP * (x - S0)) : 0.0f;
+		float L = m + a * (x - m);
+		return T * w0 + L * w1 + S * w2;
+	}
+
+	TonemapLUT(const TonemapLUT&);
+	TonemapLUT& operator=(const TonemapLUT&);
+};
+
+#endif
@@ -4,10 +4,12 @@ out vec4 FragColor;
 in vec2 TexCoords;
 
 uniform sampler2D screenTexture;
+uniform bool grayscale;
 
 void main()
 {
     vec3 col = texture(screenTexture, TexCoords).rgb;
-    float grayscale = 0.2126 * col.r + 0.7152 * col.g + 0.0722 * col.b;
-    FragColor = vec4(vec3(grayscale), 1.0);
-} 
\ No newline at end of file
+    if (grayscale)
+        col = vec3(0.2126 * col.r + 0.7152 * col.g + 0.0722 * col.b);
+    FragColor = vec4(col, 1.0);
+}
@@ -0,0 +1,135 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screenTexture;
+uniform vec2 inverseScreenSize;
+
+const float EDGE_THRESHOLD_MIN = 0.0312;
+const float EDGE_THRESHOLD_MAX = 0.125;
+const float SUBPIXEL_QUALITY = 0.75;
+const int ITERATIONS = 12;
+const float QUALITY[ITERATIONS] = float[](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0);
+
+// perceptual luma of an already display encoded color
+float luma(vec3 color)
+{
+    return sqrt(dot(color, vec3(0.299, 0.587, 0.114)));
+}
+
+void main()
+{
+    vec3 colorCenter = texture(screenTexture, TexCoords).rgb;
+    float lumaCenter = luma(colorCenter);
+    float lumaDown  = luma(textureOffset(screenTexture, TexCoords, ivec2( 0, -1)).rgb);
+    float lumaUp    = luma(textureOffset(screenTexture, TexCoords, ivec2( 0,  1)).rgb);
+    float lumaLeft  = luma(textureOffset(screenTexture, TexCoords, ivec2(-1,  0)).rgb);
+    float lumaRight = luma(textureOffset(screenTexture, TexCoords, ivec2( 1,  0)).rgb);
+
+    // 1. early out where the local contrast is too low to be an edge
+    float lumaMin = min(lumaCenter, min(min(lumaDown, lumaUp), min(lumaLeft, lumaRight)));
+    float lumaMax = max(lumaCenter, max(max(lumaDown, lumaUp), max(lumaLeft, lumaRight)));
+    float lumaRange = lumaMax - lumaMin;
+    if(lumaRange < max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD_MAX))
+    {
+        FragColor = vec4(colorCenter, 1.0);
+        return;
+    }
+
+    // 2. horizontal or vertical edge, from the second derivatives of the 3x3 neighbourhood
+    float lumaDownLeft  = luma(textureOffset(screenTexture, TexCoords, ivec2(-1, -1)).rgb);
+    float lumaUpRight   = luma(textureOffset(screenTexture, TexCoords, ivec2( 1,  1)).rgb);
+    float lumaUpLeft    = luma(textureOffset(screenTexture, TexCoords, ivec2(-1,  1)).rgb);
+    float lumaDownRight = luma(textureOffset(screenTexture, TexCoords, ivec2( 1, -1)).rgb);
+
+    float lumaDownUp = lumaDown + lumaUp;
+    float lumaLeftRight = lumaLeft + lumaRight;
+    float lumaLeftCorners = lumaDownLeft + lumaUpLeft;
+    float lumaDownCorners = lumaDownLeft + lumaDownRight;
+    float lumaRightCorners = lumaDownRight + lumaUpRight;
+    float lumaUpCorners = lumaUpRight + lumaUpLeft;
+
+    float edgeHorizontal = abs(-2.0 * lumaLeft + lumaLeftCorners) + abs(-2.0 * lumaCenter + lumaDownUp) * 2.0 + abs(-2.0 * lumaRight + lumaRightCorners);
+    float edgeVertical = abs(-2.0 * lumaUp + lumaUpCorners) + abs(-2.0 * lumaCenter + lumaLeftRight) * 2.0 + abs(-2.0 * lumaDown + lumaDownCorners);
+    bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+    // 3. which side of the pixel the edge is on
+    float luma1 = isHorizontal ? lumaDown : lumaLeft;
+    float luma2 = isHorizontal ? lumaUp : lumaRight;
+    float gradient1 = luma1 - lumaCenter;
+    float gradient2 = luma2 - lumaCenter;
+    bool is1Steepest = abs(gradient1) >= abs(gradient2);
+    float gradientScaled = 0.25 * max(abs(gradient1), abs(gradient2));
+
+    float stepLength = isHorizontal ? inverseScreenSize.y : inverseScreenSize.x;
+    float lumaLocalAverage;
+    if(is1Steepest)
+    {
+        stepLength = -stepLength;
+        lumaLocalAverage = 0.5 * (luma1 + lumaCenter);
+    }
+    else
+    {
+        lumaLocalAverage = 0.5 * (luma2 + lumaCenter);
+    }
+
+    // 4. walk along the edge (half a pixel towards it, so the bilinear fetch averages both sides) until
+    //    the luma no longer matches the edge in both directions
+    vec2 currentUv = TexCoords;
+    if(isHorizontal)
+        currentUv.y += stepLength * 0.5;
+    else
+        currentUv.x += stepLength * 0.5;
+
+    vec2 offset = isHorizontal ? vec2(inverseScreenSize.x, 0.0) : vec2(0.0, inverseScreenSize.y);
+    vec2 uv1 = currentUv - offset * QUALITY[0];
+    vec2 uv2 = currentUv + offset * QUALITY[0];
+    float lumaEnd1 = 0.0;
+    float lumaEnd2 = 0.0;
+    bool reached1 = false;
+    bool reached2 = false;
+    for(int i = 1; i < ITERATIONS && !(reached1 && reached2); ++i)
+    {
+        if(!reached1)
+        {
+            lumaEnd1 = luma(texture(screenTexture, uv1).rgb) - lumaLocalAverage;
+            reached1 = abs(lumaEnd1) >= gradientScaled;
+            if(!reached1)
+                uv1 -= offset * QUALITY[i];
+        }
+        if(!reached2)
+        {
+            lumaEnd2 = luma(texture(screenTexture, uv2).rgb) - lumaLocalAverage;
+            reached2 = abs(lumaEnd2) >= gradientScaled;
+            if(!reached2)
+                uv2 += offset * QUALITY[i];
+        }
+    }
+
+    // 5. the closer end decides how far the pixel is shifted across the edge
+    float distance1 = isHorizontal ? (TexCoords.x - uv1.x) : (TexCoords.y - uv1.y);
+    float distance2 = isHorizontal ? (uv2.x - TexCoords.x) : (uv2.y - TexCoords.y);
+    bool isDirection1 = distance1 < distance2;
+    float distanceFinal = min(distance1, distance2);
+    float edgeLength = distance1 + distance2;
+    float pixelOffset = -distanceFinal / edgeLength + 0.5;
+
+    // only if the luma at that end varies the same way as at the center, otherwise we are past the edge
+    bool isLumaCenterSmaller = lumaCenter < lumaLocalAverage;
+    bool correctVariation = ((isDirection1 ? lumaEnd1 : lumaEnd2) < 0.0) != isLumaCenterSmaller;
+    float finalOffset = correctVariation ? pixelOffset : 0.0;
+
+    // 6. sub-pixel aliasing: thin lines and single bright pixels the edge search can't resolve
+    float lumaAverage = (1.0 / 12.0) * (2.0 * (lumaDownUp + lumaLeftRight) + lumaLeftCorners + lumaRightCorners);
+    float subPixelOffset1 = clamp(abs(lumaAverage - lumaCenter) / lumaRange, 0.0, 1.0);
+    float subPixelOffset2 = (-2.0 * subPixelOffset1 + 3.0) * subPixelOffset1 * subPixelOffset1;
+    finalOffset = max(finalOffset, subPixelOffset2 * subPixelOffset2 * SUBPIXEL_QUALITY);
+
+    vec2 finalUv = TexCoords;
+    if(isHorizontal)
+        finalUv.y += finalOffset * stepLength;
+    else
+        finalUv.x += finalOffset * stepLength;
+    FragColor = vec4(texture(screenTexture, finalUv).rgb, 1.0);
+}
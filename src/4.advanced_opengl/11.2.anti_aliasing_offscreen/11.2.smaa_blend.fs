@@ -0,0 +1,35 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screenTexture;
+uniform sampler2D weightsTexture;
+
+vec4 fetch(sampler2D image, ivec2 p)
+{
+    return texelFetch(image, clamp(p, ivec2(0), textureSize(image, 0) - 1), 0);
+}
+
+void main()
+{
+    ivec2 p = ivec2(TexCoords * vec2(textureSize(screenTexture, 0)));
+
+    // weights towards the four neighbours, see 11.2.smaa_weights.fs for the layout
+    vec4 w = fetch(weightsTexture, p);
+    float up = w.r;
+    float left = w.b;
+    float down = fetch(weightsTexture, p + ivec2(0, -1)).g;
+    float right = fetch(weightsTexture, p + ivec2(1, 0)).a;
+
+    vec3 color = fetch(screenTexture, p).rgb;
+    if(up + down + left + right > 0.0)
+    {
+        // blend along the dominant direction only
+        if(max(up, down) >= max(left, right))
+            color = color * (1.0 - up - down) + fetch(screenTexture, p + ivec2(0, 1)).rgb * up + fetch(screenTexture, p + ivec2(0, -1)).rgb * down;
+        else
+            color = color * (1.0 - left - right) + fetch(screenTexture, p + ivec2(-1, 0)).rgb * left + fetch(screenTexture, p + ivec2(1, 0)).rgb * right;
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,40 @@
+#version 330 core
+out vec2 FragColor; // r = edge between this pixel and its left neighbour, g = between this pixel and the one above
+
+uniform sampler2D screenTexture;
+uniform float threshold;
+
+// local contrast adaptation: an edge is dropped if a neighbouring edge is this many times stronger
+const float LOCAL_CONTRAST_FACTOR = 2.0;
+
+float lumaAt(ivec2 p)
+{
+    ivec2 size = textureSize(screenTexture, 0);
+    vec3 color = texelFetch(screenTexture, clamp(p, ivec2(0), size - 1), 0).rgb;
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+void main()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    float L = lumaAt(p);
+    float lumaLeft = lumaAt(p + ivec2(-1, 0));
+    float lumaTop = lumaAt(p + ivec2(0, 1));
+
+    vec2 delta = abs(L - vec2(lumaLeft, lumaTop));
+    vec2 edges = step(threshold, delta);
+    if(edges.x + edges.y == 0.0)
+        discard;
+
+    // strongest delta in the neighbourhood, on both sides of the pixel and one step further out
+    float lumaRight = lumaAt(p + ivec2(1, 0));
+    float lumaBottom = lumaAt(p + ivec2(0, -1));
+    vec2 maxDelta = max(delta, abs(L - vec2(lumaRight, lumaBottom)));
+    float lumaLeftLeft = lumaAt(p + ivec2(-2, 0));
+    float lumaTopTop = lumaAt(p + ivec2(0, 2));
+    maxDelta = max(maxDelta, abs(vec2(lumaLeft, lumaTop) - vec2(lumaLeftLeft, lumaTopTop)));
+    float finalDelta = max(maxDelta.x, maxDelta.y);
+
+    edges *= step(finalDelta, LOCAL_CONTRAST_FACTOR * delta);
+    FragColor = edges;
+}
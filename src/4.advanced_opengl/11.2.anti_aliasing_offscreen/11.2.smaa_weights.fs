@@ -0,0 +1,80 @@
+#version 330 core
+// r = how much this pixel takes from the pixel above, g = how much the pixel above takes from this one,
+// b = how much this pixel takes from its left neighbour, a = how much the left neighbour takes from this one
+out vec4 FragColor;
+
+uniform sampler2D edgesTexture;
+
+const int MAX_SEARCH_STEPS = 16;
+
+vec2 edgesAt(ivec2 p)
+{
+    ivec2 size = textureSize(edgesTexture, 0);
+    return texelFetch(edgesTexture, clamp(p, ivec2(0), size - 1), 0).rg;
+}
+
+// how many pixels the edge (component c of the edges texture) continues beyond p in direction dir
+int searchLength(ivec2 p, ivec2 dir, int c)
+{
+    int run = 0;
+    for(int i = 1; i <= MAX_SEARCH_STEPS; ++i)
+    {
+        if(edgesAt(p + dir * i)[c] == 0.0)
+            break;
+        run = i;
+    }
+    return run;
+}
+
+// height of the end of an edge run: +0.5 if the crossing edge is on this pixel's side (the neighbour's
+// color reaches around the end into our row), -0.5 if on the neighbour's side, 0 without (or with both)
+float endHeight(float ownSide, float otherSide)
+{
+    return 0.5 * (ownSide - otherSide);
+}
+
+// the silhouette is reconstructed as lines from both ends of the run (at -d1 and d2 + 1, in pixels along the
+// edge) to its middle, the value at the pixel center approximates the area the neighbour covers of this pixel
+float area(float d1, float d2, float height1, float height2)
+{
+    float x1 = -d1;
+    float x2 = d2 + 1.0;
+    float middle = 0.5 * (x1 + x2);
+    const float x = 0.5;
+    return x < middle ? height1 * (middle - x) / (middle - x1) : height2 * (x - middle) / (x2 - middle);
+}
+
+void main()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    vec2 e = edgesAt(p);
+    if(e.x + e.y == 0.0)
+        discard;
+
+    vec4 weights = vec4(0.0);
+    if(e.y > 0.0)
+    {
+        // horizontal edge above the pixel, runs left and right, crossing edges are vertical (r)
+        int d1 = searchLength(p, ivec2(-1, 0), 1);
+        int d2 = searchLength(p, ivec2(1, 0), 1);
+        ivec2 left = p - ivec2(d1, 0);
+        ivec2 right = p + ivec2(d2 + 1, 0);
+        float h1 = endHeight(edgesAt(left).r, edgesAt(left + ivec2(0, 1)).r);
+        float h2 = endHeight(edgesAt(right).r, edgesAt(right + ivec2(0, 1)).r);
+        float a = area(float(d1), float(d2), h1, h2);
+        weights.rg = vec2(max(a, 0.0), max(-a, 0.0));
+    }
+    if(e.x > 0.0)
+    {
+        // vertical edge left of the pixel, runs down and up, crossing edges are horizontal (g)
+        int d1 = searchLength(p, ivec2(0, -1), 0);
+        int d2 = searchLength(p, ivec2(0, 1), 0);
+        ivec2 bottom = p - ivec2(0, d1);
+        ivec2 top = p + ivec2(0, d2);
+        float h1 = endHeight(edgesAt(bottom - ivec2(0, 1)).g, edgesAt(bottom - ivec2(1, 1)).g);
+        float h2 = endHeight(edgesAt(top).g, edgesAt(top - ivec2(1, 0)).g);
+        float a = area(float(d1), float(d2), h1, h2);
+        weights.ba = vec2(max(a, 0.0), max(-a, 0.0));
+    }
+    FragColor = weights;
+}
@@ -13,13 +13,63 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/post_aa.h>
 
 #include <iostream>
 #include <map>
+#include <vector>
+#include <cstdio>
+
+enum EAAMode
+{
+	EAA_NONE,
+	EAA_MSAA,
+	EAA_FXAA,
+	EAA_SMAA,
+	EAA_COUNT
+};
+static const char* aaModeNames[EAA_COUNT] = { "None", "MSAA", "FXAA", "SMAA 1x" };
+
+// offscreen targets of one AA mode: MSAA renders into msaaFBO and resolves into sceneFBO,
+// every other mode renders straight into sceneFBO and reads sceneColor afterwards
+struct RenderTargets
+{
+	int mode = -1;
+	int samples = 1;
+	int width = 0;
+	int height = 0;
+	unsigned int msaaFBO = 0;
+	unsigned int msaaColor = 0;
+	unsigned int msaaDepth = 0;
+	unsigned int sceneFBO = 0;
+	unsigned int sceneColor = 0;
+	unsigned int sceneDepth = 0;
+};
+
+// one line of the AA benchmark: scene and resolve / post-process cost at 1080p plus the memory of the targets
+struct AABenchmarkCase
+{
+	const char* name;
+	int mode;
+	int samples;
+	float scene_ms;
+	float aa_ms;
+	float megabytes;
+};
+static std::vector<AABenchmarkCase> benchmarkCases;
 
 typedef struct ui_params
 {
 	glm::vec3 clearColor = glm::vec3(0.0f);
+	int aa_mode = EAA_MSAA;
+	int msaa_samples = 4;
+	float smaa_threshold = 0.1f;
+	bool grayscale = false;
+	float scene_ms = 0.0f;
+	float aa_ms = 0.0f;
+	float target_mb = 0.0f;
+	bool run_benchmark = false;
 } ui_params;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -27,6 +77,93 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path);
+void allocateTargets(RenderTargets& targets, int mode, int samples, int width, int height);
+void releaseTargets(RenderTargets& targets);
+size_t targetBytes(const RenderTargets& targets, const PostAA& postAA);
+// (re)creates the offscreen targets of an AA mode; the single sample color is GL_LINEAR filtered because FXAA
+// and the SMAA blend pass rely on bilinear fetches
+// -----------------------------------------------------------------------------------------------------------
+void allocateTargets(RenderTargets& targets, int mode, int samples, int width, int height)
+{
+	releaseTargets(targets);
+	targets.mode = mode;
+	targets.samples = mode == EAA_MSAA ? samples : 1;
+	targets.width = width;
+	targets.height = height;
+
+	if (mode == EAA_MSAA)
+	{
+		glGenFramebuffers(1, &targets.msaaFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, targets.msaaFBO);
+
+		glGenTextures(1, &targets.msaaColor);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, targets.msaaColor);
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGBA8, width, height, GL_TRUE);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, targets.msaaColor, 0);
+
+		// renderbuffer object for depth and stencil test
+		glGenRenderbuffers(1, &targets.msaaDepth);
+		glBindRenderbuffer(GL_RENDERBUFFER, targets.msaaDepth);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, targets.msaaDepth);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::FRAMEBUFFER::Framebuffer is not complete!\n";
+	}
+
+	glGenFramebuffers(1, &targets.sceneFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.sceneFBO);
+
+	glGenTextures(1, &targets.sceneColor);
+	glBindTexture(GL_TEXTURE_2D, targets.sceneColor);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets.sceneColor, 0);
+
+	// the MSAA resolve target needs no depth, the scene was depth tested in msaaFBO
+	if (mode != EAA_MSAA)
+	{
+		glGenRenderbuffers(1, &targets.sceneDepth);
+		glBindRenderbuffer(GL_RENDERBUFFER, targets.sceneDepth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, targets.sceneDepth);
+	}
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER::Intermediate Framebuffer is not complete!\n";
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void releaseTargets(RenderTargets& targets)
+{
+	glDeleteFramebuffers(1, &targets.msaaFBO);
+	glDeleteTextures(1, &targets.msaaColor);
+	glDeleteRenderbuffers(1, &targets.msaaDepth);
+	glDeleteFramebuffers(1, &targets.sceneFBO);
+	glDeleteTextures(1, &targets.sceneColor);
+	glDeleteRenderbuffers(1, &targets.sceneDepth);
+	targets = RenderTargets();
+}
+
+// bytes of all offscreen targets of the mode: RGBA8 color and D24S8 depth per sample, plus the single sample
+// resolve target for MSAA and the edges and weights targets for SMAA
+size_t targetBytes(const RenderTargets& targets, const PostAA& postAA)
+{
+	size_t pixels = (size_t)targets.width * targets.height;
+	size_t bytes = pixels * targets.samples * (4 + 4);
+	if (targets.mode == EAA_MSAA)
+		bytes += pixels * 4;
+	if (targets.mode == EAA_SMAA)
+		bytes += postAA.SMAABytes();
+	return bytes;
+}
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -186,61 +323,45 @@ int main()
 
 	glBindVertexArray(0);
 
-	// framebuffer
-	unsigned int framebuffer;
-	glGenFramebuffers(1, &framebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-	static const unsigned int samples = 4;
-	// texture attachment
-	unsigned int textureColorBufferMultiSampled;
-	glGenTextures(1, &textureColorBufferMultiSampled);
-	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled);
-	glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples ,GL_RGB, SCR_WIDTH, SCR_HEIGHT, GL_TRUE);
-	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled, 0);
-
-	// renderbuffer object for depth and stencil test
-	unsigned int rbo;
-	glGenRenderbuffers(1, &rbo);
-	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "ERROR::FRAMEBUFFER::Framebuffer is not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// post-process anti-aliasing, works on any single sample color texture
+	Shader fxaaShader("11.2.fullscreen.vs", "11.2.fxaa.fs");
+	Shader smaaEdgesShader("11.2.fullscreen.vs", "11.2.smaa_edges.fs");
+	Shader smaaWeightsShader("11.2.fullscreen.vs", "11.2.smaa_weights.fs");
+	Shader smaaBlendShader("11.2.fullscreen.vs", "11.2.smaa_blend.fs");
+	PostAA* postAA = new PostAA(fxaaShader, smaaEdgesShader, smaaWeightsShader, smaaBlendShader);
 
-	// configure second post-processing framebuffer
-	unsigned int intermediateFBO;
-	glGenFramebuffers(1, &intermediateFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, intermediateFBO);
+	GLint maxSamples = 1;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
 
-	unsigned int screenTexture;
-	glGenTextures(1, &screenTexture);
-	glBindTexture(GL_TEXTURE_2D, screenTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screenTexture, 0);
+	// offscreen targets, reallocated whenever the mode, sample count or size changes
+	RenderTargets targets;
+
+	// shader configuration
+	// --------------------
+	screenShader.use();
+	screenShader.setInt("screenTexture", 0);
 
-	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	// a few rotated cubes, so there are edges of every slope to anti-alias
+	const int CUBE_COUNT = 5;
+	glm::mat4 models[CUBE_COUNT];
+	for (int i = 0; i < CUBE_COUNT; ++i)
 	{
-		std::cout << "ERROR::FRAMEBUFFER::Intermediate Framebuffer is not complete!\n";
+		models[i] = glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f + i * 1.0f, 0.0f, -1.0f - (i % 2)));
+		models[i] = glm::rotate(models[i], glm::radians(17.0f * i), glm::normalize(glm::vec3(1.0f, 0.3f * i, 0.5f)));
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	// shader configuration
-	// --------------------
-	shader.use();
-	glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, -1.0f));
-	shader.setMat4("model", model);
-    screenShader.setInt("screenTexture", 0);
+	// benchmark state: every mode at 1080p
+	const int BENCHMARK_WIDTH = 1920;
+	const int BENCHMARK_HEIGHT = 1080;
+	const int BENCHMARK_WARMUP_FRAMES = 20;
+	const int BENCHMARK_FRAMES = 200;
+	int benchmarkCase = -1;
+	int benchmarkFrame = 0;
+	// the resolve / post pass writes here at benchmark size while the benchmark runs, so every pass of every mode
+	// runs at 1080p; the window only gets a scaled copy, outside of the timed passes
+	unsigned int benchmarkFBO = 0, benchmarkColor = 0;
+	GpuTimer* sceneTimer = new GpuTimer();
+	GpuTimer* aaTimer = new GpuTimer();
 
 	// render loop
 	// -----------
@@ -259,42 +380,152 @@ int main()
 		// render
 		// ------
 
-		// 1. Rendering Pass
-		// -------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		if (params.run_benchmark && benchmarkCase < 0)
+		{
+			static const AABenchmarkCase cases[] = {
+				{ "No AA",   EAA_NONE, 1, 0.0f, 0.0f, 0.0f },
+				{ "MSAA 2x", EAA_MSAA, 2, 0.0f, 0.0f, 0.0f },
+				{ "MSAA 4x", EAA_MSAA, 4, 0.0f, 0.0f, 0.0f },
+				{ "MSAA 8x", EAA_MSAA, 8, 0.0f, 0.0f, 0.0f },
+				{ "FXAA",    EAA_FXAA, 1, 0.0f, 0.0f, 0.0f },
+				{ "SMAA 1x", EAA_SMAA, 1, 0.0f, 0.0f, 0.0f },
+			};
+			benchmarkCases.clear();
+			for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+				if (cases[i].samples <= maxSamples)
+					benchmarkCases.push_back(cases[i]);
+			benchmarkCase = 0;
+			benchmarkFrame = 0;
+
+			glGenFramebuffers(1, &benchmarkFBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, benchmarkFBO);
+			glGenTextures(1, &benchmarkColor);
+			glBindTexture(GL_TEXTURE_2D, benchmarkColor);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, BENCHMARK_WIDTH, BENCHMARK_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, benchmarkColor, 0);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cout << "ERROR::FRAMEBUFFER::Benchmark Framebuffer is not complete!\n";
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+
+		int mode = params.aa_mode;
+		int samples = glm::min(params.msaa_samples, (int)maxSamples);
+		int width = SCR_WIDTH;
+		int height = SCR_HEIGHT;
+		if (benchmarkCase >= 0)
+		{
+			mode = benchmarkCases[benchmarkCase].mode;
+			samples = benchmarkCases[benchmarkCase].samples;
+			width = BENCHMARK_WIDTH;
+			height = BENCHMARK_HEIGHT;
+			if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+			{
+				sceneTimer->Reset();
+				aaTimer->Reset();
+			}
+		}
+		if (mode != targets.mode || (mode == EAA_MSAA && samples != targets.samples) || width != targets.width || height != targets.height)
+		{
+			allocateTargets(targets, mode, samples, width, height);
+			postAA->Resize(width, height);
+		}
+		params.target_mb = targetBytes(targets, *postAA) / (1024.0f * 1024.0f);
+
+		// 1. Rendering Pass, multisampled for MSAA, single sample for everything else
+		// ---------------------------------------------------------------------------
+		sceneTimer->Begin();
+		glBindFramebuffer(GL_FRAMEBUFFER, mode == EAA_MSAA ? targets.msaaFBO : targets.sceneFBO);
+		glViewport(0, 0, width, height);
 		glClearColor(params.clearColor.r, params.clearColor.g, params.clearColor.b, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_DEPTH_TEST);
 
-		// drawing cube
+		// drawing cubes
 		shader.use();
 		glm::mat4 view = camera.GetViewMatrix();
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, 0.1f, 100.0f);
 		shader.setMat4("view", view);
 		shader.setMat4("projection", projection);
 
 		glBindVertexArray(cubeVAO);
-		glActiveTexture(GL_TEXTURE0);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		for (int i = 0; i < CUBE_COUNT; ++i)
+		{
+			shader.setMat4("model", models[i]);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+		}
 		glBindVertexArray(0);
-
-		// 2. now blit multisampled buffer(s) to normal colorbuffer of intermediate FBO. Image is stored in screenTexture
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFBO);
-        glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-		// 3. Rendering Pass, render quad with scene's visuals as its texture image
-		// -------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-
-		screenShader.use();
-		glBindVertexArray(quadVAO);
+		sceneTimer->End();
+
+		// 2. resolve or post-process anti-aliasing into the default framebuffer, or the benchmark target
+		// ------------------------------------------------------------------------------------------------
+		aaTimer->Begin();
+		if (mode == EAA_MSAA)
+		{
+			// blit multisampled buffer(s) to the normal colorbuffer, image is stored in sceneColor
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, targets.msaaFBO);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targets.sceneFBO);
+			glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, benchmarkCase >= 0 ? benchmarkFBO : 0);
+		glViewport(0, 0, width, height);
+		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
 		glDisable(GL_DEPTH_TEST);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+
+		if (mode == EAA_FXAA)
+		{
+			postAA->FXAA(targets.sceneColor);
+		}
+		else if (mode == EAA_SMAA)
+		{
+			postAA->EdgeThreshold = params.smaa_threshold;
+			postAA->SMAA(targets.sceneColor);
+		}
+		else
+		{
+			// render quad with scene's visuals as its texture image
+			screenShader.use();
+			screenShader.setBool("grayscale", params.grayscale);
+			glBindVertexArray(quadVAO);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, targets.sceneColor);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+			glBindVertexArray(0);
+		}
+		aaTimer->End();
+		params.scene_ms = sceneTimer->Milliseconds;
+		params.aa_ms = aaTimer->Milliseconds;
+
+		if (benchmarkCase >= 0)
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, benchmarkFBO);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, width, height, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+		}
+
+		if (benchmarkCase >= 0 && ++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+		{
+			AABenchmarkCase& current = benchmarkCases[benchmarkCase];
+			current.scene_ms = sceneTimer->Average();
+			current.aa_ms = aaTimer->Average();
+			current.megabytes = params.target_mb;
+			printf("%-8s %dx%d: scene %.3f ms, resolve / post %.3f ms, targets %.1f MB\n", current.name, width, height, current.scene_ms, current.aa_ms, current.megabytes);
+			benchmarkFrame = 0;
+			if (++benchmarkCase == (int)benchmarkCases.size())
+			{
+				benchmarkCase = -1;
+				params.run_benchmark = false;
+				glDeleteFramebuffers(1, &benchmarkFBO);
+				glDeleteTextures(1, &benchmarkColor);
+				benchmarkFBO = benchmarkColor = 0;
+			}
+		}
 
 		// IMGUI rendering
 		imgui_on_render(params);
@@ -311,7 +542,10 @@ int main()
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &cubeVBO);
     glDeleteBuffers(1, &quadVBO);
-	glDeleteBuffers(1, &intermediateFBO);
+	releaseTargets(targets);
+	delete sceneTimer;
+	delete aaTimer;
+	delete postAA;
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -481,6 +715,29 @@ void imgui_on_render(ui_params& param)
 
 
 	ImGui::ColorEdit3("sky##1", (float*)&params.clearColor, ImGuiColorEditFlags_Float);
+	ImGui::Combo("Anti-Aliasing", &params.aa_mode, aaModeNames, EAA_COUNT);
+	if (params.aa_mode == EAA_MSAA)
+	{
+		static const char* sampleNames[] = { "2x", "4x", "8x" };
+		int sampleIndex = params.msaa_samples == 2 ? 0 : (params.msaa_samples == 4 ? 1 : 2);
+		if (ImGui::Combo("Samples", &sampleIndex, sampleNames, 3))
+			params.msaa_samples = 2 << sampleIndex;
+	}
+	else if (params.aa_mode == EAA_SMAA)
+	{
+		ImGui::SliderFloat("Edge Threshold", &params.smaa_threshold, 0.02f, 0.3f);
+	}
+	else if (params.aa_mode == EAA_NONE)
+	{
+		ImGui::Checkbox("Grayscale", &params.grayscale);
+	}
+	ImGui::Text("Scene: %.3f ms, resolve / post: %.3f ms", params.scene_ms, params.aa_ms);
+	ImGui::Text("Offscreen targets: %.1f MB", params.target_mb);
+	if (ImGui::Button("Run 1080p Benchmark"))
+		params.run_benchmark = true;
+	for (size_t i = 0; i < benchmarkCases.size(); ++i)
+		ImGui::Text("%-8s scene %7.3f ms  AA %7.3f ms  total %7.3f ms  %6.1f MB", benchmarkCases[i].name, benchmarkCases[i].scene_ms,
+			benchmarkCases[i].aa_ms, benchmarkCases[i].scene_ms + benchmarkCases[i].aa_ms, benchmarkCases[i].megabytes);
 	ImGui::Separator();
 
 	ImGui::Text("Press 1 to show cursor");
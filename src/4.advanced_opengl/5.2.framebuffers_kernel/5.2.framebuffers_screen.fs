@@ -5,61 +5,28 @@ in vec2 TexCoords;
 
 uniform sampler2D screenTexture;
 
-const float offset = 1.0 / 300.0;
-
-const vec2 offsets[9] = vec2[](
-           vec2(-offset,  offset), // LeftTop
-           vec2( 0.0f,    offset), // Top
-           vec2( offset,  offset), // RightTop
-           vec2(-offset,  0.0f),   // Left
-           vec2( 0.0f,    0.0f),   // Center
-           vec2( offset,  0.0f),   // Right
-           vec2(-offset, -offset), // LeftBottom
-           vec2( 0.0f,   -offset), // Bottom
-           vec2( offset, -offset)  // RightBottom
-       );
-
-
-float[9] get_kernel_sharpen()
-{
-    return float[](
-           -1, -1, -1,
-           -1,  9, -1,
-           -1, -1, -1
-       );
-}
-
-float[9] get_kernel_blur()
-{
-    return float[](
-        1.0 / 16, 2.0 / 16, 1.0 / 16,
-        2.0 / 16, 4.0 / 16, 2.0 / 16,
-        1.0 / 16, 2.0 / 16, 1.0 / 16  
-        );
-}
-
-float[9] get_kernel_edge()
-{
-    return float[](
-        1, 1, 1,
-        1, -8, 1,
-        1, 1, 1
-    );
-}
+// NxN kernel, row 0 is the top row (see ConvolutionKernel in convolution.h)
+const int MAX_KERNEL_SIZE = 15;
+uniform int kernelSize;
+uniform float kernel[MAX_KERNEL_SIZE * MAX_KERNEL_SIZE];
 
 void main()
 {
-    float kernel[9] = get_kernel_sharpen();
-    vec3 sampleTex[9];
+    // exact texel neighbours instead of a fixed 1 / 300 offset, edges are clamped
+    ivec2 size = textureSize(screenTexture, 0);
+    ivec2 center = ivec2(TexCoords * vec2(size));
+    int radius = kernelSize / 2;
 
-    for(int i = 0; i < 9; i++)
+    vec3 col = vec3(0.0);
+    for(int row = 0; row < kernelSize; ++row)
     {
-        sampleTex[i] = vec3(texture(screenTexture, TexCoords.st + offsets[i]));
+        int y = clamp(center.y + radius - row, 0, size.y - 1);
+        for(int x = 0; x < kernelSize; ++x)
+        {
+            ivec2 p = ivec2(clamp(center.x + x - radius, 0, size.x - 1), y);
+            col += texelFetch(screenTexture, p, 0).rgb * kernel[row * kernelSize + x];
+        }
     }
 
-    vec3 col = vec3(0.0);
-    for(int i = 0; i < 9; i++)
-        col += sampleTex[i] * kernel[i];
-
     FragColor = vec4(col, 1.0);
 }
@@ -0,0 +1,29 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screenTexture;
+
+// one 1D factor of a rank 1 kernel: the horizontal pass runs left to right, the vertical pass top to bottom
+const int MAX_KERNEL_SIZE = 15;
+uniform int kernelSize;
+uniform float weights[MAX_KERNEL_SIZE];
+uniform bool horizontal;
+
+void main()
+{
+    ivec2 size = textureSize(screenTexture, 0);
+    ivec2 center = ivec2(TexCoords * vec2(size));
+    int radius = kernelSize / 2;
+    ivec2 direction = horizontal ? ivec2(1, 0) : ivec2(0, -1);
+
+    vec3 col = vec3(0.0);
+    for(int i = 0; i < kernelSize; ++i)
+    {
+        ivec2 p = clamp(center + direction * (i - radius), ivec2(0), size - 1);
+        col += texelFetch(screenTexture, p, 0).rgb * weights[i];
+    }
+
+    FragColor = vec4(col, 1.0);
+}
@@ -14,13 +14,40 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/convolution.h>
+#include <learnopengl/post_chain.h>
 
 #include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+
+enum EKernel
+{
+    EKERNEL_SHARPEN,
+    EKERNEL_BLUR,
+    EKERNEL_EDGE,
+    EKERNEL_EMBOSS,
+    EKERNEL_SOBEL,
+    EKERNEL_GAUSSIAN,
+    EKERNEL_BOX,
+    EKERNEL_COUNT
+};
 
 typedef struct ui_params
 {
     glm::vec3 clearColor = glm::vec3(0.5f, 0.5f, 0.5f);
     bool wireframe = false;
+    int kernel = EKERNEL_SHARPEN;
+    int kernel_size = 5;            // gaussian and box only, the 3x3 presets ignore it
+    bool use_separable = true;      // run rank 1 kernels as a horizontal and a vertical pass
+    bool separable = false;         // the current kernel is rank 1
+    bool verify = false;            // compare the next frame against the CPU reference
+    float max_error = -1.0f;
+    float mean_error = 0.0f;
+    int fetches = 9;
+    float post_ms = 0.0f;
 } ui_params;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -28,6 +55,7 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path);
+ConvolutionKernel makeKernel(int kernel, int size);
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -100,6 +128,7 @@ int main()
     // -------------------------
     Shader shader("5.2.framebuffers.vs", "5.2.framebuffers.fs");
     Shader screenShader("5.2.framebuffers_screen.vs", "5.2.framebuffers_screen.fs");
+    Shader separableShader("5.2.framebuffers_screen.vs", "5.2.framebuffers_separable.fs");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -220,43 +249,104 @@ int main()
 
     screenShader.use();
     screenShader.setInt("screenTexture", 0);
+    separableShader.use();
+    separableShader.setInt("screenTexture", 0);
 
     // framebuffer configuration
     // -------------------------
-    unsigned int framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-    // texture attachment
-    unsigned int texColorBuffer;
-    glGenTextures(1, &texColorBuffer);
-    glBindTexture(GL_TEXTURE_2D, texColorBuffer);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texColorBuffer, 0);
-
-    // renderbuffer object for depth and stencil test
-    unsigned int rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    GpuTimer* postTimer = new GpuTimer();
+    ConvolutionKernel kernel;
+    int currentKernel = -1;
+    int currentKernelSize = -1;
+
+    // the scene renders into a color texture with a depth/stencil target, the kernel passes filter it to the
+    // screen; all targets are sized to the window framebuffer by the chain. The passes depend on the kernel, so the
+    // chain is rebuilt when it switches between one 2D pass and the two passes of a separable kernel.
+    PostChain* chain = new PostChain();
+    int sceneColor = -1;
+    int width = SCR_WIDTH, height = SCR_HEIGHT;
+    int chainTwoPass = -1;
+    auto buildChain = [&](bool twoPass) {
+        chain->Clear();
+        sceneColor = chain->Create("scene", GL_RGBA8);
+        int sceneDepth = chain->Create("depth", GL_DEPTH24_STENCIL8);
+        // kept after the last pass for the verify step
+        chain->Export(sceneColor);
 
-    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    {
-        std::cout << "ERROR::FRAMEBUFFER::Framebuffer is not complete!\n";
-    }
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // 1st Rendering Pass
+        chain->AddPass("scene", {}, sceneColor, [&]() {
+            glClearColor(params.clearColor.r, params.clearColor.g, params.clearColor.b, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glEnable(GL_DEPTH_TEST);
+
+            // drawing scene
+            // -------------
+            shader.use();
+            glm::mat4 model = glm::mat4(1.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, 0.1f, 100.0f);
+            shader.setMat4("view", view);
+            shader.setMat4("projection", projection);
+
+            // cubes
+            glBindVertexArray(cubeVAO);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, cubeTexture);
+            model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+            shader.setMat4("model", model);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+            shader.setMat4("model", model);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+
+            // floor
+            glBindVertexArray(planeVAO);
+            glBindTexture(GL_TEXTURE_2D, floorTexture);
+            shader.setMat4("model", glm::mat4(1.0f));
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glBindVertexArray(0);
+        }, sceneDepth);
+
+        // 2nd Rendering Pass, the input is bound to unit 0; the quad covers the whole target so nothing is cleared
+        if (twoPass)
+        {
+            // intermediate target between the horizontal and vertical pass of a separable kernel,
+            // floating point so negative weights (edge detection) don't get clamped halfway
+            int separableColor = chain->Create("separable", GL_RGBA16F);
+
+            // rank 1: N fetches horizontally into the intermediate target, then N vertically to the screen
+            chain->AddPass("horizontal", { sceneColor }, separableColor, [&]() {
+                glDisable(GL_DEPTH_TEST);
+                glBindVertexArray(quadVAO);
+                postTimer->Begin();
+                separableShader.use();
+                separableShader.setInt("kernelSize", kernel.Size);
+                separableShader.setBool("horizontal", true);
+                glUniform1fv(glGetUniformLocation(separableShader.ID, "weights"), kernel.Size, &kernel.Horizontal[0]);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            });
+            chain->AddPass("vertical", { separableColor }, PostChain::BACKBUFFER, [&]() {
+                separableShader.setBool("horizontal", false);
+                glUniform1fv(glGetUniformLocation(separableShader.ID, "weights"), kernel.Size, &kernel.Vertical[0]);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+                postTimer->End();
+            });
+        }
+        else
+        {
+            chain->AddPass("kernel", { sceneColor }, PostChain::BACKBUFFER, [&]() {
+                glDisable(GL_DEPTH_TEST);
+                glBindVertexArray(quadVAO);
+                postTimer->Begin();
+                screenShader.use();
+                screenShader.setInt("kernelSize", kernel.Size);
+                glUniform1fv(glGetUniformLocation(screenShader.ID, "kernel"), kernel.Size * kernel.Size, &kernel.Weights[0]);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+                postTimer->End();
+            });
+        }
+    };
 
     // draw as wireframe
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -279,51 +369,56 @@ int main()
 
         // render
         // ------
-
-        // 1st Rendering Pass
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        glClearColor(params.clearColor.r, params.clearColor.g, params.clearColor.b, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-
-        // drawing scene
-        // -------------
-        shader.use();
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-
-        // cubes
-        glBindVertexArray(cubeVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture); 	
-        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        shader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        shader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // floor
-        glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
-        shader.setMat4("model", glm::mat4(1.0f));
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-
-        // 2nd Rendering Pass
-        glBindFramebuffer(GL_FRAMEBUFFER, 0); // default framebuffer
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        screenShader.use();
-        glBindVertexArray(quadVAO);
-        glDisable(GL_DEPTH_TEST);
-        glBindTexture(GL_TEXTURE_2D, texColorBuffer);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (params.kernel != currentKernel || params.kernel_size != currentKernelSize)
+        {
+            kernel = makeKernel(params.kernel, params.kernel_size);
+            currentKernel = params.kernel;
+            currentKernelSize = params.kernel_size;
+            params.max_error = -1.0f;
+        }
+        bool twoPass = kernel.Separable && params.use_separable;
+        params.separable = kernel.Separable;
+        params.fetches = twoPass ? kernel.Fetches() : kernel.Size * kernel.Size;
+
+        if ((int)twoPass != chainTwoPass)
+        {
+            buildChain(twoPass);
+            chainTwoPass = twoPass;
+        }
+        glfwGetFramebufferSize(window, &width, &height);
+        chain->Resize(width, height);
+        chain->Execute();
+        params.post_ms = postTimer->Milliseconds;
+
+        // 3. verify the GPU result against the CPU reference (both read back as float, 8 bit output)
+        // ---------------------------------------------------------------------------------------
+        if (params.verify)
+        {
+            params.verify = false;
+            std::vector<float> source(width * height * 4);
+            std::vector<float> expected(width * height * 4);
+            std::vector<float> result(width * height * 4);
+            glBindTexture(GL_TEXTURE_2D, chain->Texture(sceneColor));
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, &source[0]);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, &result[0]);
+            ConvolveReference(&source[0], &expected[0], width, height, kernel);
+
+            double sum = 0.0;
+            float maxError = 0.0f;
+            for (size_t i = 0; i < expected.size(); i += 4)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    float e = std::fabs(glm::clamp(expected[i + c], 0.0f, 1.0f) - result[i + c]);
+                    maxError = std::max(maxError, e);
+                    sum += e;
+                }
+            }
+            params.max_error = maxError * 255.0f;
+            params.mean_error = (float)(sum / (width * height * 3)) * 255.0f;
+            printf("kernel %dx%d %s: max error %.2f, mean error %.4f (8 bit steps)\n", kernel.Size, kernel.Size,
+                twoPass ? "separable" : "2D", params.max_error, params.mean_error);
+        }
 
 
         // IMGUI rendering
@@ -341,6 +436,8 @@ int main()
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteBuffers(1, &cubeVBO);
     glDeleteBuffers(1, &planeVBO);
+    delete postTimer;
+    delete chain;
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -454,6 +551,45 @@ unsigned int loadTexture(char const *path)
     return textureID;
 }
 
+// the kernels of the post-process stage, the 3x3 presets are the ones the shader used to hard-code
+// ---------------------------------------------------------------------------------------------------
+ConvolutionKernel makeKernel(int kernel, int size)
+{
+    static const float sharpen[9] = {
+        -1, -1, -1,
+        -1,  9, -1,
+        -1, -1, -1
+    };
+    static const float edge[9] = {
+        1,  1, 1,
+        1, -8, 1,
+        1,  1, 1
+    };
+    static const float emboss[9] = {
+        -2, -1, 0,
+        -1,  1, 1,
+         0,  1, 2
+    };
+    // vertical smoothing times horizontal derivative, rank 1
+    static const float sobel[9] = {
+        1, 0, -1,
+        2, 0, -2,
+        1, 0, -1
+    };
+
+    switch (kernel)
+    {
+    case EKERNEL_SHARPEN:  return ConvolutionKernel(3, sharpen);
+    case EKERNEL_BLUR:     return ConvolutionKernel::Binomial(3);
+    case EKERNEL_EDGE:     return ConvolutionKernel(3, edge);
+    case EKERNEL_EMBOSS:   return ConvolutionKernel(3, emboss);
+    case EKERNEL_SOBEL:    return ConvolutionKernel(3, sobel);
+    case EKERNEL_GAUSSIAN: return ConvolutionKernel::Binomial(size);
+    case EKERNEL_BOX:      return ConvolutionKernel::Box(size);
+    default:               return ConvolutionKernel();
+    }
+}
+
 
 void imgui_on_init(GLFWwindow* window)
 {
@@ -513,6 +649,22 @@ void imgui_on_render(ui_params& param)
     ImGui::Checkbox("Wireframe", &params.wireframe);
     ImGui::Separator();
 
+    const char* kernels[] = { "Sharpen", "Blur", "Edge", "Emboss", "Sobel", "Gaussian NxN", "Box NxN" };
+    ImGui::Combo("Kernel", &params.kernel, kernels, IM_ARRAYSIZE(kernels));
+    if (params.kernel == EKERNEL_GAUSSIAN || params.kernel == EKERNEL_BOX)
+    {
+        ImGui::SliderInt("Kernel Size", &params.kernel_size, 3, ConvolutionKernel::MAX_SIZE);
+        params.kernel_size |= 1; // odd sizes only
+    }
+    ImGui::Checkbox("Separable Passes", &params.use_separable);
+    ImGui::Text("Rank 1: %s, %d fetches per pixel", params.separable ? "yes" : "no", params.fetches);
+    ImGui::Text("Post-process: %.3f ms", params.post_ms);
+    if (ImGui::Button("Verify"))
+        params.verify = true;
+    if (params.max_error >= 0.0f)
+        ImGui::Text("CPU reference: max error %.2f, mean %.4f (8 bit steps)", params.max_error, params.mean_error);
+    ImGui::Separator();
+
     ImGui::Text("Press 1 to show cursor");
     ImGui::Text("Press 2 to hide cursor");
     ImGui::Text("camera.position:(%f,%f,%f)", camera.Position.x, camera.Position.y, camera.Position.z);
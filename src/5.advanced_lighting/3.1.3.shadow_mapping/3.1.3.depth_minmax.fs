@@ -0,0 +1,30 @@
+#version 330 core
+out vec2 FragMinMax;
+
+uniform sampler2D depthMap;  // level 0 is built from the shadow map itself
+uniform sampler2D minMaxMap; // other levels reduce the previous one, bound as the only (base) level
+uniform bool firstLevel;
+
+void main()
+{
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    if(firstLevel)
+    {
+        float depth = texelFetch(depthMap, coord, 0).r;
+        FragMinMax = vec2(depth);
+        return;
+    }
+
+    // every texel holds min/max depth of the 2x2 texels below it
+    ivec2 sourceSize = textureSize(minMaxMap, 0);
+    vec2 result = vec2(1.0, 0.0);
+    for(int y = 0; y < 2; ++y)
+    {
+        for(int x = 0; x < 2; ++x)
+        {
+            vec2 minMax = texelFetch(minMaxMap, min(coord * 2 + ivec2(x, y), sourceSize - 1), 0).rg;
+            result = vec2(min(result.x, minMax.x), max(result.y, minMax.y));
+        }
+    }
+    FragMinMax = result;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+
+uniform bool horizontal;
+
+// one side of the kernel from GaussianKernel (learnopengl/gaussian_blur.h), weights are normalized so any
+// radius keeps the moments intact; neighbouring texels are merged into one bilinear fetch
+uniform int taps;
+uniform float offsets[65];
+uniform float weights[65];
+
+void main()
+{
+    vec2 texOffset = 1.0 / textureSize(image, 0);
+    vec2 direction = horizontal ? vec2(texOffset.x, 0.0) : vec2(0.0, texOffset.y);
+
+    vec4 result = texture(image, TexCoords) * weights[0];
+    for(int i = 1; i < taps; ++i)
+        result += (texture(image, TexCoords + direction * offsets[i]) + texture(image, TexCoords - direction * offsets[i])) * weights[i];
+    FragColor = result;
+}
@@ -9,12 +9,222 @@ in VS_OUT
     vec4 FragPosLightSpace;
 } fs_in;
 
+// shadow modes, must match SHADOW_* in shadow_mapping.cpp
+#define SHADOW_PCF  0
+#define SHADOW_VSM  1
+#define SHADOW_EVSM 2
+#define SHADOW_MSM  3
+#define SHADOW_PCSS 4
+
 uniform sampler2D diffuseTexture;
 uniform sampler2D shadowMap;
+uniform sampler2D momentMap; // prefiltered moments for the VSM/EVSM/MSM modes
+uniform sampler2D depthMinMax; // min/max depth mip hierarchy of shadowMap for PCSS
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 
+uniform int shadowMode;
+uniform int pcfRadius;
+uniform float lightBleedReduction;
+uniform vec2 evsmExponents;
+uniform float momentBias;
+uniform float lightSize;     // PCSS: penumbra width in shadow map uv per unit of light space depth
+uniform int minMaxLevels;
+uniform bool showPcssRegions;
+
+const vec2 poissonDisk[16] = vec2[]
+(
+    vec2(-0.94201624, -0.39906216), vec2( 0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2( 0.34495938,  0.29387760),
+    vec2(-0.91588581,  0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543,  0.27676845), vec2( 0.97484398,  0.75648379),
+    vec2( 0.44323325, -0.97511554), vec2( 0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2( 0.79197514,  0.19090188),
+    vec2(-0.24188840,  0.99706507), vec2(-0.81409955,  0.91437590),
+    vec2( 0.19984126,  0.78641367), vec2( 0.14383161, -0.14100790)
+);
+
+// which path PCSS took for the debug view: 0 fully lit, 1 fully shadowed, 2 penumbra
+int pcssRegion = -1;
+
+float PCF(vec3 projCoords, float bias)
+{
+    // (2 * pcfRadius + 1)^2 depth comparisons, cost grows with the square of the filter width
+    float currentDepth = projCoords.z;
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    for(int x = -pcfRadius; x <= pcfRadius; ++x)
+    {
+        for(int y = -pcfRadius; y <= pcfRadius; ++y)
+        {
+            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
+            shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;        
+        }    
+    }
+    float width = float(2 * pcfRadius + 1);
+    return shadow / (width * width);
+}
+
+// contact hardening soft shadows, the min/max hierarchy skips blocker search and filtering
+// wherever the search region is entirely in front of or entirely behind the receiver
+float PCSS(vec3 projCoords, float bias)
+{
+    float receiver = projCoords.z - bias;
+    vec2 shadowSize = vec2(textureSize(shadowMap, 0));
+
+    // blocker search region, a blocker right at the light would cast the widest penumbra
+    float searchRadius = clamp(lightSize * receiver, 1.0 / shadowSize.x, 0.05);
+
+    // 1. pick the level where the search region fits into a 2x2 texel footprint and fetch its min/max depth
+    int level = clamp(int(ceil(log2(2.0 * searchRadius * shadowSize.x))), 0, minMaxLevels - 1);
+    vec2 levelSize = vec2(textureSize(depthMinMax, level));
+    ivec2 lo = ivec2(clamp(floor((projCoords.xy - searchRadius) * levelSize), vec2(0.0), levelSize - 1.0));
+    ivec2 hi = ivec2(clamp(floor((projCoords.xy + searchRadius) * levelSize), vec2(0.0), levelSize - 1.0));
+    vec2 minMax = vec2(1.0, 0.0);
+    for(int y = lo.y; y <= hi.y; ++y)
+    {
+        for(int x = lo.x; x <= hi.x; ++x)
+        {
+            vec2 texel = texelFetch(depthMinMax, ivec2(x, y), level).rg;
+            minMax = vec2(min(minMax.x, texel.x), max(minMax.y, texel.y));
+        }
+    }
+    if(receiver <= minMax.x)
+    {
+        // nothing in the region is closer to the light than the receiver
+        pcssRegion = 0;
+        return 0.0;
+    }
+    if(receiver > minMax.y)
+    {
+        // everything in the region occludes the receiver, so does every filter tap
+        pcssRegion = 1;
+        return 1.0;
+    }
+    pcssRegion = 2;
+
+    // per pixel rotation of the poisson disk (interleaved gradient noise) trades banding for fine noise
+    float angle = 6.2831853 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+
+    // 2. blocker search: average depth of the occluders inside the search region
+    float blockerSum = 0.0;
+    int blockers = 0;
+    for(int i = 0; i < 16; ++i)
+    {
+        float depth = texture(shadowMap, projCoords.xy + rotation * poissonDisk[i] * searchRadius).r;
+        if(depth < receiver)
+        {
+            blockerSum += depth;
+            ++blockers;
+        }
+    }
+    if(blockers == 0)
+        return 0.0;
+    float avgBlocker = blockerSum / float(blockers);
+
+    // 3. penumbra width grows with the blocker to receiver distance
+    float filterRadius = clamp(lightSize * (receiver - avgBlocker), 1.0 / shadowSize.x, searchRadius);
+
+    // 4. PCF over the penumbra
+    float shadow = 0.0;
+    for(int i = 0; i < 16; ++i)
+    {
+        float depth = texture(shadowMap, projCoords.xy + rotation * poissonDisk[i] * filterRadius).r;
+        shadow += receiver > depth ? 1.0 : 0.0;
+    }
+    return shadow / 16.0;
+}
+
+// remaps the upper tail of the visibility to zero, trades a bit of contact softness for less light bleeding
+float ReduceLightBleeding(float pMax, float amount)
+{
+    return clamp((pMax - amount) / (1.0 - amount), 0.0, 1.0);
+}
+
+// one sided Chebyshev inequality, upper bound of the fraction of the filter region that is lit
+float ChebyshevUpperBound(vec2 moments, float t, float minVariance)
+{
+    if(t <= moments.x)
+        return 1.0;
+    float variance = max(moments.y - moments.x * moments.x, minVariance);
+    float d = t - moments.x;
+    float pMax = variance / (variance + d * d);
+    return ReduceLightBleeding(pMax, lightBleedReduction);
+}
+
+// Hamburger 4MSM, Peters and Klein 2015 "Moment Shadow Mapping"
+float MSMShadowIntensity(vec4 moments, float fragmentDepth)
+{
+    // bias input data to avoid artifacts
+    vec4 b = mix(moments, vec4(0.5), momentBias);
+    vec3 z;
+    z[0] = fragmentDepth;
+
+    // compute a Cholesky factorization of the Hankel matrix B storing only non-trivial entries or related products
+    float L32D22 = -b[0] * b[1] + b[2];
+    float D22 = -b[0] * b[0] + b[1];
+    float squaredDepthVariance = -b[1] * b[1] + b[3];
+    float D33D22 = dot(vec2(squaredDepthVariance, -L32D22), vec2(D22, L32D22));
+    float InvD22 = 1.0 / D22;
+    float L32 = L32D22 * InvD22;
+
+    // obtain a scaled inverse image of bz = (1, z[0], z[0] * z[0])^T
+    vec3 c = vec3(1.0, z[0], z[0] * z[0]);
+    // forward substitution to solve L * c1 = bz
+    c[1] -= b.x;
+    c[2] -= b.y + L32 * c[1];
+    // scaling to solve D * c2 = c1
+    c[1] *= InvD22;
+    c[2] *= D22 / D33D22;
+    // backward substitution to solve L^T * c3 = c2
+    c[1] -= L32 * c[2];
+    c[0] -= dot(c.yz, b.xy);
+
+    // solve the quadratic equation c[0] + c[1] * z + c[2] * z^2 to obtain solutions z[1] and z[2]
+    float p = c[1] / c[2];
+    float q = c[0] / c[2];
+    float D = (p * p * 0.25) - q;
+    float r = sqrt(D);
+    z[1] = -p * 0.5 - r;
+    z[2] = -p * 0.5 + r;
+
+    // compute the shadow intensity by summing the appropriate weights
+    vec4 switchVal = (z[2] < z[0]) ? vec4(z[1], z[0], 1.0, 1.0) :
+                     ((z[1] < z[0]) ? vec4(z[0], z[1], 0.0, 1.0) : vec4(0.0));
+    float quotient = (switchVal[0] * z[2] - b[0] * (switchVal[0] + z[2]) + b[1]) / ((z[2] - switchVal[1]) * (z[0] - z[1]));
+    return clamp(switchVal[2] + switchVal[3] * quotient, 0.0, 1.0);
+}
+
+float FilteredShadow(vec3 projCoords, float bias)
+{
+    // a single trilinear fetch, the blur and the mip chain already did the filtering
+    vec4 moments = texture(momentMap, projCoords.xy);
+    float depth = projCoords.z - bias;
+
+    if(shadowMode == SHADOW_VSM)
+    {
+        return 1.0 - ChebyshevUpperBound(moments.xy, depth, 0.00002);
+    }
+    else if(shadowMode == SHADOW_EVSM)
+    {
+        float warped = 2.0 * depth - 1.0;
+        float pos = exp(evsmExponents.x * warped);
+        float neg = -exp(-evsmExponents.y * warped);
+        // scale the minimum variance by the derivative of the warp
+        vec2 depthScale = 0.0001 * evsmExponents * vec2(pos, neg);
+        vec2 minVariance = depthScale * depthScale;
+        float posContrib = ChebyshevUpperBound(moments.xy, pos, minVariance.x);
+        float negContrib = ChebyshevUpperBound(moments.zw, neg, minVariance.y);
+        return 1.0 - min(posContrib, negContrib);
+    }
+    else
+    {
+        return 1.0 - ReduceLightBleeding(1.0 - MSMShadowIntensity(moments, depth), lightBleedReduction);
+    }
+}
+
 float ShadowCalculation(vec4 FragPosLightSpace, vec3 normal, vec3 lightDir)
 {
     // // perform perspective divide, to NDC
@@ -28,22 +238,16 @@ float ShadowCalculation(vec4 FragPosLightSpace, vec3 normal, vec3 lightDir)
         return 0.0;
     }else
     {
-        // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-        float closestDepth = texture(shadowMap, projCoords.xy).r; 
-        float currentDepth = projCoords.z;
         float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
-        float shadow = 0.0; //currentDepth - bias > closestDepth ? 1.0 : 0.0f;
-        vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-        for(int x = -1; x <= 1; ++x)
-        {
-            for(int y = -1; y <= 1; ++y)
-            {
-                float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
-                shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;        
-            }    
-        }
-        shadow /= 9.0;
-        return shadow;
+        if(shadowMode == SHADOW_PCF)
+            return PCF(projCoords, bias);
+        if(shadowMode == SHADOW_PCSS)
+            return PCSS(projCoords, bias);
+        // filtered maps hold no data outside the light frustum
+        if(any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
+            return 0.0;
+        // the filter already softens the shadow test, so the filtered modes only need a small constant bias
+        return FilteredShadow(projCoords, 0.001);
     }
 }
 
@@ -71,5 +275,9 @@ void main()
     float shadow = ShadowCalculation(fs_in.FragPosLightSpace, normal, lightDir);
     vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;
 
+    // debug view: green fully lit, red fully shadowed (both early outs), blue full blocker search + filter
+    if(showPcssRegions && pcssRegion >= 0)
+        lighting = mix(lighting, pcssRegion == 0 ? vec3(0.0, 1.0, 0.0) : (pcssRegion == 1 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 0.0, 1.0)), 0.4);
+
     FragColor = vec4(lighting, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 330 core
+out vec4 FragMoments;
+
+// shadow modes, must match SHADOW_* in shadow_mapping.cpp
+#define SHADOW_VSM  1
+#define SHADOW_EVSM 2
+#define SHADOW_MSM  3
+
+uniform int shadowMode;
+uniform vec2 evsmExponents;
+
+void main()
+{
+    // the light uses an orthographic projection, so window space depth is already linear
+    float depth = gl_FragCoord.z;
+
+    if(shadowMode == SHADOW_VSM)
+    {
+        FragMoments = vec4(depth, depth * depth, 0.0, 0.0);
+    }
+    else if(shadowMode == SHADOW_EVSM)
+    {
+        // warp depth into [-1;1] first, keeps the exponentials inside 32 bit float range
+        depth = 2.0 * depth - 1.0;
+        float pos = exp(evsmExponents.x * depth);
+        float neg = -exp(-evsmExponents.y * depth);
+        FragMoments = vec4(pos, pos * pos, neg, neg * neg);
+    }
+    else
+    {
+        float depth2 = depth * depth;
+        FragMoments = vec4(depth, depth2, depth2 * depth, depth2 * depth2);
+    }
+}
@@ -14,9 +14,14 @@
 #include <imgui/backends/imgui_impl_opengl3.h>
 
 #include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 #include <learnopengl/shader.h>
 #include <learnopengl/filesystem.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/gaussian_blur.h>
 
 #include <stb_image.h>
 
@@ -24,10 +29,43 @@
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 768;
 
+// shadow modes, must match SHADOW_* in 3.1.3.shadow_mapping.fs
+enum EShadowMode
+{
+    SHADOW_PCF,
+    SHADOW_VSM,
+    SHADOW_EVSM,
+    SHADOW_MSM,
+    SHADOW_PCSS
+};
+
 typedef struct ui_params
 {
+    int shadow_mode = SHADOW_PCF;
+    int pcf_radius = 1;          // 3x3 kernel
+    int blur_radius = 2;         // prefilter of the moment maps, at shadow map resolution
+    float light_bleed_reduction = 0.2f;
+    float evsm_exponent = 40.0f;
+    float moment_bias = 0.00003f;
+    float light_size = 0.05f;
+    bool show_pcss_regions = false;
+    bool run_benchmark = false;
+    float shadow_ms = 0.0f;
+    float lighting_ms = 0.0f;
 } ui_params;
 
+// one line of the quality / cost benchmark
+struct BenchmarkCase
+{
+    const char* name;
+    int shadow_mode;
+    int pcf_radius;
+    float shadow_ms;
+    float lighting_ms;
+    float rmse; // against the widest PCF kernel, in 8 bit color steps
+};
+static std::vector<BenchmarkCase> benchmarkCases;
+
 unsigned int planeVAO;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -99,6 +137,9 @@ int main()
    // -------------------------
     Shader shader("3.1.3.shadow_mapping.vs", "3.1.3.shadow_mapping.fs");
     Shader simpleDepthShader("3.1.3.shadow_mapping_depth.vs", "3.1.3.shadow_mapping_depth.fs");
+    Shader momentShader("3.1.3.shadow_mapping_depth.vs", "3.1.3.shadow_mapping_moments.fs");
+    Shader blurShader("3.1.3.debug_quad.vs", "3.1.3.shadow_blur.fs");
+    Shader minMaxShader("3.1.3.debug_quad.vs", "3.1.3.depth_minmax.fs");
     Shader debugDepthQuad("3.1.3.debug_quad.vs", "3.1.3.debug_quad_depth.fs");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
@@ -156,6 +197,59 @@ int main()
     glReadBuffer(GL_NONE);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // configure moment map FBOs (ping-pong for the separable prefilter)
+    // ------------------------------------------------------------------
+    // the filtered modes store moments of the depth distribution instead of depth, those can be blurred and mipmapped
+    GLuint momentFBO[2];
+    GLuint momentMap[2];
+    glGenFramebuffers(2, momentFBO);
+    glGenTextures(2, momentMap);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        glBindTexture(GL_TEXTURE_2D, momentMap[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, i == 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (i == 0)
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, momentFBO[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, momentMap[i], 0);
+    }
+    // the moments are rendered with a regular depth test, only the first target needs depth
+    GLuint momentDepthRBO;
+    glGenRenderbuffers(1, &momentDepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, momentDepthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SHADOW_WIDTH, SHADOW_HEIGHT);
+    glBindFramebuffer(GL_FRAMEBUFFER, momentFBO[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, momentDepthRBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // configure the min/max depth hierarchy used by PCSS
+    // ---------------------------------------------------
+    int minMaxLevels = 1;
+    while ((SHADOW_WIDTH >> minMaxLevels) > 0)
+        ++minMaxLevels;
+    GLuint minMaxFBO;
+    GLuint depthMinMax;
+    glGenFramebuffers(1, &minMaxFBO);
+    glGenTextures(1, &depthMinMax);
+    glBindTexture(GL_TEXTURE_2D, depthMinMax);
+    for (int level = 0; level < minMaxLevels; ++level)
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RG32F, std::max(SHADOW_WIDTH >> level, 1u), std::max(SHADOW_HEIGHT >> level, 1u), 0, GL_RG, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, minMaxLevels - 1);
+
+    GpuTimer* shadowTimer = new GpuTimer();
+    GpuTimer* lightingTimer = new GpuTimer();
+
 
     // lighting info
     // -------------
@@ -174,11 +268,32 @@ int main()
     simpleDepthShader.use();
     simpleDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
     
+    momentShader.use();
+    momentShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+
+    blurShader.use();
+    blurShader.setInt("image", 0);
+    GaussianKernel blurKernel(params.blur_radius);
+
+    minMaxShader.use();
+    minMaxShader.setInt("depthMap", 0);
+    minMaxShader.setInt("minMaxMap", 1);
+
     shader.use();
     shader.setInt("diffuseTexture", 0);
     shader.setInt("shadowMap", 1);
+    shader.setInt("momentMap", 2);
+    shader.setInt("depthMinMax", 3);
+    shader.setInt("minMaxLevels", minMaxLevels);
     shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 
+    // benchmark state: every case is warmed up, timed and then compared against the first (reference) case
+    const int BENCHMARK_WARMUP_FRAMES = 20;
+    const int BENCHMARK_FRAMES = 100;
+    int benchmarkCase = -1;
+    int benchmarkFrame = 0;
+    std::vector<unsigned char> referenceImage, benchmarkImage;
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -187,21 +302,137 @@ int main()
         // -----
         processInput(window);
 
+        // start the benchmark, the reference case (widest PCF kernel) goes first
+        if (params.run_benchmark && benchmarkCase < 0)
+        {
+            static const BenchmarkCase cases[] = {
+                { "PCF 9x9 (reference)", SHADOW_PCF, 4 },
+                { "PCF 3x3", SHADOW_PCF, 1 },
+                { "PCF 5x5", SHADOW_PCF, 2 },
+                { "PCF 7x7", SHADOW_PCF, 3 },
+                { "VSM", SHADOW_VSM, 0 },
+                { "EVSM", SHADOW_EVSM, 0 },
+                { "MSM", SHADOW_MSM, 0 },
+                { "PCSS", SHADOW_PCSS, 0 },
+            };
+            benchmarkCases.assign(cases, cases + IM_ARRAYSIZE(cases));
+            benchmarkCase = 0;
+            benchmarkFrame = 0;
+        }
+        if (benchmarkCase >= 0)
+        {
+            params.shadow_mode = benchmarkCases[benchmarkCase].shadow_mode;
+            params.pcf_radius = benchmarkCases[benchmarkCase].pcf_radius;
+            if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+            {
+                shadowTimer->Reset();
+                lightingTimer->Reset();
+            }
+        }
+
         // Rendering
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
         // 1. render depth of scene to texture (from light's perspective)
         // --------------------------------------------------------------
+        shadowTimer->Begin();
         glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        simpleDepthShader.use();
-        renderScene(simpleDepthShader);
+        if (params.shadow_mode == SHADOW_PCF || params.shadow_mode == SHADOW_PCSS)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            glClear(GL_DEPTH_BUFFER_BIT);
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            simpleDepthShader.use();
+            renderScene(simpleDepthShader);
+
+            // 1.1 min/max depth mip hierarchy, every level reduces 2x2 texels of the previous one
+            if (params.shadow_mode == SHADOW_PCSS)
+            {
+                glDisable(GL_DEPTH_TEST);
+                glBindFramebuffer(GL_FRAMEBUFFER, minMaxFBO);
+                minMaxShader.use();
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, depthMap);
+                glActiveTexture(GL_TEXTURE1);
+                for (int level = 0; level < minMaxLevels; ++level)
+                {
+                    // expose only the previous level to the shader, never the one being rendered into
+                    if (level == 0)
+                    {
+                        glBindTexture(GL_TEXTURE_2D, 0);
+                    }
+                    else
+                    {
+                        glBindTexture(GL_TEXTURE_2D, depthMinMax);
+                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+                    }
+                    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, depthMinMax, level);
+                    glViewport(0, 0, std::max(SHADOW_WIDTH >> level, 1u), std::max(SHADOW_HEIGHT >> level, 1u));
+                    minMaxShader.setInt("firstLevel", level == 0);
+                    renderQuad();
+                }
+                glBindTexture(GL_TEXTURE_2D, depthMinMax);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, minMaxLevels - 1);
+                glEnable(GL_DEPTH_TEST);
+            }
+        }
+        else
+        {
+            glm::vec2 evsmExponents(params.evsm_exponent);
+
+            // clear to the moments of the far plane (depth = 1.0)
+            glBindFramebuffer(GL_FRAMEBUFFER, momentFBO[0]);
+            GLfloat farMoments[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+            if (params.shadow_mode == SHADOW_VSM)
+            {
+                farMoments[2] = farMoments[3] = 0.0f;
+            }
+            else if (params.shadow_mode == SHADOW_EVSM)
+            {
+                farMoments[0] = exp(evsmExponents.x);
+                farMoments[1] = farMoments[0] * farMoments[0];
+                farMoments[2] = -exp(-evsmExponents.y);
+                farMoments[3] = farMoments[2] * farMoments[2];
+            }
+            glClearBufferfv(GL_COLOR, 0, farMoments);
+            glClear(GL_DEPTH_BUFFER_BIT);
+
+            momentShader.use();
+            momentShader.setInt("shadowMode", params.shadow_mode);
+            momentShader.setVec2("evsmExponents", evsmExponents);
+            renderScene(momentShader);
+
+            // 1.1 prefilter the moments with a separable gaussian at shadow map resolution,
+            // costs about radius + 1 bilinear taps per direction and shadow map texel instead of per screen pixel
+            if (params.blur_radius > 0)
+            {
+                if (blurKernel.Radius != params.blur_radius)
+                    blurKernel.Build(params.blur_radius);
+                glDisable(GL_DEPTH_TEST);
+                blurShader.use();
+                blurKernel.SetUniforms(blurShader);
+                glActiveTexture(GL_TEXTURE0);
+                for (unsigned int i = 0; i < 2; ++i)
+                {
+                    glBindFramebuffer(GL_FRAMEBUFFER, momentFBO[1 - i]);
+                    glBindTexture(GL_TEXTURE_2D, momentMap[i]);
+                    blurShader.setInt("horizontal", i == 0);
+                    renderQuad();
+                }
+                glEnable(GL_DEPTH_TEST);
+            }
+
+            // mipmaps let the lighting pass filter with one trilinear fetch at any distance
+            glBindTexture(GL_TEXTURE_2D, momentMap[0]);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        shadowTimer->End();
 
         // 2. render scene as normal using the generated depth/shadow map  
         // --------------------------------------------------------------
@@ -217,11 +448,26 @@ int main()
         // set light uniforms
         shader.setVec3("lightPos", lightPos);
         shader.setVec3("viewPos", camera.Position);
+        shader.setInt("shadowMode", params.shadow_mode);
+        shader.setInt("pcfRadius", params.pcf_radius);
+        shader.setFloat("lightBleedReduction", params.light_bleed_reduction);
+        shader.setVec2("evsmExponents", glm::vec2(params.evsm_exponent));
+        shader.setFloat("momentBias", params.moment_bias);
+        shader.setFloat("lightSize", params.light_size);
+        shader.setBool("showPcssRegions", params.show_pcss_regions && benchmarkCase < 0);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, woodTexture);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, depthMap);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, momentMap[0]);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, depthMinMax);
+        lightingTimer->Begin();
         renderScene(shader);
+        lightingTimer->End();
+        params.shadow_ms = shadowTimer->Milliseconds;
+        params.lighting_ms = lightingTimer->Milliseconds;
 
         // 3. render Depth map to quad for visual debugging
         // ---------------------------------------------
@@ -232,6 +478,34 @@ int main()
         glBindTexture(GL_TEXTURE_2D, depthMap);
         // renderQuad();
 
+        // finish the current benchmark case: store timings and compare the frame against the reference image
+        if (benchmarkCase >= 0 && ++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+        {
+            BenchmarkCase& result = benchmarkCases[benchmarkCase];
+            result.shadow_ms = shadowTimer->Average();
+            result.lighting_ms = lightingTimer->Average();
+
+            std::vector<unsigned char>& image = benchmarkCase == 0 ? referenceImage : benchmarkImage;
+            image.resize(SCR_WIDTH * SCR_HEIGHT * 3);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, SCR_WIDTH, SCR_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, &image[0]);
+            double squaredError = 0.0;
+            for (size_t i = 0; i < image.size(); ++i)
+            {
+                double d = (double)image[i] - (double)referenceImage[i];
+                squaredError += d * d;
+            }
+            result.rmse = (float)sqrt(squaredError / image.size());
+
+            printf("%-20s shadow %.3f ms, lighting %.3f ms, rmse %.3f\n", result.name, result.shadow_ms, result.lighting_ms, result.rmse);
+            benchmarkFrame = 0;
+            if (++benchmarkCase == (int)benchmarkCases.size())
+            {
+                benchmarkCase = -1;
+                params.run_benchmark = false;
+            }
+        }
+
         imgui_on_render(params);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -244,6 +518,8 @@ int main()
     // free resources
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteBuffers(1, &planeVBO);
+    delete shadowTimer;
+    delete lightingTimer;
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -543,6 +819,34 @@ void imgui_on_render(ui_params& param)
         return;
     }
 
+    static const char* shadow_mode_items[] = { "PCF", "VSM", "EVSM", "MSM", "PCSS" };
+
+    ImGui::Combo("Shadow Mode", &params.shadow_mode, shadow_mode_items, IM_ARRAYSIZE(shadow_mode_items));
+    if (params.shadow_mode == SHADOW_PCF)
+    {
+        ImGui::SliderInt("PCF Radius", &params.pcf_radius, 0, 4);
+    }
+    else if (params.shadow_mode == SHADOW_PCSS)
+    {
+        ImGui::DragFloat("Light Size", &params.light_size, 0.001f, 0.0f, 0.2f);
+        ImGui::Checkbox("Show PCSS Regions", &params.show_pcss_regions);
+    }
+    else
+    {
+        ImGui::SliderInt("Blur Radius", &params.blur_radius, 0, 16);
+        ImGui::DragFloat("Light Bleed Reduction", &params.light_bleed_reduction, 0.01f, 0.0f, 0.95f);
+        if (params.shadow_mode == SHADOW_EVSM)
+            ImGui::DragFloat("EVSM Exponent", &params.evsm_exponent, 0.5f, 1.0f, 42.0f);
+        if (params.shadow_mode == SHADOW_MSM)
+            ImGui::DragFloat("Moment Bias", &params.moment_bias, 0.000001f, 0.0f, 0.001f, "%.6f");
+    }
+    ImGui::Text("Shadow pass: %.3f ms", params.shadow_ms);
+    ImGui::Text("Lighting pass: %.3f ms", params.lighting_ms);
+    ImGui::Separator();
+    if (ImGui::Button("Run Benchmark"))
+        params.run_benchmark = true;
+    for (size_t i = 0; i < benchmarkCases.size(); ++i)
+        ImGui::Text("%-20s %6.3f + %6.3f ms  rmse %.3f", benchmarkCases[i].name, benchmarkCases[i].shadow_ms, benchmarkCases[i].lighting_ms, benchmarkCases[i].rmse);
     ImGui::Separator();
     ImGui::Text("Press 1 to show cursor");
     ImGui::Text("Press 2 to hide cursor");
@@ -0,0 +1,43 @@
+#version 330 core
+out vec2 FragMinMax;
+
+// builds one face of one level of the min/max depth hierarchy of the shadow cubemap
+uniform samplerCube depthMap;
+uniform samplerCube minMaxMap; // only the previous level is visible (base level == max level)
+uniform bool firstLevel;
+uniform int face;
+uniform float size;            // edge length of the level being written
+
+// direction through a point of a cubemap face, uv in [0,1] (same layout as GL_TEXTURE_CUBE_MAP_POSITIVE_X + face)
+vec3 CubeDirection(int face, vec2 uv)
+{
+    vec2 st = uv * 2.0 - 1.0;
+    if(face == 0) return vec3( 1.0, -st.y, -st.x);
+    if(face == 1) return vec3(-1.0, -st.y,  st.x);
+    if(face == 2) return vec3( st.x,  1.0,  st.y);
+    if(face == 3) return vec3( st.x, -1.0, -st.y);
+    if(face == 4) return vec3( st.x, -st.y,  1.0);
+    return vec3(-st.x, -st.y, -1.0);
+}
+
+void main()
+{
+    if(firstLevel)
+    {
+        FragMinMax = vec2(texture(depthMap, CubeDirection(face, gl_FragCoord.xy / size)).r);
+        return;
+    }
+
+    // the 2x2 texel centers of the previous level, nearest filtering returns each of them exactly
+    vec2 base = floor(gl_FragCoord.xy) * 2.0 + 0.5;
+    vec2 minMax = vec2(1.0, 0.0);
+    for(int y = 0; y < 2; ++y)
+    {
+        for(int x = 0; x < 2; ++x)
+        {
+            vec2 texel = textureLod(minMaxMap, CubeDirection(face, (base + vec2(x, y)) / (size * 2.0)), 0.0).rg;
+            minMax = vec2(min(minMax.x, texel.x), max(minMax.y, texel.y));
+        }
+    }
+    FragMinMax = minMax;
+}
@@ -0,0 +1,41 @@
+#version 330 core
+out vec4 FragColor;
+
+// one direction of the separable prefilter over one face of the moment cubemap
+uniform samplerCube image;
+uniform bool horizontal;
+uniform int face;
+uniform float size;            // edge length of the face being written
+
+// one side of the kernel from GaussianKernel (learnopengl/gaussian_blur.h), weights are normalized so any
+// radius keeps the moments intact; neighbouring texels are merged into one bilinear fetch
+uniform int taps;
+uniform float offsets[65];
+uniform float weights[65];
+
+// direction through a point of a cubemap face, uv in [0,1] (same layout as GL_TEXTURE_CUBE_MAP_POSITIVE_X + face).
+// uv slightly outside [0,1] points into the neighbouring face, so taps near an edge continue across the seam
+vec3 CubeDirection(int face, vec2 uv)
+{
+    vec2 st = uv * 2.0 - 1.0;
+    if(face == 0) return vec3( 1.0, -st.y, -st.x);
+    if(face == 1) return vec3(-1.0, -st.y,  st.x);
+    if(face == 2) return vec3( st.x,  1.0,  st.y);
+    if(face == 3) return vec3( st.x, -1.0, -st.y);
+    if(face == 4) return vec3( st.x, -st.y,  1.0);
+    return vec3(-st.x, -st.y, -1.0);
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / size;
+    vec2 direction = horizontal ? vec2(1.0 / size, 0.0) : vec2(0.0, 1.0 / size);
+
+    vec4 result = textureLod(image, CubeDirection(face, uv), 0.0) * weights[0];
+    for(int i = 1; i < taps; ++i)
+    {
+        result += (textureLod(image, CubeDirection(face, uv + direction * offsets[i]), 0.0) +
+                   textureLod(image, CubeDirection(face, uv - direction * offsets[i]), 0.0)) * weights[i];
+    }
+    FragColor = result;
+}
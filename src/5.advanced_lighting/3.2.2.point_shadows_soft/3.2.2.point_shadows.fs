@@ -7,14 +7,35 @@ in VS_OUT {
     vec2 TexCoords;
 } fs_in;
 
+// shadow modes, must match SHADOW_* in point_shadows_soft.cpp
+#define SHADOW_PCF  0
+#define SHADOW_PCSS 1
+#define SHADOW_VSM  2
+#define SHADOW_EVSM 3
+#define SHADOW_MSM  4
+
 uniform sampler2D diffuseTexture;
 uniform samplerCube depthMap;
+uniform samplerCube depthMinMax; // min/max depth mip hierarchy of depthMap for PCSS
+uniform samplerCube momentMap;   // prefiltered moments for the VSM/EVSM/MSM modes
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 
+uniform float near_plane;
 uniform float far_plane;
 uniform bool shadows;
+uniform int shadowMode;
+uniform float lightRadius;
+uniform float shadowSize;
+uniform int minMaxLevels;
+uniform bool showPcssRegions;
+uniform float lightBleedReduction;
+uniform vec2 evsmExponents;
+uniform float momentBias;
+
+// which path PCSS took for the debug view: 0 fully lit, 1 fully shadowed, 2 penumbra
+int pcssRegion = -1;
 
 vec3 sampleOffsetDirections[20] = vec3[]
 (
@@ -60,6 +81,164 @@ float ShadowCalculation(vec3 fragPos)
     return shadow;
 }
 
+// contact hardening soft shadows for the point light, the min/max hierarchy skips blocker search and filtering
+// wherever the search region is entirely in front of or entirely behind the receiver
+float PCSS(vec3 fragPos)
+{
+    vec3 fragToLight = fragPos - lightPos;
+    float receiver = length(fragToLight) - 0.15;
+
+    // blocker search region at the receiver, a blocker at the near plane would cast the widest penumbra
+    float searchRadius = min(lightRadius * (receiver - near_plane) / near_plane, 0.25 * receiver);
+    searchRadius = max(searchRadius, 2.0 * receiver / shadowSize);
+
+    // 1. pick the level where the search cone covers about one texel and bound it with five fetches,
+    //    sampleOffsetDirections reach up to sqrt(3) * radius away from the center
+    float extent = 1.75 * searchRadius;
+    float angle = extent / receiver;
+    int level = clamp(int(ceil(log2(angle * shadowSize))), 0, minMaxLevels - 1);
+    vec3 dir = fragToLight / length(fragToLight);
+    vec3 tangent = normalize(cross(dir, abs(dir.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+    vec3 bitangent = cross(dir, tangent);
+    vec2 minMax = textureLod(depthMinMax, fragToLight, float(level)).rg;
+    for(int i = 0; i < 4; ++i)
+    {
+        vec2 corner = vec2(i % 2 == 0 ? -1.0 : 1.0, i < 2 ? -1.0 : 1.0);
+        vec2 texel = textureLod(depthMinMax, fragToLight + (tangent * corner.x + bitangent * corner.y) * extent, float(level)).rg;
+        minMax = vec2(min(minMax.x, texel.x), max(minMax.y, texel.y));
+    }
+    minMax *= far_plane;
+    if(receiver <= minMax.x)
+    {
+        pcssRegion = 0;
+        return 0.0;
+    }
+    if(receiver > minMax.y)
+    {
+        pcssRegion = 1;
+        return 1.0;
+    }
+    pcssRegion = 2;
+
+    // 2. blocker search
+    float blockerSum = 0.0;
+    int blockers = 0;
+    for(int i = 0; i < 20; ++i)
+    {
+        float depth = texture(depthMap, fragToLight + sampleOffsetDirections[i] * searchRadius).r * far_plane;
+        if(depth < receiver)
+        {
+            blockerSum += depth;
+            ++blockers;
+        }
+    }
+    if(blockers == 0)
+        return 0.0;
+    float avgBlocker = blockerSum / float(blockers);
+
+    // 3. penumbra width at the receiver grows with the blocker to receiver distance
+    float filterRadius = clamp(lightRadius * (receiver - avgBlocker) / avgBlocker, receiver / shadowSize, searchRadius);
+
+    // 4. PCF over the penumbra
+    float shadow = 0.0;
+    for(int i = 0; i < 20; ++i)
+    {
+        float depth = texture(depthMap, fragToLight + sampleOffsetDirections[i] * filterRadius).r * far_plane;
+        if(receiver > depth)
+            shadow += 1.0;
+    }
+    return shadow / 20.0;
+}
+
+float ReduceLightBleeding(float pMax, float amount)
+{
+    return clamp((pMax - amount) / (1.0 - amount), 0.0, 1.0);
+}
+
+// one sided Chebyshev inequality, upper bound of the fraction of the filter region that is lit
+float ChebyshevUpperBound(vec2 moments, float t, float minVariance)
+{
+    if(t <= moments.x)
+        return 1.0;
+    float variance = max(moments.y - moments.x * moments.x, minVariance);
+    float d = t - moments.x;
+    float pMax = variance / (variance + d * d);
+    return ReduceLightBleeding(pMax, lightBleedReduction);
+}
+
+// Hamburger 4MSM, Peters and Klein 2015 "Moment Shadow Mapping"
+float MSMShadowIntensity(vec4 moments, float fragmentDepth)
+{
+    // bias input data to avoid artifacts
+    vec4 b = mix(moments, vec4(0.5), momentBias);
+    vec3 z;
+    z[0] = fragmentDepth;
+
+    // compute a Cholesky factorization of the Hankel matrix B storing only non-trivial entries or related products
+    float L32D22 = -b[0] * b[1] + b[2];
+    float D22 = -b[0] * b[0] + b[1];
+    float squaredDepthVariance = -b[1] * b[1] + b[3];
+    float D33D22 = dot(vec2(squaredDepthVariance, -L32D22), vec2(D22, L32D22));
+    float InvD22 = 1.0 / D22;
+    float L32 = L32D22 * InvD22;
+
+    // obtain a scaled inverse image of bz = (1, z[0], z[0] * z[0])^T
+    vec3 c = vec3(1.0, z[0], z[0] * z[0]);
+    // forward substitution to solve L * c1 = bz
+    c[1] -= b.x;
+    c[2] -= b.y + L32 * c[1];
+    // scaling to solve D * c2 = c1
+    c[1] *= InvD22;
+    c[2] *= D22 / D33D22;
+    // backward substitution to solve L^T * c3 = c2
+    c[1] -= L32 * c[2];
+    c[0] -= dot(c.yz, b.xy);
+
+    // solve the quadratic equation c[0] + c[1] * z + c[2] * z^2 to obtain solutions z[1] and z[2]
+    float p = c[1] / c[2];
+    float q = c[0] / c[2];
+    float D = (p * p * 0.25) - q;
+    float r = sqrt(D);
+    z[1] = -p * 0.5 - r;
+    z[2] = -p * 0.5 + r;
+
+    // compute the shadow intensity by summing the appropriate weights
+    vec4 switchVal = (z[2] < z[0]) ? vec4(z[1], z[0], 1.0, 1.0) :
+                     ((z[1] < z[0]) ? vec4(z[0], z[1], 0.0, 1.0) : vec4(0.0));
+    float quotient = (switchVal[0] * z[2] - b[0] * (switchVal[0] + z[2]) + b[1]) / ((z[2] - switchVal[1]) * (z[0] - z[1]));
+    return clamp(switchVal[2] + switchVal[3] * quotient, 0.0, 1.0);
+}
+
+// VSM/EVSM/MSM: a single trilinear fetch from the moment cubemap, the blur and the mip chain already did the filtering
+float FilteredShadow(vec3 fragPos)
+{
+    vec3 fragToLight = fragPos - lightPos;
+    vec4 moments = texture(momentMap, fragToLight);
+    // the filter already softens the shadow test, so a much smaller bias than the PCF one is enough
+    float depth = (length(fragToLight) - 0.05) / far_plane;
+
+    if(shadowMode == SHADOW_VSM)
+    {
+        return 1.0 - ChebyshevUpperBound(moments.xy, depth, 0.00002);
+    }
+    else if(shadowMode == SHADOW_EVSM)
+    {
+        float warped = 2.0 * depth - 1.0;
+        float pos = exp(evsmExponents.x * warped);
+        float neg = -exp(-evsmExponents.y * warped);
+        // scale the minimum variance by the derivative of the warp
+        vec2 depthScale = 0.0001 * evsmExponents * vec2(pos, neg);
+        vec2 minVariance = depthScale * depthScale;
+        float posContrib = ChebyshevUpperBound(moments.xy, pos, minVariance.x);
+        float negContrib = ChebyshevUpperBound(moments.zw, neg, minVariance.y);
+        return 1.0 - min(posContrib, negContrib);
+    }
+    else
+    {
+        return 1.0 - ReduceLightBleeding(1.0 - MSMShadowIntensity(moments, depth), lightBleedReduction);
+    }
+}
+
 void main()
 {           
     vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
@@ -79,8 +258,21 @@ void main()
     spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
     vec3 specular = spec * lightColor;    
     // calculate shadow
-    float shadow = shadows ? ShadowCalculation(fs_in.FragPos) : 0.0;                      
+    float shadow = 0.0;
+    if(shadows)
+    {
+        if(shadowMode == SHADOW_PCF)
+            shadow = ShadowCalculation(fs_in.FragPos);
+        else if(shadowMode == SHADOW_PCSS)
+            shadow = PCSS(fs_in.FragPos);
+        else
+            shadow = FilteredShadow(fs_in.FragPos);
+    }
     vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;    
+
+    // debug view: green fully lit, red fully shadowed (both early outs), blue full blocker search + filter
+    if(showPcssRegions && pcssRegion >= 0)
+        lighting = mix(lighting, pcssRegion == 0 ? vec3(0.0, 1.0, 0.0) : (pcssRegion == 1 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 0.0, 1.0)), 0.4);
     
     FragColor = vec4(lighting, 1.0);
 }
\ No newline at end of file
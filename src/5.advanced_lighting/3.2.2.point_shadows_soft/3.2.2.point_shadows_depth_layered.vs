@@ -0,0 +1,20 @@
+#version 330 core
+// gl_Layer in the vertex shader, either extension is enough
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 shadowMatrices[6];
+uniform int faceIndices[6]; // cube faces the object is visible in, one instance per entry
+
+out vec4 FragPos;
+
+void main()
+{
+    // one instance per visible face replaces the 6x triangle amplification of the geometry shader
+    int face = faceIndices[gl_InstanceID];
+    FragPos = model * vec4(aPos, 1.0);
+    gl_Position = shadowMatrices[face] * FragPos;
+    gl_Layer = face;
+}
@@ -0,0 +1,38 @@
+#version 330 core
+in vec4 FragPos;
+out vec4 FragMoments;
+
+// shadow modes, must match SHADOW_* in point_shadows_soft.cpp
+#define SHADOW_VSM  2
+#define SHADOW_EVSM 3
+#define SHADOW_MSM  4
+
+uniform vec3 lightPos;
+uniform float far_plane;
+uniform int shadowMode;
+uniform vec2 evsmExponents;
+
+void main()
+{
+    // same linear [0;1] light distance as the depth cubemap, the depth test keeps the closest one
+    float depth = length(FragPos.xyz - lightPos) / far_plane;
+    gl_FragDepth = depth;
+
+    if(shadowMode == SHADOW_VSM)
+    {
+        FragMoments = vec4(depth, depth * depth, 0.0, 0.0);
+    }
+    else if(shadowMode == SHADOW_EVSM)
+    {
+        // warp depth into [-1;1] first, keeps the exponentials inside 32 bit float range
+        float warped = 2.0 * depth - 1.0;
+        float pos = exp(evsmExponents.x * warped);
+        float neg = -exp(-evsmExponents.y * warped);
+        FragMoments = vec4(pos, pos * pos, neg, neg * neg);
+    }
+    else
+    {
+        float depth2 = depth * depth;
+        FragMoments = vec4(depth, depth2, depth2 * depth, depth2 * depth2);
+    }
+}
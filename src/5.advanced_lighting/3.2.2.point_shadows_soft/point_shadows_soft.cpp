@@ -14,9 +14,14 @@
 #include <imgui/backends/imgui_impl_opengl3.h>
 
 #include <iostream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
 #include <learnopengl/shader.h>
 #include <learnopengl/filesystem.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/gaussian_blur.h>
 
 #include <stb_image.h>
 
@@ -24,18 +29,77 @@
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 768;
 
+// how the six faces of the depth cubemap are rendered
+enum EDepthPass
+{
+	DEPTH_PASS_GEOMETRY_SHADER,  // every triangle is amplified 6x by 3.2.2.point_shadows_depth.gs
+	DEPTH_PASS_INSTANCED_LAYERED // one instance per visible face, gl_Layer written by the vertex shader
+};
+
+// how the lighting pass filters the shadow cubemap, must match SHADOW_* in the shaders
+enum EShadowFilter
+{
+	SHADOW_PCF,  // fixed 20 tap disk on the depth cubemap
+	SHADOW_PCSS, // contact hardening blocker search + PCF on the depth cubemap
+	SHADOW_VSM,  // the filtered modes render a moment cubemap instead, prefiltered once per shadow map texel
+	SHADOW_EVSM,
+	SHADOW_MSM
+};
+
 typedef struct ui_params
 {
 	bool shadows = true;
+	int depth_pass = DEPTH_PASS_GEOMETRY_SHADER;
+	bool face_culling = true;
+	int extra_cubes = 0;
+	bool run_benchmark = false;
+	bool layered_supported = false;
+	int shadow_filter = SHADOW_PCF;
+	float light_radius = 0.1f;
+	bool show_pcss_regions = false;
+	int blur_radius = 2;
+	float light_bleed_reduction = 0.2f;
+	float evsm_exponent = 40.0f;
+	float moment_bias = 0.00003f;
+	bool run_filter_benchmark = false;
+	float depth_ms = 0.0f;
+	float lighting_ms = 0.0f;
+	int face_draws = 0;
 } ui_params;
 
+// scene objects, the first one is the room which is rendered from the inside
+struct SceneObject
+{
+	glm::mat4 Model;
+	glm::vec3 Center;
+	float Radius;
+};
+static std::vector<SceneObject> sceneObjects;
+static float benchmarkResults[3] = { 0.0f, 0.0f, 0.0f };
+
+// one line of the shadow filter quality / cost benchmark
+struct FilterBenchmarkCase
+{
+	const char* name;
+	int shadow_filter;
+	float depth_ms;
+	float lighting_ms;
+	float rmse; // against the 20 tap PCF disk, in 8 bit color steps
+};
+static std::vector<FilterBenchmarkCase> filterBenchmarkCases;
+
+void buildScene(int extraCubes);
+bool sphereInCubeFace(const glm::vec3& fromLight, float radius, int face, float farPlane);
+bool hasExtension(const char* name);
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* texPath);
 void renderScene(const Shader& shader);
-void renderCube();
+int renderSceneLayered(const Shader& shader, const glm::vec3& lightPos, float farPlane, bool faceCulling);
+void renderCube(int instanceCount = 1);
 void renderQuad();
 
 void imgui_on_init(GLFWwindow* window);
@@ -99,6 +163,18 @@ int main()
 	Shader shader("3.2.2.point_shadows.vs", "3.2.2.point_shadows.fs");
 	Shader simpleDepthShader("3.2.2.point_shadows_depth.vs", "3.2.2.point_shadows_depth.fs", "3.2.2.point_shadows_depth.gs");
 
+	// the layered path needs gl_Layer in the vertex shader, fall back to the geometry shader without it
+	params.layered_supported = hasExtension("GL_ARB_shader_viewport_layer_array") || hasExtension("GL_AMD_vertex_shader_layer");
+	Shader minMaxShader("3.2.2.depth_minmax.vs", "3.2.2.depth_minmax.fs");
+	Shader layeredDepthShader(params.layered_supported ? "3.2.2.point_shadows_depth_layered.vs" : "3.2.2.point_shadows_depth.vs", "3.2.2.point_shadows_depth.fs", params.layered_supported ? NULL : "3.2.2.point_shadows_depth.gs");
+	Shader momentShader("3.2.2.point_shadows_depth.vs", "3.2.2.point_shadows_moments.fs", "3.2.2.point_shadows_depth.gs");
+	Shader layeredMomentShader(params.layered_supported ? "3.2.2.point_shadows_depth_layered.vs" : "3.2.2.point_shadows_depth.vs", "3.2.2.point_shadows_moments.fs", params.layered_supported ? NULL : "3.2.2.point_shadows_depth.gs");
+	Shader blurShader("3.2.2.depth_minmax.vs", "3.2.2.moment_blur.fs");
+	buildScene(params.extra_cubes);
+	int sceneCubes = params.extra_cubes;
+	GpuTimer* depthTimer = new GpuTimer();
+	GpuTimer* lightingTimer = new GpuTimer();
+
 	// load textures
 	// -------------
 	unsigned int woodTexture = loadTexture("res/textures/wood.png");
@@ -128,6 +204,75 @@ int main()
 	glReadBuffer(GL_NONE);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+	// configure the min/max depth hierarchy used by PCSS
+	// ---------------------------------------------------
+	int minMaxLevels = 1;
+	while ((SHADOW_WIDTH >> minMaxLevels) > 0)
+		++minMaxLevels;
+	GLuint minMaxFBO;
+	glGenFramebuffers(1, &minMaxFBO);
+
+	GLuint depthMinMax;
+	glGenTextures(1, &depthMinMax);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, depthMinMax);
+	for (int level = 0; level < minMaxLevels; ++level)
+	{
+		for (GLuint i = 0; i < 6; ++i)
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RG32F, std::max(SHADOW_WIDTH >> level, 1u), std::max(SHADOW_HEIGHT >> level, 1u), 0, GL_RG, GL_FLOAT, NULL);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, minMaxLevels - 1);
+
+	// configure the moment cubemaps of the filtered modes (ping-pong for the separable prefilter)
+	// -------------------------------------------------------------------------------------------
+	// moments of the light distance can be blurred and mipmapped, which depth cannot. They are filtered anyway, so
+	// half the depth cubemap resolution is enough and keeps the two RGBA32F cubemaps at 24 MB each.
+	const unsigned int MOMENT_SIZE = SHADOW_WIDTH / 2;
+	GLuint momentCubeMap[2];
+	glGenTextures(2, momentCubeMap);
+	for (unsigned int i = 0; i < 2; ++i)
+	{
+		glBindTexture(GL_TEXTURE_CUBE_MAP, momentCubeMap[i]);
+		for (GLuint face = 0; face < 6; ++face)
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA32F, MOMENT_SIZE, MOMENT_SIZE, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, i == 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		if (i == 0)
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	}
+	// the trilinear lookups and the blur taps near an edge blend across faces
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	// the moments are rendered into all six faces at once like the depth cubemap, a layered color attachment
+	// needs a layered depth attachment of the same size
+	GLuint momentDepthCubeMap;
+	glGenTextures(1, &momentDepthCubeMap);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, momentDepthCubeMap);
+	for (GLuint face = 0; face < 6; ++face)
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, MOMENT_SIZE, MOMENT_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	GLuint momentFBO;
+	glGenFramebuffers(1, &momentFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, momentFBO);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, momentCubeMap[0], 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, momentDepthCubeMap, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer not complete!" << std::endl;
+
+	// the blur writes one face at a time
+	GLuint momentBlurFBO;
+	glGenFramebuffers(1, &momentBlurFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
 
 	// lighting info
 	// -------------
@@ -144,12 +289,44 @@ int main()
 	// --------------------
 	simpleDepthShader.use();
 	simpleDepthShader.setFloat("far_plane", far_plane);
+
+	layeredDepthShader.use();
+	layeredDepthShader.setFloat("far_plane", far_plane);
+
+	momentShader.use();
+	momentShader.setFloat("far_plane", far_plane);
+
+	layeredMomentShader.use();
+	layeredMomentShader.setFloat("far_plane", far_plane);
+
+	blurShader.use();
+	blurShader.setInt("image", 0);
+	blurShader.setFloat("size", (float)MOMENT_SIZE);
+	GaussianKernel blurKernel(params.blur_radius);
 	
+	// benchmark state: geometry shader, instanced layered, instanced layered + per-face culling
+	const int BENCHMARK_WARMUP_FRAMES = 20;
+	const int BENCHMARK_FRAMES = 200;
+	int benchmarkCase = -1;
+	int benchmarkFrame = 0;
+
+	// shadow filter benchmark: every filter is warmed up, timed and then compared against the first (reference) case
+	int filterBenchmarkCase = -1;
+	std::vector<unsigned char> referenceImage, benchmarkImage;
+
+	minMaxShader.use();
+	minMaxShader.setInt("depthMap", 0);
+	minMaxShader.setInt("minMaxMap", 1);
 
 	shader.use();
+	shader.setFloat("near_plane", near_plane);
 	shader.setFloat("far_plane", far_plane);
 	shader.setInt("diffuseTexture", 0);
 	shader.setInt("depthMap", 1);
+	shader.setInt("depthMinMax", 2);
+	shader.setInt("momentMap", 3);
+	shader.setFloat("shadowSize", (float)SHADOW_WIDTH);
+	shader.setInt("minMaxLevels", minMaxLevels);
 	
 
 	// render loop
@@ -160,8 +337,55 @@ int main()
 		// -----
 		processInput(window);
 
-		// move light position over time
-		lightPos.z = sin(glfwGetTime() * 0.5) * 3.0;
+		if (sceneCubes != params.extra_cubes)
+		{
+			buildScene(params.extra_cubes);
+			sceneCubes = params.extra_cubes;
+		}
+
+		if (!params.layered_supported)
+			params.depth_pass = DEPTH_PASS_GEOMETRY_SHADER;
+		if (params.run_benchmark && benchmarkCase < 0 && filterBenchmarkCase < 0)
+		{
+			benchmarkCase = 0;
+			benchmarkFrame = 0;
+		}
+		if (benchmarkCase >= 0)
+		{
+			params.depth_pass = benchmarkCase == 0 ? DEPTH_PASS_GEOMETRY_SHADER : DEPTH_PASS_INSTANCED_LAYERED;
+			params.face_culling = benchmarkCase == 2;
+			if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+				depthTimer->Reset();
+		}
+
+		// start the filter benchmark, the reference case (the 20 tap PCF disk) goes first
+		if (params.run_filter_benchmark && filterBenchmarkCase < 0 && benchmarkCase < 0)
+		{
+			static const FilterBenchmarkCase cases[] = {
+				{ "PCF 20 taps (reference)", SHADOW_PCF },
+				{ "PCSS", SHADOW_PCSS },
+				{ "VSM", SHADOW_VSM },
+				{ "EVSM", SHADOW_EVSM },
+				{ "MSM", SHADOW_MSM },
+			};
+			filterBenchmarkCases.assign(cases, cases + IM_ARRAYSIZE(cases));
+			filterBenchmarkCase = 0;
+			benchmarkFrame = 0;
+			params.shadows = true;
+		}
+		if (filterBenchmarkCase >= 0)
+		{
+			params.shadow_filter = filterBenchmarkCases[filterBenchmarkCase].shadow_filter;
+			if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+			{
+				depthTimer->Reset();
+				lightingTimer->Reset();
+			}
+		}
+
+		// move light position over time, it stands still while the filters are compared against the same reference image
+		if (filterBenchmarkCase < 0)
+			lightPos.z = sin(glfwGetTime() * 0.5) * 3.0;
 
 		std::vector<glm::mat4> shadowTransforms;
 		shadowTransforms.push_back(shadowProj* glm::lookAt(lightPos, lightPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
@@ -177,16 +401,151 @@ int main()
 
 		// 1. render depth of scene to texture (from light's perspective)
 		// --------------------------------------------------------------
-		glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-		glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-		glClear(GL_DEPTH_BUFFER_BIT);
-
-		simpleDepthShader.use();
-		simpleDepthShader.setMat4("shadowMatrices", shadowTransforms[0], 6);
-		simpleDepthShader.setVec3("lightPos", lightPos);
-
-		renderScene(simpleDepthShader);
+		depthTimer->Begin();
+		bool filtered = params.shadow_filter >= SHADOW_VSM;
+		if (!filtered)
+		{
+			glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+			glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}
+		else
+		{
+			glm::vec2 evsmExponents(params.evsm_exponent);
+
+			// clear to the moments of the far plane (depth = 1.0)
+			glViewport(0, 0, MOMENT_SIZE, MOMENT_SIZE);
+			glBindFramebuffer(GL_FRAMEBUFFER, momentFBO);
+			GLfloat farMoments[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			if (params.shadow_filter == SHADOW_VSM)
+			{
+				farMoments[2] = farMoments[3] = 0.0f;
+			}
+			else if (params.shadow_filter == SHADOW_EVSM)
+			{
+				farMoments[0] = exp(evsmExponents.x);
+				farMoments[1] = farMoments[0] * farMoments[0];
+				farMoments[2] = -exp(-evsmExponents.y);
+				farMoments[3] = farMoments[2] * farMoments[2];
+			}
+			glClearBufferfv(GL_COLOR, 0, farMoments);
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+			Shader& activeShader = params.depth_pass == DEPTH_PASS_GEOMETRY_SHADER ? momentShader : layeredMomentShader;
+			activeShader.use();
+			activeShader.setInt("shadowMode", params.shadow_filter);
+			activeShader.setVec2("evsmExponents", evsmExponents);
+		}
+
+		if (params.depth_pass == DEPTH_PASS_GEOMETRY_SHADER)
+		{
+			Shader& depthShader = filtered ? momentShader : simpleDepthShader;
+			depthShader.use();
+			depthShader.setMat4("shadowMatrices", shadowTransforms[0], 6);
+			depthShader.setVec3("lightPos", lightPos);
+
+			renderScene(depthShader);
+			params.face_draws = (int)sceneObjects.size() * 6;
+		}
+		else
+		{
+			Shader& depthShader = filtered ? layeredMomentShader : layeredDepthShader;
+			depthShader.use();
+			depthShader.setMat4("shadowMatrices", shadowTransforms[0], 6);
+			depthShader.setVec3("lightPos", lightPos);
+
+			params.face_draws = renderSceneLayered(depthShader, lightPos, far_plane, params.face_culling);
+		}
+
+		if (filtered)
+		{
+			// 1.1 prefilter every face with a separable gaussian at moment map resolution, costs about radius + 1
+			// bilinear taps per direction and moment texel instead of 20 depth fetches per screen pixel
+			if (params.blur_radius > 0)
+			{
+				if (blurKernel.Radius != params.blur_radius)
+					blurKernel.Build(params.blur_radius);
+				glDisable(GL_DEPTH_TEST);
+				glBindFramebuffer(GL_FRAMEBUFFER, momentBlurFBO);
+				blurShader.use();
+				blurKernel.SetUniforms(blurShader);
+				glActiveTexture(GL_TEXTURE0);
+				for (unsigned int i = 0; i < 2; ++i)
+				{
+					glBindTexture(GL_TEXTURE_CUBE_MAP, momentCubeMap[i]);
+					blurShader.setInt("horizontal", i == 0);
+					for (int face = 0; face < 6; ++face)
+					{
+						glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, momentCubeMap[1 - i], 0);
+						blurShader.setInt("face", face);
+						renderQuad();
+					}
+				}
+				glEnable(GL_DEPTH_TEST);
+			}
+
+			// mipmaps let the lighting pass filter with one trilinear fetch at any distance
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, momentCubeMap[0]);
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+		}
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		depthTimer->End();
+		params.depth_ms = depthTimer->Milliseconds;
+
+		if (benchmarkCase >= 0 && ++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+		{
+			static const char* names[] = { "geometry shader", "instanced layered", "instanced layered + face culling" };
+			benchmarkResults[benchmarkCase] = depthTimer->Average();
+			printf("%-34s %4d objects: depth pass %.3f ms\n", names[benchmarkCase], (int)sceneObjects.size(), benchmarkResults[benchmarkCase]);
+			benchmarkFrame = 0;
+			if (++benchmarkCase == 3 || !params.layered_supported)
+			{
+				benchmarkCase = -1;
+				params.run_benchmark = false;
+			}
+		}
+
+		lightingTimer->Begin();
+		// 1.2 min/max depth hierarchy for PCSS, every level reduces 2x2 texels of the previous one per face
+		if (params.shadows && params.shadow_filter == SHADOW_PCSS)
+		{
+			glDisable(GL_DEPTH_TEST);
+			glBindFramebuffer(GL_FRAMEBUFFER, minMaxFBO);
+			minMaxShader.use();
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
+			glActiveTexture(GL_TEXTURE1);
+			for (int level = 0; level < minMaxLevels; ++level)
+			{
+				// expose only the previous level to the shader, never the one being rendered into
+				if (level == 0)
+				{
+					glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+				}
+				else
+				{
+					glBindTexture(GL_TEXTURE_CUBE_MAP, depthMinMax);
+					glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, level - 1);
+					glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, level - 1);
+				}
+				unsigned int size = std::max(SHADOW_WIDTH >> level, 1u);
+				glViewport(0, 0, size, size);
+				minMaxShader.setInt("firstLevel", level == 0);
+				minMaxShader.setFloat("size", (float)size);
+				for (int face = 0; face < 6; ++face)
+				{
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, depthMinMax, level);
+					minMaxShader.setInt("face", face);
+					renderQuad();
+				}
+			}
+			glBindTexture(GL_TEXTURE_CUBE_MAP, depthMinMax);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, minMaxLevels - 1);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glEnable(GL_DEPTH_TEST);
+		}
 
 		// 2. render scene as normal using the generated depth/shadow map  
 		// --------------------------------------------------------------
@@ -203,12 +562,24 @@ int main()
 		shader.setVec3("lightPos", lightPos);
 		shader.setVec3("viewPos", camera.Position);
 		shader.setInt("shadows", params.shadows); // enable/disable shadows
+		shader.setInt("shadowMode", params.shadow_filter);
+		shader.setFloat("lightRadius", params.light_radius);
+		shader.setBool("showPcssRegions", params.show_pcss_regions && filterBenchmarkCase < 0);
+		shader.setFloat("lightBleedReduction", params.light_bleed_reduction);
+		shader.setVec2("evsmExponents", glm::vec2(params.evsm_exponent));
+		shader.setFloat("momentBias", params.moment_bias);
 		
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, woodTexture);
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, depthMinMax);
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, momentCubeMap[0]);
 		renderScene(shader);
+		lightingTimer->End();
+		params.lighting_ms = lightingTimer->Milliseconds;
 
 		// 3. render Depth map to quad for visual debugging
 		// ---------------------------------------------
@@ -219,6 +590,34 @@ int main()
 		// glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
 		// renderQuad();
 
+		// finish the current filter benchmark case: store timings and compare the frame against the reference image
+		if (filterBenchmarkCase >= 0 && ++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+		{
+			FilterBenchmarkCase& result = filterBenchmarkCases[filterBenchmarkCase];
+			result.depth_ms = depthTimer->Average();
+			result.lighting_ms = lightingTimer->Average();
+
+			std::vector<unsigned char>& image = filterBenchmarkCase == 0 ? referenceImage : benchmarkImage;
+			image.resize(SCR_WIDTH * SCR_HEIGHT * 3);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glReadPixels(0, 0, SCR_WIDTH, SCR_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, &image[0]);
+			double squaredError = 0.0;
+			for (size_t i = 0; i < image.size(); ++i)
+			{
+				double d = (double)image[i] - (double)referenceImage[i];
+				squaredError += d * d;
+			}
+			result.rmse = (float)sqrt(squaredError / image.size());
+
+			printf("%-24s shadow map %.3f ms, lighting %.3f ms, rmse %.3f\n", result.name, result.depth_ms, result.lighting_ms, result.rmse);
+			benchmarkFrame = 0;
+			if (++filterBenchmarkCase == (int)filterBenchmarkCases.size())
+			{
+				filterBenchmarkCase = -1;
+				params.run_filter_benchmark = false;
+			}
+		}
+
 		imgui_on_render(params);
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -229,6 +628,8 @@ int main()
 
 
 	// free resources
+	delete depthTimer;
+	delete lightingTimer;
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -338,53 +739,139 @@ unsigned int loadTexture(char const* path)
 	return textureID;
 }
 
+// builds the 3D scene, optionally with a number of extra cubes scattered through the room
+// -----------------------------------------------------------------------------------------
+void buildScene(int extraCubes)
+{
+	sceneObjects.clear();
+
+	// room cube
+	glm::mat4 models[6];
+	models[0] = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
+	// cubes
+	models[1] = glm::translate(glm::mat4(1.0f), glm::vec3(4.0f, -3.5f, 0.0));
+	models[1] = glm::scale(models[1], glm::vec3(0.5f));
+	models[2] = glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 3.0f, 1.0));
+	models[2] = glm::scale(models[2], glm::vec3(0.75f));
+	models[3] = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f, -1.0f, 0.0));
+	models[3] = glm::scale(models[3], glm::vec3(0.5f));
+	models[4] = glm::translate(glm::mat4(1.0f), glm::vec3(-1.5f, 1.0f, 1.5));
+	models[4] = glm::scale(models[4], glm::vec3(0.5f));
+	models[5] = glm::translate(glm::mat4(1.0f), glm::vec3(-1.5f, 2.0f, -3.0));
+	models[5] = glm::rotate(models[5], glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+	models[5] = glm::scale(models[5], glm::vec3(0.75f));
+
+	srand(7);
+	for (int i = 0; i < 6 + extraCubes; ++i)
+	{
+		glm::mat4 model;
+		if (i < 6)
+		{
+			model = models[i];
+		}
+		else
+		{
+			glm::vec3 position(((rand() % 100) / 100.0f) * 9.0f - 4.5f, ((rand() % 100) / 100.0f) * 9.0f - 4.5f, ((rand() % 100) / 100.0f) * 9.0f - 4.5f);
+			model = glm::translate(glm::mat4(1.0f), position);
+			model = glm::scale(model, glm::vec3(0.1f + ((rand() % 100) / 100.0f) * 0.2f));
+		}
+
+		// bounding sphere of the unit cube [-1;1]^3 after the model transform
+		SceneObject object;
+		object.Model = model;
+		object.Center = glm::vec3(model[3]);
+		object.Radius = glm::sqrt(3.0f) * glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+		sceneObjects.push_back(object);
+	}
+}
+
 // renders the 3D scene
 // --------------------
 void renderScene(const Shader& shader)
 {
-	// room cube
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::scale(model, glm::vec3(5.0f));
-	shader.setMat4("model", model);
-	glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
-	shader.setInt("reverse_normals", 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
-	renderCube();
-	shader.setInt("reverse_normals", 0); // and of course disable it
-	glEnable(GL_CULL_FACE);
-	// cubes
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
-	model = glm::scale(model, glm::vec3(0.5f));
-	shader.setMat4("model", model);
-	renderCube();
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
-	model = glm::scale(model, glm::vec3(0.75f));
-	shader.setMat4("model", model);
-	renderCube();
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
-	model = glm::scale(model, glm::vec3(0.5f));
-	shader.setMat4("model", model);
-	renderCube();
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
-	model = glm::scale(model, glm::vec3(0.5f));
-	shader.setMat4("model", model);
-	renderCube();
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
-	model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-	model = glm::scale(model, glm::vec3(0.75f));
-	shader.setMat4("model", model);
-	renderCube();
+	for (size_t i = 0; i < sceneObjects.size(); ++i)
+	{
+		shader.setMat4("model", sceneObjects[i].Model);
+		if (i == 0)
+		{
+			glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
+			shader.setInt("reverse_normals", 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
+			renderCube();
+			shader.setInt("reverse_normals", 0); // and of course disable it
+			glEnable(GL_CULL_FACE);
+		}
+		else
+		{
+			renderCube();
+		}
+	}
+}
+
+// renders the scene into all faces of the depth cubemap in one pass, each object is instanced once per cube face
+// whose frustum its bounding sphere touches. Returns the number of object/face pairs that were drawn.
+// --------------------------------------------------------------------------------------------------------------
+int renderSceneLayered(const Shader& shader, const glm::vec3& lightPos, float farPlane, bool faceCulling)
+{
+	int faceDraws = 0;
+	for (size_t i = 0; i < sceneObjects.size(); ++i)
+	{
+		int faceIndices[6];
+		int faceCount = 0;
+		for (int face = 0; face < 6; ++face)
+		{
+			if (!faceCulling || sphereInCubeFace(sceneObjects[i].Center - lightPos, sceneObjects[i].Radius, face, farPlane))
+				faceIndices[faceCount++] = face;
+		}
+		if (faceCount == 0)
+			continue;
+
+		shader.setMat4("model", sceneObjects[i].Model);
+		glUniform1iv(glGetUniformLocation(shader.ID, "faceIndices"), faceCount, faceIndices);
+		if (i == 0)
+			glDisable(GL_CULL_FACE);
+		renderCube(faceCount);
+		if (i == 0)
+			glEnable(GL_CULL_FACE);
+		faceDraws += faceCount;
+	}
+	return faceDraws;
+}
+
+// conservative sphere vs. cube face frustum test. Face order matches GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+// the frustum of a face is the 90 degree pyramid around its axis, cut off at the far plane.
+// -----------------------------------------------------------------------------------------------------------
+bool sphereInCubeFace(const glm::vec3& fromLight, float radius, int face, float farPlane)
+{
+	int axis = face / 2;
+	float d = (face % 2 == 0) ? fromLight[axis] : -fromLight[axis];
+	if (d < -radius || d > farPlane + radius)
+		return false;
+	for (int other = 0; other < 3; ++other)
+	{
+		// side planes d - v = 0 and d + v = 0, their normals have length sqrt(2)
+		if (other != axis && d - glm::abs(fromLight[other]) < -radius * glm::sqrt(2.0f))
+			return false;
+	}
+	return true;
+}
+
+bool hasExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i)
+	{
+		if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+			return true;
+	}
+	return false;
 }
 
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
 unsigned int cubeVBO = 0;
-void renderCube()
+void renderCube(int instanceCount)
 {
 	// initialize (if necessary)
 	if (cubeVAO == 0)
@@ -451,7 +938,10 @@ void renderCube()
 	}
 	// render Cube
 	glBindVertexArray(cubeVAO);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	if (instanceCount == 1)
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+	else
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount);
 	glBindVertexArray(0);
 }
 
@@ -538,7 +1028,46 @@ void imgui_on_render(ui_params& param)
 		return;
 	}
 
+	static const char* depth_pass_items[] = { "Geometry Shader", "Instanced Layered" };
+
+	static const char* shadow_filter_items[] = { "PCF (fixed disk)", "PCSS", "VSM", "EVSM", "MSM" };
+
 	ImGui::Checkbox("Shadows", &params.shadows);
+	ImGui::Combo("Soft Shadows", &params.shadow_filter, shadow_filter_items, IM_ARRAYSIZE(shadow_filter_items));
+	if (params.shadow_filter == SHADOW_PCSS)
+	{
+		ImGui::DragFloat("Light Radius", &params.light_radius, 0.005f, 0.0f, 1.0f);
+		ImGui::Checkbox("Show PCSS Regions", &params.show_pcss_regions);
+	}
+	else if (params.shadow_filter >= SHADOW_VSM)
+	{
+		ImGui::SliderInt("Blur Radius", &params.blur_radius, 0, 16);
+		ImGui::DragFloat("Light Bleed Reduction", &params.light_bleed_reduction, 0.01f, 0.0f, 0.95f);
+		if (params.shadow_filter == SHADOW_EVSM)
+			ImGui::DragFloat("EVSM Exponent", &params.evsm_exponent, 0.5f, 1.0f, 42.0f);
+		if (params.shadow_filter == SHADOW_MSM)
+			ImGui::DragFloat("Moment Bias", &params.moment_bias, 0.000001f, 0.0f, 0.001f, "%.6f");
+	}
+	if (params.layered_supported)
+	{
+		ImGui::Combo("Depth Pass", &params.depth_pass, depth_pass_items, IM_ARRAYSIZE(depth_pass_items));
+		if (params.depth_pass == DEPTH_PASS_INSTANCED_LAYERED)
+			ImGui::Checkbox("Per-Face Culling", &params.face_culling);
+	}
+	else
+	{
+		ImGui::Text("Instanced layered: vertex shader gl_Layer not supported");
+	}
+	ImGui::SliderInt("Extra Cubes", &params.extra_cubes, 0, 2000);
+	ImGui::Text("Depth pass: %.3f ms, %d object faces (including the moment prefilter)", params.depth_ms, params.face_draws);
+	ImGui::Text("Lighting pass: %.3f ms (including the PCSS min/max build)", params.lighting_ms);
+	if (ImGui::Button("Run Benchmark"))
+		params.run_benchmark = true;
+	ImGui::Text("GS %.3f ms, layered %.3f ms, layered + culling %.3f ms", benchmarkResults[0], benchmarkResults[1], benchmarkResults[2]);
+	if (ImGui::Button("Run Filter Benchmark"))
+		params.run_filter_benchmark = true;
+	for (size_t i = 0; i < filterBenchmarkCases.size(); ++i)
+		ImGui::Text("%-24s %6.3f + %6.3f ms  rmse %.3f", filterBenchmarkCases[i].name, filterBenchmarkCases[i].depth_ms, filterBenchmarkCases[i].lighting_ms, filterBenchmarkCases[i].rmse);
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
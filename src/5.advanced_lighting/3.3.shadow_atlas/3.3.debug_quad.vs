@@ -4,8 +4,10 @@ layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
+uniform vec4 viewport; // xy: bottom left, zw: size in NDC
+
 void main()
 {
     TexCoords = aTexCoords;
-	gl_Position = vec4(aPos, 1.0);
-}
\ No newline at end of file
+    gl_Position = vec4(viewport.xy + (aPos.xy * 0.5 + 0.5) * viewport.zw, 0.0, 1.0);
+}
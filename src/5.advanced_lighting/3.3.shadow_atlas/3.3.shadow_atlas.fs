@@ -0,0 +1,102 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+} fs_in;
+
+#define MAX_LIGHTS 24
+
+uniform sampler2D diffuseTexture;
+uniform sampler2DShadow shadowAtlas;
+
+uniform int nrLights;
+uniform vec4 lightPositions[MAX_LIGHTS]; // xyz: position, w: radius (= far plane of the shadow faces)
+uniform vec3 lightColors[MAX_LIGHTS];
+uniform vec4 shadowTiles[MAX_LIGHTS * 6]; // xy: atlas offset, zw: atlas scale, zero scale means no shadow
+
+uniform vec3 viewPos;
+uniform float atlasSize;
+uniform bool shadows;
+
+// must match the face matrices built on the cpu side (same as the cubemap face order)
+const vec3 faceDirs[6] = vec3[]
+(
+    vec3( 1.0,  0.0,  0.0), vec3(-1.0,  0.0,  0.0),
+    vec3( 0.0,  1.0,  0.0), vec3( 0.0, -1.0,  0.0),
+    vec3( 0.0,  0.0,  1.0), vec3( 0.0,  0.0, -1.0)
+);
+const vec3 faceUps[6] = vec3[]
+(
+    vec3( 0.0, -1.0,  0.0), vec3( 0.0, -1.0,  0.0),
+    vec3( 0.0,  0.0,  1.0), vec3( 0.0,  0.0, -1.0),
+    vec3( 0.0, -1.0,  0.0), vec3( 0.0, -1.0,  0.0)
+);
+
+float ShadowCalculation(int light, vec3 fragToLight, float farPlane)
+{
+    // pick the cube face the fragment falls into
+    vec3 a = abs(fragToLight);
+    int face;
+    if(a.x >= a.y && a.x >= a.z)
+        face = fragToLight.x > 0.0 ? 0 : 1;
+    else if(a.y >= a.z)
+        face = fragToLight.y > 0.0 ? 2 : 3;
+    else
+        face = fragToLight.z > 0.0 ? 4 : 5;
+
+    vec4 tile = shadowTiles[light * 6 + face];
+    if(tile.z == 0.0)
+        return 1.0;
+
+    // same projection as lookAt(lightPos, lightPos + faceDir, faceUp) with a 90 degree perspective
+    vec3 f = faceDirs[face];
+    vec3 r = normalize(cross(f, faceUps[face]));
+    vec3 u = cross(r, f);
+    vec2 uv = vec2(dot(r, fragToLight), dot(u, fragToLight)) / dot(f, fragToLight) * 0.5 + 0.5;
+
+    // keep the bilinear footprint inside the tile so neighbouring tiles never bleed in
+    float halfTexel = 0.5 / (tile.z * atlasSize);
+    uv = clamp(uv, vec2(halfTexel), vec2(1.0 - halfTexel));
+
+    float bias = 0.05;
+    float currentDepth = (length(fragToLight) - bias) / farPlane;
+    return texture(shadowAtlas, vec3(tile.xy + uv * tile.zw, currentDepth));
+}
+
+void main()
+{
+    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+
+    vec3 lighting = 0.05 * color;
+    for(int i = 0; i < nrLights; ++i)
+    {
+        vec3 fragToLight = fs_in.FragPos - lightPositions[i].xyz;
+        float radius = lightPositions[i].w;
+        float distance = length(fragToLight);
+        if(distance > radius)
+            continue;
+
+        vec3 lightDir = -fragToLight / distance;
+        // diffuse
+        float diff = max(dot(lightDir, normal), 0.0);
+        vec3 diffuse = diff * lightColors[i] * color;
+        // specular
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
+        vec3 specular = spec * lightColors[i] * 0.3;
+        // windowed inverse square falloff, reaches zero at the light radius
+        float window = clamp(1.0 - pow(distance / radius, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+        // calculate shadow
+        float visibility = shadows ? ShadowCalculation(i, fragToLight, radius) : 1.0;
+
+        lighting += (diffuse + specular) * attenuation * visibility;
+    }
+
+    FragColor = vec4(lighting, 1.0);
+}
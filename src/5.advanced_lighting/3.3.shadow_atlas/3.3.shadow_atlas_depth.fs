@@ -0,0 +1,11 @@
+#version 330 core
+in vec3 FragPos;
+
+uniform vec3 lightPos;
+uniform float far_plane;
+
+void main()
+{
+    // store linear distance to the light, mapped to [0;1] range by dividing by far_plane
+    gl_FragDepth = length(FragPos - lightPos) / far_plane;
+}
@@ -0,0 +1,706 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <imgui/imgui.h>
+#include <imgui/backends/imgui_impl_glfw.h>
+#include <imgui/backends/imgui_impl_opengl3.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <learnopengl/shader.h>
+#include <learnopengl/filesystem.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/shadow_atlas.h>
+
+#include <stb_image.h>
+
+// settings
+const unsigned int SCR_WIDTH = 1024;
+const unsigned int SCR_HEIGHT = 768;
+
+// must match MAX_LIGHTS in 3.3.shadow_atlas.fs
+const int MAX_LIGHTS = 24;
+const unsigned int ATLAS_SIZE = 4096;
+
+typedef struct ui_params
+{
+	bool shadows = true;
+	bool animate = true;
+	bool show_atlas = false;
+	int nr_lights = 16;
+	int face_budget = 24;
+	int max_tile_size = 2; // index into tile_sizes
+	int faces_updated = 0;
+	int faces_stale = 0;
+	int lights_without_shadow = 0;
+	float occupancy = 0.0f;
+} ui_params;
+
+static const unsigned int tile_sizes[] = { 256, 512, 1024, 2048 };
+
+// a shadow casting point light, its six cube faces live as separate tiles in the shadow atlas
+struct AtlasLight
+{
+	glm::vec3 Position;
+	glm::vec3 Color;
+	float Radius;
+	glm::vec3 OrbitCenter;
+	float OrbitRadius;
+	float OrbitSpeed;
+
+	unsigned int TileSize = 0;
+	ShadowTile Faces[6];
+	unsigned int FaceFrame[6] = { 0, 0, 0, 0, 0, 0 }; // frame the face was last rendered, 0: never
+	unsigned int MovedFrame = 0;                      // last frame the light changed position
+};
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow* window);
+unsigned int loadTexture(const char* texPath);
+void renderScene(const Shader& shader);
+void renderCube();
+void renderQuad();
+
+void imgui_on_init(GLFWwindow* window);
+void imgui_on_render(ui_params& param);
+void imgui_on_deinit(GLFWwindow* window);
+
+static ui_params params;
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+float lastX = SCR_WIDTH * 0.5f;
+float lastY = SCR_HEIGHT * 0.5f;
+static bool firstMouse = true;
+
+
+int main()
+{
+	// glfw: initialize and configure
+	// ------------------------------
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+	// glfw window creation
+	// --------------------
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// glad: load all OpenGL function pointers
+	// ---------------------------------------
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	imgui_on_init(window);
+
+	glEnable(GL_DEPTH_TEST);
+
+	// build and compile shaders
+	// -------------------------
+	Shader shader("3.3.shadow_atlas.vs", "3.3.shadow_atlas.fs");
+	Shader simpleDepthShader("3.3.shadow_atlas_depth.vs", "3.3.shadow_atlas_depth.fs");
+	Shader lightBoxShader("3.3.light_box.vs", "3.3.light_box.fs");
+	Shader debugDepthQuad("3.3.debug_quad.vs", "3.3.debug_quad_depth.fs");
+
+	// load textures
+	// -------------
+	unsigned int woodTexture = loadTexture("res/textures/wood.png");
+
+	// one depth texture for all lights instead of a cubemap + FBO per light
+	// ---------------------------------------------------------------------
+	ShadowAtlas* atlas = new ShadowAtlas(ATLAS_SIZE, 64);
+
+	// lighting info
+	// -------------
+	std::vector<AtlasLight> lights(MAX_LIGHTS);
+	srand(13);
+	for (int i = 0; i < MAX_LIGHTS; ++i)
+	{
+		AtlasLight& light = lights[i];
+		light.OrbitCenter = glm::vec3(((rand() % 100) / 100.0f) * 6.0f - 3.0f, ((rand() % 100) / 100.0f) * 5.0f - 2.5f, ((rand() % 100) / 100.0f) * 6.0f - 3.0f);
+		light.OrbitRadius = 0.5f + ((rand() % 100) / 100.0f) * 1.5f;
+		light.OrbitSpeed = 0.2f + ((rand() % 100) / 100.0f) * 0.6f;
+		light.Radius = 4.0f + ((rand() % 100) / 100.0f) * 3.0f;
+		light.Color = glm::vec3(((rand() % 100) / 200.0f) + 0.5f, ((rand() % 100) / 200.0f) + 0.5f, ((rand() % 100) / 200.0f) + 0.5f) * 4.0f;
+		light.Position = light.OrbitCenter;
+	}
+
+	// cube face orientation, must match faceDirs/faceUps in 3.3.shadow_atlas.fs
+	const glm::vec3 faceDirs[6] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const glm::vec3 faceUps[6] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+	const float near_plane = 0.05f;
+
+	// shader configuration
+	// --------------------
+	shader.use();
+	shader.setInt("diffuseTexture", 0);
+	shader.setInt("shadowAtlas", 1);
+	shader.setFloat("atlasSize", (float)ATLAS_SIZE);
+
+	debugDepthQuad.use();
+	debugDepthQuad.setInt("depthMap", 0);
+
+	std::vector<glm::vec4> lightPositions(MAX_LIGHTS);
+	std::vector<glm::vec3> lightColors(MAX_LIGHTS);
+	std::vector<glm::vec4> shadowTiles(MAX_LIGHTS * 6);
+	unsigned int frame = 0;
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// input
+		// -----
+		processInput(window);
+		++frame;
+
+		// move lights over time
+		// ---------------------
+		float time = (float)glfwGetTime();
+		for (int i = 0; i < params.nr_lights; ++i)
+		{
+			AtlasLight& light = lights[i];
+			if (params.animate || light.MovedFrame == 0)
+			{
+				float angle = time * light.OrbitSpeed + i;
+				light.Position = light.OrbitCenter + glm::vec3(cos(angle), 0.0f, sin(angle)) * light.OrbitRadius;
+				light.MovedFrame = frame;
+			}
+		}
+
+		// 1. pick a tile size per light from its screen coverage and (re)allocate its faces in the atlas
+		// ------------------------------------------------------------------------------------------------
+		unsigned int maxTileSize = tile_sizes[params.max_tile_size];
+		float fovy = glm::radians(camera.Zoom);
+		params.lights_without_shadow = 0;
+		for (int i = 0; i < MAX_LIGHTS; ++i)
+		{
+			AtlasLight& light = lights[i];
+			unsigned int desired = 0;
+			if (i < params.nr_lights)
+			{
+				desired = atlas->TileSizeForCoverage(light.Position, light.Radius, camera.Position, fovy, SCR_HEIGHT, maxTileSize);
+				// grow right away but only shrink once the light covers clearly less of the screen, avoids re-rendering on every step
+				if (desired < light.TileSize && light.TileSize <= maxTileSize && atlas->TileSizeForCoverage(light.Position, light.Radius, camera.Position, fovy, SCR_HEIGHT, maxTileSize, 1.5f) >= light.TileSize)
+					desired = light.TileSize;
+			}
+			if (desired == light.TileSize && light.Faces[0].Valid() && light.Faces[0].Size < desired)
+			{
+				// the faces fell back to smaller tiles while the atlas was full, move them up once larger tiles fit again;
+				// the current tiles are kept until then
+				ShadowTile larger[6];
+				if (atlas->AllocateGroup(larger, 6, desired, light.Faces[0].Size * 2))
+				{
+					for (int face = 0; face < 6; ++face)
+					{
+						atlas->Free(light.Faces[face]);
+						light.Faces[face] = larger[face];
+						light.FaceFrame[face] = 0;
+					}
+				}
+				continue;
+			}
+			if (desired == light.TileSize && (desired == 0 || light.Faces[0].Valid()))
+				continue;
+
+			for (int face = 0; face < 6; ++face)
+			{
+				atlas->Free(light.Faces[face]);
+				light.FaceFrame[face] = 0;
+			}
+			light.TileSize = desired;
+
+			// fall back to smaller tiles when the atlas is full
+			if (desired != 0)
+				atlas->AllocateGroup(light.Faces, 6, desired);
+			if (desired != 0 && !light.Faces[0].Valid())
+				++params.lights_without_shadow;
+		}
+		params.occupancy = atlas->Occupancy();
+
+		// 2. render at most face_budget stale faces, faces that were never rendered first, then the oldest ones
+		// -------------------------------------------------------------------------------------------------------
+		std::vector<std::pair<unsigned int, int> > staleFaces; // (last rendered frame, light * 6 + face)
+		for (int i = 0; i < params.nr_lights; ++i)
+		{
+			for (int face = 0; face < 6; ++face)
+			{
+				if (lights[i].Faces[face].Valid() && lights[i].FaceFrame[face] < lights[i].MovedFrame)
+					staleFaces.push_back(std::make_pair(lights[i].FaceFrame[face], i * 6 + face));
+			}
+		}
+		std::sort(staleFaces.begin(), staleFaces.end());
+		params.faces_updated = std::min((int)staleFaces.size(), params.face_budget);
+		params.faces_stale = (int)staleFaces.size() - params.faces_updated;
+
+		simpleDepthShader.use();
+		for (int n = 0; n < params.faces_updated; ++n)
+		{
+			AtlasLight& light = lights[staleFaces[n].second / 6];
+			int face = staleFaces[n].second % 6;
+
+			glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), 1.0f, near_plane, light.Radius);
+			glm::mat4 lightSpaceMatrix = shadowProj * glm::lookAt(light.Position, light.Position + faceDirs[face], faceUps[face]);
+			simpleDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+			simpleDepthShader.setVec3("lightPos", light.Position);
+			simpleDepthShader.setFloat("far_plane", light.Radius);
+
+			atlas->BeginTile(light.Faces[face]);
+			renderScene(simpleDepthShader);
+			light.FaceFrame[face] = frame;
+		}
+		atlas->End();
+
+		// 3. render scene as normal, every light looks up its own tiles in the atlas
+		// ----------------------------------------------------------------------------
+		glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 100.0f);
+		glm::mat4 view = camera.GetViewMatrix();
+
+		for (int i = 0; i < params.nr_lights; ++i)
+		{
+			lightPositions[i] = glm::vec4(lights[i].Position, lights[i].Radius);
+			lightColors[i] = lights[i].Color;
+			for (int face = 0; face < 6; ++face)
+				shadowTiles[i * 6 + face] = atlas->TileRect(lights[i].Faces[face]);
+		}
+
+		shader.use();
+		shader.setMat4("projection", projection);
+		shader.setMat4("view", view);
+		shader.setVec3("viewPos", camera.Position);
+		shader.setInt("shadows", params.shadows);
+		shader.setInt("nrLights", params.nr_lights);
+		shader.setVec4("lightPositions", lightPositions[0], MAX_LIGHTS);
+		shader.setVec3("lightColors", lightColors[0], MAX_LIGHTS);
+		shader.setVec4("shadowTiles", shadowTiles[0], MAX_LIGHTS * 6);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, woodTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, atlas->DepthMap);
+		renderScene(shader);
+
+		// 4. show all lights as small boxes
+		// ----------------------------------
+		lightBoxShader.use();
+		lightBoxShader.setMat4("projection", projection);
+		lightBoxShader.setMat4("view", view);
+		for (int i = 0; i < params.nr_lights; ++i)
+		{
+			glm::mat4 model = glm::mat4(1.0f);
+			model = glm::translate(model, lights[i].Position);
+			model = glm::scale(model, glm::vec3(0.08f));
+			lightBoxShader.setMat4("model", model);
+			lightBoxShader.setVec3("lightColor", lights[i].Color);
+			renderCube();
+		}
+
+		// 5. render the atlas to a quad for visual debugging
+		// ---------------------------------------------------
+		if (params.show_atlas)
+		{
+			glDisable(GL_DEPTH_TEST);
+			debugDepthQuad.use();
+			debugDepthQuad.setVec4("viewport", 0.35f, -0.95f, 0.6f, 0.6f * SCR_WIDTH / SCR_HEIGHT);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, atlas->DepthMap);
+			// read raw depth values instead of comparison results
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+			renderQuad();
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glEnable(GL_DEPTH_TEST);
+		}
+
+		imgui_on_render(params);
+
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+		// -------------------------------------------------------------------------------
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+
+	// free resources
+	delete atlas;
+
+	// glfw: terminate, clearing all previously allocated GLFW resources.
+	// ------------------------------------------------------------------
+	imgui_on_deinit(window);
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow* window)
+{
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+
+	float currentFrame = (float)glfwGetTime();
+	deltaTime = currentFrame - lastFrame;
+	lastFrame = currentFrame;
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+		camera.ProcessKeyboard(Camera_Movement::FORWARD, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+		camera.ProcessKeyboard(Camera_Movement::BACKWARD, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+		camera.ProcessKeyboard(Camera_Movement::LEFT, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+		camera.ProcessKeyboard(Camera_Movement::RIGHT, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+		glfwSetCursorPosCallback(window, NULL);
+	}
+	if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetCursorPosCallback(window, mouse_callback);
+		firstMouse = true;
+	}
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	// make sure the viewport matches the new window dimensions; note that width and 
+	// height will be significantly larger than specified on retina displays.
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+	if (firstMouse)
+	{
+		lastX = xpos;
+		lastY = ypos;
+		firstMouse = false;
+	}
+
+	float xoffset = xpos - lastX;
+	float yoffset = lastY - ypos;
+	lastX = xpos;
+	lastY = ypos;
+
+	camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	camera.ProcessMouseScroll(yoffset);
+}
+
+unsigned int loadTexture(char const* path)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load(FileSystem::getPath(path).c_str(), &width, &height, &nrComponents, 0);
+	if (data)
+	{
+		GLenum format;
+		if (nrComponents == 1)
+			format = GL_RED;
+		else if (nrComponents == 3)
+			format = GL_RGB;
+		else if (nrComponents == 4)
+			format = GL_RGBA;
+
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT); // for this tutorial: use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes texels from next repeat 
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		stbi_image_free(data);
+	}
+	else
+	{
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+		stbi_image_free(data);
+	}
+
+	return textureID;
+}
+
+// renders the 3D scene
+// --------------------
+void renderScene(const Shader& shader)
+{
+	// room cube
+	glm::mat4 model = glm::mat4(1.0f);
+	model = glm::scale(model, glm::vec3(5.0f));
+	shader.setMat4("model", model);
+	glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
+	shader.setInt("reverse_normals", 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
+	renderCube();
+	shader.setInt("reverse_normals", 0); // and of course disable it
+	glEnable(GL_CULL_FACE);
+	// cubes
+	model = glm::mat4(1.0f);
+	model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
+	model = glm::scale(model, glm::vec3(0.5f));
+	shader.setMat4("model", model);
+	renderCube();
+	model = glm::mat4(1.0f);
+	model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
+	model = glm::scale(model, glm::vec3(0.75f));
+	shader.setMat4("model", model);
+	renderCube();
+	model = glm::mat4(1.0f);
+	model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
+	model = glm::scale(model, glm::vec3(0.5f));
+	shader.setMat4("model", model);
+	renderCube();
+	model = glm::mat4(1.0f);
+	model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
+	model = glm::scale(model, glm::vec3(0.5f));
+	shader.setMat4("model", model);
+	renderCube();
+	model = glm::mat4(1.0f);
+	model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
+	model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+	model = glm::scale(model, glm::vec3(0.75f));
+	shader.setMat4("model", model);
+	renderCube();
+}
+
+// renderCube() renders a 1x1 3D cube in NDC.
+// -------------------------------------------------
+unsigned int cubeVAO = 0;
+unsigned int cubeVBO = 0;
+void renderCube()
+{
+	// initialize (if necessary)
+	if (cubeVAO == 0)
+	{
+		float vertices[] = {
+			// back face
+			-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+			 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+			 1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
+			 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+			-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+			-1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+			// front face
+			-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+			 1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+			 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+			 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+			-1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+			-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+			// left face
+			-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+			-1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+			-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+			-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+			-1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+			-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+			// right face
+			 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+			 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+			 1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right         
+			 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+			 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+			 1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left     
+			// bottom face
+			-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+			 1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+			 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+			 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+			-1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+			-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+			// top face
+			-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+			 1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+			 1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right     
+			 1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+			-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+			-1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left        
+		};
+		glGenVertexArrays(1, &cubeVAO);
+		glGenBuffers(1, &cubeVBO);
+		// fill buffer
+		glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		// link vertex attributes
+		glBindVertexArray(cubeVAO);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+	// render Cube
+	glBindVertexArray(cubeVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 36);
+	glBindVertexArray(0);
+}
+
+// renderQuad() renders a 1x1 XY quad in NDC
+// -----------------------------------------
+unsigned int quadVAO = 0;
+unsigned int quadVBO;
+void renderQuad()
+{
+	if (quadVAO == 0)
+	{
+		static const float quadVertices[] = {
+			// positions        // texture Coords
+			-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+			-1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+			 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+			 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+		};
+		// setup plane VAO
+		glGenVertexArrays(1, &quadVAO);
+		glGenBuffers(1, &quadVBO);
+		glBindVertexArray(quadVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	}
+	glBindVertexArray(quadVAO);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindVertexArray(0);
+}
+
+void imgui_on_init(GLFWwindow* window)
+{
+	// Setup Dear ImGui context
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO(); (void)io;
+	//io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+	//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+
+	// Setup Dear ImGui style
+	ImGui::StyleColorsDark();
+	//ImGui::StyleColorsClassic();
+
+	// Setup Platform/Renderer backends
+	ImGui_ImplGlfw_InitForOpenGL(window, true);
+	ImGui_ImplOpenGL3_Init();
+
+	// Load Fonts
+	// - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
+	// - AddFontFromFileTTF() will return the ImFont* so you can store it if you need to select the font among multiple.
+	// - If the file cannot be loaded, the function will return NULL. Please handle those errors in your application (e.g. use an assertion, or display an error and quit).
+	// - The fonts will be rasterized at a given size (w/ oversampling) and stored into a texture when calling ImFontAtlas::Build()/GetTexDataAsXXXX(), which ImGui_ImplXXXX_NewFrame below will call.
+	// - Read 'docs/FONTS.md' for more instructions and details.
+	// - Remember that in C/C++ if you want to include a backslash \ in a string literal you need to write a double backslash \\ !
+	//io.Fonts->AddFontDefault();
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/Roboto-Medium.ttf", 16.0f);
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/Cousine-Regular.ttf", 15.0f);
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/DroidSans.ttf", 16.0f);
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/ProggyTiny.ttf", 10.0f);
+	//ImFont* font = io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\ArialUni.ttf", 18.0f, NULL, io.Fonts->GetGlyphRangesJapanese());
+	//IM_ASSERT(font != NULL);
+}
+
+void imgui_on_render(ui_params& param)
+{
+	// Start the Dear ImGui frame
+	ImGui_ImplOpenGL3_NewFrame();
+	ImGui_ImplGlfw_NewFrame();
+	ImGui::NewFrame();
+
+	//if (show_demo_window)
+	//	ImGui::ShowDemoWindow(&show_demo_window);
+
+	static bool open = false;
+
+	ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+	if (!ImGui::Begin("Config", &open, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		ImGui::End();
+		return;
+	}
+
+	static const char* tile_size_items[] = { "256", "512", "1024", "2048" };
+
+	ImGui::Checkbox("Shadows", &params.shadows);
+	ImGui::Checkbox("Animate Lights", &params.animate);
+	ImGui::Checkbox("Show Atlas", &params.show_atlas);
+	ImGui::SliderInt("Lights", &params.nr_lights, 1, MAX_LIGHTS);
+	ImGui::SliderInt("Faces / Frame", &params.face_budget, 1, MAX_LIGHTS * 6);
+	ImGui::Combo("Max Tile Size", &params.max_tile_size, tile_size_items, IM_ARRAYSIZE(tile_size_items));
+	ImGui::Separator();
+	ImGui::Text("Atlas: %ux%u, %.1f%% used", ATLAS_SIZE, ATLAS_SIZE, params.occupancy * 100.0f);
+	ImGui::Text("Faces rendered: %d, pending: %d", params.faces_updated, params.faces_stale);
+	ImGui::Text("Lights without shadow: %d", params.lights_without_shadow);
+	ImGui::Separator();
+	ImGui::Text("Press 1 to show cursor");
+	ImGui::Text("Press 2 to hide cursor");
+	ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+
+	ImGui::End();
+
+	// Rendering
+	ImGui::Render();
+	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+}
+
+void imgui_on_deinit(GLFWwindow* window)
+{
+	// Cleanup
+	ImGui_ImplOpenGL3_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+}
@@ -0,0 +1,56 @@
+#version 330 core
+out vec2 FragColor; // r = adapted average luminance, g = exposure
+
+uniform sampler2D histogram;
+uniform sampler2D previous;
+uniform int bins;
+uniform float minLog2;
+uniform float log2Range;
+uniform float lowPercent;
+uniform float highPercent;
+uniform float speedUp;
+uniform float speedDown;
+uniform float deltaTime;
+uniform float keyValue;
+uniform bool reset;
+
+void main()
+{
+    // black pixels (bin 0) don't count towards the percentiles
+    float total = 0.0;
+    for(int i = 1; i < bins; ++i)
+        total += texelFetch(histogram, ivec2(i, 0), 0).r;
+
+    float previousLuminance = texelFetch(previous, ivec2(0), 0).r;
+    float target = previousLuminance;
+    if(total > 0.0)
+    {
+        // average log luminance of the pixels between the two percentiles, bins straddling a
+        // percentile only contribute the part of their count that lies inside
+        float low = total * lowPercent;
+        float high = total * highPercent;
+        float cumulative = 0.0;
+        float sum = 0.0;
+        float weight = 0.0;
+        for(int i = 1; i < bins; ++i)
+        {
+            float count = texelFetch(histogram, ivec2(i, 0), 0).r;
+            float inside = max(min(cumulative + count, high) - max(cumulative, low), 0.0);
+            sum += inside * (minLog2 + (float(i) - 0.5) / float(bins - 1) * log2Range);
+            weight += inside;
+            cumulative += count;
+        }
+        if(weight > 0.0)
+            target = exp2(sum / weight);
+    }
+
+    // exponential adaptation, frame rate independent
+    float luminance = target;
+    if(!reset)
+    {
+        float speed = target > previousLuminance ? speedUp : speedDown;
+        luminance = previousLuminance + (target - previousLuminance) * (1.0 - exp(-deltaTime * speed));
+    }
+
+    FragColor = vec2(luminance, keyValue / max(luminance, 0.0001));
+}
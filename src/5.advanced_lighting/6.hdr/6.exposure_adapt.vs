@@ -0,0 +1,7 @@
+#version 330 core
+// a single point covering the 1x1 exposure target
+
+void main()
+{
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+}
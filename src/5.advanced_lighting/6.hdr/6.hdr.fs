@@ -5,6 +5,20 @@ in vec2 TexCoords;
 uniform sampler2D hdrBuffer;
 uniform bool hdr;
 uniform float exposure;
+uniform bool autoExposure;
+uniform sampler2D exposureTexture; // g = measured exposure, see auto_exposure.h
+uniform sampler3D tonemapLUT;      // tone mapping, grading and gamma, see tonemap_lut.h
+uniform float lutMinLog2;
+uniform float lutLog2Range;
+uniform float lutScale;
+uniform float lutOffset;
+
+// log2 shaper, then a single trilinear fetch does the whole tone mapping
+vec3 tonemap(vec3 color)
+{
+    vec3 shaped = clamp((log2(max(color, 1e-10)) - lutMinLog2) / lutLog2Range, 0.0, 1.0);
+    return texture(tonemapLUT, shaped * lutScale + lutOffset).rgb;
+}
 
 void main()
 {
@@ -12,14 +26,13 @@ void main()
     vec3 hdrColor = texture(hdrBuffer, TexCoords).rgb;
     if(hdr)
     {
-        // Reinhard tone mapping
-        //vec3 mapped = hdrColor / (hdrColor + vec3(1.0));
-
-        // exposure tone mapping
-        vec3 mapped = vec3(1.0) - exp(-hdrColor * exposure);
+        // exposure, the slider becomes a compensation factor with auto exposure
+        float e = exposure;
+        if(autoExposure)
+            e *= texelFetch(exposureTexture, ivec2(0), 0).g;
 
-        // gamma correction
-        mapped = pow(mapped, vec3(1.0 / gamma));
+        // tone mapping operator and gamma correction come from the LUT
+        vec3 mapped = tonemap(hdrColor * e);
 
         FragColor = vec4(mapped, 1.0);
     } else
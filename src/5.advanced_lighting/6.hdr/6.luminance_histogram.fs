@@ -0,0 +1,7 @@
+#version 330 core
+out float FragColor;
+
+void main()
+{
+    FragColor = 1.0;
+}
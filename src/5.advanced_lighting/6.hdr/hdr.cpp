@@ -13,17 +13,44 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/filesystem.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/auto_exposure.h>
+#include <learnopengl/tonemap_lut.h>
+#include <learnopengl/post_chain.h>
 
 #include <stb_image.h>
 
+#include <cstdio>
+
 // settings
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 768;
 
+// one line of the auto exposure benchmark: histogram + adaptation of the scene upscaled to a larger target
+struct ExposureBenchmarkCase
+{
+	int width;
+	int height;
+	int sampleStep;
+	float exposure_us;
+};
+static std::vector<ExposureBenchmarkCase> exposureBenchmarkCases;
+
 typedef struct ui_params
 {
 	bool hdr = false;
-	float exposure = 1.0f;
+	float exposure = 1.0f;          // exposure compensation on top of the measured exposure when auto exposure is on
+	bool auto_exposure = true;
+	int sample_step = 2;
+	float low_percent = 0.5f;
+	float high_percent = 0.95f;
+	float speed_up = 3.0f;
+	float speed_down = 1.0f;
+	float key_value = 0.18f;
+	float exposure_us = 0.0f;
+	bool run_benchmark = false;
+	TonemapSettings tonemap;
+	float lut_bake_ms = 0.0f;
 } ui_params;
 
 
@@ -99,41 +126,13 @@ int main()
     // -------------------------
 	Shader shader("6.lighting.vs", "6.lighting.fs");
 	Shader hdrShader("6.hdr.vs", "6.hdr.fs");
+	Shader histogramShader("6.luminance_histogram.vs", "6.luminance_histogram.fs");
+	Shader adaptShader("6.exposure_adapt.vs", "6.exposure_adapt.fs");
 
     // load textures
     // -------------
 	unsigned int woodTexture = loadTexture("res/textures/wood.png", true); // note that we're loading the texture as an SRGB texture
 
-	// configure floating point framebuffer
-    // ------------------------------------
-	unsigned int hdrFBO;
-	glGenFramebuffers(1, &hdrFBO);
-	
-	// create floating point color buffer
-	unsigned int colorBuffer;
-	glGenTextures(1, &colorBuffer);
-	glBindTexture(GL_TEXTURE_2D, colorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// create depth buffer (renderbuffer)
-	unsigned int rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-
-	// attach buffers
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorBuffer, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "Framebuffer not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
 	// lighting info
 	// -------------
 	// positions
@@ -156,27 +155,43 @@ int main()
 	shader.setInt("diffuseTexture", 0);
 	hdrShader.use();
 	hdrShader.setInt("hdrBuffer", 0);
-
-	// render loop
-	// -----------
-	while (!glfwWindowShouldClose(window))
-	{
-		// input
-		// -----
-		processInput(window);
-
-		// Rendering
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
+	hdrShader.setInt("exposureTexture", 1);
+	hdrShader.setInt("tonemapLUT", 2);
+
+	// tone mapping LUT, rebaked on the CPU whenever one of its settings changes
+	TonemapLUT* tonemapLUT = new TonemapLUT();
+	tonemapLUT->SetUniforms(hdrShader);
+
+	// automatic exposure, the measured exposure is only ever read by the tone mapping shader
+	AutoExposure* autoExposure = new AutoExposure(histogramShader, adaptShader);
+	GpuTimer* exposureTimer = new GpuTimer();
+
+	// benchmark state: 1080p and 4K targets filled with the upscaled scene, every pixel vs. every 4th pixel
+	const int BENCHMARK_WARMUP_FRAMES = 20;
+	const int BENCHMARK_FRAMES = 200;
+	int benchmarkCase = -1;
+	int benchmarkFrame = 0;
+	GpuTimer* benchmarkTimer = new GpuTimer();
+	AutoExposure* benchmarkExposure = new AutoExposure(histogramShader, adaptShader);
+	unsigned int benchmarkFBO, benchmarkBuffer = 0;
+	glGenFramebuffers(1, &benchmarkFBO);
+
+	// floating point scene target with its depth buffer, then the pass to the default framebuffer; the chain sizes
+	// the targets to the window framebuffer
+	PostChain* chain = new PostChain();
+	int hdrColor = chain->Create("hdr", GL_RGBA16F);
+	int hdrDepth = chain->Create("depth", GL_DEPTH_COMPONENT24);
+	int width = SCR_WIDTH, height = SCR_HEIGHT;
+
+	chain->AddPass("scene", {}, hdrColor, [&]() {
 		// 1. render scene into floating point framebuffer
 		// -----------------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 100.0f);
+
+		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / height, 0.1f, 100.0f);
 		glm::mat4 view = camera.GetViewMatrix();
-		
+
 		shader.use();
 		shader.setMat4("projection", projection);
 		shader.setMat4("view", view);
@@ -199,17 +214,114 @@ int main()
 		shader.setMat4("model", model);
 		shader.setInt("inverse_normals", true);
 		renderCube();
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}, hdrDepth);
+
+	// exposure measurement and its benchmark read the scene target too, they run in the tone mapping pass before the
+	// quad; AutoExposure::Update() leaves the default framebuffer and its viewport bound
+	chain->AddPass("tonemap", { hdrColor }, PostChain::BACKBUFFER, [&]() {
+		// 1.1 measure the scene luminance and adapt the exposure to it
+		// ------------------------------------------------------------
+		if (params.hdr && params.auto_exposure)
+		{
+			autoExposure->SampleStep = params.sample_step;
+			autoExposure->LowPercent = params.low_percent;
+			autoExposure->HighPercent = glm::max(params.high_percent, params.low_percent);
+			autoExposure->SpeedUp = params.speed_up;
+			autoExposure->SpeedDown = params.speed_down;
+			autoExposure->KeyValue = params.key_value;
+			exposureTimer->Begin();
+			autoExposure->Update(chain->Texture(hdrColor), width, height, deltaTime);
+			exposureTimer->End();
+			params.exposure_us = exposureTimer->Milliseconds * 1000.0f;
+		}
+		else
+		{
+			autoExposure->Reset();
+		}
+
+		// 1.2 benchmark: the same work on 1080p and 4K copies of the scene
+		if (params.run_benchmark && benchmarkCase < 0)
+		{
+			static const ExposureBenchmarkCase cases[] = {
+				{ 1920, 1080, 1, 0.0f },
+				{ 1920, 1080, 2, 0.0f },
+				{ 3840, 2160, 1, 0.0f },
+				{ 3840, 2160, 2, 0.0f },
+			};
+			exposureBenchmarkCases.assign(cases, cases + sizeof(cases) / sizeof(cases[0]));
+			benchmarkCase = 0;
+			benchmarkFrame = 0;
+		}
+		if (benchmarkCase >= 0)
+		{
+			ExposureBenchmarkCase& current = exposureBenchmarkCases[benchmarkCase];
+			if (benchmarkFrame == 0)
+			{
+				// (re)allocate the target and stretch the scene into it once per case
+				if (benchmarkBuffer)
+					glDeleteTextures(1, &benchmarkBuffer);
+				glGenTextures(1, &benchmarkBuffer);
+				glBindTexture(GL_TEXTURE_2D, benchmarkBuffer);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, current.width, current.height, 0, GL_RGBA, GL_FLOAT, NULL);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, benchmarkFBO);
+				glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, benchmarkBuffer, 0);
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, chain->Framebuffer(hdrColor));
+				glBlitFramebuffer(0, 0, width, height, 0, 0, current.width, current.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				benchmarkExposure->SampleStep = current.sampleStep;
+			}
+			if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+				benchmarkTimer->Reset();
+			benchmarkTimer->Begin();
+			benchmarkExposure->Update(benchmarkBuffer, current.width, current.height, deltaTime);
+			benchmarkTimer->End();
+
+			if (++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+			{
+				current.exposure_us = benchmarkTimer->Average() * 1000.0f;
+				printf("%4dx%-4d step %d: %.1f us\n", current.width, current.height, current.sampleStep, current.exposure_us);
+				benchmarkFrame = 0;
+				if (++benchmarkCase == (int)exposureBenchmarkCases.size())
+				{
+					benchmarkCase = -1;
+					params.run_benchmark = false;
+				}
+			}
+		}
 
 		// 2. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
 		// --------------------------------------------------------------------------------------------------------------------------
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		hdrShader.use();
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, colorBuffer);
+		glBindTexture(GL_TEXTURE_2D, chain->Texture(hdrColor));
+		if (tonemapLUT->Update(params.tonemap))
+			params.lut_bake_ms = tonemapLUT->BakeMilliseconds;
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, autoExposure->ExposureTexture());
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_3D, tonemapLUT->Texture);
 		hdrShader.setInt("hdr", params.hdr);
 		hdrShader.setFloat("exposure", params.exposure);
+		hdrShader.setBool("autoExposure", params.auto_exposure);
 		renderQuad();
+		glActiveTexture(GL_TEXTURE0);
+	});
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// input
+		// -----
+		processInput(window);
+
+		// Rendering
+		glfwGetFramebufferSize(window, &width, &height);
+		chain->Resize(width, height);
+		chain->Execute();
 
 		imgui_on_render(params);
 
@@ -221,6 +333,15 @@ int main()
 
 
 	// free resources
+	glDeleteFramebuffers(1, &benchmarkFBO);
+	if (benchmarkBuffer)
+		glDeleteTextures(1, &benchmarkBuffer);
+	delete exposureTimer;
+	delete benchmarkTimer;
+	delete autoExposure;
+	delete benchmarkExposure;
+	delete tonemapLUT;
+	delete chain;
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -499,6 +620,30 @@ void imgui_on_render(ui_params& param)
 
 	ImGui::Checkbox("HDR", &params.hdr);
 	ImGui::DragFloat("Exposure", &params.exposure, 0.01f, 0.0f, 10.0f);
+	static const char* tonemap_items[] = { "Exponential", "Reinhard Extended", "ACES Fit", "Uchimura", "AgX" };
+	ImGui::Combo("Tone Mapping", &params.tonemap.Operator, tonemap_items, IM_ARRAYSIZE(tonemap_items));
+	if (params.tonemap.Operator == TONEMAP_REINHARD_EXTENDED)
+		ImGui::DragFloat("White Point", &params.tonemap.WhitePoint, 0.05f, 1.0f, 32.0f);
+	ImGui::DragFloat("Contrast", &params.tonemap.Contrast, 0.01f, 0.5f, 2.0f);
+	ImGui::DragFloat("Saturation", &params.tonemap.Saturation, 0.01f, 0.0f, 2.0f);
+	ImGui::ColorEdit3("Color Filter", (float*)&params.tonemap.ColorFilter, ImGuiColorEditFlags_Float);
+	ImGui::DragFloat("Gamma", &params.tonemap.Gamma, 0.01f, 1.0f, 3.0f);
+	ImGui::Text("LUT %d^3 bake: %.3f ms", TonemapLUT::SIZE, params.lut_bake_ms);
+	ImGui::Checkbox("Auto Exposure", &params.auto_exposure);
+	if (params.auto_exposure)
+	{
+		ImGui::SliderInt("Sample Step", &params.sample_step, 1, 8);
+		ImGui::DragFloat("Low Percentile", &params.low_percent, 0.01f, 0.0f, 1.0f);
+		ImGui::DragFloat("High Percentile", &params.high_percent, 0.01f, 0.0f, 1.0f);
+		ImGui::DragFloat("Adapt Speed Up", &params.speed_up, 0.05f, 0.0f, 20.0f);
+		ImGui::DragFloat("Adapt Speed Down", &params.speed_down, 0.05f, 0.0f, 20.0f);
+		ImGui::DragFloat("Key Value", &params.key_value, 0.005f, 0.01f, 1.0f);
+		ImGui::Text("Histogram + adaptation: %.1f us", params.exposure_us);
+	}
+	if (ImGui::Button("Run Exposure Benchmark"))
+		params.run_benchmark = true;
+	for (size_t i = 0; i < exposureBenchmarkCases.size(); ++i)
+		ImGui::Text("%4dx%-4d step %d %8.1f us", exposureBenchmarkCases[i].width, exposureBenchmarkCases[i].height, exposureBenchmarkCases[i].sampleStep, exposureBenchmarkCases[i].exposure_us);
 
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
@@ -0,0 +1,64 @@
+#version 330 core
+out vec3 FragColor;
+
+in vec2 TexCoords;
+
+// 13 tap downsample (Jimenez, "Next Generation Post Processing in Call of Duty: Advanced Warfare"):
+// five overlapping 2x2 box filters, fetched bilinearly, so no detail is skipped when halving the resolution
+uniform sampler2D srcTexture;
+uniform bool firstPass; // weight the boxes of the full resolution input by luma to tame single bright pixels
+
+float KarisWeight(vec3 c)
+{
+    return 1.0 / (1.0 + dot(c, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(srcTexture, 0));
+    float x = texel.x;
+    float y = texel.y;
+
+    // a - b - c
+    // - j - k -
+    // d - e - f
+    // - l - m -
+    // g - h - i
+    vec3 a = texture(srcTexture, TexCoords + vec2(-2.0 * x,  2.0 * y)).rgb;
+    vec3 b = texture(srcTexture, TexCoords + vec2(      0.0,  2.0 * y)).rgb;
+    vec3 c = texture(srcTexture, TexCoords + vec2( 2.0 * x,  2.0 * y)).rgb;
+    vec3 d = texture(srcTexture, TexCoords + vec2(-2.0 * x,       0.0)).rgb;
+    vec3 e = texture(srcTexture, TexCoords).rgb;
+    vec3 f = texture(srcTexture, TexCoords + vec2( 2.0 * x,       0.0)).rgb;
+    vec3 g = texture(srcTexture, TexCoords + vec2(-2.0 * x, -2.0 * y)).rgb;
+    vec3 h = texture(srcTexture, TexCoords + vec2(      0.0, -2.0 * y)).rgb;
+    vec3 i = texture(srcTexture, TexCoords + vec2( 2.0 * x, -2.0 * y)).rgb;
+    vec3 j = texture(srcTexture, TexCoords + vec2(-x,  y)).rgb;
+    vec3 k = texture(srcTexture, TexCoords + vec2( x,  y)).rgb;
+    vec3 l = texture(srcTexture, TexCoords + vec2(-x, -y)).rgb;
+    vec3 m = texture(srcTexture, TexCoords + vec2( x, -y)).rgb;
+
+    if(firstPass)
+    {
+        vec3 boxes[5] = vec3[](
+            (a + b + d + e) * 0.25, (b + c + e + f) * 0.25,
+            (d + e + g + h) * 0.25, (e + f + h + i) * 0.25,
+            (j + k + l + m) * 0.25);
+        float boxWeights[5] = float[](0.125, 0.125, 0.125, 0.125, 0.5);
+        vec3 result = vec3(0.0);
+        float weightSum = 0.0;
+        for(int n = 0; n < 5; ++n)
+        {
+            float w = boxWeights[n] * KarisWeight(boxes[n]);
+            result += boxes[n] * w;
+            weightSum += w;
+        }
+        FragColor = result / weightSum;
+        return;
+    }
+
+    FragColor = e * 0.125;
+    FragColor += (a + c + g + i) * 0.03125;
+    FragColor += (b + d + f + h) * 0.0625;
+    FragColor += (j + k + l + m) * 0.125;
+}
@@ -5,9 +5,22 @@ in vec2 TexCoords;
 uniform sampler2D scene;
 uniform sampler2D bloomBlur;
 uniform float exposure;
+uniform bool autoExposure;
+uniform sampler2D exposureTexture; // g = measured exposure, see auto_exposure.h
+uniform sampler3D tonemapLUT;      // tone mapping, grading and gamma, see tonemap_lut.h
+uniform float lutMinLog2;
+uniform float lutLog2Range;
+uniform float lutScale;
+uniform float lutOffset;
 uniform bool bloom;
+uniform float bloomStrength = 1.0;
 
-const float gamma = 2.2f;
+// log2 shaper, then a single trilinear fetch does the whole tone mapping
+vec3 tonemap(vec3 color)
+{
+    vec3 shaped = clamp((log2(max(color, 1e-10)) - lutMinLog2) / lutLog2Range, 0.0, 1.0);
+    return texture(tonemapLUT, shaped * lutScale + lutOffset).rgb;
+}
 
 void main()
 {
@@ -16,14 +29,16 @@ void main()
     if(bloom)
     {
         vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
-        hdrColor += bloomColor; // additive blending
+        hdrColor += bloomColor * bloomStrength; // additive blending
     }
 
-    // exposure tone mapping
-    vec3 mapped = vec3(1.0) - exp(-hdrColor * exposure);
+    // exposure, the slider becomes a compensation factor with auto exposure
+    float e = exposure;
+    if(autoExposure)
+        e *= texelFetch(exposureTexture, ivec2(0), 0).g;
 
-    // gamma correction
-    mapped = pow(mapped, vec3(1.0 / gamma));
+    // tone mapping operator and gamma correction come from the LUT
+    vec3 mapped = tonemap(hdrColor * e);
 
     FragColor = vec4(mapped, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 330 core
+out vec3 FragColor;
+
+in vec2 TexCoords;
+
+// 3x3 tent filter on the next smaller mip, blended additively onto the current one
+uniform sampler2D srcTexture;
+uniform float filterRadius; // in uv, the same for every mip so the tent grows with the mip texel size
+
+void main()
+{
+    float x = filterRadius;
+    float y = filterRadius * float(textureSize(srcTexture, 0).x) / float(textureSize(srcTexture, 0).y);
+
+    // a - b - c
+    // d - e - f
+    // g - h - i
+    vec3 a = texture(srcTexture, TexCoords + vec2(-x,  y)).rgb;
+    vec3 b = texture(srcTexture, TexCoords + vec2(0.0, y)).rgb;
+    vec3 c = texture(srcTexture, TexCoords + vec2( x,  y)).rgb;
+    vec3 d = texture(srcTexture, TexCoords + vec2(-x, 0.0)).rgb;
+    vec3 e = texture(srcTexture, TexCoords).rgb;
+    vec3 f = texture(srcTexture, TexCoords + vec2( x, 0.0)).rgb;
+    vec3 g = texture(srcTexture, TexCoords + vec2(-x, -y)).rgb;
+    vec3 h = texture(srcTexture, TexCoords + vec2(0.0, -y)).rgb;
+    vec3 i = texture(srcTexture, TexCoords + vec2( x, -y)).rgb;
+
+    FragColor = e * 4.0;
+    FragColor += (b + d + f + h) * 2.0;
+    FragColor += (a + c + g + i);
+    FragColor *= 1.0 / 16.0;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+// one point per sampled pixel, no vertex attributes: the pixel comes from gl_VertexID and the point
+// lands on the histogram bin of its luminance, additive blending does the counting
+uniform sampler2D hdrBuffer;
+uniform int sampleStep;
+uniform int width;      // sampled pixels per row
+uniform int bins;
+uniform float minLog2;
+uniform float log2Range;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_VertexID % width, gl_VertexID / width) * sampleStep;
+    vec3 color = texelFetch(hdrBuffer, pixel, 0).rgb;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+
+    // bin 0 holds black pixels, the log2 range is spread over bins 1 .. bins - 1
+    int bin = 0;
+    if(luminance > exp2(minLog2))
+    {
+        float t = clamp((log2(luminance) - minLog2) / log2Range, 0.0, 1.0);
+        bin = 1 + min(int(t * float(bins - 1)), bins - 2);
+    }
+
+    gl_Position = vec4((float(bin) + 0.5) / float(bins) * 2.0 - 1.0, 0.0, 0.0, 1.0);
+}
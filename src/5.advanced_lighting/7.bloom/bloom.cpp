@@ -13,6 +13,11 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/filesystem.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/gaussian_blur.h>
+#include <learnopengl/auto_exposure.h>
+#include <learnopengl/tonemap_lut.h>
+#include <learnopengl/frame_graph.h>
 
 #include <stb_image.h>
 
@@ -20,13 +25,61 @@
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 768;
 
+// how the bright fragments are spread out
+enum EBloomMode
+{
+	BLOOM_PINGPONG,  // blur_amount full resolution passes of the 9 tap separable blur
+	BLOOM_MIP_CHAIN  // 13 tap downsample into ever smaller mips, then tent upsample and accumulate
+};
+
+const int BLOOM_MAX_MIPS = 8;
+
+// one line of the separable blur benchmark: one horizontal + vertical pass at full resolution
+struct BlurBenchmarkCase
+{
+	int radius;
+	bool linearSampling;
+	int fetches;
+	float blur_ms;
+};
+static std::vector<BlurBenchmarkCase> blurBenchmarkCases;
+
 typedef struct ui_params
 {
 	bool bloom = true;
 	float exposure = 1.0f;
+	bool auto_exposure = true;
+	float exposure_us = 0.0f;
+	TonemapSettings tonemap;
+	float lut_bake_ms = 0.0f;
+	int bloom_mode = BLOOM_MIP_CHAIN;
 	unsigned int blur_amount = 10;
+	int blur_radius = 4;
+	bool linear_sampling = true;
+	bool run_blur_benchmark = false;
+	int bloom_mips = 6;
+	float filter_radius = 0.005f;
+	float bloom_strength = 1.0f;
+	float pingpong_ms = 0.0f;
+	float downsample_ms[BLOOM_MAX_MIPS] = {};
+	float upsample_ms[BLOOM_MAX_MIPS] = {};
+	int graph_passes = 0;
+	float graph_declared_mb = 0.0f;
+	float graph_pooled_mb = 0.0f;
+	int graph_textures = 0;
+	bool print_timings = false;
 } ui_params;
 
+// scene targets: HDR color and bright fragments (MRT) plus depth, everything after them lives in the frame graph
+struct SceneTargets
+{
+	int width = 0;
+	int height = 0;
+	unsigned int hdrFBO = 0;
+	unsigned int colorBuffers[2] = { 0, 0 };
+	unsigned int rboDepth = 0;
+};
+
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -35,6 +88,7 @@ void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* texPath, bool gammaCorrection);
 void renderQuad();
 void renderCube();
+void allocateSceneTargets(SceneTargets& targets, int width, int height);
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -44,6 +98,10 @@ static ui_params params;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// framebuffer size, kept up to date by framebuffer_size_callback; all targets follow it
+int scrWidth = SCR_WIDTH;
+int scrHeight = SCR_HEIGHT;
+
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
 float lastX = SCR_WIDTH * 0.5f;
 float lastY = SCR_HEIGHT * 0.5f;
@@ -100,72 +158,31 @@ int main()
 	Shader shaderLight("7.bloom.vs", "7.light_box.fs");
 	Shader shaderBlur("7.blur.vs", "7.blur.fs");
 	Shader shaderBloomFinal("7.bloom_final.vs", "7.bloom_final.fs");
+	Shader shaderDownsample("7.blur.vs", "7.bloom_downsample.fs");
+	Shader shaderUpsample("7.blur.vs", "7.bloom_upsample.fs");
+	Shader shaderHistogram("7.luminance_histogram.vs", "7.luminance_histogram.fs");
+	Shader shaderExposureAdapt("7.exposure_adapt.vs", "7.exposure_adapt.fs");
 	
 	// load textures
 	// -------------
 	unsigned int woodTexture = loadTexture("res/textures/wood.png", true); // SRGB texture
 	unsigned int containerTexture = loadTexture("res/textures/wood.png", true); // SRGB texture
 
-	// configure floating point framebuffer
-	// ------------------------------------
-	unsigned int hdrFBO;
-	glGenFramebuffers(1, &hdrFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-
-	// create floating point color buffer
-	unsigned int colorBuffers[2];
-	glGenTextures(2, colorBuffers);
-	for (GLuint i = 0; i < 2; ++i)
-	{
-		glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		// attach buffers
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-	}
-
-	// create depth buffer (renderbuffer)
-	unsigned int rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-	// attach depth buffer
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-
-	GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-	glDrawBuffers(2, attachments);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "Framebuffer not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// render targets, the scene ones are (re)allocated with the window size, the graph's come from its pool
+	// -------------------------------------------------------------------------------------------------------
+	SceneTargets sceneTargets;
+	FrameGraph* graph = new FrameGraph();
+	FrameGraph* benchmarkGraph = new FrameGraph();
 
-	// ping-pong-framebuffer for blurring
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorbuffers[2];
-	glGenFramebuffers(2, pingpongFBO);
-	glGenTextures(2, pingpongColorbuffers);
-	for (GLuint i = 0; i < 2; ++i)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-		glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
+	// graph passes of the bloom, the graph times each of them
+	std::vector<int> blurPasses;
+	int downsamplePasses[BLOOM_MAX_MIPS];
+	int upsamplePasses[BLOOM_MAX_MIPS];
+	int benchmarkPasses[2];
 
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		{
-			std::cout << "Framebuffer not complete!\n";
-		}
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
+	// automatic exposure measured on the scene before bloom is added, see 6.hdr for the details and benchmark
+	AutoExposure* autoExposure = new AutoExposure(shaderHistogram, shaderExposureAdapt);
+	GpuTimer* exposureTimer = new GpuTimer();
 
 
 	// lighting info
@@ -190,9 +207,144 @@ int main()
 	shader.setInt("diffuseTexture", 0);
 	shaderBlur.use();
 	shaderBlur.setInt("image", 0);
+	GaussianKernel blurKernel(params.blur_radius, 0.0f, params.linear_sampling);
+	GaussianKernel benchmarkKernel(4);
+
+	// blur benchmark state: radius 4 to 64, every texel fetched vs. texel pairs merged by the bilinear filter
+	const int BENCHMARK_WARMUP_FRAMES = 20;
+	const int BENCHMARK_FRAMES = 200;
+	int benchmarkCase = -1;
+	int benchmarkFrame = 0;
 	shaderBloomFinal.use();
 	shaderBloomFinal.setInt("scene", 0);
 	shaderBloomFinal.setInt("bloomBlur", 1);
+	shaderBloomFinal.setInt("exposureTexture", 2);
+	shaderBloomFinal.setInt("tonemapLUT", 3);
+	TonemapLUT* tonemapLUT = new TonemapLUT();
+	tonemapLUT->SetUniforms(shaderBloomFinal);
+	shaderDownsample.use();
+	shaderDownsample.setInt("srcTexture", 0);
+	shaderUpsample.use();
+	shaderUpsample.setInt("srcTexture", 0);
+
+	// frame graph: bloom in the selected mode, then tone mapping into the default framebuffer; rebuilt whenever
+	// its structure changes, the passes read everything else from params when they run
+	// ----------------------------------------------------------------------------------------------------------
+	int graphMode = -1, graphBlurAmount = -1, graphMips = -1;
+	auto buildGraph = [&]()
+	{
+		graph->Clear();
+		blurPasses.clear();
+		int scene = graph->Import("scene", sceneTargets.colorBuffers[0]);
+		int bloom = graph->Import("bright", sceneTargets.colorBuffers[1]);
+
+		if (params.bloom_mode == BLOOM_PINGPONG)
+		{
+			// 2. blur bright fragments with two-pass Gaussian Blur
+			int blur[2] = { graph->Create("blur0", GL_RGBA16F), graph->Create("blur1", GL_RGBA16F) };
+			bool horizontal = true;
+			for (unsigned int i = 0; i < params.blur_amount; ++i)
+			{
+				bool first = i == 0;
+				blurPasses.push_back(graph->AddPass("blur", { bloom }, { blur[horizontal] }, [&, horizontal, first]()
+				{
+					if (first)
+					{
+						if (blurKernel.Radius != params.blur_radius || blurKernel.LinearSampling != params.linear_sampling)
+							blurKernel.Build(params.blur_radius, 0.0f, params.linear_sampling);
+						shaderBlur.use();
+						blurKernel.SetUniforms(shaderBlur);
+					}
+					shaderBlur.setInt("horizontal", horizontal);
+					renderQuad();
+				}));
+				bloom = blur[horizontal];
+				horizontal = !horizontal;
+			}
+		}
+		else
+		{
+			// 2. progressive bloom: every downsample halves the resolution, so the whole chain costs about
+			//    as much as one full resolution pass no matter how wide the bloom gets
+			int mips[BLOOM_MAX_MIPS];
+			for (int i = 0; i < params.bloom_mips; ++i)
+			{
+				mips[i] = graph->Create("bloom mip", GL_R11F_G11F_B10F, i + 1);
+				downsamplePasses[i] = graph->AddPass("downsample", { i == 0 ? bloom : mips[i - 1] }, { mips[i] }, [&, i]()
+				{
+					shaderDownsample.use();
+					shaderDownsample.setBool("firstPass", i == 0);
+					renderQuad();
+				});
+			}
+
+			// walk back up, adding the tent filtered smaller mip onto the larger one
+			for (int i = params.bloom_mips - 1; i > 0; --i)
+			{
+				upsamplePasses[i] = graph->AddPass("upsample", { mips[i] }, { mips[i - 1] }, [&]()
+				{
+					glEnable(GL_BLEND);
+					glBlendFunc(GL_ONE, GL_ONE);
+					shaderUpsample.use();
+					shaderUpsample.setFloat("filterRadius", params.filter_radius);
+					renderQuad();
+					glDisable(GL_BLEND);
+				});
+			}
+			bloom = mips[0];
+		}
+
+		// 3. tonemap HDR colors plus bloom to default framebuffer's (clamped) color range
+		graph->AddPass("tonemap", { scene, bloom }, { FrameGraph::BACKBUFFER }, [&]()
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			shaderBloomFinal.use();
+			glActiveTexture(GL_TEXTURE2);
+			glBindTexture(GL_TEXTURE_2D, autoExposure->ExposureTexture());
+			glActiveTexture(GL_TEXTURE3);
+			glBindTexture(GL_TEXTURE_3D, tonemapLUT->Texture);
+			glActiveTexture(GL_TEXTURE0);
+			// every mip gets summed into the first one, keep the brightness comparable to the ping-pong blur
+			float bloomStrength = params.bloom_strength;
+			if (params.bloom_mode == BLOOM_MIP_CHAIN)
+				bloomStrength /= (float)params.bloom_mips;
+			shaderBloomFinal.setFloat("exposure", params.exposure);
+			shaderBloomFinal.setBool("autoExposure", params.auto_exposure);
+			shaderBloomFinal.setFloat("bloomStrength", bloomStrength);
+			shaderBloomFinal.setBool("bloom", params.bloom && (params.bloom_mode == BLOOM_MIP_CHAIN || params.blur_amount > 0));
+			renderQuad();
+		});
+		graph->Compile();
+
+		graphMode = params.bloom_mode;
+		graphBlurAmount = params.blur_amount;
+		graphMips = params.bloom_mips;
+		params.graph_passes = graph->PassCount();
+		params.graph_declared_mb = graph->DeclaredBytes() / (1024.0f * 1024.0f);
+		params.graph_pooled_mb = graph->PooledBytes() / (1024.0f * 1024.0f);
+		params.graph_textures = graph->PooledCount();
+	};
+
+	// blur benchmark graph: one horizontal + vertical pass of benchmarkKernel on the bright buffer, the result is
+	// exported as nothing in the graph reads it
+	auto buildBenchmarkGraph = [&]()
+	{
+		benchmarkGraph->Clear();
+		int bright = benchmarkGraph->Import("bright", sceneTargets.colorBuffers[1]);
+		int blur[2] = { benchmarkGraph->Create("blur0", GL_RGBA16F), benchmarkGraph->Create("blur1", GL_RGBA16F) };
+		for (int i = 0; i < 2; ++i)
+		{
+			benchmarkPasses[i] = benchmarkGraph->AddPass("blur", { i == 0 ? bright : blur[0] }, { blur[i] }, [&, i]()
+			{
+				shaderBlur.use();
+				benchmarkKernel.SetUniforms(shaderBlur);
+				shaderBlur.setInt("horizontal", i == 0);
+				renderQuad();
+			});
+		}
+		benchmarkGraph->Export(blur[1]);
+		benchmarkGraph->Compile();
+	};
 
 	// render loop
 	// -----------
@@ -202,16 +354,30 @@ int main()
 		// -----
 		processInput(window);
 
+		// resizes are handled here for all targets: the scene targets are reallocated, the graphs follow
+		if (scrWidth != sceneTargets.width || scrHeight != sceneTargets.height)
+		{
+			allocateSceneTargets(sceneTargets, scrWidth, scrHeight);
+			graph->Resize(scrWidth, scrHeight);
+			benchmarkGraph->Resize(scrWidth, scrHeight);
+			// the imported scene textures were replaced, both graphs get rebuilt on their next use
+			benchmarkGraph->Clear();
+			graphMode = -1;
+		}
+		if (graphMode != params.bloom_mode || graphMips != params.bloom_mips || graphBlurAmount != (int)params.blur_amount)
+			buildGraph();
+
 		// Rendering
+		glViewport(0, 0, scrWidth, scrHeight);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// 1. render scene into floating point framebuffer
 		// -----------------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, sceneTargets.hdrFBO);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 100.0f);
+		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)scrWidth / scrHeight, 0.1f, 100.0f);
 		glm::mat4 view = camera.GetViewMatrix();
 		glm::mat4 model = glm::mat4(1.0f);
 		shader.use();
@@ -291,34 +457,87 @@ int main()
 
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-		// 2. blur bright fragments with two-pass Gaussian Blur 
-		// --------------------------------------------------
-		bool horizontal = true, first_iteration = true;
-		shaderBlur.use();
-		for (unsigned int i = 0; i < params.blur_amount; ++i)
+		// 1.1 adapt the exposure to the scene luminance
+		if (params.auto_exposure)
 		{
-			glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-			shaderBlur.setInt("horizontal", horizontal);
-			glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);
-			renderQuad();
-			horizontal = !horizontal;
-			if (first_iteration)
-				first_iteration = false;
+			exposureTimer->Begin();
+			autoExposure->Update(sceneTargets.colorBuffers[0], scrWidth, scrHeight, deltaTime);
+			exposureTimer->End();
+			params.exposure_us = exposureTimer->Milliseconds * 1000.0f;
+		}
+		else
+		{
+			autoExposure->Reset();
 		}
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+		// 2.1 blur benchmark: time one separable pass per case on the bright buffer, outside of the bloom itself
+		if (params.run_blur_benchmark && benchmarkCase < 0)
+		{
+			blurBenchmarkCases.clear();
+			for (int radius = 4; radius <= 64; radius *= 2)
+			{
+				for (int linear = 0; linear < 2; ++linear)
+				{
+					BlurBenchmarkCase c = { radius, linear == 1, GaussianKernel(radius, 0.0f, linear == 1).Fetches(), 0.0f };
+					blurBenchmarkCases.push_back(c);
+				}
+			}
+			benchmarkCase = 0;
+			benchmarkFrame = 0;
+		}
+		if (benchmarkCase >= 0)
+		{
+			BlurBenchmarkCase& current = blurBenchmarkCases[benchmarkCase];
+			if (benchmarkFrame == 0)
+				benchmarkKernel.Build(current.radius, 0.0f, current.linearSampling);
+			if (benchmarkGraph->PassCount() == 0)
+				buildBenchmarkGraph();
+			if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+				benchmarkGraph->ResetTimings();
+			glDisable(GL_DEPTH_TEST);
+			benchmarkGraph->Execute();
+			glEnable(GL_DEPTH_TEST);
+
+			if (++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+			{
+				current.blur_ms = benchmarkGraph->PassAverage(benchmarkPasses[0]) + benchmarkGraph->PassAverage(benchmarkPasses[1]);
+				printf("radius %2d %-8s %3d fetches per direction: %.3f ms\n", current.radius, current.linearSampling ? "linear" : "discrete", current.fetches, current.blur_ms);
+				benchmarkFrame = 0;
+				if (++benchmarkCase == (int)blurBenchmarkCases.size())
+				{
+					benchmarkCase = -1;
+					params.run_blur_benchmark = false;
+					// an empty graph returns its textures to the driver
+					benchmarkGraph->Clear();
+					benchmarkGraph->Compile();
+				}
+			}
+		}
 
-		// 2. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
-		// --------------------------------------------------------------------------------------------------------------------------
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		shaderBloomFinal.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-		shaderBloomFinal.setFloat("exposure", params.exposure);
-		shaderBloomFinal.setBool("bloom", params.bloom && params.blur_amount > 0);
-		renderQuad();
+		// 2. bloom and tone mapping, see buildGraph
+		// ----------------------------------------
+		if (tonemapLUT->Update(params.tonemap))
+			params.lut_bake_ms = tonemapLUT->BakeMilliseconds;
+		glDisable(GL_DEPTH_TEST);
+		graph->Execute();
+		glEnable(GL_DEPTH_TEST);
+
+		params.pingpong_ms = 0.0f;
+		for (size_t i = 0; i < blurPasses.size(); ++i)
+			params.pingpong_ms += graph->PassMilliseconds(blurPasses[i]);
+		if (params.bloom_mode == BLOOM_MIP_CHAIN)
+		{
+			for (int i = 0; i < params.bloom_mips; ++i)
+			{
+				params.downsample_ms[i] = graph->PassMilliseconds(downsamplePasses[i]);
+				params.upsample_ms[i] = i > 0 ? graph->PassMilliseconds(upsamplePasses[i]) : 0.0f;
+			}
+		}
+		if (params.print_timings)
+		{
+			graph->PrintTimings();
+			params.print_timings = false;
+		}
 
 		imgui_on_render(params);
 
@@ -330,6 +549,11 @@ int main()
 
 
 	// free resources
+	delete exposureTimer;
+	delete autoExposure;
+	delete tonemapLUT;
+	delete graph;
+	delete benchmarkGraph;
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -339,6 +563,53 @@ int main()
 	return 0;
 }
 
+// (re)creates the floating point scene framebuffer: HDR color, bright fragments and depth
+// --------------------------------------------------------------------------------------
+void allocateSceneTargets(SceneTargets& targets, int width, int height)
+{
+	if (targets.hdrFBO)
+	{
+		glDeleteFramebuffers(1, &targets.hdrFBO);
+		glDeleteTextures(2, targets.colorBuffers);
+		glDeleteRenderbuffers(1, &targets.rboDepth);
+	}
+	targets.width = width;
+	targets.height = height;
+
+	glGenFramebuffers(1, &targets.hdrFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.hdrFBO);
+
+	// create floating point color buffer
+	glGenTextures(2, targets.colorBuffers);
+	for (GLuint i = 0; i < 2; ++i)
+	{
+		glBindTexture(GL_TEXTURE_2D, targets.colorBuffers[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		// attach buffers
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, targets.colorBuffers[i], 0);
+	}
+
+	// create depth buffer (renderbuffer)
+	glGenRenderbuffers(1, &targets.rboDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, targets.rboDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
+	// attach depth buffer
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targets.rboDepth);
+
+	GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, attachments);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Framebuffer not complete!\n";
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -484,6 +755,13 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 	// make sure the viewport matches the new window dimensions; note that width and 
 	// height will be significantly larger than specified on retina displays.
 	glViewport(0, 0, width, height);
+
+	// minimized windows report 0 x 0, keep the last size for the render targets
+	if (width > 0 && height > 0)
+	{
+		scrWidth = width;
+		scrHeight = height;
+	}
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -608,7 +886,50 @@ void imgui_on_render(ui_params& param)
 
 	ImGui::Checkbox("Bloom", &params.bloom);
 	ImGui::DragFloat("Exposure", &params.exposure, 0.01f, 0.0f, 10.0f);
-	ImGui::DragInt("Blur Amount", (int *)(&params.blur_amount), 1, 0, 50);
+	static const char* tonemap_items[] = { "Exponential", "Reinhard Extended", "ACES Fit", "Uchimura", "AgX" };
+	ImGui::Combo("Tone Mapping", &params.tonemap.Operator, tonemap_items, IM_ARRAYSIZE(tonemap_items));
+	if (params.tonemap.Operator == TONEMAP_REINHARD_EXTENDED)
+		ImGui::DragFloat("White Point", &params.tonemap.WhitePoint, 0.05f, 1.0f, 32.0f);
+	ImGui::DragFloat("Contrast", &params.tonemap.Contrast, 0.01f, 0.5f, 2.0f);
+	ImGui::DragFloat("Saturation", &params.tonemap.Saturation, 0.01f, 0.0f, 2.0f);
+	ImGui::ColorEdit3("Color Filter", (float*)&params.tonemap.ColorFilter, ImGuiColorEditFlags_Float);
+	ImGui::DragFloat("Gamma", &params.tonemap.Gamma, 0.01f, 1.0f, 3.0f);
+	ImGui::Text("LUT %d^3 bake: %.3f ms", TonemapLUT::SIZE, params.lut_bake_ms);
+	ImGui::Checkbox("Auto Exposure", &params.auto_exposure);
+	if (params.auto_exposure)
+		ImGui::Text("Histogram + adaptation: %.1f us", params.exposure_us);
+	static const char* bloom_mode_items[] = { "Ping-Pong Gaussian", "Mip Chain" };
+	ImGui::Combo("Bloom Mode", &params.bloom_mode, bloom_mode_items, IM_ARRAYSIZE(bloom_mode_items));
+	ImGui::DragFloat("Bloom Strength", &params.bloom_strength, 0.01f, 0.0f, 4.0f);
+	if (params.bloom_mode == BLOOM_PINGPONG)
+	{
+		ImGui::DragInt("Blur Amount", (int *)(&params.blur_amount), 1, 0, 50);
+		ImGui::SliderInt("Blur Radius", &params.blur_radius, 1, 64);
+		ImGui::Checkbox("Linear Sampling", &params.linear_sampling);
+		ImGui::Text("Blur: %.3f ms", params.pingpong_ms);
+	}
+	else
+	{
+		ImGui::SliderInt("Mips", &params.bloom_mips, 1, BLOOM_MAX_MIPS);
+		ImGui::DragFloat("Filter Radius", &params.filter_radius, 0.0005f, 0.0f, 0.05f);
+		float total = 0.0f;
+		for (int i = 0; i < params.bloom_mips; ++i)
+		{
+			float upsample = i > 0 ? params.upsample_ms[i] : 0.0f;
+			ImGui::Text("Mip %d %4dx%-4d down %.3f ms, up %.3f ms", i, scrWidth >> (i + 1), scrHeight >> (i + 1), params.downsample_ms[i], upsample);
+			total += params.downsample_ms[i] + upsample;
+		}
+		ImGui::Text("Bloom: %.3f ms", total);
+	}
+	ImGui::Text("Frame graph: %d passes, %d textures", params.graph_passes, params.graph_textures);
+	ImGui::Text("Graph targets: %.1f MB pooled, %.1f MB without pooling", params.graph_pooled_mb, params.graph_declared_mb);
+	if (ImGui::Button("Print Pass Timings"))
+		params.print_timings = true;
+	ImGui::Separator();
+	if (ImGui::Button("Run Blur Benchmark"))
+		params.run_blur_benchmark = true;
+	for (size_t i = 0; i < blurBenchmarkCases.size(); ++i)
+		ImGui::Text("radius %2d %-8s %3d fetches %6.3f ms", blurBenchmarkCases[i].radius, blurBenchmarkCases[i].linearSampling ? "linear" : "discrete", blurBenchmarkCases[i].fetches, blurBenchmarkCases[i].blur_ms);
 
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
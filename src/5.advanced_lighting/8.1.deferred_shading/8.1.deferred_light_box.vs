@@ -3,11 +3,21 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+out vec4 CurrentClip;
+out vec4 PreviousClip;
+
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
 
+// unjittered, for the motion vectors
+uniform mat4 viewProjection;
+uniform mat4 prevViewProjection;
+uniform mat4 prevModel;
+
 void main()
 {
+    CurrentClip = viewProjection * model * vec4(aPos, 1.0);
+    PreviousClip = prevViewProjection * prevModel * vec4(aPos, 1.0);
     gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+}
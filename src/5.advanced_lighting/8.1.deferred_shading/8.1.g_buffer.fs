@@ -2,10 +2,13 @@
 layout (location = 0) out vec3 gPosition;
 layout (location = 1) out vec3 gNormal;
 layout (location = 2) out vec4 gAlbedoSpec;
+layout (location = 3) out vec2 gVelocity;
 
 in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
+in vec4 CurrentClip;
+in vec4 PreviousClip;
 
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
@@ -16,4 +19,6 @@ void main()
     gNormal = normalize(Normal);
     gAlbedoSpec.rgb = texture(texture_diffuse1, TexCoords).rgb;
     gAlbedoSpec.a = texture(texture_specular1, TexCoords).r;
-}
\ No newline at end of file
+    // screen space motion since the last frame, in texture coordinates
+    gVelocity = (CurrentClip.xy / CurrentClip.w - PreviousClip.xy / PreviousClip.w) * 0.5;
+}
@@ -6,11 +6,18 @@ layout (location = 2) in vec2 aTexCoords;
 out vec3 FragPos;
 out vec2 TexCoords;
 out vec3 Normal;
+out vec4 CurrentClip;
+out vec4 PreviousClip;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// unjittered, for the motion vectors
+uniform mat4 viewProjection;
+uniform mat4 prevViewProjection;
+uniform mat4 prevModel;
+
 void main()
 {
     vec4 worldPos = model * vec4(aPos, 1.0);
@@ -20,5 +27,8 @@ void main()
     mat3 normalMatrix = transpose(inverse(mat3(model)));
     Normal = normalMatrix * aNormal;
 
+    CurrentClip = viewProjection * worldPos;
+    PreviousClip = prevViewProjection * prevModel * vec4(aPos, 1.0);
+
     gl_Position = projection * view * worldPos;
-}
\ No newline at end of file
+}
@@ -0,0 +1,106 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D currentColor;     // render size, rendered with jitter
+uniform sampler2D velocityTexture;  // render size, current minus previous texture coordinate
+uniform sampler2D historyColor;     // output size, the accumulated previous frames
+
+uniform vec2 jitter;                // of the current frame, in render pixels
+uniform float feedbackMin;
+uniform float feedbackMax;
+uniform bool historyValid;
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Catmull-Rom filtered history in 5 bilinear taps (the corners of the 4x4 footprint are left out),
+// plain bilinear reprojection would blur the history a little more every frame
+vec3 sampleHistory(vec2 uv)
+{
+    vec2 size = vec2(textureSize(historyColor, 0));
+    vec2 samplePos = uv * size;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    vec2 w12 = w1 + w2;
+    vec2 texPos0 = (texPos1 - 1.0) / size;
+    vec2 texPos3 = (texPos1 + 2.0) / size;
+    vec2 texPos12 = (texPos1 + w2 / w12) / size;
+
+    vec3 result = texture(historyColor, vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y
+                + texture(historyColor, vec2(texPos0.x, texPos12.y)).rgb * w0.x * w12.y
+                + texture(historyColor, texPos12).rgb * w12.x * w12.y
+                + texture(historyColor, vec2(texPos3.x, texPos12.y)).rgb * w3.x * w12.y
+                + texture(historyColor, vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    return max(result / weight, 0.0);
+}
+
+// moves the history towards the center of the neighbourhood box until it lies inside, so stale colors
+// (disocclusion, shading changes) are rejected while valid ones stay untouched
+vec3 clipToBox(vec3 history, vec3 boxMin, vec3 boxMax)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extents = 0.5 * (boxMax - boxMin) + 1e-4;
+    vec3 offset = history - center;
+    vec3 units = abs(offset / extents);
+    float scale = max(units.x, max(units.y, units.z));
+    return scale > 1.0 ? center + offset / scale : history;
+}
+
+void main()
+{
+    ivec2 renderSize = textureSize(currentColor, 0);
+    vec2 renderToOutput = vec2(textureSize(historyColor, 0)) / vec2(renderSize);
+
+    // the scene is shifted by +jitter, so render pixel i sampled the unjittered position i + 0.5 - jitter;
+    // pick the pixel whose sample lies closest to this output pixel
+    vec2 position = TexCoords * vec2(renderSize);
+    ivec2 texel = clamp(ivec2(floor(position + jitter)), ivec2(0), renderSize - 1);
+    vec2 sampleOffset = (vec2(texel) + 0.5 - jitter - position) * renderToOutput;
+
+    // 3x3 neighbourhood of the current frame
+    vec3 color = texelFetch(currentColor, texel, 0).rgb;
+    vec3 boxMin = color;
+    vec3 boxMax = color;
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+        {
+            vec3 neighbour = texelFetch(currentColor, clamp(texel + ivec2(x, y), ivec2(0), renderSize - 1), 0).rgb;
+            boxMin = min(boxMin, neighbour);
+            boxMax = max(boxMax, neighbour);
+        }
+    }
+
+    vec2 previousUV = TexCoords - texelFetch(velocityTexture, texel, 0).rg;
+    bool onScreen = all(greaterThanEqual(previousUV, vec2(0.0))) && all(lessThanEqual(previousUV, vec2(1.0)));
+    if (!historyValid || !onScreen)
+    {
+        FragColor = vec4(color, 1.0);
+        return;
+    }
+
+    vec3 history = clipToBox(sampleHistory(previousUV), boxMin, boxMax);
+
+    // keep more history where it agrees with the current frame
+    float lumaColor = luma(color);
+    float lumaHistory = luma(history);
+    float difference = abs(lumaColor - lumaHistory) / max(lumaColor, max(lumaHistory, 0.2));
+    float agreement = 1.0 - difference;
+    float feedback = mix(feedbackMin, feedbackMax, agreement * agreement);
+
+    // with upsampling a sample far from this output pixel only contributes a little
+    float confidence = exp(-1.5 * dot(sampleOffset, sampleOffset));
+
+    FragColor = vec4(mix(history, color, (1.0 - feedback) * confidence), 1.0);
+}
@@ -14,6 +14,8 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/temporal_aa.h>
 
 #include <stb_image.h>
 
@@ -27,8 +29,32 @@ typedef struct ui_params
 	bool light_show_position = true;
 	bool light_attenuation = true;
 	float exposure = 1.0f;
+	bool animate = false;
+	bool taa = true;
+	float render_scale = 1.0f;    // internal resolution of the g-buffer and lighting, upsampled temporally to the window
+	float feedback_min = 0.88f;
+	float feedback_max = 0.97f;
+	float scene_ms = 0.0f;
+	float taa_ms = 0.0f;
+	float history_mb = 0.0f;
 } ui_params;
 
+// g-buffer and lit color at the internal resolution; the lighting target shares the depth buffer and the velocity
+// texture of the g-buffer, so the forward rendered light boxes are depth tested and write their motion vectors
+struct RenderTargets
+{
+	int width = 0;
+	int height = 0;
+	GLuint gBuffer = 0;
+	GLuint gPosition = 0;
+	GLuint gNormal = 0;
+	GLuint gAlbedoSpec = 0;
+	GLuint gVelocity = 0;
+	GLuint rboDepth = 0;
+	GLuint lightingFBO = 0;
+	GLuint lightingColor = 0;
+};
+
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -37,6 +63,8 @@ void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* texPath, bool gammaCorrection);
 void renderQuad();
 void renderCube();
+void allocateTargets(RenderTargets& targets, int width, int height);
+void releaseTargets(RenderTargets& targets);
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -120,54 +148,11 @@ int main()
     objectPositions.push_back(glm::vec3( 0.0,  -0.5,  3.0));
     objectPositions.push_back(glm::vec3( 3.0,  -0.5,  3.0));
 
-	// configure g-buffer framebuffer
-	// ------------------------------------
-	GLuint gBuffer;
-	glGenFramebuffers(1, &gBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-	GLuint gPosition, gNormal, gAlbedoSpec;
-
-	// - position color buffer
-	glGenTextures(1, &gPosition);
-	glBindTexture(GL_TEXTURE_2D, gPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-
-	// - normal color buffer
-	glGenTextures(1, &gNormal);
-	glBindTexture(GL_TEXTURE_2D, gNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-
-	// - color & specular color buffer
-	glGenTextures(1, &gAlbedoSpec);
-	glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedoSpec, 0);
-
-	GLuint attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-	glDrawBuffers(3, attachments);
-
-	// create depth buffer (renderbuffer)
-	unsigned int rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-	// attach depth buffer
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "Framebuffer not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
+	// temporal anti-aliasing, the g-buffer is (re)allocated in the render loop when the render scale changes
+	// ---------------------------------------------------------------------------------------------------------
+	Shader shaderTaaResolve("8.1.taa_resolve.vs", "8.1.taa_resolve.fs");
+	TemporalAA* taa = new TemporalAA(shaderTaaResolve);
+	RenderTargets targets;
 
 	// lighting info
 	// -------------
@@ -215,6 +200,15 @@ int main()
 	}
 
 
+	// motion vector state: last frame's unjittered view projection and object transforms
+	glm::mat4 prevViewProjection(1.0f);
+	std::vector<glm::mat4> prevModels(objectPositions.size());
+	bool firstFrame = true;
+	bool taaEnabled = params.taa;
+	float animationTime = 0.0f;
+	GpuTimer* sceneTimer = new GpuTimer();
+	GpuTimer* taaTimer = new GpuTimer();
+
 	// render loop
 	// -----------
 	while (!glfwWindowShouldClose(window))
@@ -223,32 +217,70 @@ int main()
 		// -----
 		processInput(window);
 
+		// internal resolution, the temporal history stays at window size
+		int renderWidth = glm::max((int)(SCR_WIDTH * params.render_scale + 0.5f), 1);
+		int renderHeight = glm::max((int)(SCR_HEIGHT * params.render_scale + 0.5f), 1);
+		if (renderWidth != targets.width || renderHeight != targets.height)
+		{
+			allocateTargets(targets, renderWidth, renderHeight);
+			taa->Resize(renderWidth, renderHeight, SCR_WIDTH, SCR_HEIGHT);
+		}
+		if (params.taa != taaEnabled)
+		{
+			taa->Reset();
+			taaEnabled = params.taa;
+		}
+		taa->FeedbackMin = params.feedback_min;
+		taa->FeedbackMax = params.feedback_max;
+		params.history_mb = taa->HistoryBytes() / (1024.0f * 1024.0f);
+
+		// a different sub-pixel offset every frame, the resolve accumulates them into the history
+		camera.SetJitter(params.taa ? taa->NextJitter() : glm::vec2(0.0f), renderWidth, renderHeight);
+		if (params.animate)
+			animationTime += deltaTime;
+
         // render
         // ------
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glViewport(0, 0, renderWidth, renderHeight);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		sceneTimer->Begin();
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, targets.gBuffer);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		glEnable(GL_DEPTH_TEST);
+		float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+		glm::mat4 projection = camera.GetProjectionMatrix(aspect);
 		glm::mat4 view = camera.GetViewMatrix();
+		// motion vectors are computed without the jitter, the first frame has nothing to move from
+		glm::mat4 viewProjection = camera.GetProjectionMatrix(aspect, 0.1f, 100.0f, false) * view;
+		if (firstFrame)
+			prevViewProjection = viewProjection;
 		shaderGeometryPass.use();
 		shaderGeometryPass.setMat4("projection", projection);
 		shaderGeometryPass.setMat4("view", view);
+		shaderGeometryPass.setMat4("viewProjection", viewProjection);
+		shaderGeometryPass.setMat4("prevViewProjection", prevViewProjection);
 		for (unsigned int i = 0; i < objectPositions.size(); ++i)
 		{
 			glm::mat4 model = glm::translate(glm::mat4(1.0f), objectPositions[i]);
+			model = glm::rotate(model, animationTime * (0.5f + 0.1f * i), glm::vec3(0.0f, 1.0f, 0.0f));
 			model = glm::scale(model, glm::vec3(0.5f));
+			if (firstFrame)
+				prevModels[i] = model;
 			shaderGeometryPass.setMat4("model", model);
+			shaderGeometryPass.setMat4("prevModel", prevModels[i]);
 			backpack.Draw(shaderGeometryPass);
+			prevModels[i] = model;
 		}
 
         // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
         // -----------------------------------------------------------------------------------------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glBindFramebuffer(GL_FRAMEBUFFER, targets.lightingFBO);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0); // keep the velocity of the geometry pass
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDisable(GL_DEPTH_TEST);
 		shaderLightingPass.use();
 		shaderLightingPass.setVec3("viewPos", camera.Position);
 		shaderLightingPass.setInt("gbuffer_display_mode", params.gbuffer_display_mode);
@@ -256,41 +288,63 @@ int main()
 		shaderLightingPass.setFloat("exposure", params.exposure);
 
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gPosition);
+		glBindTexture(GL_TEXTURE_2D, targets.gPosition);
 		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, gNormal);
+		glBindTexture(GL_TEXTURE_2D, targets.gNormal);
 		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
+		glBindTexture(GL_TEXTURE_2D, targets.gAlbedoSpec);
 
 		renderQuad();
+		glEnable(GL_DEPTH_TEST);
 
-
-        // 2.5. copy content of geometry's depth buffer to default framebuffer's depth buffer
-        // ----------------------------------------------------------------------------------
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
-		glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 3. render lights on top of scene
-        // --------------------------------
+        // 3. render lights on top of scene, the lighting target shares the g-buffer's depth buffer
+        // -----------------------------------------------------------------------------------------
 		if (params.light_show_position)
 		{
+			GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+			glDrawBuffers(2, attachments);
 			shaderLightBox.use();
 			shaderLightBox.setMat4("projection", projection);
 			shaderLightBox.setMat4("view", view);
+			shaderLightBox.setMat4("viewProjection", viewProjection);
+			shaderLightBox.setMat4("prevViewProjection", prevViewProjection);
 			for (unsigned int i = 0; i < NR_LIGHTS; ++i)
 			{
 				glm::mat4 model = glm::translate(glm::mat4(1.0f), lightPositions[i]);
 				model = glm::scale(model, glm::vec3(0.125f));
 				shaderLightBox.setMat4("model", model);
+				shaderLightBox.setMat4("prevModel", model);
 				shaderLightBox.setVec3("lightColor", lightColors[i]);
 				renderCube();
 			}
-
 		}
+		sceneTimer->End();
 
+        // 4. temporal resolve into the window sized history, or a plain (upscaling) copy without it
+        // ------------------------------------------------------------------------------------------
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+		taaTimer->Begin();
+		if (params.taa)
+		{
+			taa->Resolve(targets.lightingColor, targets.gVelocity);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, taa->HistoryFramebuffer());
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+		else
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, targets.lightingFBO);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		}
+		taaTimer->End();
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		params.scene_ms = sceneTimer->Milliseconds;
+		params.taa_ms = taaTimer->Milliseconds;
+
+		prevViewProjection = viewProjection;
+		firstFrame = false;
 
 		imgui_on_render(params);
 
@@ -302,6 +356,10 @@ int main()
 
 
 	// free resources
+	releaseTargets(targets);
+	delete sceneTimer;
+	delete taaTimer;
+	delete taa;
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -311,6 +369,96 @@ int main()
 	return 0;
 }
 
+// (re)creates the g-buffer and the lighting target at the internal render resolution
+// -----------------------------------------------------------------------------------
+void allocateTargets(RenderTargets& targets, int width, int height)
+{
+	releaseTargets(targets);
+	targets.width = width;
+	targets.height = height;
+
+	glGenFramebuffers(1, &targets.gBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.gBuffer);
+
+	// - position color buffer
+	glGenTextures(1, &targets.gPosition);
+	glBindTexture(GL_TEXTURE_2D, targets.gPosition);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets.gPosition, 0);
+
+	// - normal color buffer
+	glGenTextures(1, &targets.gNormal);
+	glBindTexture(GL_TEXTURE_2D, targets.gNormal);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, targets.gNormal, 0);
+
+	// - color & specular color buffer
+	glGenTextures(1, &targets.gAlbedoSpec);
+	glBindTexture(GL_TEXTURE_2D, targets.gAlbedoSpec);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, targets.gAlbedoSpec, 0);
+
+	// - screen space motion vectors
+	glGenTextures(1, &targets.gVelocity);
+	glBindTexture(GL_TEXTURE_2D, targets.gVelocity);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, width, height, 0, GL_RG, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, targets.gVelocity, 0);
+
+	GLuint attachments[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+	glDrawBuffers(4, attachments);
+
+	// create depth buffer (renderbuffer)
+	glGenRenderbuffers(1, &targets.rboDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, targets.rboDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
+	// attach depth buffer
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targets.rboDepth);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Framebuffer not complete!\n";
+	}
+
+	// lit color, filtered for the upscaling copy when the temporal resolve is off
+	glGenFramebuffers(1, &targets.lightingFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.lightingFBO);
+	glGenTextures(1, &targets.lightingColor);
+	glBindTexture(GL_TEXTURE_2D, targets.lightingColor);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets.lightingColor, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, targets.gVelocity, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targets.rboDepth);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Lighting framebuffer not complete!\n";
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void releaseTargets(RenderTargets& targets)
+{
+	glDeleteFramebuffers(1, &targets.gBuffer);
+	glDeleteFramebuffers(1, &targets.lightingFBO);
+	GLuint textures[5] = { targets.gPosition, targets.gNormal, targets.gAlbedoSpec, targets.gVelocity, targets.lightingColor };
+	glDeleteTextures(5, textures);
+	glDeleteRenderbuffers(1, &targets.rboDepth);
+	targets = RenderTargets();
+}
+
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -586,6 +734,18 @@ void imgui_on_render(ui_params& param)
 	ImGui::Checkbox("Show Lights", &params.light_show_position);
 	ImGui::Checkbox("Lighting Attenuation", &params.light_attenuation);
 	ImGui::DragFloat("Exposure", &params.exposure, 0.01f, 0.0f, 10.0f);
+	ImGui::Checkbox("Animate", &params.animate);
+	ImGui::Separator();
+	ImGui::Checkbox("Temporal AA", &params.taa);
+	ImGui::SliderFloat("Render Scale", &params.render_scale, 0.5f, 1.0f);
+	if (params.taa)
+	{
+		ImGui::SliderFloat("Feedback Min", &params.feedback_min, 0.5f, 0.99f);
+		ImGui::SliderFloat("Feedback Max", &params.feedback_max, 0.5f, 0.99f);
+		ImGui::Text("History: %.1f MB", params.history_mb);
+	}
+	ImGui::Text("G-buffer + lighting: %.3f ms", params.scene_ms);
+	ImGui::Text("Resolve + present: %.3f ms", params.taa_ms);
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
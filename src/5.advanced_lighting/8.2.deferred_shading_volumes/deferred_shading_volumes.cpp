@@ -14,6 +14,7 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/frame_graph.h>
 
 #include <stb_image.h>
 
@@ -27,6 +28,10 @@ typedef struct ui_params
 	bool light_show_position = true;
 	bool light_attenuation = true;
 	float exposure = 1.0f;
+	bool print_timings = false;
+	std::vector<std::string> pass_names;
+	std::vector<float> pass_ms;
+	float graph_pooled_mb = 0.0f;
 } ui_params;
 
 
@@ -46,6 +51,10 @@ static ui_params params;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// framebuffer size, kept up to date by framebuffer_size_callback; the frame graph follows it
+int scrWidth = SCR_WIDTH;
+int scrHeight = SCR_HEIGHT;
+
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
 float lastX = SCR_WIDTH * 0.5f;
 float lastY = SCR_HEIGHT * 0.5f;
@@ -120,55 +129,6 @@ int main()
     objectPositions.push_back(glm::vec3( 0.0,  -0.5,  3.0));
     objectPositions.push_back(glm::vec3( 3.0,  -0.5,  3.0));
 
-	// configure g-buffer framebuffer
-	// ------------------------------------
-	GLuint gBuffer;
-	glGenFramebuffers(1, &gBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-	GLuint gPosition, gNormal, gAlbedoSpec;
-
-	// - position color buffer
-	glGenTextures(1, &gPosition);
-	glBindTexture(GL_TEXTURE_2D, gPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-
-	// - normal color buffer
-	glGenTextures(1, &gNormal);
-	glBindTexture(GL_TEXTURE_2D, gNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-
-	// - color & specular color buffer
-	glGenTextures(1, &gAlbedoSpec);
-	glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedoSpec, 0);
-
-	GLuint attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-	glDrawBuffers(3, attachments);
-
-	// create depth buffer (renderbuffer)
-	unsigned int rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-	// attach depth buffer
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "Framebuffer not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-
 	// lighting info
 	// -------------
 	const unsigned int NR_LIGHTS = 32;
@@ -221,96 +181,126 @@ int main()
 		shaderLightingPass.setFloat(buf, radius);
 	}
 
-
-	// render loop
-	// -----------
-	while (!glfwWindowShouldClose(window))
+	// frame graph: g-buffer, lighting and the light boxes, which depth test against the g-buffer depth; the
+	// g-buffer targets are transient, the graph allocates them and follows window resizes
+	// ------------------------------------------------------------------------------------------------------
+	FrameGraph* graph = new FrameGraph();
+	glm::mat4 projection, view;
+	bool graphShowLights = false;
+	auto buildGraph = [&]()
 	{
-		// input
-		// -----
-		processInput(window);
-
-        // render
-        // ------
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 1. geometry pass: render scene's geometry/color data into gbuffer
-        // -----------------------------------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		shaderGeometryPass.use();
-		shaderGeometryPass.setMat4("projection", projection);
-		shaderGeometryPass.setMat4("view", view);
-		for (unsigned int i = 0; i < objectPositions.size(); ++i)
+		graph->Clear();
+		int gPosition = graph->Create("gPosition", GL_RGB16F, 0, GL_NEAREST);
+		int gNormal = graph->Create("gNormal", GL_RGB16F, 0, GL_NEAREST);
+		int gAlbedoSpec = graph->Create("gAlbedoSpec", GL_RGBA8, 0, GL_NEAREST);
+		int depth = graph->Create("depth", GL_DEPTH_COMPONENT24, 0, GL_NEAREST);
+
+		// 1. geometry pass: render scene's geometry/color data into gbuffer
+		// -----------------------------------------------------------------
+		graph->AddPass("geometry", {}, { gPosition, gNormal, gAlbedoSpec, depth }, [&]()
 		{
-			glm::mat4 model = glm::translate(glm::mat4(1.0f), objectPositions[i]);
-			model = glm::scale(model, glm::vec3(0.5f));
-			shaderGeometryPass.setMat4("model", model);
-			backpack.Draw(shaderGeometryPass);
-		}
+			glEnable(GL_DEPTH_TEST);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			shaderGeometryPass.use();
+			shaderGeometryPass.setMat4("projection", projection);
+			shaderGeometryPass.setMat4("view", view);
+			for (unsigned int i = 0; i < objectPositions.size(); ++i)
+			{
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), objectPositions[i]);
+				model = glm::scale(model, glm::vec3(0.5f));
+				shaderGeometryPass.setMat4("model", model);
+				backpack.Draw(shaderGeometryPass);
+			}
+		});
 
-        // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
-        // -----------------------------------------------------------------------------------------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		shaderLightingPass.use();
-		shaderLightingPass.setVec3("viewPos", camera.Position);
-		shaderLightingPass.setInt("gbuffer_display_mode", params.gbuffer_display_mode);
-		shaderLightingPass.setInt("light_attenuation", params.light_attenuation);
-		shaderLightingPass.setFloat("exposure", params.exposure);
-
-		for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+		// 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
+		// -----------------------------------------------------------------------------------------------------------------------
+		graph->AddPass("lighting", { gPosition, gNormal, gAlbedoSpec }, { FrameGraph::BACKBUFFER }, [&]()
 		{
-			char buf[32];
-			sprintf(buf, "lights[%d].Position", i);
-			glm::vec3 temp = lightPositions[i];
-			temp.x = sin(glfwGetTime() * 0.1f * i) * lightPositions[i].x;
-			temp.y = cos(glfwGetTime() * 0.1f * i) * lightPositions[i].y;
-			shaderLightingPass.setVec3(buf, temp);
-		}
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			shaderLightingPass.use();
+			shaderLightingPass.setVec3("viewPos", camera.Position);
+			shaderLightingPass.setInt("gbuffer_display_mode", params.gbuffer_display_mode);
+			shaderLightingPass.setInt("light_attenuation", params.light_attenuation);
+			shaderLightingPass.setFloat("exposure", params.exposure);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gPosition);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, gNormal);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-
-		renderQuad();
-
-
-        // 2.5. copy content of geometry's depth buffer to default framebuffer's depth buffer
-        // ----------------------------------------------------------------------------------
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
-		glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 3. render lights on top of scene
-        // --------------------------------
-		if (params.light_show_position)
-		{
-			shaderLightBox.use();
-			shaderLightBox.setMat4("projection", projection);
-			shaderLightBox.setMat4("view", view);
 			for (unsigned int i = 0; i < NR_LIGHTS; ++i)
 			{
+				char buf[32];
+				sprintf(buf, "lights[%d].Position", i);
 				glm::vec3 temp = lightPositions[i];
 				temp.x = sin(glfwGetTime() * 0.1f * i) * lightPositions[i].x;
 				temp.y = cos(glfwGetTime() * 0.1f * i) * lightPositions[i].y;
-				glm::mat4 model = glm::translate(glm::mat4(1.0f), temp);
-				model = glm::scale(model, glm::vec3(0.125f));
-				shaderLightBox.setMat4("model", model);
-				shaderLightBox.setVec3("lightColor", lightColors[i]);
-				renderCube();
+				shaderLightingPass.setVec3(buf, temp);
 			}
+			renderQuad();
+		});
 
+		// 3. render lights on top of scene, after copying the geometry's depth buffer to the default framebuffer's
+		//    depth buffer; the depth target is read by the blit, not sampled
+		// ----------------------------------------------------------------------------------------------------------
+		if (params.light_show_position)
+		{
+			graph->AddPass("light boxes", { depth }, { FrameGraph::BACKBUFFER }, [&, depth]()
+			{
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, graph->Framebuffer(depth));
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
+				glBlitFramebuffer(0, 0, scrWidth, scrHeight, 0, 0, scrWidth, scrHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+				shaderLightBox.use();
+				shaderLightBox.setMat4("projection", projection);
+				shaderLightBox.setMat4("view", view);
+				for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+				{
+					glm::vec3 temp = lightPositions[i];
+					temp.x = sin(glfwGetTime() * 0.1f * i) * lightPositions[i].x;
+					temp.y = cos(glfwGetTime() * 0.1f * i) * lightPositions[i].y;
+					glm::mat4 model = glm::translate(glm::mat4(1.0f), temp);
+					model = glm::scale(model, glm::vec3(0.125f));
+					shaderLightBox.setMat4("model", model);
+					shaderLightBox.setVec3("lightColor", lightColors[i]);
+					renderCube();
+				}
+			});
 		}
+		graph->Compile();
+		graphShowLights = params.light_show_position;
+	};
+	buildGraph();
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// input
+		// -----
+		processInput(window);
+
+		// render
+		// ------
+		graph->Resize(scrWidth, scrHeight);
+		if (graphShowLights != params.light_show_position)
+			buildGraph();
+		projection = glm::perspective(glm::radians(camera.Zoom), (float)scrWidth / (float)scrHeight, 0.1f, 100.0f);
+		view = camera.GetViewMatrix();
+		graph->Execute();
+
+		params.pass_names.clear();
+		params.pass_ms.clear();
+		for (size_t i = 0; i < graph->Schedule().size(); ++i)
+		{
+			params.pass_names.push_back(graph->PassName(graph->Schedule()[i]));
+			params.pass_ms.push_back(graph->PassMilliseconds(graph->Schedule()[i]));
+		}
+		params.graph_pooled_mb = graph->PooledBytes() / (1024.0f * 1024.0f);
+		if (params.print_timings)
+		{
+			graph->PrintTimings();
+			params.print_timings = false;
+		}
 
 		imgui_on_render(params);
 
@@ -322,6 +312,7 @@ int main()
 
 
 	// free resources
+	delete graph;
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -479,6 +470,13 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 	// make sure the viewport matches the new window dimensions; note that width and 
 	// height will be significantly larger than specified on retina displays.
 	glViewport(0, 0, width, height);
+
+	// minimized windows report 0 x 0, keep the last size for the render targets
+	if (width > 0 && height > 0)
+	{
+		scrWidth = width;
+		scrHeight = height;
+	}
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -607,6 +605,12 @@ void imgui_on_render(ui_params& param)
 	ImGui::Checkbox("Lighting Attenuation", &params.light_attenuation);
 	ImGui::DragFloat("Exposure", &params.exposure, 0.01f, 0.0f, 10.0f);
 	ImGui::Separator();
+	for (size_t i = 0; i < params.pass_names.size(); ++i)
+		ImGui::Text("%-12s %.3f ms", params.pass_names[i].c_str(), params.pass_ms[i]);
+	ImGui::Text("Graph targets: %.1f MB", params.graph_pooled_mb);
+	if (ImGui::Button("Print Pass Timings"))
+		params.print_timings = true;
+	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
 	ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
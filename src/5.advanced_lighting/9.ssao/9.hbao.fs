@@ -0,0 +1,78 @@
+#version 330 core
+out float FragColor;
+in vec2 TexCoords;
+
+// horizon based ambient occlusion: march a few screen space directions from the pixel, track the highest
+// horizon above the tangent plane along each of them and accumulate how much every new horizon rises
+uniform sampler2D normalDepth;
+uniform sampler2DArray normalDepthLayers;
+uniform sampler2D texNoise;
+
+uniform vec2 viewRay; // tan(fovy / 2) * aspect, tan(fovy / 2)
+
+// parameters
+uniform float radius = 0.5;
+uniform float bias = 0.025;  // sine of the angle the horizon has to rise above the tangent plane
+uniform int directions = 4;
+uniform int steps = 4;
+uniform int level;
+uniform vec2 aoSize;
+
+// same de-interleaved layout as 9.ssao_lowres.fs
+uniform bool interleaved;
+uniform int layer;
+uniform ivec2 layerOffset;
+
+vec4 FetchNormalDepth(vec2 uv)
+{
+    if(interleaved)
+        return textureLod(normalDepthLayers, vec3(uv, float(layer)), 0.0);
+    return textureLod(normalDepth, uv, float(level));
+}
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+    return vec3((uv * 2.0 - 1.0) * viewRay * -depth, depth);
+}
+
+void main()
+{
+    vec2 uv = interleaved ? (floor(gl_FragCoord.xy) * 4.0 + vec2(layerOffset) + 0.5) / aoSize : TexCoords;
+    vec4 center = FetchNormalDepth(uv);
+    vec3 fragPos = ViewPosition(uv, center.w);
+    vec3 normal = normalize(center.xyz);
+
+    // the noise vector rotates the directions, a second value derived from it jitters the first step
+    vec2 noise = interleaved ? texelFetch(texNoise, layerOffset, 0).xy : texture(texNoise, gl_FragCoord.xy / 4.0).xy;
+    float rotation = atan(noise.y, noise.x);
+    float jitter = fract(dot(noise, vec2(12.9898, 78.233)));
+
+    // radius projected to uv space at the depth of the pixel
+    vec2 radiusUV = radius * 0.5 / (viewRay * max(-fragPos.z, 0.001));
+    float stepSize = 1.0 / (float(steps) + 1.0);
+
+    float occlusion = 0.0;
+    for(int i = 0; i < directions; ++i)
+    {
+        float angle = rotation + 6.2831853 * float(i) / float(directions);
+        vec2 direction = vec2(cos(angle), sin(angle)) * radiusUV;
+
+        float horizonSin = bias;
+        for(int j = 0; j < steps; ++j)
+        {
+            vec2 sampleUV = uv + direction * (float(j) + jitter + 1.0) * stepSize;
+            vec3 horizonVec = ViewPosition(sampleUV, FetchNormalDepth(sampleUV).w) - fragPos;
+            float distanceSq = dot(horizonVec, horizonVec);
+            float sampleSin = dot(normal, horizonVec) * inversesqrt(max(distanceSq, 1e-6));
+            if(sampleSin > horizonSin)
+            {
+                // attenuate far away occluders so the effect fades out at the radius
+                float falloff = clamp(1.0 - distanceSq / (radius * radius), 0.0, 1.0);
+                occlusion += (sampleSin - horizonSin) * falloff;
+                horizonSin = sampleSin;
+            }
+        }
+    }
+
+    FragColor = clamp(1.0 - occlusion / float(directions), 0.0, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+out float FragColor;
+
+// the 4x4 blur of 9.ssao_blur.fs, weighted by depth similarity so occlusion does not leak across edges
+uniform sampler2D ssaoInput;
+uniform sampler2D normalDepth;
+uniform int level;
+uniform float sharpness = 50.0;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(ssaoInput, 0);
+    float depth = texelFetch(normalDepth, texel, level).w;
+
+    float result = 0.0;
+    float weightSum = 0.0;
+    for(int x = -2; x < 2; ++x)
+    {
+        for(int y = -2; y < 2; ++y)
+        {
+            ivec2 sampleTexel = clamp(texel + ivec2(x, y), ivec2(0), size - 1);
+            float sampleDepth = texelFetch(normalDepth, sampleTexel, level).w;
+            float weight = exp(-abs((sampleDepth - depth) / min(depth, -0.001)) * sharpness);
+            result += texelFetch(ssaoInput, sampleTexel, 0).r * weight;
+            weightSum += weight;
+        }
+    }
+
+    FragColor = result / weightSum;
+}
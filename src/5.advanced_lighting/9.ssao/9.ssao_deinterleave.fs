@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragNormalDepth;
+
+// copies every 4th texel of one pyramid level into one layer, layer (i, j) holds the texels (4x + i, 4y + j)
+uniform sampler2D normalDepth;
+uniform int level;
+uniform ivec2 layerOffset;
+
+void main()
+{
+    FragNormalDepth = texelFetch(normalDepth, ivec2(gl_FragCoord.xy) * 4 + layerOffset, level);
+}
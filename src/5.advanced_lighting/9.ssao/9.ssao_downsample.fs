@@ -0,0 +1,29 @@
+#version 330 core
+out vec4 FragNormalDepth;
+
+// builds one level of the normal/depth pyramid: rgb view space normal, a view space depth
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D normalDepth; // only the previous level is visible (base level == max level)
+uniform bool firstLevel;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    if(firstLevel)
+    {
+        FragNormalDepth = vec4(normalize(texelFetch(gNormal, texel, 0).rgb), texelFetch(gPosition, texel, 0).z);
+        return;
+    }
+
+    // keep one of the four samples instead of averaging them, an average across a silhouette describes
+    // a surface that does not exist; the one closest to the camera keeps thin foreground objects
+    vec4 result = texelFetch(normalDepth, texel * 2, 0);
+    for(int i = 1; i < 4; ++i)
+    {
+        vec4 s = texelFetch(normalDepth, texel * 2 + ivec2(i & 1, i >> 1), 0);
+        if(s.w > result.w)
+            result = s;
+    }
+    FragNormalDepth = result;
+}
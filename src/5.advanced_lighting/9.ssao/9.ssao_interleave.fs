@@ -0,0 +1,11 @@
+#version 330 core
+out float FragColor;
+
+// puts the 16 de-interleaved AO layers back together
+uniform sampler2DArray aoLayers;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    FragColor = texelFetch(aoLayers, ivec3(texel / 4, (texel.x % 4) + (texel.y % 4) * 4), 0).r;
+}
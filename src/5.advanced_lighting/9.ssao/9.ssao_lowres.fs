@@ -0,0 +1,72 @@
+#version 330 core
+out float FragColor;
+in vec2 TexCoords;
+
+// hemisphere kernel SSAO on a downsampled normal/depth pyramid level, optionally on one de-interleaved layer
+uniform sampler2D normalDepth;
+uniform sampler2DArray normalDepthLayers;
+uniform sampler2D texNoise;
+
+uniform vec3 samples[64];
+uniform mat4 projection;
+uniform vec2 viewRay; // tan(fovy / 2) * aspect, tan(fovy / 2)
+
+// parameters
+uniform int kernelSize = 64;
+uniform float radius = 0.5;
+uniform float bias = 0.025;
+uniform int level;
+uniform vec2 aoSize;
+
+// de-interleaved: every layer is a quarter by quarter image of the pixels sharing one noise vector,
+// so neighbouring fragments sample neighbouring texels with the same kernel and the texture cache holds
+uniform bool interleaved;
+uniform int layer;
+uniform ivec2 layerOffset;
+
+vec4 FetchNormalDepth(vec2 uv)
+{
+    if(interleaved)
+        return textureLod(normalDepthLayers, vec3(uv, float(layer)), 0.0);
+    return textureLod(normalDepth, uv, float(level));
+}
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+    return vec3((uv * 2.0 - 1.0) * viewRay * -depth, depth);
+}
+
+void main()
+{
+    vec2 uv = interleaved ? (floor(gl_FragCoord.xy) * 4.0 + vec2(layerOffset) + 0.5) / aoSize : TexCoords;
+    vec4 center = FetchNormalDepth(uv);
+    vec3 fragPos = ViewPosition(uv, center.w);
+    vec3 normal = normalize(center.xyz);
+    // the same 4x4 noise tiling as the full resolution pass, one vector per layer when de-interleaved
+    vec3 randomVec = normalize(interleaved ? texelFetch(texNoise, layerOffset, 0).xyz : texture(texNoise, gl_FragCoord.xy / 4.0).xyz);
+
+    // create TBN change-of-basis matrix: from tangent-space to view-space
+    vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
+    vec3 bitangent = cross(normal, tangent);
+    mat3 TBN = mat3(tangent, bitangent, normal);
+
+    float occlusion = 0.0f;
+    for(int i = 0; i < kernelSize; ++i)
+    {
+        vec3 sample = TBN * samples[i]; // from tangent to view-space
+        sample = fragPos + sample * radius;
+
+        vec4 offset = vec4(sample, 1.0); // view space -> clip space
+        offset = projection * offset;
+        offset.xyz /= offset.w;
+        offset.xyz = offset.xyz * 0.5 + 0.5; // transform to range 0.0 - 1.0
+
+        float sampleDepth = FetchNormalDepth(offset.xy).w;
+
+        float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
+        occlusion += (sampleDepth >= sample.z + bias ? 1.0 : 0.0) * rangeCheck;
+    }
+
+    occlusion = 1.0 - (occlusion / kernelSize);
+    FragColor = occlusion;
+}
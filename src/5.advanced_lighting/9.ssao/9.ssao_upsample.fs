@@ -0,0 +1,34 @@
+#version 330 core
+out float FragColor;
+
+// depth aware upsampling: the bilinear weights of the four nearest low resolution texels are scaled down
+// for texels whose depth differs from the full resolution pixel, so edges stay sharp
+uniform sampler2D ssaoInput;
+uniform sampler2D normalDepth;
+uniform int level;
+uniform float sharpness = 50.0;
+
+void main()
+{
+    float depth = texelFetch(normalDepth, ivec2(gl_FragCoord.xy), 0).w;
+    ivec2 size = textureSize(ssaoInput, 0);
+
+    vec2 lowPos = gl_FragCoord.xy / float(1 << level) - 0.5;
+    ivec2 base = ivec2(floor(lowPos));
+    vec2 f = fract(lowPos);
+
+    float result = 0.0;
+    float weightSum = 0.0;
+    for(int i = 0; i < 4; ++i)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 sampleTexel = clamp(base + offset, ivec2(0), size - 1);
+        float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+        float sampleDepth = texelFetch(normalDepth, sampleTexel, level).w;
+        float weight = max(bilinear * exp(-abs((sampleDepth - depth) / min(depth, -0.001)) * sharpness), 1e-5);
+        result += texelFetch(ssaoInput, sampleTexel, 0).r * weight;
+        weightSum += weight;
+    }
+
+    FragColor = result / weightSum;
+}
@@ -14,14 +14,33 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/frame_graph.h>
 
 #include <stb_image.h>
 #include <random>
+#include <vector>
+#include <cmath>
 
 // settings
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 768;
 
+// how occlusion is estimated
+enum ESSAOMethod
+{
+	SSAO_KERNEL, // random hemisphere samples, 9.ssao.fs / 9.ssao_lowres.fs
+	SSAO_HBAO    // horizon search along a few screen space directions, 9.hbao.fs
+};
+
+// resolution the occlusion is computed at, also the normal/depth pyramid level it reads from
+enum ESSAOResolution
+{
+	SSAO_FULL,
+	SSAO_HALF,
+	SSAO_QUARTER
+};
+
 typedef struct ui_params
 {
 	int gbuffer_display_mode = 0;
@@ -29,9 +48,35 @@ typedef struct ui_params
 	int kernel_size = 64;
 	float kernel_radius = 0.5f;
 	float kernel_bias = 0.025f;
+	int method = SSAO_KERNEL;
+	int hbao_directions = 4;
+	int hbao_steps = 4;
+	int resolution = SSAO_FULL;
+	bool interleaved = true;
+	bool run_benchmark = false;
+	float ssao_ms = 0.0f;
+	bool print_timings = false;
+	std::vector<std::string> pass_names;
+	std::vector<float> pass_ms;
+	int culled_passes = 0;
+	float graph_pooled_mb = 0.0f;
 	glm::vec3 dir;
 } ui_params;
 
+// one line of the quality / cost benchmark
+struct BenchmarkCase
+{
+	const char* name;
+	int method;
+	int samples; // kernel size, or directions * steps for HBAO
+	int resolution;
+	bool interleaved;
+	float ssao_ms;
+	float rmse;  // of the final occlusion against the first case
+	float noise; // of the raw occlusion against its blurred result, how much work is left to the blur
+};
+static std::vector<BenchmarkCase> benchmarkCases;
+
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -40,6 +85,7 @@ void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* texPath, bool gammaCorrection);
 void renderQuad();
 void renderCube();
+void allocateLowResTargets(int level, GLuint aoLow[2], GLuint aoLayers, GLuint normalDepthLayers);
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -112,100 +158,47 @@ int main()
     Shader shaderGeometryPass("9.ssao_geometry.vs", "9.ssao_geometry.fs");
     Shader shaderSSAO("9.ssao.vs", "9.ssao.fs");
     Shader shaderSSAOBlur("9.ssao.vs", "9.ssao_blur.fs");
+	Shader shaderDownsample("9.ssao.vs", "9.ssao_downsample.fs");
+	Shader shaderDeinterleave("9.ssao.vs", "9.ssao_deinterleave.fs");
+	Shader shaderSSAOLowRes("9.ssao.vs", "9.ssao_lowres.fs");
+	Shader shaderHBAO("9.ssao.vs", "9.hbao.fs");
+	Shader shaderInterleave("9.ssao.vs", "9.ssao_interleave.fs");
+	Shader shaderBilateral("9.ssao.vs", "9.ssao_bilateral.fs");
+	Shader shaderUpsample("9.ssao.vs", "9.ssao_upsample.fs");
 	Shader shaderLightingPass("9.ssao.vs", "9.ssao_lighting.fs");
 	
     // load models
     // -----------
     Model backpack(FileSystem::getPath("res/objects/backpack/backpack.obj"));
 
-	// configure g-buffer framebuffer
-	// ------------------------------------
-	GLuint gBuffer;
-	glGenFramebuffers(1, &gBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-	GLuint gPosition, gNormal, gAlbedo;
-
-	// - position color buffer
-	glGenTextures(1, &gPosition);
-	glBindTexture(GL_TEXTURE_2D, gPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	// g-buffer and full resolution occlusion targets come from the frame graph, see buildGraph
+	// ---------------------------------------------------------------------------------------
+	FrameGraph* graph = new FrameGraph();
+	graph->Resize(SCR_WIDTH, SCR_HEIGHT);
+
+	// normal/depth pyramid for the reduced resolution modes: rgb view space normal, a view space depth
+	// ------------------------------------------------------------------------------------------------
+	const int PYRAMID_LEVELS = SSAO_QUARTER + 1;
+	GLuint normalDepth;
+	glGenTextures(1, &normalDepth);
+	glBindTexture(GL_TEXTURE_2D, normalDepth);
+	for (int level = 0; level < PYRAMID_LEVELS; ++level)
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA16F, SCR_WIDTH >> level, SCR_HEIGHT >> level, 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-
-	// - normal color buffer
-	glGenTextures(1, &gNormal);
-	glBindTexture(GL_TEXTURE_2D, gNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-
-	// - color & specular color buffer
-	glGenTextures(1, &gAlbedo);
-	glBindTexture(GL_TEXTURE_2D, gAlbedo);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
-
-	GLuint attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-	glDrawBuffers(3, attachments);
-
-	// create depth buffer (renderbuffer)
-	unsigned int rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-	// attach depth buffer
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "gBuffer Framebuffer not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	// SSAO framebuffer
-	// --------------------
-	unsigned int ssaoFBO;
-	glGenFramebuffers(1, &ssaoFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-
-	GLuint ssaoColorBuffer;
-	glGenTextures(1, &ssaoColorBuffer);
-	glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SCR_WIDTH, SCR_HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBuffer, 0);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "SSAO Framebuffer not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// SSAO Blur framebuffer
-	unsigned int ssaoBlurFBO;
-	glGenFramebuffers(1, &ssaoBlurFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-
-	GLuint ssaoBlurColorBuffer;
-	glGenTextures(1, &ssaoBlurColorBuffer);
-	glBindTexture(GL_TEXTURE_2D, ssaoBlurColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SCR_WIDTH, SCR_HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoBlurColorBuffer, 0);
-	
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "SSAOBlur Framebuffer not complete!\n";
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, PYRAMID_LEVELS - 1);
+
+	// low resolution targets: raw and blurred occlusion plus the 16 de-interleaved layers,
+	// (re)allocated whenever the resolution changes
+	unsigned int lowResFBO;
+	glGenFramebuffers(1, &lowResFBO);
+	GLuint aoLow[2], aoLayers, normalDepthLayers;
+	glGenTextures(2, aoLow);
+	glGenTextures(1, &aoLayers);
+	glGenTextures(1, &normalDepthLayers);
+	int lowResLevel = -1;
 
 	// generate sample kernel
 	// ----------------------
@@ -260,6 +253,44 @@ int main()
 	shaderSSAOBlur.use();
 	shaderSSAOBlur.setInt("ssaoInput", 0);
 
+	shaderDownsample.use();
+	shaderDownsample.setInt("gPosition", 0);
+	shaderDownsample.setInt("gNormal", 1);
+	shaderDownsample.setInt("normalDepth", 2);
+
+	shaderDeinterleave.use();
+	shaderDeinterleave.setInt("normalDepth", 0);
+
+	shaderSSAOLowRes.use();
+	shaderSSAOLowRes.setInt("normalDepth", 0);
+	shaderSSAOLowRes.setInt("normalDepthLayers", 1);
+	shaderSSAOLowRes.setInt("texNoise", 2);
+	shaderSSAOLowRes.setVec3("samples", ssaoKernel[0], 64);
+
+	shaderHBAO.use();
+	shaderHBAO.setInt("normalDepth", 0);
+	shaderHBAO.setInt("normalDepthLayers", 1);
+	shaderHBAO.setInt("texNoise", 2);
+
+	shaderInterleave.use();
+	shaderInterleave.setInt("aoLayers", 0);
+
+	shaderBilateral.use();
+	shaderBilateral.setInt("ssaoInput", 0);
+	shaderBilateral.setInt("normalDepth", 1);
+
+	shaderUpsample.use();
+	shaderUpsample.setInt("ssaoInput", 0);
+	shaderUpsample.setInt("normalDepth", 1);
+
+	// benchmark state: every case is warmed up, timed and then compared against the first (reference) case
+	const int BENCHMARK_WARMUP_FRAMES = 20;
+	const int BENCHMARK_FRAMES = 200;
+	int benchmarkCase = -1;
+	int benchmarkFrame = 0;
+	std::vector<float> referenceImage, benchmarkImage, rawImage;
+	ui_params savedParams;   // the settings the benchmark sweeps over, restored when it is done
+
 	const GLfloat constant  = 1.0f; 
 	const GLfloat linear = 0.09f;
 	const GLfloat quadratic = 0.032f;
@@ -274,6 +305,239 @@ int main()
 	shaderLightingPass.setFloat("light.Linear", linear);
 	shaderLightingPass.setFloat("light.Quadratic", quadratic);
 
+	// frame graph: g-buffer, occlusion and lighting; rebuilt when the occlusion path changes, when the display mode
+	// stops (or starts) showing the occlusion, which culls the occlusion passes, and around the benchmark, which
+	// exports the occlusion for reading it back
+	// ------------------------------------------------------------------------------------------------------------
+	glm::mat4 projection, view;
+	std::vector<int> ssaoPasses;
+	int graphKey = -1;
+	int graphBlur = -1, graphRaw = -1;
+	auto buildGraph = [&](bool pyramidPath, bool benchmark)
+	{
+		graph->Clear();
+		ssaoPasses.clear();
+		// positions are sampled at arbitrary offsets by the kernel, filtering would blend depths across edges
+		int gPosition = graph->Create("gPosition", GL_RGBA16F, 0, GL_NEAREST);
+		int gNormal = graph->Create("gNormal", GL_RGB16F, 0, GL_NEAREST);
+		int gAlbedo = graph->Create("gAlbedo", GL_RGBA8, 0, GL_NEAREST);
+		int depth = graph->Create("depth", GL_DEPTH_COMPONENT24, 0, GL_NEAREST);
+		int ssao = graph->Create("ssao", GL_R8, 0, GL_NEAREST);
+		int ssaoBlur = graph->Create("ssao blur", GL_R8, 0, GL_NEAREST);
+
+		// 1. geometry pass: render scene's geometry/color data into gbuffer
+		// -----------------------------------------------------------------
+		graph->AddPass("geometry", {}, { gPosition, gNormal, gAlbedo, depth }, [&]()
+		{
+			glEnable(GL_DEPTH_TEST);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			shaderGeometryPass.use();
+			shaderGeometryPass.setMat4("projection", projection);
+			shaderGeometryPass.setMat4("view", view);
+			// room cube
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0, 7.0f, 0.0f));
+			model = glm::scale(model, glm::vec3(7.5f, 7.5f, 7.5f));
+			shaderGeometryPass.setMat4("model", model);
+			shaderGeometryPass.setInt("invertedNormals", 1); // invert normals as we're inside the cube
+			renderCube();
+
+			// backpack model on the floor
+			model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 0.0));
+			model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0, 0.0, 0.0));
+			model = glm::scale(model, glm::vec3(1.0f));
+			shaderGeometryPass.setInt("invertedNormals", 0);
+			shaderGeometryPass.setMat4("model", model);
+			backpack.Draw(shaderGeometryPass);
+		});
+
+		if (!pyramidPath)
+		{
+			// 2. generate SSAO texture
+			// ------------------------
+			ssaoPasses.push_back(graph->AddPass("ssao", { gPosition, gNormal }, { ssao }, [&]()
+			{
+				glDisable(GL_DEPTH_TEST);
+				shaderSSAO.use();
+				shaderSSAO.setMat4("projection", projection);
+				shaderSSAO.setInt("kernelSize", params.kernel_size);
+				shaderSSAO.setFloat("radius", params.kernel_radius);
+				shaderSSAO.setFloat("bias", params.kernel_bias);
+				glActiveTexture(GL_TEXTURE2);
+				glBindTexture(GL_TEXTURE_2D, noiseTexture);
+				renderQuad();
+			}));
+
+			// 3. blur SSAO texture to remove noise
+			// ------------------------------------
+			ssaoPasses.push_back(graph->AddPass("ssao blur", { ssao }, { ssaoBlur }, [&]()
+			{
+				shaderSSAOBlur.use();
+				renderQuad();
+				glEnable(GL_DEPTH_TEST);
+			}));
+		}
+		else
+		{
+			// 2. - 3. occlusion on the normal/depth pyramid: the pyramid, the de-interleaved layers and the low
+			//    resolution occlusion are demo owned mip levels and array layers the graph does not describe, so
+			//    they run as one pass that only writes the final occlusion
+			// ---------------------------------------------------------------------------------------------------
+			ssaoPasses.push_back(graph->AddPass("ssao pyramid", { gPosition, gNormal }, { ssaoBlur }, [&, ssaoBlur]()
+			{
+				int level = params.resolution;
+				unsigned int aoWidth = SCR_WIDTH >> level;
+				unsigned int aoHeight = SCR_HEIGHT >> level;
+				glDisable(GL_DEPTH_TEST);
+				glBindFramebuffer(GL_FRAMEBUFFER, lowResFBO);
+
+				// 2.1 normal/depth pyramid down to the AO resolution, sampling only the previous level
+				// -------------------------------------------------------------------------------------
+				shaderDownsample.use();
+				glActiveTexture(GL_TEXTURE2);
+				for (int i = 0; i <= level; ++i)
+				{
+					if (i == 0)
+					{
+						glBindTexture(GL_TEXTURE_2D, 0);
+					}
+					else
+					{
+						glBindTexture(GL_TEXTURE_2D, normalDepth);
+						glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, i - 1);
+						glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, i - 1);
+					}
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, normalDepth, i);
+					glViewport(0, 0, SCR_WIDTH >> i, SCR_HEIGHT >> i);
+					shaderDownsample.setInt("firstLevel", i == 0);
+					renderQuad();
+				}
+				glBindTexture(GL_TEXTURE_2D, normalDepth);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, PYRAMID_LEVELS - 1);
+
+				// 2.2 occlusion at the pyramid level, hemisphere kernel or horizon search
+				// ------------------------------------------------------------------------
+				Shader& shaderAO = params.method == SSAO_HBAO ? shaderHBAO : shaderSSAOLowRes;
+				shaderAO.use();
+				shaderAO.setMat4("projection", projection);
+				shaderAO.setInt("kernelSize", params.kernel_size);
+				shaderAO.setInt("directions", params.hbao_directions);
+				shaderAO.setInt("steps", params.hbao_steps);
+				shaderAO.setFloat("radius", params.kernel_radius);
+				shaderAO.setFloat("bias", params.kernel_bias);
+				float tanHalfFov = tan(glm::radians(camera.Zoom) * 0.5f);
+				shaderAO.setVec2("viewRay", glm::vec2(tanHalfFov * (float)SCR_WIDTH / (float)SCR_HEIGHT, tanHalfFov));
+				shaderAO.setInt("level", level);
+				shaderAO.setVec2("aoSize", glm::vec2((float)aoWidth, (float)aoHeight));
+				shaderAO.setBool("interleaved", params.interleaved);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, normalDepth);
+				glActiveTexture(GL_TEXTURE2);
+				glBindTexture(GL_TEXTURE_2D, noiseTexture);
+				if (params.interleaved)
+				{
+					// split the level into 16 quarter by quarter layers, render the occlusion of every layer with
+					// its own noise vector, then put the layers back together
+					glViewport(0, 0, aoWidth / 4, aoHeight / 4);
+					for (int layer = 0; layer < 16; ++layer)
+					{
+						glm::ivec2 layerOffset(layer % 4, layer / 4);
+						shaderDeinterleave.use();
+						shaderDeinterleave.setInt("level", level);
+						glUniform2i(glGetUniformLocation(shaderDeinterleave.ID, "layerOffset"), layerOffset.x, layerOffset.y);
+						glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, normalDepthLayers, 0, layer);
+						renderQuad();
+					}
+					shaderAO.use();
+					glActiveTexture(GL_TEXTURE1);
+					glBindTexture(GL_TEXTURE_2D_ARRAY, normalDepthLayers);
+					for (int layer = 0; layer < 16; ++layer)
+					{
+						glm::ivec2 layerOffset(layer % 4, layer / 4);
+						shaderAO.setInt("layer", layer);
+						glUniform2i(glGetUniformLocation(shaderAO.ID, "layerOffset"), layerOffset.x, layerOffset.y);
+						glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, aoLayers, 0, layer);
+						renderQuad();
+					}
+
+					glViewport(0, 0, aoWidth, aoHeight);
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, aoLow[0], 0);
+					shaderInterleave.use();
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D_ARRAY, aoLayers);
+					renderQuad();
+				}
+				else
+				{
+					glViewport(0, 0, aoWidth, aoHeight);
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, aoLow[0], 0);
+					renderQuad();
+				}
+
+				// 3.1 depth aware blur at the AO resolution, straight into the final buffer at full resolution
+				// ---------------------------------------------------------------------------------------------
+				if (level == SSAO_FULL)
+					glBindFramebuffer(GL_FRAMEBUFFER, graph->Framebuffer(ssaoBlur));
+				else
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, aoLow[1], 0);
+				shaderBilateral.use();
+				shaderBilateral.setInt("level", level);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, aoLow[0]);
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, normalDepth);
+				renderQuad();
+
+				// 3.2 depth aware upsampling back to full resolution
+				// --------------------------------------------------
+				if (level != SSAO_FULL)
+				{
+					glBindFramebuffer(GL_FRAMEBUFFER, graph->Framebuffer(ssaoBlur));
+					glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+					shaderUpsample.use();
+					shaderUpsample.setInt("level", level);
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D, aoLow[1]);
+					renderQuad();
+				}
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glEnable(GL_DEPTH_TEST);
+			}));
+		}
+		if (benchmark)
+		{
+			if (!pyramidPath)
+				graph->Export(ssao);
+			graph->Export(ssaoBlur);
+		}
+
+		// 4. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion;
+		//    the display modes of the other g-buffer channels don't read the occlusion, which culls its passes
+		// -----------------------------------------------------------------------------------------------------
+		bool showsOcclusion = params.gbuffer_display_mode == 0 || params.gbuffer_display_mode == 5;
+		std::vector<int> reads = { gPosition, gNormal, gAlbedo };
+		if (showsOcclusion)
+			reads.push_back(ssaoBlur);
+		graph->AddPass("lighting", reads, { FrameGraph::BACKBUFFER }, [&, showsOcclusion]()
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			if (!showsOcclusion)
+			{
+				glActiveTexture(GL_TEXTURE3);
+				glBindTexture(GL_TEXTURE_2D, 0);
+				glActiveTexture(GL_TEXTURE0);
+			}
+			shaderLightingPass.use();
+			shaderLightingPass.setInt("gbuffer_display_mode", params.gbuffer_display_mode);
+			shaderLightingPass.setInt("light_attenuation", params.light_attenuation);
+			renderQuad();
+		});
+		graph->Compile();
+		graphBlur = ssaoBlur;
+		graphRaw = pyramidPath ? -1 : ssao;
+	};
+
 
 
 	// render loop
@@ -284,83 +548,130 @@ int main()
 		// -----
 		processInput(window);
 
-        // render
-        // ------
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 1. geometry pass: render scene's geometry/color data into gbuffer
-        // -----------------------------------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		shaderGeometryPass.use();
-		shaderGeometryPass.setMat4("projection", projection);
-		shaderGeometryPass.setMat4("view", view);
-		// room cube
-		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0, 7.0f, 0.0f));
-		model = glm::scale(model, glm::vec3(7.5f, 7.5f, 7.5f));
-		shaderGeometryPass.setMat4("model", model);
-		shaderGeometryPass.setInt("invertedNormals", 1); // invert normals as we're inside the cube
-		renderCube();
-
-		// backpack model on the floor
-		model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 0.0));
-		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0, 0.0, 0.0));
-		model = glm::scale(model, glm::vec3(1.0f));
-		shaderGeometryPass.setInt("invertedNormals", 0);
-		shaderGeometryPass.setMat4("model", model);
-		backpack.Draw(shaderGeometryPass);
-
-		// 2. generate SSAO texture
-		// ------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-		glClear(GL_COLOR_BUFFER_BIT);
-		shaderSSAO.use();
-		shaderSSAO.setMat4("projection", projection);
-		shaderSSAO.setInt("kernelSize", params.kernel_size);
-		shaderSSAO.setFloat("radius", params.kernel_radius);
-		shaderSSAO.setFloat("bias", params.kernel_bias);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gPosition);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, gNormal);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, noiseTexture);
-		renderQuad();
-
-
-		// 3. blur SSAO texture to remove noise
-		// ------------------------------------
-		glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-		glClear(GL_COLOR_BUFFER_BIT);
-		shaderSSAOBlur.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-		renderQuad();
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-
-		// 4. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion
-		// -----------------------------------------------------------------------------------------------------
-		 glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		 shaderLightingPass.use();
-		 shaderLightingPass.setInt("gbuffer_display_mode", params.gbuffer_display_mode);
-		 shaderLightingPass.setInt("light_attenuation", params.light_attenuation);
-	
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, gPosition);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, gNormal);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gAlbedo);
-        glActiveTexture(GL_TEXTURE3); // add extra SSAO texture to lighting pass
-        glBindTexture(GL_TEXTURE_2D, ssaoBlurColorBuffer);
-        renderQuad();
-
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		// start the benchmark, the full resolution reference goes first
+		if (params.run_benchmark && benchmarkCase < 0)
+		{
+			static const BenchmarkCase cases[] = {
+				{ "Kernel 64 (reference)", SSAO_KERNEL, 64, SSAO_FULL, false },
+				{ "Kernel 32", SSAO_KERNEL, 32, SSAO_FULL, false },
+				{ "Kernel 16", SSAO_KERNEL, 16, SSAO_FULL, false },
+				{ "HBAO 4x4", SSAO_HBAO, 16, SSAO_FULL, false },
+				{ "HBAO 8x4", SSAO_HBAO, 32, SSAO_FULL, false },
+				{ "Half", SSAO_KERNEL, 64, SSAO_HALF, false },
+				{ "Half interleaved", SSAO_KERNEL, 64, SSAO_HALF, true },
+				{ "Quarter", SSAO_KERNEL, 64, SSAO_QUARTER, false },
+				{ "Quarter interleaved", SSAO_KERNEL, 64, SSAO_QUARTER, true },
+			};
+			benchmarkCases.assign(cases, cases + IM_ARRAYSIZE(cases));
+			benchmarkCase = 0;
+			benchmarkFrame = 0;
+			savedParams = params;
+		}
+		if (benchmarkCase >= 0)
+		{
+			const BenchmarkCase& current = benchmarkCases[benchmarkCase];
+			params.method = current.method;
+			params.kernel_size = current.method == SSAO_KERNEL ? current.samples : savedParams.kernel_size;
+			params.hbao_directions = current.method == SSAO_HBAO ? current.samples / 4 : savedParams.hbao_directions;
+			params.hbao_steps = current.method == SSAO_HBAO ? 4 : savedParams.hbao_steps;
+			params.resolution = current.resolution;
+			params.interleaved = current.interleaved;
+			if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+				graph->ResetTimings();
+		}
+
+		// everything but the full resolution hemisphere kernel runs on the normal/depth pyramid
+		bool pyramidPath = params.resolution != SSAO_FULL || params.method == SSAO_HBAO;
+		if (pyramidPath && params.resolution != lowResLevel)
+		{
+			allocateLowResTargets(params.resolution, aoLow, aoLayers, normalDepthLayers);
+			lowResLevel = params.resolution;
+		}
+
+		// render
+		// ------
+		bool showsOcclusion = params.gbuffer_display_mode == 0 || params.gbuffer_display_mode == 5;
+		int key = (pyramidPath ? 1 : 0) | (showsOcclusion ? 2 : 0) | (benchmarkCase >= 0 ? 4 : 0);
+		if (key != graphKey)
+		{
+			buildGraph(pyramidPath, benchmarkCase >= 0);
+			graphKey = key;
+		}
+		projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		view = camera.GetViewMatrix();
+		graph->Execute();
+
+		params.ssao_ms = 0.0f;
+		for (size_t i = 0; i < ssaoPasses.size(); ++i)
+			params.ssao_ms += graph->PassMilliseconds(ssaoPasses[i]);
+		params.pass_names.clear();
+		params.pass_ms.clear();
+		for (size_t i = 0; i < graph->Schedule().size(); ++i)
+		{
+			params.pass_names.push_back(graph->PassName(graph->Schedule()[i]));
+			params.pass_ms.push_back(graph->PassMilliseconds(graph->Schedule()[i]));
+		}
+		params.culled_passes = graph->PassCount() - (int)graph->Schedule().size();
+		params.graph_pooled_mb = graph->PooledBytes() / (1024.0f * 1024.0f);
+		if (params.print_timings)
+		{
+			graph->PrintTimings();
+			params.print_timings = false;
+		}
+
+		// finish the current benchmark case: store the timing and compare the occlusion against the reference
+		if (benchmarkCase >= 0 && ++benchmarkFrame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+		{
+			BenchmarkCase& result = benchmarkCases[benchmarkCase];
+			result.ssao_ms = 0.0f;
+			for (size_t i = 0; i < ssaoPasses.size(); ++i)
+				result.ssao_ms += graph->PassAverage(ssaoPasses[i]);
+
+			std::vector<float>& image = benchmarkCase == 0 ? referenceImage : benchmarkImage;
+			image.resize(SCR_WIDTH * SCR_HEIGHT);
+			glBindFramebuffer(GL_FRAMEBUFFER, graph->Framebuffer(graphBlur));
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glReadPixels(0, 0, SCR_WIDTH, SCR_HEIGHT, GL_RED, GL_FLOAT, &image[0]);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			double squaredError = 0.0;
+			for (size_t i = 0; i < image.size(); ++i)
+			{
+				double d = (double)image[i] - (double)referenceImage[i];
+				squaredError += d * d;
+			}
+			result.rmse = (float)sqrt(squaredError / image.size());
+
+			// raw (unblurred) occlusion, only comparable pixel for pixel at full resolution
+			result.noise = 0.0f;
+			if (params.resolution == SSAO_FULL)
+			{
+				rawImage.resize(SCR_WIDTH * SCR_HEIGHT);
+				glBindTexture(GL_TEXTURE_2D, pyramidPath ? aoLow[0] : graph->Texture(graphRaw));
+				glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, &rawImage[0]);
+				squaredError = 0.0;
+				for (size_t i = 0; i < rawImage.size(); ++i)
+				{
+					double d = (double)rawImage[i] - (double)image[i];
+					squaredError += d * d;
+				}
+				result.noise = (float)sqrt(squaredError / rawImage.size());
+			}
+
+			printf("%-22s %2d fetches, ssao %.3f ms, rmse %.4f, noise %.4f\n", result.name, result.samples, result.ssao_ms, result.rmse, result.noise);
+			benchmarkFrame = 0;
+			if (++benchmarkCase == (int)benchmarkCases.size())
+			{
+				benchmarkCase = -1;
+				params.run_benchmark = false;
+				params.method = savedParams.method;
+				params.kernel_size = savedParams.kernel_size;
+				params.hbao_directions = savedParams.hbao_directions;
+				params.hbao_steps = savedParams.hbao_steps;
+				params.resolution = savedParams.resolution;
+				params.interleaved = savedParams.interleaved;
+			}
+		}
+
 
 		imgui_on_render(params);
 
@@ -372,6 +683,7 @@ int main()
 
 
 	// free resources
+	delete graph;
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -381,6 +693,36 @@ int main()
 	return 0;
 }
 
+// allocates the reduced resolution occlusion targets for one pyramid level (1: half, 2: quarter)
+// --------------------------------------------------------------------------------------------
+void allocateLowResTargets(int level, GLuint aoLow[2], GLuint aoLayers, GLuint normalDepthLayers)
+{
+	unsigned int width = SCR_WIDTH >> level;
+	unsigned int height = SCR_HEIGHT >> level;
+	for (int i = 0; i < 2; ++i)
+	{
+		glBindTexture(GL_TEXTURE_2D, aoLow[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	// one layer per position in the 4x4 noise tile
+	GLuint layers[2] = { aoLayers, normalDepthLayers };
+	GLenum formats[2] = { GL_RED, GL_RGBA16F };
+	for (int i = 0; i < 2; ++i)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, layers[i]);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, formats[i], width / 4, height / 4, 16, 0, i == 0 ? GL_RED : GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+}
+
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -656,9 +998,33 @@ void imgui_on_render(ui_params& param)
 	ImGui::Checkbox("Lighting Attenuation", &params.light_attenuation);
 	ImGui::Separator();
 	ImGui::Text("SSAO");
-	ImGui::DragInt("Kernel Size", &params.kernel_size, 1.0f, 1, 128);
+	static const char* method_items[] = { "Hemisphere Kernel", "HBAO" };
+	ImGui::Combo("Method", &params.method, method_items, IM_ARRAYSIZE(method_items));
+	if (params.method == SSAO_KERNEL)
+	{
+		ImGui::DragInt("Kernel Size", &params.kernel_size, 1.0f, 1, 64);
+	}
+	else
+	{
+		ImGui::SliderInt("Directions", &params.hbao_directions, 1, 16);
+		ImGui::SliderInt("Steps", &params.hbao_steps, 1, 16);
+	}
 	ImGui::DragFloat("Kernel Radius", &params.kernel_radius, 0.1f, 0.1f, 2.0f);
 	ImGui::DragFloat("Kernel Bias", &params.kernel_bias, 0.005f, 0.005f, 0.1f);
+	static const char* resolution_items[] = { "Full", "Half", "Quarter" };
+	ImGui::Combo("Resolution", &params.resolution, resolution_items, IM_ARRAYSIZE(resolution_items));
+	if (params.resolution != SSAO_FULL || params.method == SSAO_HBAO)
+		ImGui::Checkbox("Interleaved 4x4", &params.interleaved);
+	ImGui::Text("SSAO: %.3f ms", params.ssao_ms);
+	for (size_t i = 0; i < params.pass_names.size(); ++i)
+		ImGui::Text("%-12s %.3f ms", params.pass_names[i].c_str(), params.pass_ms[i]);
+	ImGui::Text("Culled passes: %d, graph targets: %.1f MB", params.culled_passes, params.graph_pooled_mb);
+	if (ImGui::Button("Print Pass Timings"))
+		params.print_timings = true;
+	if (ImGui::Button("Run Benchmark"))
+		params.run_benchmark = true;
+	for (size_t i = 0; i < benchmarkCases.size(); ++i)
+		ImGui::Text("%-22s %2d fetches %6.3f ms  rmse %.4f  noise %.4f", benchmarkCases[i].name, benchmarkCases[i].samples, benchmarkCases[i].ssao_ms, benchmarkCases[i].rmse, benchmarkCases[i].noise);
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
@@ -11,6 +11,10 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/geometry.h>
+
+#include <chrono>
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
@@ -18,6 +22,15 @@
 
 typedef struct ui_params
 {
+	int grid_size = 7;
+	bool instanced = true;
+	int sphere_mesh = SphereLODs::ICOSPHERE;
+	float max_pixel_error = 0.5f;
+	float submit_ms = 0.0f;
+	int draw_calls = 0;
+	int triangles = 0;
+	float vertex_invocations = 0.0f;
+	int lod_spheres[SphereLODs::LOD_COUNT] = { 0 };
 } ui_params;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -25,7 +38,6 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path);
-void renderSphere();
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -114,15 +126,30 @@ int main()
         glm::vec3(300.0f, 300.0f, 300.0f),
         glm::vec3(300.0f, 300.0f, 300.0f)
     };
-    int nrRows    = 7;
-    int nrColumns = 7;
     float spacing = 2.5;
 
+    // the sphere grid as instances: model matrix and material per sphere, rebuilt when the grid size changes
+    std::vector<PBRInstance> instances;
+    int gridSize = 0;
+    // instanced, the spheres are sorted by LOD into the instance buffer every frame
+    InstanceBuffer* sphereInstances = new InstanceBuffer();
+    std::vector<PBRInstance> sortedInstances;
+    std::vector<int> instanceLODs;
+
+    // all LODs of the sphere meshes in one buffer, picked by the size of each sphere on screen
+    SphereLODs* spheres = new SphereLODs();
+
     // initialize static shader uniforms before rendering
     // --------------------------------------------------
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    float fovY = glm::radians(camera.Zoom);
+    glm::mat4 projection = glm::perspective(fovY, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
     shader.use();
     shader.setMat4("projection", projection);
+    for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+    {
+        shader.setVec3("lightPositions[" + std::to_string(i) + "]", lightPositions[i]);
+        shader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
+    }
 
     // render loop
     // -----------
@@ -148,26 +175,86 @@ int main()
         shader.setMat4("view", view);
         shader.setVec3("camPos", camera.Position);
 
-        // render rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively
+        // render rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively;
+        // every sphere is drawn with the LOD of its size on screen. Instanced it is one draw call per LOD, otherwise one per
+        // sphere with its uniforms; the submit time on the CPU is what the two cost (the GPU work is the same)
+        int nrRows = params.grid_size;
+        int nrColumns = params.grid_size;
+        if (gridSize != params.grid_size)
+        {
+            instances.clear();
+            InstanceBuffer::AppendSphereGrid(instances, nrRows, nrColumns, spacing, glm::vec3(0.5f, 0.0f, 0.0f));
+            gridSize = params.grid_size;
+        }
+        SphereLODs::Kind sphereMesh = (SphereLODs::Kind)params.sphere_mesh;
+        spheres->MaxPixelError = params.max_pixel_error;
+        for (int lod = 0; lod < SphereLODs::LOD_COUNT; ++lod)
+            params.lod_spheres[lod] = 0;
+
+        std::chrono::high_resolution_clock::time_point submitStart = std::chrono::high_resolution_clock::now();
         glm::mat4 model = glm::mat4(1.0f);
-        for (int row = 0; row < nrRows; ++row) 
+        if (params.instanced)
+        {
+            // counting sort of the instances by LOD, each LOD is then a range of the instance buffer
+            instanceLODs.resize(instances.size());
+            for (size_t i = 0; i < instances.size(); ++i)
+            {
+                glm::vec3 center(instances[i].Model[3]);
+                instanceLODs[i] = spheres->Select(sphereMesh, SphereLODs::ProjectedRadius(center, 1.0f, camera.Position, fovY, (float)SCR_HEIGHT));
+                ++params.lod_spheres[instanceLODs[i]];
+            }
+            int first[SphereLODs::LOD_COUNT];
+            int next[SphereLODs::LOD_COUNT];
+            for (int lod = 0, offset = 0; lod < SphereLODs::LOD_COUNT; offset += params.lod_spheres[lod], ++lod)
+                first[lod] = next[lod] = offset;
+            sortedInstances.resize(instances.size());
+            for (size_t i = 0; i < instances.size(); ++i)
+                sortedInstances[next[instanceLODs[i]]++] = instances[i];
+            sphereInstances->Upload(sortedInstances);
+
+            shader.setBool("instanced", true);
+            params.draw_calls = 0;
+            for (int lod = 0; lod < SphereLODs::LOD_COUNT; ++lod)
+            {
+                if (params.lod_spheres[lod] == 0)
+                    continue;
+                spheres->Draw(sphereMesh, lod, sphereInstances, first[lod], params.lod_spheres[lod]);
+                ++params.draw_calls;
+            }
+            shader.setBool("instanced", false);
+        }
+        else
         {
-            shader.setFloat("metallic", (float)row / (float)nrRows);
-            for (int col = 0; col < nrColumns; ++col) 
+            for (int row = 0; row < nrRows; ++row) 
             {
-                // we clamp the roughness to 0.05 - 1.0 as perfectly smooth surfaces (roughness of 0.0) tend to look a bit off
-                // on direct lighting.
-                shader.setFloat("roughness", glm::clamp((float)col / (float)nrColumns, 0.05f, 1.0f));
+                shader.setFloat("metallic", (float)row / (float)nrRows);
+                for (int col = 0; col < nrColumns; ++col) 
+                {
+                    // we clamp the roughness to 0.05 - 1.0 as perfectly smooth surfaces (roughness of 0.0) tend to look a bit off
+                    // on direct lighting.
+                    shader.setFloat("roughness", glm::clamp((float)col / (float)nrColumns, 0.05f, 1.0f));
                 
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(
-                    (col - (nrColumns / 2)) * spacing, 
-                    (row - (nrRows / 2)) * spacing, 
-                    0.0f
-                ));
-                shader.setMat4("model", model);
-                renderSphere();
+                    glm::vec3 position((col - (nrColumns / 2)) * spacing, (row - (nrRows / 2)) * spacing, 0.0f);
+                    model = glm::mat4(1.0f);
+                    model = glm::translate(model, position);
+                    shader.setMat4("model", model);
+                    int lod = spheres->Select(sphereMesh, SphereLODs::ProjectedRadius(position, 1.0f, camera.Position, fovY, (float)SCR_HEIGHT));
+                    ++params.lod_spheres[lod];
+                    spheres->Draw(sphereMesh, lod);
+                }
             }
+            params.draw_calls = nrRows * nrColumns;
+        }
+        params.submit_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - submitStart).count();
+
+        // triangles of the grid and the vertex shader invocations they cost after the post-transform cache
+        params.triangles = 0;
+        params.vertex_invocations = 0.0f;
+        for (int lod = 0; lod < SphereLODs::LOD_COUNT; ++lod)
+        {
+            const SphereLODs::LOD& level = spheres->Level(sphereMesh, lod);
+            params.triangles += params.lod_spheres[lod] * level.Triangles;
+            params.vertex_invocations += params.lod_spheres[lod] * level.Triangles * level.ACMR;
         }
 
         // render light source (simply re-render sphere at light positions)
@@ -175,16 +262,11 @@ int main()
         // keeps the codeprint small.
         for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
         {
-            glm::vec3 newPos = lightPositions[i] + glm::vec3(sin(glfwGetTime() * 5.0) * 5.0, 0.0, 0.0);
-            newPos = lightPositions[i];
-            shader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
-            shader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
-
             model = glm::mat4(1.0f);
-            model = glm::translate(model, newPos);
+            model = glm::translate(model, lightPositions[i]);
             model = glm::scale(model, glm::vec3(0.5f));
             shader.setMat4("model", model);
-            renderSphere();
+            spheres->Draw(sphereMesh, spheres->Select(sphereMesh, SphereLODs::ProjectedRadius(lightPositions[i], 0.5f, camera.Position, fovY, (float)SCR_HEIGHT)));
         }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -194,6 +276,10 @@ int main()
         glfwPollEvents();
     }
 
+    // free resources
+    delete sphereInstances;
+    delete spheres;
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     imgui_on_deinit(window);
@@ -269,103 +355,6 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-// renders (and builds at first invocation) a sphere
-// -------------------------------------------------
-unsigned int sphereVAO = 0;
-unsigned int indexCount;
-void renderSphere()
-{
-    if (sphereVAO == 0)
-    {
-        glGenVertexArrays(1, &sphereVAO);
-
-        unsigned int vbo, ebo;
-        glGenBuffers(1, &vbo);
-        glGenBuffers(1, &ebo);
-
-        std::vector<glm::vec3> positions;
-        std::vector<glm::vec2> uv;
-        std::vector<glm::vec3> normals;
-        std::vector<unsigned int> indices;
-
-        const unsigned int X_SEGMENTS = 64;
-        const unsigned int Y_SEGMENTS = 64;
-        const float PI = 3.14159265359f;
-        for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
-        {
-            for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
-            {
-                float xSegment = (float)x / (float)X_SEGMENTS;
-                float ySegment = (float)y / (float)Y_SEGMENTS;
-                float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-                float yPos = std::cos(ySegment * PI);
-                float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-
-                positions.push_back(glm::vec3(xPos, yPos, zPos));
-                uv.push_back(glm::vec2(xSegment, ySegment));
-                normals.push_back(glm::vec3(xPos, yPos, zPos));
-            }
-        }
-
-        bool oddRow = false;
-        for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
-        {
-            if (!oddRow) // even rows: y == 0, y == 2; and so on
-            {
-                for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
-                {
-                    indices.push_back(y       * (X_SEGMENTS + 1) + x);
-                    indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-                }
-            }
-            else
-            {
-                for (int x = X_SEGMENTS; x >= 0; --x)
-                {
-                    indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-                    indices.push_back(y       * (X_SEGMENTS + 1) + x);
-                }
-            }
-            oddRow = !oddRow;
-        }
-        indexCount = static_cast<unsigned int>(indices.size());
-
-        std::vector<float> data;
-        for (unsigned int i = 0; i < positions.size(); ++i)
-        {
-            data.push_back(positions[i].x);
-            data.push_back(positions[i].y);
-            data.push_back(positions[i].z);           
-            if (normals.size() > 0)
-            {
-                data.push_back(normals[i].x);
-                data.push_back(normals[i].y);
-                data.push_back(normals[i].z);
-            }
-            if (uv.size() > 0)
-            {
-                data.push_back(uv[i].x);
-                data.push_back(uv[i].y);
-            }
-        }
-        glBindVertexArray(sphereVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-        unsigned int stride = (3 + 2 + 3) * sizeof(float);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-        glEnableVertexAttribArray(1);        
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));        
-    }
-
-    glBindVertexArray(sphereVAO);
-    glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
-}
-
 // utility function for loading a 2D texture from file
 // ---------------------------------------------------
 unsigned int loadTexture(char const * path)
@@ -458,6 +447,14 @@ void imgui_on_render(ui_params& param)
 		return;
 	}
 
+	ImGui::SliderInt("grid size", &params.grid_size, 1, 100);
+	ImGui::Checkbox("instanced", &params.instanced);
+	ImGui::Combo("sphere mesh", &params.sphere_mesh, "UV sphere\0icosphere\0cube sphere\0");
+	ImGui::SliderFloat("LOD max pixel error", &params.max_pixel_error, 0.1f, 4.0f);
+	ImGui::Text("CPU submit: %.3f ms for %d spheres in %d draw call%s", params.submit_ms, params.grid_size * params.grid_size, params.draw_calls, params.draw_calls > 1 ? "s" : "");
+	ImGui::Text("triangles: %d, vertex shader invocations: ~%.0f", params.triangles, params.vertex_invocations);
+	ImGui::Text("spheres per LOD: %d %d %d %d %d %d", params.lod_spheres[0], params.lod_spheres[1], params.lod_spheres[2],
+		params.lod_spheres[3], params.lod_spheres[4], params.lod_spheres[5]);
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
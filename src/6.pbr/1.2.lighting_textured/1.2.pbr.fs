@@ -4,9 +4,12 @@ in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
 
-// material parameters
+// material parameters, packed (see pbr_material.h): normal holds x and y only, ORM is ao, roughness, metallic
 uniform sampler2D albedoMap;
 uniform sampler2D normalMap;
+uniform sampler2D ormMap;
+// the five separate maps, for comparison with the packed layout
+uniform bool packedMaterial;
 uniform sampler2D metallicMap;
 uniform sampler2D roughnessMap;
 uniform sampler2D aoMap;
@@ -26,7 +29,14 @@ const float PI = 3.14159265359;
 // technique somewhere later in the normal mapping tutorial.
 vec3 getNormalFromMap()
 {
-    vec3 tangentNormal = texture(normalMap, TexCoords).xyz * 2.0 - 1.0;
+    vec3 tangentNormal;
+    if (packedMaterial)
+    {
+        tangentNormal.xy = texture(normalMap, TexCoords).rg * 2.0 - 1.0;
+        tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+    }
+    else
+        tangentNormal = texture(normalMap, TexCoords).xyz * 2.0 - 1.0;
 
     vec3 Q1  = dFdx(WorldPos);
     vec3 Q2  = dFdy(WorldPos);
@@ -83,9 +93,20 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
 void main()
 {
     vec3 albedo = pow(texture(albedoMap, TexCoords).rgb, vec3(2.2));
-    float metallic = texture(metallicMap, TexCoords).r;
-    float roughness = texture(roughnessMap, TexCoords).r;
-    float ao = texture(aoMap, TexCoords).r;
+    float metallic, roughness, ao;
+    if (packedMaterial)
+    {
+        vec3 orm = texture(ormMap, TexCoords).rgb;
+        ao = orm.r;
+        roughness = orm.g;
+        metallic = orm.b;
+    }
+    else
+    {
+        metallic = texture(metallicMap, TexCoords).r;
+        roughness = texture(roughnessMap, TexCoords).r;
+        ao = texture(aoMap, TexCoords).r;
+    }
 
     vec3 N = getNormalFromMap();
     vec3 V = normalize(camPos - WorldPos);
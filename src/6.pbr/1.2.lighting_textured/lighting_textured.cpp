@@ -11,6 +11,8 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/pbr_material.h>
+#include <learnopengl/gpu_timer.h>
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
@@ -18,13 +20,16 @@
 
 typedef struct ui_params
 {
+	bool packed = true;
+	float spheres_ms = 0.0f;
+	float packed_mb = 0.0f;
+	float separate_mb = 0.0f;
 } ui_params;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
-unsigned int loadTexture(const char *path);
 void renderSphere();
 
 void imgui_on_init(GLFWwindow* window);
@@ -96,13 +101,17 @@ int main()
     // -------------------------
     Shader shader("1.2.pbr.vs", "1.2.pbr.fs");
 
-    // load PBR material textures
-    // --------------------------
-    unsigned int albedo    = loadTexture("res/textures/pbr/rusted_iron/albedo.png");
-    unsigned int normal    = loadTexture("res/textures/pbr/rusted_iron/normal.png");
-    unsigned int metallic  = loadTexture("res/textures/pbr/rusted_iron/metallic.png");
-    unsigned int roughness = loadTexture("res/textures/pbr/rusted_iron/roughness.png");
-    unsigned int ao        = loadTexture("res/textures/pbr/rusted_iron/ao.png");
+    // load PBR material textures: packed into albedo, normal (RG) and ORM (see pbr_material.h), and the five
+    // separate maps to compare memory and frame time against
+    // ------------------------------------------------------------------------------------------------------
+    PBRMaterial* packedMaterial = new PBRMaterial();
+    PBRMaterial* separateMaterial = new PBRMaterial();
+    packedMaterial->Load("res/textures/pbr/rusted_iron");
+    separateMaterial->Load("res/textures/pbr/rusted_iron", false);
+    params.packed_mb = packedMaterial->TextureBytes / (1024.0f * 1024.0f);
+    params.separate_mb = separateMaterial->TextureBytes / (1024.0f * 1024.0f);
+    GpuTimer* spheresTimer = new GpuTimer();
+    bool timedPacked = params.packed;
 
     // lights
     // ------
@@ -121,6 +130,7 @@ int main()
     shader.use();
     shader.setInt("albedoMap", 0);
     shader.setInt("normalMap", 1);
+    shader.setInt("ormMap", 2);
     shader.setInt("metallicMap", 2);
     shader.setInt("roughnessMap", 3);
     shader.setInt("aoMap", 4);
@@ -151,16 +161,20 @@ int main()
         shader.setMat4("view", view);
         shader.setVec3("camPos", camera.Position);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, albedo);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normal);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, metallic);
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, roughness);
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, ao);
+        // ormMap and metallicMap share unit 2, the shader reads one or the other
+        shader.setBool("packedMaterial", params.packed);
+        if (params.packed)
+            packedMaterial->Bind(0);
+        else
+            separateMaterial->Bind(0);
+
+        // average GPU time of the sphere grid since the layout was last switched
+        if (timedPacked != params.packed)
+        {
+            spheresTimer->Reset();
+            timedPacked = params.packed;
+        }
+        spheresTimer->Begin();
 
         // render rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively
         glm::mat4 model = glm::mat4(1.0f);
@@ -183,6 +197,8 @@ int main()
                 renderSphere();
             }
         }
+        spheresTimer->End();
+        params.spheres_ms = spheresTimer->Average();
 
         // render light source (simply re-render sphere at light positions)
         // this looks a bit off as we use the same shader, but it'll make their positions obvious and 
@@ -208,6 +224,11 @@ int main()
         glfwPollEvents();
     }
 
+    // free resources
+    delete spheresTimer;
+    delete packedMaterial;
+    delete separateMaterial;
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     imgui_on_deinit(window);
@@ -380,46 +401,6 @@ void renderSphere()
     glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
 }
 
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
-unsigned int loadTexture(char const * path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(FileSystem::getPath(path).c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-
 void imgui_on_init(GLFWwindow* window)
 {
 	// Setup Dear ImGui context
@@ -472,6 +453,10 @@ void imgui_on_render(ui_params& param)
 		return;
 	}
 
+	ImGui::Checkbox("packed material (ORM)", &params.packed);
+	ImGui::Text("textures: %d, %.1f MB (separate %.1f MB, packed %.1f MB)", params.packed ? 3 : 5,
+		params.packed ? params.packed_mb : params.separate_mb, params.separate_mb, params.packed_mb);
+	ImGui::Text("spheres GPU: %.3f ms", params.spheres_ms);
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
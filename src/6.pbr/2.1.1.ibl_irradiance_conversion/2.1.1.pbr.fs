@@ -4,11 +4,11 @@ in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
 
-// material parameters
-uniform vec3 albedo;
-uniform float metallic;
-uniform float roughness;
-uniform float ao;
+// material parameters, from the uniforms or the instance buffer (see pbr.vs)
+flat in vec3 Albedo;
+flat in float Metallic;
+flat in float Roughness;
+flat in float AO;
 
 // lights
 uniform vec3 lightPositions[4];
@@ -59,6 +59,11 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
 
 void main()
 {
+    vec3 albedo = Albedo;
+    float metallic = Metallic;
+    float roughness = Roughness;
+    float ao = AO;
+
     vec3 N = normalize(Normal);
     vec3 V = normalize(camPos - WorldPos);
 
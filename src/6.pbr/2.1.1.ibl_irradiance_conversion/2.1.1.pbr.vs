@@ -2,20 +2,42 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// per-instance model matrix and material, see InstanceBuffer
+layout (location = 3) in mat4 aInstanceModel;
+layout (location = 7) in vec4 aInstanceAlbedoMetallic;
+layout (location = 8) in vec2 aInstanceRoughnessAO;
 
 out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
+flat out vec3 Albedo;
+flat out float Metallic;
+flat out float Roughness;
+flat out float AO;
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
 
+// material parameters of single (non-instanced) draws
+uniform vec3 albedo;
+uniform float metallic;
+uniform float roughness;
+uniform float ao;
+
+uniform bool instanced;   // take model and material from the instance attributes instead of the uniforms
+
 void main()
 {
+    mat4 instanceModel = instanced ? aInstanceModel : model;
+    Albedo    = instanced ? aInstanceAlbedoMetallic.rgb : albedo;
+    Metallic  = instanced ? aInstanceAlbedoMetallic.a : metallic;
+    Roughness = instanced ? aInstanceRoughnessAO.x : roughness;
+    AO        = instanced ? aInstanceRoughnessAO.y : ao;
+
     TexCoords = aTexCoords;
-    WorldPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(model) * aNormal;   
+    WorldPos = vec3(instanceModel * vec4(aPos, 1.0));
+    Normal = mat3(instanceModel) * aNormal;   
 
     gl_Position =  projection * view * vec4(WorldPos, 1.0);
 }
\ No newline at end of file
@@ -10,7 +10,10 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/hdr_image.h>
 #include <learnopengl/model.h>
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/geometry.h>
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
@@ -26,7 +29,6 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path, bool hdr = false);
 void renderCube();
-void renderSphere();
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -120,6 +122,15 @@ int main()
 	int nrColumns = 7;
 	float spacing = 2.5;
 
+	// the sphere grid as instances with their model matrix and material, drawn with a single instanced call
+	std::vector<PBRInstance> sphereGrid;
+	InstanceBuffer::AppendSphereGrid(sphereGrid, nrRows, nrColumns, spacing, glm::vec3(0.5f, 0.0f, 0.0f));
+	InstanceBuffer* sphereInstances = new InstanceBuffer();
+	sphereInstances->Upload(sphereGrid);
+
+	// sphere meshes shared by the 6.pbr demos, the LOD follows the size of the spheres on screen
+	SphereLODs* spheres = new SphereLODs();
+
 	// pbr: setup framebuffer
 	// ----------------------
 	unsigned int captureFBO, captureRBO;
@@ -133,9 +144,8 @@ int main()
 
 	// pbr: load the HDR environment map
 	// ---------------------------------
-	stbi_set_flip_vertically_on_load(true);
-
-	unsigned int hdrTexture = loadTexture("res/textures/hdr/newport_loft.hdr", true);
+	// decoded in parallel straight to half floats, bottom row first like stbi_set_flip_vertically_on_load(true)
+	unsigned int hdrTexture = HDRImage::LoadTexture(FileSystem::getPath("res/textures/hdr/newport_loft.hdr"));
 
 	// pbr: setup cubemap to render to and attach to framebuffer
 	// ---------------------------------------------------------
@@ -229,26 +239,10 @@ int main()
 		pbrShader.setVec3("camPos", camera.Position);
 
 		// render rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively
-		glm::mat4 model = glm::mat4(1.0f);
-		for (int row = 0; row < nrRows; ++row)
-		{
-			pbrShader.setFloat("metallic", (float)row / (float)nrRows);
-			for (int col = 0; col < nrColumns; ++col)
-			{
-				// we clamp the roughness to 0.05 - 1.0 as perfectly smooth surfaces (roughness of 0.0) tend to look a bit off
-				// on direct lighting.
-				pbrShader.setFloat("roughness", glm::clamp((float)col / (float)nrColumns, 0.05f, 1.0f));
-
-				model = glm::mat4(1.0f);
-				model = glm::translate(model, glm::vec3(
-					(col - (nrColumns / 2)) * spacing,
-					(row - (nrRows / 2)) * spacing,
-					0.0f
-				));
-				pbrShader.setMat4("model", model);
-				renderSphere();
-			}
-		}
+		pbrShader.setBool("instanced", true);
+		float fovY = glm::radians(camera.Zoom);
+		spheres->Draw(SphereLODs::ICOSPHERE, spheres->SelectInstanced(SphereLODs::ICOSPHERE, sphereGrid, camera.Position, fovY, (float)SCR_HEIGHT), sphereInstances);
+		pbrShader.setBool("instanced", false);
 
 		// render light source (simply re-render sphere at light positions)
 		// this looks a bit off as we use the same shader, but it'll make their positions obvious and 
@@ -260,11 +254,11 @@ int main()
 			pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
 			pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
 
-			model = glm::mat4(1.0f);
+			glm::mat4 model = glm::mat4(1.0f);
 			model = glm::translate(model, newPos);
 			model = glm::scale(model, glm::vec3(0.5f));
 			pbrShader.setMat4("model", model);
-			renderSphere();
+			spheres->Draw(SphereLODs::ICOSPHERE, spheres->Select(SphereLODs::ICOSPHERE, SphereLODs::ProjectedRadius(newPos, 0.5f, camera.Position, fovY, (float)SCR_HEIGHT)));
 		}
 
         // render skybox (render as last to prevent overdraw)
@@ -289,6 +283,10 @@ int main()
 		glfwPollEvents();
 	}
 
+	// free resources
+	delete sphereInstances;
+	delete spheres;
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	imgui_on_deinit(window);
@@ -364,103 +362,6 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-// renders (and builds at first invocation) a sphere
-// -------------------------------------------------
-unsigned int sphereVAO = 0;
-unsigned int indexCount;
-void renderSphere()
-{
-	if (sphereVAO == 0)
-	{
-		glGenVertexArrays(1, &sphereVAO);
-
-		unsigned int vbo, ebo;
-		glGenBuffers(1, &vbo);
-		glGenBuffers(1, &ebo);
-
-		std::vector<glm::vec3> positions;
-		std::vector<glm::vec2> uv;
-		std::vector<glm::vec3> normals;
-		std::vector<unsigned int> indices;
-
-		const unsigned int X_SEGMENTS = 64;
-		const unsigned int Y_SEGMENTS = 64;
-		const float PI = 3.14159265359f;
-		for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
-		{
-			for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
-			{
-				float xSegment = (float)x / (float)X_SEGMENTS;
-				float ySegment = (float)y / (float)Y_SEGMENTS;
-				float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-				float yPos = std::cos(ySegment * PI);
-				float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-
-				positions.push_back(glm::vec3(xPos, yPos, zPos));
-				uv.push_back(glm::vec2(xSegment, ySegment));
-				normals.push_back(glm::vec3(xPos, yPos, zPos));
-			}
-		}
-
-		bool oddRow = false;
-		for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
-		{
-			if (!oddRow) // even rows: y == 0, y == 2; and so on
-			{
-				for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
-				{
-					indices.push_back(y * (X_SEGMENTS + 1) + x);
-					indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-				}
-			}
-			else
-			{
-				for (int x = X_SEGMENTS; x >= 0; --x)
-				{
-					indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-					indices.push_back(y * (X_SEGMENTS + 1) + x);
-				}
-			}
-			oddRow = !oddRow;
-		}
-		indexCount = static_cast<unsigned int>(indices.size());
-
-		std::vector<float> data;
-		for (unsigned int i = 0; i < positions.size(); ++i)
-		{
-			data.push_back(positions[i].x);
-			data.push_back(positions[i].y);
-			data.push_back(positions[i].z);
-			if (normals.size() > 0)
-			{
-				data.push_back(normals[i].x);
-				data.push_back(normals[i].y);
-				data.push_back(normals[i].z);
-			}
-			if (uv.size() > 0)
-			{
-				data.push_back(uv[i].x);
-				data.push_back(uv[i].y);
-			}
-		}
-		glBindVertexArray(sphereVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-		unsigned int stride = (3 + 2 + 3) * sizeof(float);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-	}
-
-	glBindVertexArray(sphereVAO);
-	glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
-}
-
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -4,14 +4,16 @@ in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
 
-// material parameters
-uniform vec3 albedo;
-uniform float metallic;
-uniform float roughness;
-uniform float ao;
+// material parameters, from the uniforms or the instance buffer (see pbr.vs)
+flat in vec3 Albedo;
+flat in float Metallic;
+flat in float Roughness;
+flat in float AO;
 
 // IBL
 uniform samplerCube irradianceMap;
+uniform bool useSH;
+uniform vec3 shCoefficients[9];
 
 // lights
 uniform vec3 lightPositions[4];
@@ -21,6 +23,17 @@ uniform vec3 camPos;
 
 const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
+// irradiance / PI from 9 spherical harmonics coefficients (see spherical_harmonics.h),
+// a few multiply-adds in place of the irradiance map fetch
+vec3 IrradianceSH(vec3 n)
+{
+    vec3 irradiance = shCoefficients[0]
+        + shCoefficients[1] * n.y + shCoefficients[2] * n.z + shCoefficients[3] * n.x
+        + shCoefficients[4] * (n.x * n.y) + shCoefficients[5] * (n.y * n.z) + shCoefficients[6] * (3.0 * n.z * n.z - 1.0)
+        + shCoefficients[7] * (n.x * n.z) + shCoefficients[8] * (n.x * n.x - n.y * n.y);
+    return max(irradiance, vec3(0.0));
+}
+// ----------------------------------------------------------------------------
 float DistributionGGX(vec3 N, vec3 H, float roughness)
 {
     float a = roughness*roughness;
@@ -69,6 +82,11 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 // ----------------------------------------------------------------------------
 void main()
 {		
+    vec3 albedo = Albedo;
+    float metallic = Metallic;
+    float roughness = Roughness;
+    float ao = AO;
+
     vec3 N = Normal;
     vec3 V = normalize(camPos - WorldPos);
     vec3 R = reflect(-V, N); 
@@ -120,7 +138,7 @@ void main()
     vec3 kS = fresnelSchlickRoughness(max(dot(N, V), 0.0), F0, roughness);
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;	  
-    vec3 irradiance = texture(irradianceMap, N).rgb;
+    vec3 irradiance = useSH ? IrradianceSH(N) : texture(irradianceMap, N).rgb;
     vec3 diffuse      = irradiance * albedo;
     // vec3 ambient = vec3(0.03);
     vec3 ambient = (kD * diffuse) * ao;
@@ -10,7 +10,12 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/hdr_image.h>
 #include <learnopengl/model.h>
+#include <learnopengl/ibl_cache.h>
+#include <learnopengl/spherical_harmonics.h>
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/geometry.h>
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
@@ -19,6 +24,14 @@
 typedef struct ui_params
 {
 	bool show_irradiance_map = false;
+	bool ibl_cached = false;
+	float ibl_ms = 0.0f;
+	bool use_sh = false;
+	bool time_convolution = false;
+	float sh_ms = 0.0f;
+	float convolution_ms = 0.0f;
+	float sh_rms_error = 0.0f;
+	float sh_max_error = 0.0f;
 } ui_params;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -27,7 +40,9 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path, bool hdr = false);
 void renderCube();
-void renderSphere();
+SH9 projectEnvironment(unsigned int envCubemap, float* milliseconds);
+void measureSHError(unsigned int irradianceMap, const SH9& sh, float* rmsError, float* maxError);
+float timeIrradianceConvolution(Shader& irradianceShader, unsigned int envCubemap);
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -39,6 +54,7 @@ const unsigned int SCR_HEIGHT = 720;
 
 const unsigned int CUBE_MAP_SIZE = 512;
 const unsigned int IRRADIANCE_MAP_SIZE = 32;
+const unsigned int SH_SOURCE_MIP = 3; // 64x64 faces, plenty for 9 coefficients
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 10.0f));
@@ -123,110 +139,149 @@ int main()
 	int nrColumns = 7;
 	float spacing = 2.5;
 
-	// pbr: setup framebuffer
-	// ----------------------
-	unsigned int captureFBO, captureRBO;
-	glGenFramebuffers(1, &captureFBO);
-	glGenRenderbuffers(1, &captureRBO);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-
-	// pbr: load the HDR environment map
-	// ---------------------------------
-	stbi_set_flip_vertically_on_load(true);
-
-	unsigned int hdrTexture = loadTexture("res/textures/hdr/newport_loft.hdr", true);
-
-	// pbr: setup cubemap to render to and attach to framebuffer
-	// ---------------------------------------------------------
-	unsigned int envCubemap;
-	glGenTextures(1, &envCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-	for (unsigned int i = 0; i < 6; ++i)
+	// the sphere grid as instances with their model matrix and material, drawn with a single instanced call
+	std::vector<PBRInstance> sphereGrid;
+	InstanceBuffer::AppendSphereGrid(sphereGrid, nrRows, nrColumns, spacing, glm::vec3(0.5f, 0.0f, 0.0f));
+	InstanceBuffer* sphereInstances = new InstanceBuffer();
+	sphereInstances->Upload(sphereGrid);
+
+	// sphere meshes shared by the 6.pbr demos, the LOD follows the size of the spheres on screen
+	SphereLODs* spheres = new SphereLODs();
+
+	// pbr: load the IBL maps from the cache next to the HDR file, bake them and fill the cache when it misses
+	// -------------------------------------------------------------------------------------------------------
+	double iblStart = glfwGetTime();
+	IBLCache iblCache("res/textures/hdr/newport_loft.hdr");
+	int envCache = iblCache.Add("environment", GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, CUBE_MAP_SIZE, IBLCache::MipCount(CUBE_MAP_SIZE));
+	int irradianceCache = iblCache.Add("irradiance", GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, IRRADIANCE_MAP_SIZE, 1);
+	params.ibl_cached = iblCache.Load();
+	if (!params.ibl_cached)
 	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, CUBE_MAP_SIZE, CUBE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
-	// ----------------------------------------------------------------------------------------------
-	glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-	glm::mat4 captureViews[] =
-	{
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-	};
+		// pbr: setup framebuffer
+		// ----------------------
+		unsigned int captureFBO, captureRBO;
+		glGenFramebuffers(1, &captureFBO);
+		glGenRenderbuffers(1, &captureRBO);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+
+		// pbr: load the HDR environment map
+		// ---------------------------------
+		// decoded in parallel straight to half floats, bottom row first like stbi_set_flip_vertically_on_load(true)
+		unsigned int hdrTexture = HDRImage::LoadTexture(FileSystem::getPath("res/textures/hdr/newport_loft.hdr"));
+
+		// pbr: setup cubemap to render to and attach to framebuffer
+		// ---------------------------------------------------------
+		unsigned int envCubemap;
+		glGenTextures(1, &envCubemap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, CUBE_MAP_SIZE, CUBE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
+		// ----------------------------------------------------------------------------------------------
+		glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+		glm::mat4 captureViews[] =
+		{
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+		};
 
-	// pbr: convert HDR equirectangular environment map to cubemap equivalent
-	equirectangularToCubemapShader.use();
-	equirectangularToCubemapShader.setInt("equirectangularMap", 0);
-	equirectangularToCubemapShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, hdrTexture);
+		// pbr: convert HDR equirectangular environment map to cubemap equivalent
+		equirectangularToCubemapShader.use();
+		equirectangularToCubemapShader.setInt("equirectangularMap", 0);
+		equirectangularToCubemapShader.setMat4("projection", captureProjection);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hdrTexture);
 
-	glViewport(0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE); // don't forget to configure the viewport to the capture dimensions.
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		equirectangularToCubemapShader.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glViewport(0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE); // don't forget to configure the viewport to the capture dimensions.
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			equirectangularToCubemapShader.setMat4("view", captureViews[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		renderCube();
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			renderCube();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	// pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
-    // --------------------------------------------------------------------------------
-	unsigned int irradianceMap;
-	glGenTextures(1, &irradianceMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
+	    // --------------------------------------------------------------------------------
+		unsigned int irradianceMap;
+		glGenTextures(1, &irradianceMap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
+
+		// pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
+		// -----------------------------------------------------------------------------
+		irradianceShader.use();
+		irradianceShader.setInt("environmentMap", 0);
+		irradianceShader.setMat4("projection", captureProjection);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
-	
-	// pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
-	// -----------------------------------------------------------------------------
-	irradianceShader.use();
-	irradianceShader.setInt("environmentMap", 0);
-	irradianceShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		glViewport(0, 0, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			irradianceShader.setMat4("view", captureViews[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glViewport(0, 0, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		irradianceShader.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderCube();
+		}
 
-		renderCube();
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// hand the baked maps to the cache and write it for the next startup
+		iblCache.SetTexture(envCache, envCubemap);
+		iblCache.SetTexture(irradianceCache, irradianceMap);
+		if (!iblCache.Save())
+			std::cout << "Failed to write IBL cache: " << iblCache.CachePath << std::endl;
+		glDeleteTextures(1, &hdrTexture);
+		glDeleteFramebuffers(1, &captureFBO);
+		glDeleteRenderbuffers(1, &captureRBO);
 	}
+	unsigned int envCubemap = iblCache.Texture(envCache);
+	unsigned int irradianceMap = iblCache.Texture(irradianceCache);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// startup cost of the IBL maps, finish so the GPU side of the bake or upload is included
+	glFinish();
+	params.ibl_ms = static_cast<float>((glfwGetTime() - iblStart) * 1000.0);
+	std::cout << "IBL maps " << (params.ibl_cached ? "loaded from cache" : "baked") << " in " << params.ibl_ms << " ms (" << iblCache.CachePath << ", " << iblCache.FileBytes / (1024 * 1024) << " MB)" << std::endl;
 
+	// pbr: project the environment onto 9 SH coefficients, the texture free alternative to the irradiance map
+	// -------------------------------------------------------------------------------------------------------
+	SH9 sh = projectEnvironment(envCubemap, &params.sh_ms);
+	measureSHError(irradianceMap, sh, &params.sh_rms_error, &params.sh_max_error);
+	std::cout << "SH9 projection in " << params.sh_ms << " ms, error against the irradiance map " << params.sh_rms_error * 100.0f << "% rms, " << params.sh_max_error * 100.0f << "% max" << std::endl;
 
 	// initialize static shader uniforms before rendering
 	// --------------------------------------------------
@@ -237,6 +292,7 @@ int main()
 	pbrShader.setFloat("ao", 1.0f);
 	pbrShader.setMat4("projection", projection);
 	pbrShader.setInt("irradianceMap", 0);
+	sh.SetUniforms(pbrShader);
 
 	backgroundShader.use();
 	backgroundShader.setInt("environmentMap", 0);
@@ -267,38 +323,33 @@ int main()
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// time the convolution bake against the SH projection on request, both include their GPU work
+		if (params.time_convolution)
+		{
+			params.convolution_ms = timeIrradianceConvolution(irradianceShader, envCubemap);
+			sh = projectEnvironment(envCubemap, &params.sh_ms);
+			std::cout << "irradiance convolution " << params.convolution_ms << " ms, SH9 projection " << params.sh_ms << " ms" << std::endl;
+			params.time_convolution = false;
+			glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+		}
+
 		// render scene, supplying the convoluted irradiance map to the final shader.
 		// ------------------------------------------------------------------------------------------
 		pbrShader.use();
 		glm::mat4 view = camera.GetViewMatrix();
 		pbrShader.setMat4("view", view);
 		pbrShader.setVec3("camPos", camera.Position);
+		pbrShader.setBool("useSH", params.use_sh);
 
 		// bind pre-computed IBL data
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
 
 		// render rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively
-		glm::mat4 model = glm::mat4(1.0f);
-		for (int row = 0; row < nrRows; ++row)
-		{
-			pbrShader.setFloat("metallic", (float)row / (float)nrRows);
-			for (int col = 0; col < nrColumns; ++col)
-			{
-				// we clamp the roughness to 0.05 - 1.0 as perfectly smooth surfaces (roughness of 0.0) tend to look a bit off
-				// on direct lighting.
-				pbrShader.setFloat("roughness", glm::clamp((float)col / (float)nrColumns, 0.05f, 1.0f));
-
-				model = glm::mat4(1.0f);
-				model = glm::translate(model, glm::vec3(
-					(col - (nrColumns / 2)) * spacing,
-					(row - (nrRows / 2)) * spacing,
-					0.0f
-				));
-				pbrShader.setMat4("model", model);
-				renderSphere();
-			}
-		}
+		pbrShader.setBool("instanced", true);
+		float fovY = glm::radians(camera.Zoom);
+		spheres->Draw(SphereLODs::ICOSPHERE, spheres->SelectInstanced(SphereLODs::ICOSPHERE, sphereGrid, camera.Position, fovY, (float)SCR_HEIGHT), sphereInstances);
+		pbrShader.setBool("instanced", false);
 
 		// render light source (simply re-render sphere at light positions)
 		// this looks a bit off as we use the same shader, but it'll make their positions obvious and 
@@ -310,11 +361,11 @@ int main()
 			pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
 			pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
 
-			model = glm::mat4(1.0f);
+			glm::mat4 model = glm::mat4(1.0f);
 			model = glm::translate(model, newPos);
 			model = glm::scale(model, glm::vec3(0.5f));
 			pbrShader.setMat4("model", model);
-			renderSphere();
+			spheres->Draw(SphereLODs::ICOSPHERE, spheres->Select(SphereLODs::ICOSPHERE, SphereLODs::ProjectedRadius(newPos, 0.5f, camera.Position, fovY, (float)SCR_HEIGHT)));
 		}
 
         // render skybox (render as last to prevent overdraw)
@@ -342,6 +393,10 @@ int main()
 		glfwPollEvents();
 	}
 
+	// free resources
+	delete sphereInstances;
+	delete spheres;
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	imgui_on_deinit(window);
@@ -349,6 +404,113 @@ int main()
 	return 0;
 }
 
+// reads a low mip of the environment cubemap back and projects it onto SH9, the time includes the readback
+// ---------------------------------------------------------------------------------------------------------
+SH9 projectEnvironment(unsigned int envCubemap, float* milliseconds)
+{
+	glFinish();
+	double start = glfwGetTime();
+
+	int size = CUBE_MAP_SIZE >> SH_SOURCE_MIP;
+	std::vector<float> texels(6 * size * size * 4);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+	for (unsigned int i = 0; i < 6; ++i)
+		glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, SH_SOURCE_MIP, GL_RGBA, GL_FLOAT, &texels[i * size * size * 4]);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	SH9 sh = SH9::ProjectCubemap(&texels[0], size);
+
+	*milliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0);
+	return sh;
+}
+
+// relative error of the SH irradiance against the convolved irradiance map over all of its texels: rms over the
+// whole map and the largest per texel luminance error
+// -----------------------------------------------------------------------------------------------------------------
+void measureSHError(unsigned int irradianceMap, const SH9& sh, float* rmsError, float* maxError)
+{
+	int size = IRRADIANCE_MAP_SIZE;
+	std::vector<float> texels(size * size * 3);
+	const glm::vec3 luma(0.2126f, 0.7152f, 0.0722f);
+	double squaredError = 0.0;
+	double squaredReference = 0.0;
+	*maxError = 0.0f;
+	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+	for (int face = 0; face < 6; ++face)
+	{
+		glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, GL_FLOAT, &texels[0]);
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				float s = (x + 0.5f) * 2.0f / size - 1.0f;
+				float t = (y + 0.5f) * 2.0f / size - 1.0f;
+				glm::vec3 reference = glm::make_vec3(&texels[(y * size + x) * 3]);
+				glm::vec3 difference = sh.Evaluate(SH9::CubemapDirection(face, s, t)) - reference;
+				squaredError += glm::dot(difference, difference);
+				squaredReference += glm::dot(reference, reference);
+				float luminance = glm::dot(reference, luma);
+				if (luminance > 0.0f)
+					*maxError = glm::max(*maxError, glm::abs(glm::dot(difference, luma)) / luminance);
+			}
+		}
+	}
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	*rmsError = squaredReference > 0.0 ? static_cast<float>(std::sqrt(squaredError / squaredReference)) : 0.0f;
+}
+
+// runs the irradiance convolution once more into a scratch cubemap, the GPU side of the bake that SH9 replaces
+// ------------------------------------------------------------------------------------------------------------
+float timeIrradianceConvolution(Shader& irradianceShader, unsigned int envCubemap)
+{
+	glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+	glm::mat4 captureViews[] =
+	{
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+	};
+
+	unsigned int captureFBO, captureRBO, scratchMap;
+	glGenFramebuffers(1, &captureFBO);
+	glGenRenderbuffers(1, &captureRBO);
+	glGenTextures(1, &scratchMap);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, scratchMap);
+	for (unsigned int i = 0; i < 6; ++i)
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+	glFinish();
+	double start = glfwGetTime();
+
+	irradianceShader.use();
+	irradianceShader.setInt("environmentMap", 0);
+	irradianceShader.setMat4("projection", captureProjection);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+	glViewport(0, 0, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		irradianceShader.setMat4("view", captureViews[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, scratchMap, 0);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		renderCube();
+	}
+	glFinish();
+	float milliseconds = static_cast<float>((glfwGetTime() - start) * 1000.0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &captureFBO);
+	glDeleteRenderbuffers(1, &captureRBO);
+	glDeleteTextures(1, &scratchMap);
+	return milliseconds;
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow* window)
@@ -417,103 +579,6 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-// renders (and builds at first invocation) a sphere
-// -------------------------------------------------
-unsigned int sphereVAO = 0;
-unsigned int indexCount;
-void renderSphere()
-{
-	if (sphereVAO == 0)
-	{
-		glGenVertexArrays(1, &sphereVAO);
-
-		unsigned int vbo, ebo;
-		glGenBuffers(1, &vbo);
-		glGenBuffers(1, &ebo);
-
-		std::vector<glm::vec3> positions;
-		std::vector<glm::vec2> uv;
-		std::vector<glm::vec3> normals;
-		std::vector<unsigned int> indices;
-
-		const unsigned int X_SEGMENTS = 64;
-		const unsigned int Y_SEGMENTS = 64;
-		const float PI = 3.14159265359f;
-		for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
-		{
-			for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
-			{
-				float xSegment = (float)x / (float)X_SEGMENTS;
-				float ySegment = (float)y / (float)Y_SEGMENTS;
-				float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-				float yPos = std::cos(ySegment * PI);
-				float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-
-				positions.push_back(glm::vec3(xPos, yPos, zPos));
-				uv.push_back(glm::vec2(xSegment, ySegment));
-				normals.push_back(glm::vec3(xPos, yPos, zPos));
-			}
-		}
-
-		bool oddRow = false;
-		for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
-		{
-			if (!oddRow) // even rows: y == 0, y == 2; and so on
-			{
-				for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
-				{
-					indices.push_back(y * (X_SEGMENTS + 1) + x);
-					indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-				}
-			}
-			else
-			{
-				for (int x = X_SEGMENTS; x >= 0; --x)
-				{
-					indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-					indices.push_back(y * (X_SEGMENTS + 1) + x);
-				}
-			}
-			oddRow = !oddRow;
-		}
-		indexCount = static_cast<unsigned int>(indices.size());
-
-		std::vector<float> data;
-		for (unsigned int i = 0; i < positions.size(); ++i)
-		{
-			data.push_back(positions[i].x);
-			data.push_back(positions[i].y);
-			data.push_back(positions[i].z);
-			if (normals.size() > 0)
-			{
-				data.push_back(normals[i].x);
-				data.push_back(normals[i].y);
-				data.push_back(normals[i].z);
-			}
-			if (uv.size() > 0)
-			{
-				data.push_back(uv[i].x);
-				data.push_back(uv[i].y);
-			}
-		}
-		glBindVertexArray(sphereVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-		unsigned int stride = (3 + 2 + 3) * sizeof(float);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-	}
-
-	glBindVertexArray(sphereVAO);
-	glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
-}
-
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -691,6 +756,15 @@ void imgui_on_render(ui_params& param)
 
 	ImGui::Checkbox("Irradiance Map", &params.show_irradiance_map);
 	ImGui::Separator();
+	ImGui::Text("IBL maps %s in %.1f ms", params.ibl_cached ? "loaded from cache" : "baked", params.ibl_ms);
+	ImGui::Checkbox("SH9 irradiance", &params.use_sh);
+	ImGui::Text("SH9 projection: %.2f ms", params.sh_ms);
+	ImGui::Text("SH9 error vs irradiance map: %.2f%% rms, %.2f%% max", params.sh_rms_error * 100.0f, params.sh_max_error * 100.0f);
+	if (ImGui::Button("time convolution"))
+		params.time_convolution = true;
+	if (params.convolution_ms > 0.0f)
+		ImGui::Text("irradiance convolution: %.2f ms", params.convolution_ms);
+	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
 	ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
@@ -4,16 +4,17 @@ in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
 
-// material parameters
-uniform vec3 albedo;
-uniform float metallic;
-uniform float roughness;
-uniform float ao;
+// material parameters, from the uniforms or the instance buffer (see pbr.vs)
+flat in vec3 Albedo;
+flat in float Metallic;
+flat in float Roughness;
+flat in float AO;
 
 // IBL
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
+uniform bool analyticBRDF;   // use EnvBRDFApprox() instead of the LUT
 
 // lights
 uniform vec3 lightPositions[4];
@@ -68,9 +69,24 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
 }   
 
+// ----------------------------------------------------------------------------
+// analytic fit of the split sum BRDF LUT (Karis, "Physically Based Shading on Mobile"), no texture fetch
+vec2 EnvBRDFApprox(float NdotV, float roughness)
+{
+    const vec4 c0 = vec4(-1.0, -0.0275, -0.572, 0.022);
+    const vec4 c1 = vec4(1.0, 0.0425, 1.04, -0.04);
+    vec4 r = roughness * c0 + c1;
+    float a004 = min(r.x * r.x, exp2(-9.28 * NdotV)) * r.x + r.y;
+    return vec2(-1.04, 1.04) * a004 + r.zw;
+}
 // ----------------------------------------------------------------------------
 void main()
 {		
+    vec3 albedo = Albedo;
+    float metallic = Metallic;
+    float roughness = Roughness;
+    float ao = AO;
+
     vec3 N = Normal;
     vec3 V = normalize(camPos - WorldPos);
     vec3 R = reflect(-V, N); 
@@ -129,7 +145,7 @@ void main()
     // sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
     const float MAX_REFLECTION_LOD = 4.0;
     vec3 prefilteredColor = textureLod(prefilterMap, R,  roughness * MAX_REFLECTION_LOD).rgb;
-    vec2 brdf  = texture(brdfLUT, vec2(max(dot(N, V), 0.0), roughness)).rg;
+    vec2 brdf  = analyticBRDF ? EnvBRDFApprox(max(dot(N, V), 0.0), roughness) : texture(brdfLUT, vec2(max(dot(N, V), 0.0), roughness)).rg;
     vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
 
     vec3 ambient = (kD * diffuse + specular) * ao;
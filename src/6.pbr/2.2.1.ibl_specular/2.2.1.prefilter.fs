@@ -4,6 +4,7 @@ in vec3 WorldPos;
 
 uniform samplerCube environmentMap;
 uniform float roughness;
+uniform int sampleCount; // GGX samples per texel, set per roughness level
 
 const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
@@ -69,7 +70,7 @@ void main()
     vec3 R = N;
     vec3 V = R;
 
-    const uint SAMPLE_COUNT = 1024u;
+    uint SAMPLE_COUNT = uint(sampleCount);
     vec3 prefilteredColor = vec3(0.0);
     float totalWeight = 0.0;
     
@@ -83,7 +84,8 @@ void main()
         float NdotL = max(dot(N, L), 0.0);
         if(NdotL > 0.0)
         {
-            // sample from the environment's mip level based on roughness/pdf
+            // filtered importance sampling: sample from the environment's mip level whose texels cover the
+            // solid angle of this sample (based on roughness/pdf), so few samples still integrate the whole lobe
             float D   = DistributionGGX(N, H, roughness);
             float NdotH = max(dot(N, H), 0.0);
             float HdotV = max(dot(H, V), 0.0);
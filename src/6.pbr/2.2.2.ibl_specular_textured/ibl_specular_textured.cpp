@@ -10,7 +10,11 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/hdr_image.h>
 #include <learnopengl/model.h>
+#include <learnopengl/ibl_cache.h>
+#include <learnopengl/brdf_lut.h>
+#include <learnopengl/pbr_material.h>
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
@@ -20,28 +24,21 @@ typedef struct ui_params
 {
 	bool show_irradiance_map = false;
 	float prefilter_mip = 0.0f;
+	bool ibl_cached = false;
+	float ibl_ms = 0.0f;
+	bool analytic_brdf = false;
+	float material_mb = 0.0f;
 } ui_params;
 
-typedef struct ibl_material
-{
-	unsigned int albedo;
-	unsigned int normal;
-	unsigned int metallic;
-	unsigned int roughness;
-	unsigned int ao;
-} ibl_texture;
-
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-void loadIBLMaterial(ibl_material* ibl_tex, const char* dir);
 void renderCube();
 void renderSphere();
-void renderQuad();
 unsigned int loadTexture(const char* path, bool hdr = false);
 unsigned int loadTexture2(const char* path);
-void renderSphereTextured(ibl_material* ibl_tex);
+void renderSphereTextured(const PBRMaterial* material);
 
 void imgui_on_init(GLFWwindow* window);
 void imgui_on_render(ui_params& param);
@@ -54,7 +51,6 @@ const unsigned int SCR_HEIGHT = 720;
 const unsigned int CUBE_MAP_SIZE = 512;
 const unsigned int IRRADIANCE_MAP_SIZE = 32;
 const unsigned int PREFILTER_MAP_SIZE = 128;
-const unsigned int LUT_TEX_SIZE = 512;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 10.0f));
@@ -121,7 +117,6 @@ int main()
 	Shader equirectangularToCubemapShader("2.2.2.cubemap.vs", "2.2.2.equirectangular_to_cubemap.fs");
 	Shader irradianceShader("2.2.2.cubemap.vs", "2.2.2.irradiance_convolution.fs");
 	Shader prefilterShader("2.2.2.cubemap.vs", "2.2.2.prefilter.fs");
-	Shader brdfShader("2.2.2.brdf.vs", "2.2.2.brdf.fs");
 	Shader backgroundShader("2.2.2.background.vs", "2.2.2.background.fs");
 
 	pbrShader.use();
@@ -130,37 +125,30 @@ int main()
 	pbrShader.setInt("brdfLUT", 2);
 	pbrShader.setInt("albedoMap", 3);
 	pbrShader.setInt("normalMap", 4);
-	pbrShader.setInt("metallicMap", 5);
-	pbrShader.setInt("roughnessMap", 6);
-	pbrShader.setInt("aoMap", 7);
+	pbrShader.setInt("ormMap", 5);
 
 	backgroundShader.use();
 	backgroundShader.setInt("environmentMap", 0);
 
-	// load PBR material textures
-	// --------------------------
-	
-	// rusted iron
-	ibl_material ibl_mat_iron;
-	loadIBLMaterial(&ibl_mat_iron, "res/textures/pbr/rusted_iron");
-
-	// gold
-	ibl_material ibl_mat_gold;
-	loadIBLMaterial(&ibl_mat_gold, "res/textures/pbr/gold");
-
-	// grass
-	ibl_material ibl_mat_grass;
-	loadIBLMaterial(&ibl_mat_grass, "res/textures/pbr/grass");
-
-	// plastic
-	ibl_material ibl_mat_plastic;
-	loadIBLMaterial(&ibl_mat_plastic, "res/textures/pbr/plastic");
-
-	// wall
-	ibl_material ibl_mat_wall;
-	loadIBLMaterial(&ibl_mat_wall, "res/textures/pbr/wall");
-
-	ibl_material ibl_materials[5] = { ibl_mat_iron, ibl_mat_gold, ibl_mat_grass, ibl_mat_plastic, ibl_mat_wall };
+	// load PBR material textures, packed into albedo, normal (RG) and ORM on the first run (see pbr_material.h)
+	// ------------------------------------------------------------------------------------------------------------
+	const char* materialDirs[] = {
+		"res/textures/pbr/rusted_iron",
+		"res/textures/pbr/gold",
+		"res/textures/pbr/grass",
+		"res/textures/pbr/plastic",
+		"res/textures/pbr/wall"
+	};
+	const unsigned int MATERIAL_COUNT = sizeof(materialDirs) / sizeof(materialDirs[0]);
+	PBRMaterial* ibl_materials = new PBRMaterial[MATERIAL_COUNT];
+	size_t materialBytes = 0;
+	for (unsigned int i = 0; i < MATERIAL_COUNT; ++i)
+	{
+		if (!ibl_materials[i].Load(materialDirs[i]))
+			std::cout << "Material failed to load at path: " << materialDirs[i] << std::endl;
+		materialBytes += ibl_materials[i].TextureBytes;
+	}
+	params.material_mb = materialBytes / (1024.0f * 1024.0f);
 
 
 	// lights
@@ -182,184 +170,194 @@ int main()
 	int nrColumns = 5;
 	float spacing = 2.5;
 
-	// pbr: setup framebuffer
-	// ----------------------
-	unsigned int captureFBO, captureRBO;
-	glGenFramebuffers(1, &captureFBO);
-	glGenRenderbuffers(1, &captureRBO);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-
-	// pbr: load the HDR environment map
-	// ---------------------------------
-	stbi_set_flip_vertically_on_load(true);
-	unsigned int hdrTexture = loadTexture("res/textures/hdr/newport_loft.hdr", true);
-
-	// pbr: setup cubemap to render to and attach to framebuffer
-	// ---------------------------------------------------------
-	unsigned int envCubemap;
-	glGenTextures(1, &envCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, CUBE_MAP_SIZE, CUBE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
-	// ----------------------------------------------------------------------------------------------
-	glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-	glm::mat4 captureViews[] =
+	// pbr: load the IBL maps from the cache next to the HDR file, bake them and fill the cache when it misses
+	// -------------------------------------------------------------------------------------------------------
+	unsigned int maxMipLevels = 5;
+	// GGX samples per pre-filter mip (roughness 0, 0.25, ... 1): a mirror needs a single sample, the rough mips are
+	// small enough to afford more; within 2% of 8192 samples, measured with ibl_reference --prefilter-sweep
+	const unsigned int prefilterSampleCounts[] = { 1, 64, 128, 256, 512 };
+	double iblStart = glfwGetTime();
+	IBLCache iblCache("res/textures/hdr/newport_loft.hdr");
+	int envCache = iblCache.Add("environment", GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, CUBE_MAP_SIZE, IBLCache::MipCount(CUBE_MAP_SIZE));
+	int irradianceCache = iblCache.Add("irradiance", GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, IRRADIANCE_MAP_SIZE, 1);
+	int prefilterCache = iblCache.Add("prefilter", GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, PREFILTER_MAP_SIZE, maxMipLevels);
+	params.ibl_cached = iblCache.Load();
+	if (!params.ibl_cached)
 	{
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-	};
+		// pbr: setup framebuffer
+		// ----------------------
+		unsigned int captureFBO, captureRBO;
+		glGenFramebuffers(1, &captureFBO);
+		glGenRenderbuffers(1, &captureRBO);
 
-	// pbr: convert HDR equirectangular environment map to cubemap equivalent
-	equirectangularToCubemapShader.use();
-	equirectangularToCubemapShader.setInt("equirectangularMap", 0);
-	equirectangularToCubemapShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, hdrTexture);
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+
+		// pbr: load the HDR environment map
+		// ---------------------------------
+		// decoded in parallel straight to half floats, bottom row first like stbi_set_flip_vertically_on_load(true)
+		unsigned int hdrTexture = HDRImage::LoadTexture(FileSystem::getPath("res/textures/hdr/newport_loft.hdr"));
+
+		// pbr: setup cubemap to render to and attach to framebuffer
+		// ---------------------------------------------------------
+		unsigned int envCubemap;
+		glGenTextures(1, &envCubemap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, CUBE_MAP_SIZE, CUBE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
+		// ----------------------------------------------------------------------------------------------
+		glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+		glm::mat4 captureViews[] =
+		{
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+		};
 
-	glViewport(0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		equirectangularToCubemapShader.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		renderCube();
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-	// pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
-	// --------------------------------------------------------------------------------
-	unsigned int irradianceMap;
-	glGenTextures(1, &irradianceMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
-
-	// pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
-	// -----------------------------------------------------------------------------
-	irradianceShader.use();
-	irradianceShader.setInt("environmentMap", 0);
-	irradianceShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-
-	glViewport(0, 0, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		irradianceShader.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		renderCube();
-	}
+		// pbr: convert HDR equirectangular environment map to cubemap equivalent
+		equirectangularToCubemapShader.use();
+		equirectangularToCubemapShader.setInt("equirectangularMap", 0);
+		equirectangularToCubemapShader.setMat4("projection", captureProjection);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hdrTexture);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			equirectangularToCubemapShader.setMat4("view", captureViews[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderCube();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	// pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
-	// --------------------------------------------------------------------------------
-	unsigned int prefilterMap;
-	glGenTextures(1, &prefilterMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, PREFILTER_MAP_SIZE, PREFILTER_MAP_SIZE, 0, GL_RGB, GL_FLOAT, nullptr);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-	// pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
-	// ----------------------------------------------------------------------------------------------------
-	prefilterShader.use();
-	prefilterShader.setInt("environmentMap", 0);
-	prefilterShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	unsigned int maxMipLevels = 5;
-	for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
-	{
-		// reisze framebuffer according to mip-level size.
-		unsigned int mipWidth = static_cast<unsigned int>(PREFILTER_MAP_SIZE * std::pow(0.5, mip));
-		unsigned int mipHeight = static_cast<unsigned int>(PREFILTER_MAP_SIZE * std::pow(0.5, mip));
+		// then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+		// pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
+		// --------------------------------------------------------------------------------
+		unsigned int irradianceMap;
+		glGenTextures(1, &irradianceMap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-		glViewport(0, 0, mipWidth, mipHeight);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
+
+		// pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
+		// -----------------------------------------------------------------------------
+		irradianceShader.use();
+		irradianceShader.setInt("environmentMap", 0);
+		irradianceShader.setMat4("projection", captureProjection);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-		float roughness = (float)mip / (float)(maxMipLevels - 1);
-		prefilterShader.setFloat("roughness", roughness);
+		glViewport(0, 0, IRRADIANCE_MAP_SIZE, IRRADIANCE_MAP_SIZE);
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 		for (unsigned int i = 0; i < 6; ++i)
 		{
-			prefilterShader.setMat4("view", captureViews[i]);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
+			irradianceShader.setMat4("view", captureViews[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			renderCube();
 		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
+		// --------------------------------------------------------------------------------
+		unsigned int prefilterMap;
+		glGenTextures(1, &prefilterMap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, PREFILTER_MAP_SIZE, PREFILTER_MAP_SIZE, 0, GL_RGB, GL_FLOAT, nullptr);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+		// pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
+		// ----------------------------------------------------------------------------------------------------
+		prefilterShader.use();
+		prefilterShader.setInt("environmentMap", 0);
+		prefilterShader.setMat4("projection", captureProjection);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
+		{
+			// reisze framebuffer according to mip-level size.
+			unsigned int mipWidth = static_cast<unsigned int>(PREFILTER_MAP_SIZE * std::pow(0.5, mip));
+			unsigned int mipHeight = static_cast<unsigned int>(PREFILTER_MAP_SIZE * std::pow(0.5, mip));
+			glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+			glViewport(0, 0, mipWidth, mipHeight);
+
+			float roughness = (float)mip / (float)(maxMipLevels - 1);
+			prefilterShader.setFloat("roughness", roughness);
+			prefilterShader.setInt("sampleCount", prefilterSampleCounts[mip]);
+			for (unsigned int i = 0; i < 6; ++i)
+			{
+				prefilterShader.setMat4("view", captureViews[i]);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				renderCube();
+			}
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// hand the baked maps to the cache and write it for the next startup
+		iblCache.SetTexture(envCache, envCubemap);
+		iblCache.SetTexture(irradianceCache, irradianceMap);
+		iblCache.SetTexture(prefilterCache, prefilterMap);
+		if (!iblCache.Save())
+			std::cout << "Failed to write IBL cache: " << iblCache.CachePath << std::endl;
+		glDeleteTextures(1, &hdrTexture);
+		glDeleteFramebuffers(1, &captureFBO);
+		glDeleteRenderbuffers(1, &captureRBO);
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// pbr: generate a 2D LUT from the BRDF equations used.
-	// ----------------------------------------------------
-	unsigned int brdfLUTTexture;
-	glGenTextures(1, &brdfLUTTexture);
-
-	// pre-allocate enough memory for the LUT texture
-	glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, LUT_TEX_SIZE, LUT_TEX_SIZE, 0, GL_RG, GL_FLOAT, 0);
-	// be sure to set wrapping mode to GL_CLAMP_TO_EDGE
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, LUT_TEX_SIZE, LUT_TEX_SIZE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
-
-	glViewport(0, 0, LUT_TEX_SIZE, LUT_TEX_SIZE);
-	brdfShader.use();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderQuad();
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	unsigned int envCubemap = iblCache.Texture(envCache);
+	unsigned int irradianceMap = iblCache.Texture(irradianceCache);
+	unsigned int prefilterMap = iblCache.Texture(prefilterCache);
+
+	// the BRDF LUT does not depend on the environment, it ships pre-baked with the library (see brdf_lut.h)
+	unsigned int brdfLUTTexture = LoadBRDFLUT();
+
+	// startup cost of the IBL maps, finish so the GPU side of the bake or upload is included
+	glFinish();
+	params.ibl_ms = static_cast<float>((glfwGetTime() - iblStart) * 1000.0);
+	std::cout << "IBL maps " << (params.ibl_cached ? "loaded from cache" : "baked") << " in " << params.ibl_ms << " ms (" << iblCache.CachePath << ", " << iblCache.FileBytes / (1024 * 1024) << " MB)" << std::endl;
 
 	// initialize static shader uniforms before rendering
 	// --------------------------------------------------
@@ -401,6 +399,7 @@ int main()
 		glm::mat4 view = camera.GetViewMatrix();
 		pbrShader.setMat4("view", view);
 		pbrShader.setVec3("camPos", camera.Position);
+		pbrShader.setBool("analyticBRDF", params.analytic_brdf);
 
 		// bind pre-computed IBL data
 		glActiveTexture(GL_TEXTURE0);
@@ -411,7 +410,7 @@ int main()
 		glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
 
 		// ibl spheres
-		unsigned int mat_size = sizeof(ibl_materials) / sizeof(ibl_material);
+		unsigned int mat_size = MATERIAL_COUNT;
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(-5.0, 0.0, 2.0));
 		float rorate_angle = glm::radians(glfwGetTime() * 50.0f);
@@ -466,6 +465,9 @@ int main()
 		glfwPollEvents();
 	}
 
+	// free resources
+	delete[] ibl_materials;
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	imgui_on_deinit(window);
@@ -713,37 +715,6 @@ void renderCube()
 	glBindVertexArray(0);
 }
 
-// renderQuad() renders a 1x1 XY quad in NDC
-// -----------------------------------------
-unsigned int quadVAO = 0;
-unsigned int quadVBO;
-void renderQuad()
-{
-	if (quadVAO == 0)
-	{
-		float quadVertices[] = {
-			// positions        // texture Coords
-			-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-			-1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-			 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-			 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-		};
-		// setup plane VAO
-		glGenVertexArrays(1, &quadVAO);
-		glGenBuffers(1, &quadVBO);
-		glBindVertexArray(quadVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	}
-	glBindVertexArray(quadVAO);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
-}
-
 // utility function for loading a 2D texture from file
 // ---------------------------------------------------
 unsigned int loadTexture(char const* path, bool hdr/* = false*/)
@@ -836,28 +807,10 @@ unsigned int loadTexture2(char const* path)
 	return textureID;
 }
 
-void loadIBLMaterial(ibl_material* ibl_tex, const char* dir)
+void renderSphereTextured(const PBRMaterial* material)
 {
-	ibl_tex->albedo = loadTexture(std::string(dir).append("/albedo.png").c_str());
-	ibl_tex->normal = loadTexture(std::string(dir).append("/normal.png").c_str());
-	ibl_tex->metallic = loadTexture(std::string(dir).append("/metallic.png").c_str());
-	ibl_tex->roughness = loadTexture(std::string(dir).append("/roughness.png").c_str());
-	ibl_tex->ao = loadTexture(std::string(dir).append("/ao.png").c_str());
-}
-
-void renderSphereTextured(ibl_material* ibl_tex)
-{
-	// rusted iron
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, ibl_tex->albedo);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, ibl_tex->normal);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, ibl_tex->metallic);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, ibl_tex->roughness);
-	glActiveTexture(GL_TEXTURE7);
-	glBindTexture(GL_TEXTURE_2D, ibl_tex->ao);
+	// albedo, normal and ORM on units 3 to 5
+	material->Bind(3);
 
 	renderSphere();
 }
@@ -916,6 +869,10 @@ void imgui_on_render(ui_params& param)
 
 	ImGui::Checkbox("irradiance Map", &params.show_irradiance_map);
 	ImGui::DragFloat("pre-filter Mip", &params.prefilter_mip, 0.1, 0.0, 10.0);
+	ImGui::Checkbox("analytic BRDF (no LUT)", &params.analytic_brdf);
+	ImGui::Separator();
+	ImGui::Text("IBL maps %s in %.1f ms", params.ibl_cached ? "loaded from cache" : "baked", params.ibl_ms);
+	ImGui::Text("materials: 3 textures each, %.1f MB", params.material_mb);
 	ImGui::Separator();
 	ImGui::Text("Press 1 to show cursor");
 	ImGui::Text("Press 2 to hide cursor");
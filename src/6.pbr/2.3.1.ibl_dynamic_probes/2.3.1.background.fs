@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+in vec3 WorldPos;
+
+uniform samplerCube environmentMap;
+uniform float prefilter_mip = 0.0;
+
+void main()
+{		
+    vec3 envColor = textureLod(environmentMap, WorldPos, prefilter_mip).rgb;
+    
+    // HDR tonemap and gamma correct
+    envColor = envColor / (envColor + vec3(1.0));
+    envColor = pow(envColor, vec3(1.0/2.2)); 
+    
+    FragColor = vec4(envColor, 1.0);
+}
\ No newline at end of file
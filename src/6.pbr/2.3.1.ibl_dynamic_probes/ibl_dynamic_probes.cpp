@@ -0,0 +1,622 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/hdr_image.h>
+#include <learnopengl/ibl_cache.h>
+#include <learnopengl/brdf_lut.h>
+#include <learnopengl/reflection_probe.h>
+#include <learnopengl/geometry.h>
+
+#include <imgui/imgui.h>
+#include <imgui/backends/imgui_impl_glfw.h>
+#include <imgui/backends/imgui_impl_opengl3.h>
+
+typedef struct ui_params
+{
+	float budget_ms = 1.0f;
+	bool freeze_probes = false;
+	bool pause_objects = false;
+	bool show_probe_capture = false;
+	bool ibl_cached = false;
+	float update_estimated_ms = 0.0f;
+	int update_steps = 0;
+	int probe_update_frames[2] = { 0, 0 };
+	float capture_ms = 0.0f;
+	float irradiance_ms = 0.0f;
+	float prefilter_ms = 0.0f;
+} ui_params;
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow* window);
+void renderCube();
+
+void imgui_on_init(GLFWwindow* window);
+void imgui_on_render(ui_params& param);
+void imgui_on_deinit(GLFWwindow* window);
+
+// settings
+const unsigned int SCR_WIDTH = 1280;
+const unsigned int SCR_HEIGHT = 720;
+
+const unsigned int CUBE_MAP_SIZE = 512;
+
+// camera
+Camera camera(glm::vec3(0.0f, 0.0f, 14.0f));
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+static ui_params params;
+
+int main()
+{
+	// glfw: initialize and configure
+	// ------------------------------
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_SAMPLES, 4);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+	// glfw window creation
+	// --------------------
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+	glfwMakeContextCurrent(window);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// glad: load all OpenGL function pointers
+	// ---------------------------------------
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	imgui_on_init(window);
+
+	// configure global opengl state
+	// -----------------------------
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LEQUAL); // set depth function to less than AND equal for skybox depth trick.
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	// build and compile shaders
+	// -------------------------
+	Shader pbrShader("2.3.1.pbr.vs", "2.3.1.pbr.fs");
+	Shader equirectangularToCubemapShader("2.3.1.cubemap.vs", "2.3.1.equirectangular_to_cubemap.fs");
+	Shader irradianceShader("2.3.1.cubemap.vs", "2.3.1.irradiance_convolution.fs");
+	Shader prefilterShader("2.3.1.cubemap.vs", "2.3.1.prefilter.fs");
+	Shader backgroundShader("2.3.1.background.vs", "2.3.1.background.fs");
+
+	// lights
+	// ------
+	glm::vec3 lightPositions[] = {
+		glm::vec3(-10.0f,  10.0f, 10.0f),
+		glm::vec3(10.0f,  10.0f, 10.0f),
+		glm::vec3(-10.0f, -10.0f, 10.0f),
+		glm::vec3(10.0f, -10.0f, 10.0f),
+	};
+	glm::vec3 lightColors[] = {
+		glm::vec3(300.0f, 300.0f, 300.0f),
+		glm::vec3(300.0f, 300.0f, 300.0f),
+		glm::vec3(300.0f, 300.0f, 300.0f),
+		glm::vec3(300.0f, 300.0f, 300.0f)
+	};
+	int nrRows = 2;
+	int nrColumns = 7;
+	float spacing = 2.5;
+
+	// moving cubes, circling above and below the spheres so the probes have something to pick up
+	glm::vec3 objectColors[] = {
+		glm::vec3(0.9f, 0.1f, 0.1f),
+		glm::vec3(0.1f, 0.9f, 0.1f),
+		glm::vec3(0.1f, 0.2f, 0.9f)
+	};
+	const int OBJECT_COUNT = 6;
+	float objectTime = 0.0f;
+
+	// pbr: load the environment cubemap from the cache the other 6.pbr demos fill, convert the HDR file on a miss
+	// -----------------------------------------------------------------------------------------------------------
+	IBLCache iblCache("res/textures/hdr/newport_loft.hdr");
+	int envCache = iblCache.Add("environment", GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, CUBE_MAP_SIZE, IBLCache::MipCount(CUBE_MAP_SIZE));
+	params.ibl_cached = iblCache.Load();
+	if (!params.ibl_cached)
+	{
+		unsigned int captureFBO, captureRBO;
+		glGenFramebuffers(1, &captureFBO);
+		glGenRenderbuffers(1, &captureRBO);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+
+		unsigned int hdrTexture = HDRImage::LoadTexture(FileSystem::getPath("res/textures/hdr/newport_loft.hdr"));
+
+		unsigned int envCubemap;
+		glGenTextures(1, &envCubemap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, CUBE_MAP_SIZE, CUBE_MAP_SIZE, 0, GL_RGB, GL_FLOAT, NULL);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// pbr: convert HDR equirectangular environment map to cubemap equivalent
+		equirectangularToCubemapShader.use();
+		equirectangularToCubemapShader.setInt("equirectangularMap", 0);
+		equirectangularToCubemapShader.setMat4("projection", glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f));
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hdrTexture);
+
+		glViewport(0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			equirectangularToCubemapShader.setMat4("view", ReflectionProbe::FaceView(i, glm::vec3(0.0f)));
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderCube();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+		// only the environment is stored, the maps of the other demos in the cache file are kept
+		iblCache.SetTexture(envCache, envCubemap);
+		if (!iblCache.Save())
+			std::cout << "Failed to write IBL cache: " << iblCache.CachePath << std::endl;
+		glDeleteTextures(1, &hdrTexture);
+		glDeleteFramebuffers(1, &captureFBO);
+		glDeleteRenderbuffers(1, &captureRBO);
+	}
+	unsigned int envCubemap = iblCache.Texture(envCache);
+
+	// the BRDF LUT does not depend on the environment, it ships pre-baked with the library (see brdf_lut.h)
+	unsigned int brdfLUTTexture = LoadBRDFLUT();
+
+	// pbr: reflection probes between the two rows of spheres, everything is lit by the probe closest to it
+	// -----------------------------------------------------------------------------------------------------
+	ReflectionProbe* leftProbe = new ReflectionProbe(glm::vec3(-1.5f * spacing, 0.0f, 0.0f));
+	ReflectionProbe* rightProbe = new ReflectionProbe(glm::vec3(1.5f * spacing, 0.0f, 0.0f));
+	ReflectionProbe* probes[] = { leftProbe, rightProbe };
+	const int PROBE_COUNT = sizeof(probes) / sizeof(probes[0]);
+
+	pbrShader.use();
+	pbrShader.setFloat("ao", 1.0f);
+	pbrShader.setInt("irradianceMap", 0);
+	pbrShader.setInt("prefilterMap", 1);
+	pbrShader.setInt("brdfLUT", 2);
+	for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+	{
+		pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", lightPositions[i]);
+		pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
+	}
+
+	backgroundShader.use();
+	backgroundShader.setInt("environmentMap", 0);
+
+	// binds the filtered maps of the probe closest to position for the pbr shader
+	auto bindClosestProbe = [&](const glm::vec3& position)
+	{
+		ReflectionProbe* closest = probes[0];
+		for (int i = 1; i < PROBE_COUNT; ++i)
+		{
+			if (glm::length(probes[i]->Position - position) < glm::length(closest->Position - position))
+				closest = probes[i];
+		}
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, closest->IrradianceMap());
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, closest->PrefilterMap());
+	};
+
+	// sphere meshes shared by the 6.pbr demos, the LOD follows the size of each sphere in the view drawn
+	SphereLODs* spheres = new SphereLODs();
+
+	// draws the scene seen from position, for the camera as well as for a face of a probe; the objects are shaded
+	// with the maps of the last completed probe updates, so reflections of reflections build up over the updates
+	ProbeUpdater::SceneFunction renderScene = [&](const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position)
+	{
+		pbrShader.use();
+		pbrShader.setMat4("projection", projection);
+		pbrShader.setMat4("view", view);
+		pbrShader.setVec3("camPos", position);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		float viewportHeight = (float)viewport[3];
+
+		// spheres with increasing roughness from left to right, dielectric on the top row and metal below
+		pbrShader.setVec3("albedo", 0.5f, 0.0f, 0.0f);
+		for (int row = 0; row < nrRows; ++row)
+		{
+			pbrShader.setFloat("metallic", (float)row);
+			for (int col = 0; col < nrColumns; ++col)
+			{
+				pbrShader.setFloat("roughness", glm::clamp((float)col / (float)nrColumns, 0.05f, 1.0f));
+				glm::vec3 spherePosition((col - (nrColumns / 2)) * spacing, (0.5f - row) * spacing, 0.0f);
+				bindClosestProbe(spherePosition);
+				pbrShader.setMat4("model", glm::translate(glm::mat4(1.0f), spherePosition));
+				spheres->Draw(SphereLODs::ICOSPHERE, spheres->Select(SphereLODs::ICOSPHERE, SphereLODs::ProjectedRadius(spherePosition, 1.0f, position, projection, viewportHeight)));
+			}
+		}
+
+		pbrShader.setFloat("metallic", 0.0f);
+		pbrShader.setFloat("roughness", 0.3f);
+		for (int i = 0; i < OBJECT_COUNT; ++i)
+		{
+			// three above the spheres turning one way, three below turning the other
+			float direction = i < OBJECT_COUNT / 2 ? 1.0f : -1.0f;
+			float angle = direction * objectTime * 0.6f + (i % 3) * 2.0f * glm::pi<float>() / 3.0f;
+			glm::vec3 objectPosition(std::cos(angle) * 6.0f, direction * 3.75f, std::sin(angle) * 6.0f);
+			bindClosestProbe(objectPosition);
+			pbrShader.setVec3("albedo", objectColors[i % 3]);
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), objectPosition);
+			model = glm::rotate(model, angle * 2.0f, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)));
+			model = glm::scale(model, glm::vec3(0.6f));
+			pbrShader.setMat4("model", model);
+			renderCube();
+		}
+
+		// render light source (simply re-render sphere at light positions)
+		pbrShader.setVec3("albedo", 1.0f, 1.0f, 1.0f);
+		for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+		{
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), lightPositions[i]);
+			model = glm::scale(model, glm::vec3(0.5f));
+			pbrShader.setMat4("model", model);
+			spheres->Draw(SphereLODs::ICOSPHERE, spheres->Select(SphereLODs::ICOSPHERE, SphereLODs::ProjectedRadius(lightPositions[i], 0.5f, position, projection, viewportHeight)));
+		}
+
+		// render skybox (render as last to prevent overdraw)
+		backgroundShader.use();
+		backgroundShader.setMat4("projection", projection);
+		backgroundShader.setMat4("view", view);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		renderCube();
+	};
+
+	// pbr: the probes re-capture and re-filter a face at a time within the budget, with the bake shaders and the
+	// sample counts of the static pre-filter map; one full update first, so they are valid from the first frame
+	// ------------------------------------------------------------------------------------------------------------
+	std::vector<unsigned int> prefilterSampleCounts = { 1, 64, 128, 256, 512 };
+	ProbeUpdater* probeUpdater = new ProbeUpdater(irradianceShader, prefilterShader, prefilterSampleCounts, renderCube, renderScene, params.budget_ms);
+	for (int i = 0; i < PROBE_COUNT; ++i)
+		probeUpdater->Add(probes[i]);
+	probeUpdater->UpdateAll();
+
+	// then before rendering, configure the viewport to the original framebuffer's screen dimensions
+	glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float currentFrame = static_cast<float>(glfwGetTime());
+		deltaTime = currentFrame - lastFrame;
+		lastFrame = currentFrame;
+		if (!params.pause_objects)
+			objectTime += deltaTime;
+
+		// input
+		// -----
+		processInput(window);
+
+		// pbr: spend this frame's budget on the probes, before they are shaded with
+		// --------------------------------------------------------------------------
+		probeUpdater->BudgetMs = params.budget_ms;
+		if (!params.freeze_probes)
+			probeUpdater->Update();
+		params.update_estimated_ms = params.freeze_probes ? 0.0f : probeUpdater->EstimatedMs;
+		params.update_steps = params.freeze_probes ? 0 : probeUpdater->FrameSteps;
+		for (int i = 0; i < PROBE_COUNT; ++i)
+			params.probe_update_frames[i] = probes[i]->UpdateFrames;
+		params.capture_ms = probeUpdater->StepMilliseconds(ReflectionProbe::CAPTURE_FACE);
+		params.irradiance_ms = probeUpdater->StepMilliseconds(ReflectionProbe::IRRADIANCE_FACE);
+		params.prefilter_ms = 0.0f;
+		for (int mip = 0; mip < leftProbe->PrefilterLevels; ++mip)
+			params.prefilter_ms += probeUpdater->StepMilliseconds(ReflectionProbe::PREFILTER_FACE, mip);
+
+		// render
+		// ------
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		glm::mat4 view = camera.GetViewMatrix();
+		if (params.show_probe_capture)
+		{
+			// the raw capture of the left probe instead of the scene, to watch its faces being re-rendered
+			backgroundShader.use();
+			backgroundShader.setMat4("projection", projection);
+			backgroundShader.setMat4("view", view);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, leftProbe->CaptureMap());
+			renderCube();
+		}
+		else
+			renderScene(view, projection, camera.Position);
+
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+		// -------------------------------------------------------------------------------
+		imgui_on_render(params);
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	// free resources
+	delete probeUpdater;
+	delete leftProbe;
+	delete rightProbe;
+	delete spheres;
+
+	// glfw: terminate, clearing all previously allocated GLFW resources.
+	// ------------------------------------------------------------------
+	imgui_on_deinit(window);
+	glfwTerminate();
+	return 0;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow* window)
+{
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+		camera.ProcessKeyboard(FORWARD, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+		camera.ProcessKeyboard(BACKWARD, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+		camera.ProcessKeyboard(LEFT, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+		camera.ProcessKeyboard(RIGHT, deltaTime);
+	if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+		glfwSetCursorPosCallback(window, NULL);
+	}
+	if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetCursorPosCallback(window, mouse_callback);
+		firstMouse = true;
+	}
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	// make sure the viewport matches the new window dimensions; note that width and 
+	// height will be significantly larger than specified on retina displays.
+	glViewport(0, 0, width, height);
+}
+
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+	float xpos = static_cast<float>(xposIn);
+	float ypos = static_cast<float>(yposIn);
+
+	if (firstMouse)
+	{
+		lastX = xpos;
+		lastY = ypos;
+		firstMouse = false;
+	}
+
+	float xoffset = xpos - lastX;
+	float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+	lastX = xpos;
+	lastY = ypos;
+
+	camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
+
+// renderCube() renders a 1x1 3D cube in NDC.
+// -------------------------------------------------
+unsigned int cubeVAO = 0;
+unsigned int cubeVBO = 0;
+void renderCube()
+{
+	// initialize (if necessary)
+	if (cubeVAO == 0)
+	{
+		float vertices[] = {
+			// back face
+			-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+			 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+			 1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
+			 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+			-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+			-1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+			// front face
+			-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+			 1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+			 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+			 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+			-1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+			-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+			// left face
+			-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+			-1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+			-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+			-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+			-1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+			-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+			// right face
+			 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+			 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+			 1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right         
+			 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+			 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+			 1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left     
+			// bottom face
+			-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+			 1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+			 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+			 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+			-1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+			-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+			// top face
+			-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+			 1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+			 1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right     
+			 1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+			-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+			-1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left        
+		};
+		glGenVertexArrays(1, &cubeVAO);
+		glGenBuffers(1, &cubeVBO);
+		// fill buffer
+		glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		// link vertex attributes
+		glBindVertexArray(cubeVAO);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+	// render Cube
+	glBindVertexArray(cubeVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 36);
+	glBindVertexArray(0);
+}
+
+void imgui_on_init(GLFWwindow* window)
+{
+	// Setup Dear ImGui context
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO(); (void)io;
+	//io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+	//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+
+	// Setup Dear ImGui style
+	ImGui::StyleColorsDark();
+	//ImGui::StyleColorsClassic();
+
+	// Setup Platform/Renderer backends
+	ImGui_ImplGlfw_InitForOpenGL(window, true);
+	ImGui_ImplOpenGL3_Init();
+
+	// Load Fonts
+	// - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
+	// - AddFontFromFileTTF() will return the ImFont* so you can store it if you need to select the font among multiple.
+	// - If the file cannot be loaded, the function will return NULL. Please handle those errors in your application (e.g. use an assertion, or display an error and quit).
+	// - The fonts will be rasterized at a given size (w/ oversampling) and stored into a texture when calling ImFontAtlas::Build()/GetTexDataAsXXXX(), which ImGui_ImplXXXX_NewFrame below will call.
+	// - Read 'docs/FONTS.md' for more instructions and details.
+	// - Remember that in C/C++ if you want to include a backslash \ in a string literal you need to write a double backslash \\ !
+	//io.Fonts->AddFontDefault();
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/Roboto-Medium.ttf", 16.0f);
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/Cousine-Regular.ttf", 15.0f);
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/DroidSans.ttf", 16.0f);
+	//io.Fonts->AddFontFromFileTTF("../../misc/fonts/ProggyTiny.ttf", 10.0f);
+	//ImFont* font = io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\ArialUni.ttf", 18.0f, NULL, io.Fonts->GetGlyphRangesJapanese());
+	//IM_ASSERT(font != NULL);
+}
+
+void imgui_on_render(ui_params& param)
+{
+	// Start the Dear ImGui frame
+	ImGui_ImplOpenGL3_NewFrame();
+	ImGui_ImplGlfw_NewFrame();
+	ImGui::NewFrame();
+
+	//if (show_demo_window)
+	//	ImGui::ShowDemoWindow(&show_demo_window);
+
+	static bool open = false;
+
+	ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+	if (!ImGui::Begin("Config", &open, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::SliderFloat("probe budget (ms)", &params.budget_ms, 0.1f, 4.0f);
+	ImGui::Checkbox("freeze probes", &params.freeze_probes);
+	ImGui::Checkbox("pause objects", &params.pause_objects);
+	ImGui::Checkbox("show left probe capture", &params.show_probe_capture);
+	ImGui::Separator();
+	ImGui::Text("probe updates: %d steps, %.2f ms estimated", params.update_steps, params.update_estimated_ms);
+	ImGui::Text("left probe updated over %d frames, right over %d", params.probe_update_frames[0], params.probe_update_frames[1]);
+	ImGui::Text("per face: capture %.2f ms, irradiance %.2f ms, pre-filter %.2f ms", params.capture_ms, params.irradiance_ms, params.prefilter_ms);
+	ImGui::Text("environment %s", params.ibl_cached ? "loaded from cache" : "converted from HDR");
+	ImGui::Separator();
+	ImGui::Text("Press 1 to show cursor");
+	ImGui::Text("Press 2 to hide cursor");
+	ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+
+	ImGui::End();
+
+	// Rendering
+	ImGui::Render();
+	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+}
+
+void imgui_on_deinit(GLFWwindow* window)
+{
+	// Cleanup
+	ImGui_ImplOpenGL3_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+}
\ No newline at end of file
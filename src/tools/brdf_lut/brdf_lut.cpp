@@ -0,0 +1,165 @@
+#include <learnopengl/filesystem.h>
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/ibl_reference.h>
+#include <learnopengl/brdf_lut.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Bakes the split sum BRDF LUT of the 6.pbr IBL demos once, at build time, into the half float table of
+// include/learnopengl/brdf_lut_table.h that LoadBRDFLUT() uploads. The LUT is smooth, so a small table sampled
+// bilinearly reproduces the 512^2 LUT the demos used to render on startup; the tool reports how closely, together
+// with the error of the analytic EnvBRDFApprox() fit.
+//
+//   brdf_lut [--size N] [--samples N] [--output file relative to the root]
+//     --size N     table resolution (default 64)
+//     --samples N  importance samples per texel (default 1024, as the demos rendered it)
+//     --output     header to write (default include/learnopengl/brdf_lut_table.h)
+
+// the LUT the demos used to render on startup, the reference of the error measurements
+const int REFERENCE_SIZE = 512;
+const unsigned int REFERENCE_SAMPLE_COUNT = 1024;
+
+struct LUTError
+{
+	float rms;
+	float max;
+	glm::vec2 maxAt;   // NdotV, roughness of the largest error
+};
+
+// GL_LINEAR sampling with clamp to edge of an RG table at uv, texel centers at (i + 0.5) / size
+glm::vec2 sampleTable(const std::vector<float>& table, int size, float u, float v)
+{
+	float x = glm::clamp(u * size - 0.5f, 0.0f, (float)(size - 1));
+	float y = glm::clamp(v * size - 0.5f, 0.0f, (float)(size - 1));
+	int x0 = (int)x;
+	int y0 = (int)y;
+	int x1 = std::min(x0 + 1, size - 1);
+	int y1 = std::min(y0 + 1, size - 1);
+	float fx = x - x0;
+	float fy = y - y0;
+	glm::vec2 t00(table[((size_t)y0 * size + x0) * 2], table[((size_t)y0 * size + x0) * 2 + 1]);
+	glm::vec2 t10(table[((size_t)y0 * size + x1) * 2], table[((size_t)y0 * size + x1) * 2 + 1]);
+	glm::vec2 t01(table[((size_t)y1 * size + x0) * 2], table[((size_t)y1 * size + x0) * 2 + 1]);
+	glm::vec2 t11(table[((size_t)y1 * size + x1) * 2], table[((size_t)y1 * size + x1) * 2 + 1]);
+	return glm::mix(glm::mix(t00, t10, fx), glm::mix(t01, t11, fx), fy);
+}
+
+// error of lookup(NdotV, roughness) against the reference at every reference texel, in units of the LUT values
+template <typename Lookup>
+LUTError measure(const std::vector<float>& reference, Lookup lookup)
+{
+	LUTError error = { 0.0f, 0.0f, glm::vec2(0.0f) };
+	double squared = 0.0;
+	for (int y = 0; y < REFERENCE_SIZE; ++y)
+	{
+		for (int x = 0; x < REFERENCE_SIZE; ++x)
+		{
+			glm::vec2 uv((x + 0.5f) / REFERENCE_SIZE, (y + 0.5f) / REFERENCE_SIZE);
+			glm::vec2 difference = glm::abs(lookup(uv.x, uv.y) - glm::vec2(reference[((size_t)y * REFERENCE_SIZE + x) * 2], reference[((size_t)y * REFERENCE_SIZE + x) * 2 + 1]));
+			squared += difference.x * difference.x + difference.y * difference.y;
+			if (std::max(difference.x, difference.y) > error.max)
+			{
+				error.max = std::max(difference.x, difference.y);
+				error.maxAt = uv;
+			}
+		}
+	}
+	error.rms = (float)std::sqrt(squared / (2.0 * REFERENCE_SIZE * REFERENCE_SIZE));
+	return error;
+}
+
+bool writeHeader(const std::string& path, int size, unsigned int sampleCount, const std::vector<unsigned short>& halves)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+		return false;
+	fprintf(file, "#ifndef BRDF_LUT_TABLE_H\n#define BRDF_LUT_TABLE_H\n\n");
+	fprintf(file, "// Split sum BRDF LUT, generated by src/tools/brdf_lut (%d^2, %u samples per texel), do not edit.\n", size, sampleCount);
+	fprintf(file, "// RG half floats, x = NdotV and y = roughness at the texel centers, row 0 is roughness ~0.\n\n");
+	fprintf(file, "const int BRDF_LUT_TABLE_SIZE = %d;\n\n", size);
+	fprintf(file, "static const unsigned short BRDF_LUT_TABLE[%d * %d * 2] = {\n", size, size);
+	for (size_t i = 0; i < halves.size(); i += 16)
+	{
+		fprintf(file, "\t");
+		for (size_t j = i; j < i + 16 && j < halves.size(); ++j)
+			fprintf(file, "0x%04x,%s", halves[j], j + 1 < i + 16 && j + 1 < halves.size() ? " " : "");
+		fprintf(file, "\n");
+	}
+	fprintf(file, "};\n\n#endif\n");
+	return fclose(file) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	int size = 64;
+	unsigned int sampleCount = 1024;
+	std::string output = "include/learnopengl/brdf_lut_table.h";
+	bool valid = true;
+	for (int i = 1; i < argc && valid; i += 2)
+	{
+		// every flag takes a value, anything else (--help, a typo) must not regenerate the tracked table
+		if (i + 1 >= argc)
+			valid = false;
+		else if (strcmp(argv[i], "--size") == 0)
+			size = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--samples") == 0)
+			sampleCount = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--output") == 0)
+			output = argv[i + 1];
+		else
+			valid = false;
+	}
+	if (!valid || size < 2 || sampleCount < 1)
+	{
+		printf("usage: brdf_lut [--size N] [--samples N] [--output file]\n");
+		return 1;
+	}
+
+	ThreadPool pool;
+	IBLReference reference(pool);
+
+	// 1. bake the table and store it as half floats, the precision of the RG16F texture
+	// ---------------------------------------------------------------------------------
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::vector<float> table;
+	reference.BRDFLut(size, sampleCount, table);
+	float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	std::vector<unsigned short> halves(table.size());
+	for (size_t i = 0; i < table.size(); ++i)
+	{
+		halves[i] = glm::packHalf1x16(table[i]);
+		table[i] = glm::unpackHalf1x16(halves[i]);
+	}
+	printf("baked %d^2 LUT with %u samples in %.1f ms on %d threads\n", size, sampleCount, milliseconds, pool.ThreadCount());
+
+	// 2. compare the table and the analytic fit with the full size LUT of the demos
+	// -----------------------------------------------------------------------------
+	std::vector<float> full;
+	reference.BRDFLut(REFERENCE_SIZE, REFERENCE_SAMPLE_COUNT, full);
+	LUTError tableError = measure(full, [&](float NdotV, float roughness) { return sampleTable(table, size, NdotV, roughness); });
+	LUTError analyticError = measure(full, [](float NdotV, float roughness) { return EnvBRDFApprox(NdotV, roughness); });
+	// the largest table errors sit in the first texels of NdotV, where the Monte Carlo estimate of the LUT is noisy
+	printf("against the %d^2 LUT:  table    rms %.5f, max %.5f at NdotV %.3f roughness %.3f (%zu bytes instead of %d)\n", REFERENCE_SIZE,
+		tableError.rms, tableError.max, tableError.maxAt.x, tableError.maxAt.y, halves.size() * sizeof(unsigned short), REFERENCE_SIZE * REFERENCE_SIZE * 2 * 2);
+	printf("                       analytic rms %.5f, max %.5f at NdotV %.3f roughness %.3f (no texture)\n",
+		analyticError.rms, analyticError.max, analyticError.maxAt.x, analyticError.maxAt.y);
+
+	// 3. write the header that ships with the library
+	// -----------------------------------------------
+	if (!writeHeader(FileSystem::getPath(output), size, sampleCount, halves))
+	{
+		printf("Failed to write %s\n", FileSystem::getPath(output).c_str());
+		return 1;
+	}
+	printf("wrote %s\n", FileSystem::getPath(output).c_str());
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include <learnopengl/frame_graph.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Scheduling checks of FrameGraph::Compile(), without a GL context (compiling a graph only does bookkeeping). Prints
+// the schedule of every graph and returns non-zero when one breaks the ordering rules; registered with ctest.
+//
+//   frame_graph_test
+
+static int failures = 0;
+
+static void noop()
+{
+}
+
+// position of the named pass in the schedule, -1 when it was culled
+static int position(const FrameGraph& graph, const std::vector<std::string>& names, const char* name)
+{
+	const std::vector<int>& schedule = graph.Schedule();
+	for (size_t s = 0; s < schedule.size(); ++s)
+		if (names[schedule[s]] == name)
+			return (int)s;
+	return -1;
+}
+
+static void expectBefore(const char* graphName, const FrameGraph& graph, const std::vector<std::string>& names, const char* first, const char* second)
+{
+	int a = position(graph, names, first);
+	int b = position(graph, names, second);
+	if (a < 0 || b < 0 || a >= b)
+	{
+		printf("FAIL %s: %s must run before %s\n", graphName, first, second);
+		++failures;
+	}
+}
+
+static void printSchedule(const char* graphName, const FrameGraph& graph, const std::vector<std::string>& names)
+{
+	printf("%-24s", graphName);
+	for (size_t s = 0; s < graph.Schedule().size(); ++s)
+		printf(" %s", names[graph.Schedule()[s]].c_str());
+	printf("\n");
+}
+
+int main()
+{
+	// two passes writing the backbuffer: the clearing lighting pass must not run after the overlay, even though the
+	// overlay only depends on a target written before the g-buffer
+	{
+		FrameGraph graph;
+		graph.Resize(64, 64);
+		int t = graph.Create("overlay input", GL_RGBA8);
+		int g = graph.Create("gbuffer", GL_RGBA16F);
+		std::vector<std::string> names;
+		names.push_back("pre");      graph.AddPass("pre", {}, { t }, noop);
+		names.push_back("geometry"); graph.AddPass("geometry", {}, { g }, noop);
+		names.push_back("lighting"); graph.AddPass("lighting", { g }, { FrameGraph::BACKBUFFER }, noop);
+		names.push_back("overlay");  graph.AddPass("overlay", { t }, { FrameGraph::BACKBUFFER }, noop);
+		graph.Compile();
+		printSchedule("backbuffer writers", graph, names);
+		expectBefore("backbuffer writers", graph, names, "pre", "overlay");
+		expectBefore("backbuffer writers", graph, names, "geometry", "lighting");
+		expectBefore("backbuffer writers", graph, names, "lighting", "overlay");
+	}
+
+	// a pass whose result nobody reads is culled, the chain to the backbuffer is kept in order
+	{
+		FrameGraph graph;
+		graph.Resize(64, 64);
+		int scene = graph.Create("scene", GL_RGBA16F);
+		int unused = graph.Create("unused", GL_RGBA16F);
+		std::vector<std::string> names;
+		names.push_back("scene");   graph.AddPass("scene", {}, { scene }, noop);
+		names.push_back("debug");   graph.AddPass("debug", { scene }, { unused }, noop);
+		names.push_back("tonemap"); graph.AddPass("tonemap", { scene }, { FrameGraph::BACKBUFFER }, noop);
+		graph.Compile();
+		printSchedule("culling", graph, names);
+		expectBefore("culling", graph, names, "scene", "tonemap");
+		if (position(graph, names, "debug") >= 0)
+		{
+			printf("FAIL culling: debug must be culled\n");
+			++failures;
+		}
+	}
+
+	printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+	return failures ? 1 : 0;
+}
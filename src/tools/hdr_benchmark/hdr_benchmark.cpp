@@ -0,0 +1,131 @@
+#include <stb_image.h>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/hdr_image.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Decode throughput of HDRImage against stb_image on a Radiance .hdr file, without a GL context. Every decoder runs
+// a few times and the fastest run counts; throughput is the size of the file over the decode time, so the numbers
+// compare directly. Also checks that HDRImage produces exactly the half floats of stbi_loadf + glm::packHalf1x16.
+//
+//   hdr_benchmark [hdr file relative to the root] [--runs N]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+float elapsed(Clock::time_point start)
+{
+	return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+void printResult(const char* name, float milliseconds, size_t fileBytes, int pixels, float baseline)
+{
+	printf("%-32s %8.2f ms  %7.1f MB/s  %6.1f Mpixel/s", name, milliseconds, fileBytes / (milliseconds * 1000.0), pixels / (milliseconds * 1000.0));
+	if (baseline > 0.0f)
+		printf("  %5.2fx", baseline / milliseconds);
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::string hdrPath = "res/textures/hdr/newport_loft.hdr";
+	int runs = 5;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+			runs = std::max(atoi(argv[++i]), 1);
+		else
+			hdrPath = argv[i];
+	}
+	std::string path = FileSystem::getPath(hdrPath);
+
+	HDRImage probe;
+	if (!probe.Open(path))
+	{
+		printf("Failed to open HDR image: %s\n", path.c_str());
+		return 1;
+	}
+	int width = probe.Width;
+	int height = probe.Height;
+	size_t fileBytes = probe.FileBytes;
+	probe.Close();
+	printf("%s: %dx%d, %.2f MB, best of %d runs\n", hdrPath.c_str(), width, height, fileBytes / (1024.0 * 1024.0), runs);
+
+	// 1. stb_image: float RGB as the demos loaded it, and converted to half floats like the upload does
+	// -------------------------------------------------------------------------------------------------
+	stbi_set_flip_vertically_on_load(true);
+	std::vector<unsigned short> expected((size_t)width * height * 4);
+	float stbFloat = 1e30f;
+	float stbHalf = 1e30f;
+	for (int run = 0; run < runs; ++run)
+	{
+		Clock::time_point start = Clock::now();
+		int w, h, components;
+		float* rgb = stbi_loadf(path.c_str(), &w, &h, &components, 3);
+		float decoded = elapsed(start);
+		if (!rgb)
+		{
+			printf("stb_image failed to load %s\n", path.c_str());
+			return 1;
+		}
+		for (size_t i = 0; i < (size_t)width * height; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+				expected[i * 4 + c] = glm::packHalf1x16(rgb[i * 3 + c]);
+			expected[i * 4 + 3] = 0x3c00;
+		}
+		stbFloat = std::min(stbFloat, decoded);
+		stbHalf = std::min(stbHalf, elapsed(start));
+		stbi_image_free(rgb);
+	}
+	printResult("stbi_loadf (float RGB)", stbFloat, fileBytes, width * height, 0.0f);
+	printResult("stbi_loadf + half conversion", stbHalf, fileBytes, width * height, 0.0f);
+
+	// 2. HDRImage on 1, 2, 4, ... threads: open (map, header, scanline index) and decode to half floats
+	// -------------------------------------------------------------------------------------------------
+	std::vector<unsigned short> rgba((size_t)width * height * 4);
+	int maxThreads = (int)std::max(std::thread::hardware_concurrency(), 1u);
+	for (int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+	{
+		ThreadPool pool(threads);
+		float best = 1e30f;
+		float bestOpen = 0.0f;
+		for (int run = 0; run < runs; ++run)
+		{
+			Clock::time_point start = Clock::now();
+			HDRImage image;
+			image.Open(path);
+			float opened = elapsed(start);
+			image.DecodeHalf(pool, &rgba[0]);
+			float total = elapsed(start);
+			if (total < best)
+			{
+				best = total;
+				bestOpen = opened;
+			}
+		}
+		char name[64];
+		snprintf(name, sizeof(name), "HDRImage, %d thread%s", threads, threads > 1 ? "s" : "");
+		printResult(name, best, fileBytes, width * height, stbHalf);
+		printf("%-32s %8.2f ms of it to map the file and index the scanlines\n", "", bestOpen);
+		if (threads == maxThreads)
+			break;
+	}
+
+	// 3. the half floats have to match stb_image's, bit for bit
+	// ---------------------------------------------------------
+	size_t mismatches = 0;
+	for (size_t i = 0; i < rgba.size(); ++i)
+		mismatches += rgba[i] != expected[i] ? 1 : 0;
+	printf("%zu of %zu half floats differ from stbi_loadf + glm::packHalf1x16\n", mismatches, rgba.size());
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+#include <stb_image.h>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/ibl_reference.h>
+#include <learnopengl/ibl_cache.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Headless IBL bake on the CPU: bakes the maps of the 6.pbr IBL demos from an HDR file, reports the time and
+// throughput of every pass per thread count and compares the result with the GPU bake the demos stored in the
+// IBL cache next to the HDR file. Exits with 1 when a map is outside its tolerance, so it can run as a regression test.
+//
+//   ibl_reference [hdr file relative to the root] [--threads N] [--scaling] [--prefilter-sweep]
+//     --threads N          bake with N threads (default: all hardware threads)
+//     --scaling            bake with 1, 2, 4, ... up to all hardware threads and print the speedup of each
+//     --prefilter-sweep    time the pre-filter pass with several sample counts per level and print the error of each
+//                          level against an 8192 sample bake
+
+// settings, the same as the 2.2.x demos
+const int CUBE_MAP_SIZE = 512;
+const int IRRADIANCE_MAP_SIZE = 32;
+const int PREFILTER_MAP_SIZE = 128;
+const int PREFILTER_MIP_LEVELS = 5;
+const unsigned int PREFILTER_SAMPLE_COUNTS[PREFILTER_MIP_LEVELS] = { 1, 64, 128, 256, 512 };
+const int LUT_TEX_SIZE = 512;
+const unsigned int LUT_SAMPLE_COUNT = 1024;
+
+struct BakeResult
+{
+	CubeImage environment;
+	CubeImage irradiance;
+	CubeImage prefilter;
+	std::vector<float> brdfLUT;
+	float milliseconds[4];    // environment, irradiance, pre-filter, BRDF LUT
+	double samples[4];        // texel fetches or BRDF evaluations of each pass
+};
+
+struct MapTolerance
+{
+	const char* name;
+	float maxRelativeError;   // rms over each mip level, relative to the rms of the GPU result
+};
+
+float elapsed(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void bake(ThreadPool& pool, const float* hdr, int width, int height, BakeResult& result)
+{
+	IBLReference reference(pool);
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	reference.EquirectToCube(hdr, width, height, CUBE_MAP_SIZE, result.environment);
+	result.milliseconds[0] = elapsed(start);
+	result.samples[0] = 6.0 * CUBE_MAP_SIZE * CUBE_MAP_SIZE;
+
+	start = std::chrono::high_resolution_clock::now();
+	reference.Irradiance(result.environment, IRRADIANCE_MAP_SIZE, result.irradiance);
+	result.milliseconds[1] = elapsed(start);
+	result.samples[1] = 6.0 * IRRADIANCE_MAP_SIZE * IRRADIANCE_MAP_SIZE * IBLReference::IrradianceSamples().size();
+
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<unsigned int> sampleCounts(PREFILTER_SAMPLE_COUNTS, PREFILTER_SAMPLE_COUNTS + PREFILTER_MIP_LEVELS);
+	reference.Prefilter(result.environment, PREFILTER_MAP_SIZE, sampleCounts, 0.0f, result.prefilter);
+	result.milliseconds[2] = elapsed(start);
+	result.samples[2] = 0.0;
+	for (int level = 0; level < PREFILTER_MIP_LEVELS; ++level)
+		result.samples[2] += 6.0 * result.prefilter.LevelSize(level) * result.prefilter.LevelSize(level) * sampleCounts[level];
+
+	start = std::chrono::high_resolution_clock::now();
+	reference.BRDFLut(LUT_TEX_SIZE, LUT_SAMPLE_COUNT, result.brdfLUT);
+	result.milliseconds[3] = elapsed(start);
+	result.samples[3] = (double)LUT_TEX_SIZE * LUT_TEX_SIZE * LUT_SAMPLE_COUNT;
+}
+
+void printBake(int threads, const BakeResult& result, float baseline)
+{
+	static const char* passes[4] = { "equirect", "irradiance", "prefilter", "brdf lut" };
+	float total = 0.0f;
+	printf("%2d threads:", threads);
+	for (int i = 0; i < 4; ++i)
+	{
+		printf("  %s %8.1f ms (%7.1f M/s)", passes[i], result.milliseconds[i], result.samples[i] / (result.milliseconds[i] * 1000.0));
+		total += result.milliseconds[i];
+	}
+	printf("  total %8.1f ms", total);
+	if (baseline > 0.0f)
+		printf(", %.2fx", baseline / total);
+	printf("\n");
+}
+
+// compares every level of a CPU cubemap (RGBA float) with the stored GPU map, returns false when one is off
+bool compareMap(IBLCache& cache, const MapTolerance& tolerance, const float* cpu, int cpuChannels, int cpuLevels)
+{
+	std::vector<float> gpu;
+	int size, levels, channels;
+	if (!cache.ReadMap(tolerance.name, gpu, size, levels, channels))
+	{
+		printf("%-12s not in the GPU cache, skipped\n", tolerance.name);
+		return true;
+	}
+	levels = levels < cpuLevels ? levels : cpuLevels;
+
+	bool passed = true;
+	size_t gpuOffset = 0;
+	size_t cpuOffset = 0;
+	for (int level = 0; level < levels; ++level)
+	{
+		int levelSize = size >> level > 0 ? size >> level : 1;
+		size_t texels = (size_t)6 * levelSize * levelSize;
+		double squaredError = 0.0;
+		double squaredReference = 0.0;
+		float maxError = 0.0f;
+		for (size_t i = 0; i < texels; ++i)
+		{
+			for (int c = 0; c < channels; ++c)
+			{
+				float reference = gpu[gpuOffset + i * channels + c];
+				float difference = cpu[cpuOffset + i * cpuChannels + c] - reference;
+				squaredError += difference * difference;
+				squaredReference += reference * reference;
+				maxError = fabsf(difference) > maxError ? fabsf(difference) : maxError;
+			}
+		}
+		gpuOffset += texels * channels;
+		cpuOffset += texels * cpuChannels;
+		float relative = squaredReference > 0.0 ? (float)sqrt(squaredError / squaredReference) : 0.0f;
+		bool ok = relative <= tolerance.maxRelativeError;
+		passed = passed && ok;
+		printf("%-12s level %d (%4d^2): rms %.3f%%, max abs %.4f  %s\n", tolerance.name, level, levelSize, relative * 100.0f, maxError, ok ? "ok" : "FAILED");
+	}
+	return passed;
+}
+
+// rms error of every level of a pre-filtered map against a reference, relative to the rms of the reference
+void printLevelErrors(const CubeImage& prefilter, const CubeImage& reference)
+{
+	for (int level = 0; level < prefilter.Levels; ++level)
+	{
+		double squaredError = 0.0;
+		double squaredReference = 0.0;
+		int size = prefilter.LevelSize(level);
+		for (int face = 0; face < 6; ++face)
+		{
+			const float* texels = prefilter.Face(level, face);
+			const float* expected = reference.Face(level, face);
+			for (size_t i = 0; i < (size_t)size * size * 4; ++i)
+			{
+				if (i % 4 == 3)
+					continue;
+				double difference = texels[i] - expected[i];
+				squaredError += difference * difference;
+				squaredReference += expected[i] * expected[i];
+			}
+		}
+		printf(" %6.2f%%", squaredReference > 0.0 ? 100.0 * sqrt(squaredError / squaredReference) : 0.0);
+	}
+	printf("\n");
+}
+
+// bake time and per level error of the pre-filter pass for the fixed 1024 samples of the original shader, a few
+// fixed counts and the per level counts the demos use
+void prefilterSweep(ThreadPool& pool, const CubeImage& environment)
+{
+	IBLReference reference(pool);
+	CubeImage expected;
+	reference.Prefilter(environment, PREFILTER_MAP_SIZE, PREFILTER_MIP_LEVELS, 8192, expected);
+
+	std::vector<std::vector<unsigned int> > schedules;
+	static const unsigned int fixedCounts[4] = { 1024, 256, 64, 32 };
+	for (int i = 0; i < 4; ++i)
+		schedules.push_back(std::vector<unsigned int>(PREFILTER_MIP_LEVELS, fixedCounts[i]));
+	schedules.push_back(std::vector<unsigned int>(PREFILTER_SAMPLE_COUNTS, PREFILTER_SAMPLE_COUNTS + PREFILTER_MIP_LEVELS));
+
+	printf("pre-filter samples per level          time  error per level against 8192 samples\n");
+	float baseline = 0.0f;
+	for (size_t i = 0; i < schedules.size(); ++i)
+	{
+		CubeImage prefilter;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		reference.Prefilter(environment, PREFILTER_MAP_SIZE, schedules[i], 0.0f, prefilter);
+		float milliseconds = elapsed(start);
+		if (i == 0)
+			baseline = milliseconds;
+		for (int level = 0; level < PREFILTER_MIP_LEVELS; ++level)
+			printf("%5u", schedules[i][level]);
+		printf("  %8.1f ms (%5.1fx) ", milliseconds, baseline / milliseconds);
+		printLevelErrors(prefilter, expected);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string hdrPath = "res/textures/hdr/newport_loft.hdr";
+	int threadCount = 0;
+	bool scaling = false;
+	bool sweep = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--scaling") == 0)
+			scaling = true;
+		else if (strcmp(argv[i], "--prefilter-sweep") == 0)
+			sweep = true;
+		else
+			hdrPath = argv[i];
+	}
+
+	// load the HDR file the way loadTexture() of the demos does
+	// ---------------------------------------------------------
+	stbi_set_flip_vertically_on_load(true);
+	int width, height, components;
+	float* hdr = stbi_loadf(FileSystem::getPath(hdrPath).c_str(), &width, &height, &components, 3);
+	if (!hdr)
+	{
+		printf("Failed to load HDR image: %s\n", FileSystem::getPath(hdrPath).c_str());
+		return 1;
+	}
+	printf("%s: %dx%d\n", hdrPath.c_str(), width, height);
+
+	// bake, once or per thread count
+	// ------------------------------
+	BakeResult result;
+	if (scaling)
+	{
+		int maxThreads = (int)std::max(std::thread::hardware_concurrency(), 1u);
+		float baseline = 0.0f;
+		for (int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+		{
+			ThreadPool pool(threads);
+			bake(pool, hdr, width, height, result);
+			printBake(threads, result, baseline);
+			if (threads == 1)
+				baseline = result.milliseconds[0] + result.milliseconds[1] + result.milliseconds[2] + result.milliseconds[3];
+			if (threads == maxThreads)
+				break;
+		}
+	}
+	else
+	{
+		ThreadPool pool(threadCount);
+		bake(pool, hdr, width, height, result);
+		printBake(pool.ThreadCount(), result, 0.0f);
+		if (sweep)
+			prefilterSweep(pool, result.environment);
+	}
+	stbi_image_free(hdr);
+
+	// compare with the GPU bake of the demos
+	// --------------------------------------
+	IBLCache cache(hdrPath);
+	std::vector<float> probe;
+	int size, levels, channels;
+	if (!cache.ReadMap("environment", probe, size, levels, channels))
+	{
+		printf("no GPU bake of this file in %s, run one of the 6.pbr IBL demos first to write it\n", cache.CachePath.c_str());
+		return 0;
+	}
+	// the environment and irradiance tolerances cover half float storage and the cube seams, the pre-filter is a
+	// Monte Carlo estimate on the same sample set but sums in a different order and precision. The demos no longer
+	// bake the BRDF LUT, src/tools/brdf_lut checks the shipped table against the same reference instead
+	static const MapTolerance tolerances[3] = {
+		{ "environment", 0.01f },
+		{ "irradiance", 0.02f },
+		{ "prefilter", 0.03f },
+	};
+	bool passed = compareMap(cache, tolerances[0], &result.environment.Texels[0], 4, result.environment.Levels);
+	passed = compareMap(cache, tolerances[1], &result.irradiance.Texels[0], 4, 1) && passed;
+	passed = compareMap(cache, tolerances[2], &result.prefilter.Texels[0], 4, PREFILTER_MIP_LEVELS) && passed;
+	printf(passed ? "CPU bake matches the GPU bake\n" : "CPU bake differs from the GPU bake\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#include <learnopengl/filesystem.h>
+#include <learnopengl/pbr_material.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Import step for the textured PBR materials, without a GL context: packs the albedo, normal, metallic, roughness and
+// ao maps of each material directory into the layout of pbr_material.h (albedo RGB, normal RG, ORM) and stores it as
+// <dir>/material.pbrpack, where PBRMaterial::Load() picks it up. Prints the texture memory and the textures bound per
+// material before and after packing.
+//
+//   pbr_pack [material directories relative to the root]   (default: every material of res/textures/pbr)
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> dirs;
+	for (int i = 1; i < argc; ++i)
+		dirs.push_back(argv[i]);
+	if (dirs.empty())
+	{
+		const char* materials[] = { "rusted_iron", "gold", "grass", "plastic", "wall" };
+		for (int i = 0; i < 5; ++i)
+			dirs.push_back(std::string("res/textures/pbr/") + materials[i]);
+	}
+
+	printf("%-28s %12s %12s %7s %10s\n", "material", "separate", "packed", "saved", "pack");
+	size_t totalBefore = 0, totalAfter = 0;
+	for (size_t i = 0; i < dirs.size(); ++i)
+	{
+		std::string path = FileSystem::getPath(dirs[i]);
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		PBRTextureSet set;
+		if (!set.Pack(path))
+		{
+			printf("%-28s no source maps\n", dirs[i].c_str());
+			continue;
+		}
+		float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (!set.Save(path))
+		{
+			printf("Failed to write %s\n", PBRTextureSet::PackPath(path).c_str());
+			return 1;
+		}
+
+		size_t before = PBRTextureSet::SourceTextureBytes(path);
+		size_t after = set.TextureBytes();
+		totalBefore += before;
+		totalAfter += after;
+		printf("%-28s %9.2f MB %9.2f MB %6.1f%% %7.1f ms\n", dirs[i].c_str(), before / (1024.0 * 1024.0), after / (1024.0 * 1024.0),
+			before ? 100.0 * (1.0 - (double)after / before) : 0.0, milliseconds);
+	}
+	printf("%-28s %9.2f MB %9.2f MB\n", "total", totalBefore / (1024.0 * 1024.0), totalAfter / (1024.0 * 1024.0));
+	printf("textures per material: 5 -> 3, fetches per fragment: 5 -> 3\n");
+	return 0;
+}
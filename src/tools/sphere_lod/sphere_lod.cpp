@@ -0,0 +1,78 @@
+#include <learnopengl/geometry.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Triangle count, vertex shader load and accuracy of the sphere LODs of geometry.h, without a GL context. For every
+// mesh and LOD it prints the vertex shader invocations per triangle (ACMR) of a 32 entry FIFO post-transform cache
+// as generated and after OptimizeVertexCache(), the invocations per unique vertex (ATVR, 1 is ideal), the largest
+// deviation from the sphere, and up to which radius on screen SphereLODs::Select() uses the LOD.
+//
+//   sphere_lod [--pixel-error E]   (default 0.5, the SphereLODs default)
+
+int main(int argc, char** argv)
+{
+	float pixelError = 0.5f;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--pixel-error") == 0)
+			pixelError = (float)atof(argv[i + 1]);
+	}
+	if (pixelError <= 0.0f)
+	{
+		printf("usage: sphere_lod [--pixel-error E]\n");
+		return 1;
+	}
+
+	const char* names[SphereLODs::KIND_COUNT] = { "uv sphere", "icosphere", "cube sphere" };
+	printf("%-12s %3s %8s %8s %9s %9s %6s %9s %12s %8s\n", "mesh", "lod", "tris", "verts", "acmr raw", "acmr opt", "atvr", "error", "up to px", "build");
+	for (int kind = 0; kind < SphereLODs::KIND_COUNT; ++kind)
+	{
+		for (int lod = 0; lod < SphereLODs::LOD_COUNT; ++lod)
+		{
+			MeshData raw = kind == SphereLODs::UV_SPHERE ? Geometry::UVSphere(4 << lod) : kind == SphereLODs::ICOSPHERE ? Geometry::Icosphere(lod) : Geometry::CubeSphere(1 << lod);
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			MeshData mesh = SphereLODs::Build((SphereLODs::Kind)kind, lod);
+			float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+			float acmr = Geometry::ACMR(mesh, 32);
+			float error = Geometry::SphereError(mesh);
+			// Select() takes this LOD while error * radius stays within the pixel error
+			printf("%-12s %3d %8d %8d %9.3f %9.3f %6.3f %9.5f %12.1f %6.2f ms\n", names[kind], lod, mesh.TriangleCount(), mesh.VertexCount(),
+				Geometry::ACMR(raw, 32), acmr, acmr * mesh.TriangleCount() / mesh.VertexCount(), error, pixelError / error, milliseconds);
+		}
+	}
+
+	// the same screen-space error from all three, at the radius of a sphere of the 6.pbr grid seen from the camera
+	const float radii[] = { 4.0f, 16.0f, 64.0f, 256.0f };
+	printf("\nfor a pixel error of %.2f: triangles (vertex shader invocations) of the selected LOD\n", pixelError);
+	printf("%-12s", "radius px");
+	for (int i = 0; i < 4; ++i)
+		printf(" %18.0f", radii[i]);
+	printf("\n");
+	for (int kind = 0; kind < SphereLODs::KIND_COUNT; ++kind)
+	{
+		printf("%-12s", names[kind]);
+		for (int i = 0; i < 4; ++i)
+		{
+			int lod = SphereLODs::LOD_COUNT - 1;
+			for (int l = 0; l < SphereLODs::LOD_COUNT - 1; ++l)
+			{
+				MeshData mesh = SphereLODs::Build((SphereLODs::Kind)kind, l);
+				if (Geometry::SphereError(mesh) * radii[i] <= pixelError)
+				{
+					lod = l;
+					break;
+				}
+			}
+			MeshData mesh = SphereLODs::Build((SphereLODs::Kind)kind, lod);
+			char cell[32];
+			snprintf(cell, sizeof(cell), "%d (%d)", mesh.TriangleCount(), (int)(Geometry::ACMR(mesh, 32) * mesh.TriangleCount() + 0.5f));
+			printf(" %18s", cell);
+		}
+		printf("\n");
+	}
+	return 0;
+}